@@ -0,0 +1,52 @@
+#ifndef LAYEREDITACTION_H
+# define LAYEREDITACTION_H
+
+# include <functional>
+# include <memory>
+
+# include "MapData.h"
+# include "TiledLayer.h"
+# include "Types.h"
+
+# include "IAction.h"
+
+namespace HMDT::Action {
+    /**
+     * @brief An action which modifies the pixels of a single map layer.
+     * @details Only the tiles overlapping the edited area are snapshotted,
+     *          once before and once after the edit, so undoing and redoing the
+     *          edit only ever writes those tiles back.
+     *
+     * @par The layer is leased for as long as the action exists, as releasing
+     *      it would load it back without the edit.
+     */
+    class LayerEditAction: public Action::IAction {
+        public:
+            //! Performs the edit. Must only touch the area given to the action.
+            using EditCallback = std::function<bool(MapData&)>;
+
+            LayerEditAction(std::shared_ptr<MapData>, MapData::Layer,
+                            const Rectangle&, const EditCallback&);
+
+            virtual bool doAction(const Callback& = _) override;
+            virtual bool undoAction(const Callback& = _) override;
+
+        private:
+            std::shared_ptr<MapData> m_map_data;
+            MapData::Layer m_layer;
+            Rectangle m_area;
+            EditCallback m_edit;
+
+            //! Keeps the layer from being released while it holds the edit
+            MapData::LayerLease m_lease;
+
+            //! The edited tiles from before the edit was first done
+            std::shared_ptr<const TiledLayer> m_before;
+
+            //! The edited tiles from after the edit was first done
+            std::shared_ptr<const TiledLayer> m_after;
+    };
+}
+
+#endif
+
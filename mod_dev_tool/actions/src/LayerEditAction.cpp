@@ -0,0 +1,65 @@
+
+#include "LayerEditAction.h"
+
+#include "Logger.h"
+
+HMDT::Action::LayerEditAction::LayerEditAction(
+        std::shared_ptr<MapData> map_data,
+        MapData::Layer layer,
+        const Rectangle& area,
+        const EditCallback& edit):
+    m_map_data(map_data),
+    m_layer(layer),
+    m_area(area),
+    m_edit(edit),
+    m_lease(map_data->leaseLayer(layer)),
+    m_before(nullptr),
+    m_after(nullptr)
+{ }
+
+bool HMDT::Action::LayerEditAction::doAction(const Callback& callback) {
+    if(!callback(0)) return false;
+
+    // Redoing the edit only needs to write the edited tiles back
+    if(m_after != nullptr) {
+        if(!m_map_data->restoreLayer(m_layer, *m_after)) return false;
+    } else {
+        m_before = m_map_data->snapshotLayer(m_layer, m_area);
+        if(m_before == nullptr) {
+            WRITE_ERROR("Failed to snapshot map layer ",
+                        MapData::getLayerName(m_layer), " before editing it.");
+            return false;
+        }
+
+        // Put back anything the edit may have changed before it failed
+        if(!m_edit(*m_map_data)) {
+            m_map_data->restoreLayer(m_layer, *m_before);
+            return false;
+        }
+        m_map_data->markLayerDirty(m_layer, m_area);
+
+        m_after = m_map_data->snapshotLayer(m_layer, m_area);
+        if(m_after == nullptr) return false;
+    }
+
+    if(!callback(1)) return false;
+
+    return true;
+}
+
+bool HMDT::Action::LayerEditAction::undoAction(const Callback& callback) {
+    if(!callback(0)) return false;
+
+    if(m_before == nullptr) {
+        WRITE_ERROR("Cannot undo an edit of map layer ",
+                    MapData::getLayerName(m_layer), " which was never done.");
+        return false;
+    }
+
+    if(!m_map_data->restoreLayer(m_layer, *m_before)) return false;
+
+    if(!callback(1)) return false;
+
+    return true;
+}
+
@@ -195,6 +195,8 @@ namespace HMDT {
 
     MaybeVoid convertBitMapTo8BPPGreyscale(BitMap2&) noexcept;
 
+    uint64_t estimateMemoryUsage(const BitMap2&) noexcept;
+
     std::ostream& operator<<(std::ostream&, const HMDT::BitMap2&);
 }
 
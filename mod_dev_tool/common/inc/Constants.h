@@ -69,6 +69,12 @@ namespace HMDT {
     //! The filename for storing shape data
     const std::string SHAPEDATA_FILENAME = "shapedata.bin";
 
+    /**
+     * @brief How many pixels worth of ProvinceIDs are converted at a time when
+     *        reading or writing the shape data file
+     */
+    const std::uint32_t SHAPE_LABEL_CHUNK_SIZE = 1 << 20;
+
     //! The filename for storing data about provinces
     const std::string PROVINCEDATA_FILENAME = "definition.csv";
 
@@ -87,6 +93,18 @@ namespace HMDT {
     //! The filename for storing the rivers
     const std::string RIVERS_FILENAME = "rivers.bmp";
 
+    //! The rivers color index which marks the source of a river
+    const std::uint8_t RIVER_SOURCE_INDEX = 0;
+
+    //! The rivers color index which marks where a river flows into another
+    const std::uint8_t RIVER_FLOW_IN_INDEX = 1;
+
+    //! The rivers color index which marks where a river branches off another
+    const std::uint8_t RIVER_FLOW_OUT_INDEX = 2;
+
+    //! The largest rivers color index which is still part of a river
+    const std::uint8_t RIVER_WIDEST_INDEX = 11;
+
     //! The filename for storing the normalmap
     const std::string NORMALMAP_FILENAME = "world_normal.bmp";
 
@@ -108,8 +126,33 @@ namespace HMDT {
     //! The 4 magic bytes 
     const std::string SHAPEDATA_MAGIC = "SDAT";
 
-    //! The maximum number of province previews to store in memory
-    const size_t MAX_CACHED_PROVINCE_PREVIEWS = 100;
+    /**
+     * @brief The maximum number of bytes of province previews to store in
+     *        memory. The most recently used preview is always kept, even if it
+     *        is larger than this on its own.
+     */
+    const uint64_t MAX_CACHED_PROVINCE_PREVIEW_BYTES = 128 * 1024 * 1024;
+
+    //! The maximum number of province previews waiting to be prefetched
+    const size_t MAX_QUEUED_PROVINCE_PREVIEW_PREFETCHES = 64;
+
+    //! The width and height in pixels of every cell in the province spatial index
+    const uint32_t PROVINCE_SPATIAL_INDEX_CELL_SIZE = 64;
+
+    /**
+     * @brief The maximum number of dirty rectangles remembered per map layer.
+     *        Readers which fall further behind than this must refresh fully.
+     */
+    const size_t MAX_LAYER_CHANGE_HISTORY = 256;
+
+    //! The most issues of each validator to write to the log after validating
+    const size_t MAX_LOGGED_VALIDATION_ISSUES = 10;
+
+    //! How many files may be written at once when exporting
+    const size_t MAX_FILE_WRITER_THREADS = 4;
+
+    //! How many files may wait to be written before exporting blocks
+    const size_t MAX_QUEUED_FILE_WRITES = 64;
 
     //! How much to zoom each time
     const double ZOOM_FACTOR = 0.1;
@@ -135,6 +178,9 @@ namespace HMDT {
 
     //! A completely impossible province ID that we will never support
     const ProvinceID INVALID_PROVINCE = EMPTY_UUID;
+
+    //! The label matrix value of pixels which do not belong to any province
+    const ProvinceIndex INVALID_PROVINCE_INDEX = 0;
 }
 
 #endif
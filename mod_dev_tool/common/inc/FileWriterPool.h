@@ -0,0 +1,95 @@
+/**
+ * @file FileWriterPool.h
+ *
+ * @brief Declares a pool of threads which write files in the background.
+ */
+
+#ifndef FILE_WRITER_POOL_H
+# define FILE_WRITER_POOL_H
+
+# include <condition_variable>
+# include <cstddef>
+# include <deque>
+# include <filesystem>
+# include <mutex>
+# include <string>
+# include <system_error>
+# include <thread>
+# include <vector>
+
+# include "Maybe.h"
+
+namespace HMDT {
+    /**
+     * @brief Writes files on a fixed number of worker threads.
+     * @details Files are only written if their contents actually changed.
+     *          The number of files waiting to be written is bounded, so
+     *          anything producing files faster than they can be written will
+     *          block until there is room again. write() may be called from any
+     *          number of threads at once.
+     */
+    class FileWriterPool {
+        public:
+            FileWriterPool(size_t, size_t);
+            FileWriterPool();
+            ~FileWriterPool();
+
+            FileWriterPool(const FileWriterPool&) = delete;
+            FileWriterPool& operator=(const FileWriterPool&) = delete;
+
+            void write(const std::filesystem::path&, std::string);
+
+            MaybeVoid wait();
+
+            size_t getWrittenCount() const noexcept;
+            size_t getSkippedCount() const noexcept;
+
+        private:
+            /**
+             * @brief A single file waiting to be written
+             */
+            struct WriteRequest {
+                std::filesystem::path path;
+                std::string contents;
+            };
+
+            void runWorker();
+
+            //! Guards every member below
+            mutable std::mutex m_mutex;
+
+            //! Signalled when a request is queued, or when stopping
+            std::condition_variable m_request_queued;
+
+            //! Signalled when a request is taken off of the queue
+            std::condition_variable m_request_taken;
+
+            //! Signalled when the last outstanding request is finished
+            std::condition_variable m_idle;
+
+            //! Every file waiting to be written
+            std::deque<WriteRequest> m_requests;
+
+            //! The most requests which may wait at once
+            size_t m_max_queued_requests;
+
+            //! How many requests are currently being written
+            size_t m_active_requests;
+
+            //! How many files were written
+            size_t m_written_count;
+
+            //! How many files were skipped, as they had not changed
+            size_t m_skipped_count;
+
+            //! The first error hit by any worker since the last wait()
+            std::error_code m_first_error;
+
+            bool m_stopping;
+
+            std::vector<std::thread> m_workers;
+    };
+}
+
+#endif
+
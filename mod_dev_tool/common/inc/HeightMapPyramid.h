@@ -0,0 +1,84 @@
+/**
+ * @file HeightMapPyramid.h
+ *
+ * @brief Declares a pyramid of ever smaller copies of the heightmap.
+ */
+
+#ifndef HEIGHTMAP_PYRAMID_H
+# define HEIGHTMAP_PYRAMID_H
+
+# include <array>
+# include <cstdint>
+# include <vector>
+
+# include "Maybe.h"
+# include "Types.h"
+
+namespace HMDT {
+    struct BitMap2;
+
+    /**
+     * @brief Every halving of a heightmap, down to a single pixel.
+     * @details Each level is half the width and height of the one before it
+     *          (rounded up), where every pixel is the average of the 2x2
+     *          pixels it covers. The full resolution heightmap is not part of
+     *          the pyramid, so level 0 is already half of its size.
+     *
+     *          Heightmaps are 8-bit palette images, so level 0 averages the
+     *          heights that each palette index resolves to rather than the
+     *          indices themselves. Every later level then holds plain heights.
+     */
+    class HeightMapPyramid {
+        public:
+            /**
+             * @brief A single downsampled copy of the heightmap
+             */
+            struct Level {
+                uint32_t width;
+                uint32_t height;
+
+                //! One byte per pixel, one row after another
+                std::vector<uint8_t> data;
+            };
+
+            //! The height of every 8-bit palette index
+            using Palette = std::array<uint8_t, 256>;
+
+            static Palette makePalette(const BitMap2&) noexcept;
+
+            HeightMapPyramid();
+
+            void build(const uint8_t*, uint32_t, uint32_t, const Palette&);
+            void update(const uint8_t*, const Rectangle&);
+            void clear() noexcept;
+
+            uint32_t getWidth() const noexcept;
+            uint32_t getHeight() const noexcept;
+            const Palette& getPalette() const noexcept;
+
+            size_t getLevelCount() const noexcept;
+
+            MaybeRef<const Level> getLevel(size_t) const noexcept;
+            MaybeRef<const Level> findLevel(uint32_t, uint32_t) const noexcept;
+
+            friend uint64_t estimateMemoryUsage(const HeightMapPyramid&) noexcept;
+
+        private:
+            //! The width of the full resolution heightmap
+            uint32_t m_width;
+
+            //! The height of the full resolution heightmap
+            uint32_t m_height;
+
+            //! The heights that the full resolution heightmap resolves to
+            Palette m_palette;
+
+            //! Every level, from largest to smallest
+            std::vector<Level> m_levels;
+    };
+
+    uint64_t estimateMemoryUsage(const HeightMapPyramid&) noexcept;
+}
+
+#endif
+
@@ -0,0 +1,240 @@
+/**
+ * @file LRUCache.h
+ *
+ * @brief Defines a least-recently-used cache which is bounded by a number of
+ *        bytes rather than a number of entries.
+ */
+
+#ifndef LRU_CACHE_H
+# define LRU_CACHE_H
+
+# include <cstdint>
+# include <list>
+# include <unordered_map>
+# include <utility>
+
+namespace HMDT {
+    /**
+     * @brief A cache which evicts its least recently used entries once the
+     *        combined size of every entry goes over a byte budget.
+     * @details Looking up, inserting, and erasing an entry are all O(1). The
+     *          most recently used entry is always kept, even if it is larger
+     *          than the entire budget by itself.
+     *
+     * @tparam Key The key to look entries up by. Must be hashable.
+     * @tparam Value The value stored for every key.
+     */
+    template<typename Key, typename Value>
+    class LRUCache {
+        public:
+            /**
+             * @brief A single cached value
+             */
+            struct Entry {
+                Key key;
+                Value value;
+
+                //! How many bytes this entry counts for against the budget
+                uint64_t bytes;
+            };
+
+            using EntryList = std::list<Entry>;
+            using const_iterator = typename EntryList::const_iterator;
+
+            /**
+             * @brief Creates a new, empty cache.
+             *
+             * @param byte_budget How many bytes may be cached before entries
+             *                    start getting evicted.
+             */
+            explicit LRUCache(uint64_t byte_budget):
+                m_entries(),
+                m_lookup(),
+                m_byte_budget(byte_budget),
+                m_total_bytes(0)
+            { }
+
+            /**
+             * @brief Gets the value for a key, marking it as the most recently
+             *        used entry.
+             *
+             * @param key The key to look up
+             *
+             * @return The value, or nullptr if the key is not cached
+             */
+            Value* get(const Key& key) noexcept {
+                auto it = m_lookup.find(key);
+                if(it == m_lookup.end()) return nullptr;
+
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+                return &it->second->value;
+            }
+
+            /**
+             * @brief Gets the value for a key without marking it as used.
+             *
+             * @param key The key to look up
+             *
+             * @return The value, or nullptr if the key is not cached
+             */
+            const Value* peek(const Key& key) const noexcept {
+                auto it = m_lookup.find(key);
+                if(it == m_lookup.end()) return nullptr;
+
+                return &it->second->value;
+            }
+
+            bool contains(const Key& key) const noexcept {
+                return m_lookup.count(key) != 0;
+            }
+
+            /**
+             * @brief Inserts or replaces the value for a key, marking it as the
+             *        most recently used entry. Least recently used entries are
+             *        then evicted until the cache fits its budget again.
+             *
+             * @param key The key to insert
+             * @param value The value to store
+             * @param bytes How many bytes the value counts for
+             *
+             * @return The number of entries which were evicted
+             */
+            size_t insert(const Key& key, Value value, uint64_t bytes) {
+                erase(key);
+
+                m_entries.push_front(Entry{ key, std::move(value), bytes });
+                m_lookup[key] = m_entries.begin();
+                m_total_bytes += bytes;
+
+                return evict();
+            }
+
+            /**
+             * @brief Removes a key from the cache.
+             *
+             * @param key The key to remove
+             *
+             * @return true if the key was cached, false otherwise
+             */
+            bool erase(const Key& key) noexcept {
+                auto it = m_lookup.find(key);
+                if(it == m_lookup.end()) return false;
+
+                m_total_bytes -= it->second->bytes;
+                m_entries.erase(it->second);
+                m_lookup.erase(it);
+
+                return true;
+            }
+
+            /**
+             * @brief Removes every entry which matches a predicate.
+             *
+             * @param pred Called with every Entry, returns true if that entry
+             *             should be removed
+             *
+             * @return The number of entries which were removed
+             */
+            template<typename Pred>
+            size_t eraseIf(Pred&& pred) {
+                size_t num_erased = 0;
+
+                for(auto it = m_entries.begin(); it != m_entries.end();) {
+                    if(pred(static_cast<const Entry&>(*it))) {
+                        m_total_bytes -= it->bytes;
+                        m_lookup.erase(it->key);
+                        it = m_entries.erase(it);
+                        ++num_erased;
+                    } else {
+                        ++it;
+                    }
+                }
+
+                return num_erased;
+            }
+
+            void clear() noexcept {
+                m_entries.clear();
+                m_lookup.clear();
+                m_total_bytes = 0;
+            }
+
+            size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            uint64_t getTotalBytes() const noexcept {
+                return m_total_bytes;
+            }
+
+            uint64_t getByteBudget() const noexcept {
+                return m_byte_budget;
+            }
+
+            /**
+             * @brief Changes the byte budget, evicting entries if the cache no
+             *        longer fits.
+             *
+             * @param byte_budget The new budget
+             *
+             * @return The number of entries which were evicted
+             */
+            size_t setByteBudget(uint64_t byte_budget) {
+                m_byte_budget = byte_budget;
+
+                return evict();
+            }
+
+            //! Iterates from the most to the least recently used entry
+            const_iterator begin() const noexcept {
+                return m_entries.begin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_entries.end();
+            }
+
+        private:
+            /**
+             * @brief Evicts least recently used entries until the cache fits
+             *        its budget, always keeping the most recent entry.
+             *
+             * @return The number of entries which were evicted
+             */
+            size_t evict() {
+                size_t num_evicted = 0;
+
+                while(m_total_bytes > m_byte_budget && m_entries.size() > 1) {
+                    auto& oldest = m_entries.back();
+
+                    m_total_bytes -= oldest.bytes;
+                    m_lookup.erase(oldest.key);
+                    m_entries.pop_back();
+
+                    ++num_evicted;
+                }
+
+                return num_evicted;
+            }
+
+            //! Every entry, from most to least recently used
+            EntryList m_entries;
+
+            //! Where every key is in m_entries
+            std::unordered_map<Key, typename EntryList::iterator> m_lookup;
+
+            //! How many bytes may be cached before entries get evicted
+            uint64_t m_byte_budget;
+
+            //! How many bytes are currently cached
+            uint64_t m_total_bytes;
+    };
+}
+
+#endif
+
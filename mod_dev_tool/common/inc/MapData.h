@@ -1,27 +1,97 @@
 #ifndef MAPDATA_H
 # define MAPDATA_H
 
+# include <atomic>
+# include <deque>
+# include <functional>
 # include <memory>
+# include <mutex>
+# include <optional>
 # include <utility>
+# include <vector>
 
 # include "Types.h"
+# include "TiledLayer.h"
+# include "MemoryReport.h"
 
 namespace HMDT {
     /**
      * @brief Holds all representations of the map. Note that this object cannot
      *        be copied, and must either be used as-is or as a shared_ptr
+     * @details Layers are only allocated the first time they are accessed. If
+     *          a loader has been registered for a layer, it will be invoked
+     *          right after allocation so that the layer can be filled in.
+     *          Layers with a loader can also be released again when nobody
+     *          holds a LayerLease on them.
+     *
+     * @par Writers also mark which tiles of a layer they touched, so that a
+     *      snapshot of a layer only ever has to copy those tiles, and
+     *      restoring it only has to write those tiles back.
+     *
+     * @par Every layer has a generation counter. Writers call markLayerDirty()
+     *      after modifying a layer, and readers remember the last generation
+     *      they have seen so that they only need to refresh what changed.
      */
     class MapData {
         public:
+            /**
+             * @brief Every map representation held by MapData
+             */
+            enum class Layer {
+                INPUT,
+                PROVINCE_COLORS,
+                PROVINCE_OUTLINES,
+                CITIES,
+                LABEL_MATRIX,
+                STATE_ID_MATRIX,
+                STATE_OUTLINES,
+                HEIGHTMAP,
+                RIVERS,
+
+                COUNT
+            };
+
+            //! Called to fill in a layer after it has been lazily allocated
+            using LayerLoaderCallback = std::function<void()>;
+
+            //! Called after a layer has been released by releaseUnusedLayers()
+            using LayerReleaseCallback = std::function<void()>;
+
+            /**
+             * @brief Keeps a layer from being released for as long as it is
+             *        held.
+             * @details Anything which remembers a layer across calls (rather
+             *          than just locking it for the duration of one call)
+             *          should hold a lease on it.
+             */
+            class LayerLease {
+                public:
+                    LayerLease() = default;
+                    ~LayerLease();
+
+                    LayerLease(LayerLease&&) = default;
+                    LayerLease& operator=(LayerLease&&);
+
+                    LayerLease(const LayerLease&) = delete;
+                    LayerLease& operator=(const LayerLease&) = delete;
+
+                    explicit operator bool() const noexcept;
+
+                private:
+                    friend MapData;
+
+                    explicit LayerLease(std::shared_ptr<std::atomic<uint32_t>>);
+
+                    //! The lease count of the layer, shared with MapData
+                    std::shared_ptr<std::atomic<uint32_t>> m_count;
+            };
+
             using MapType = std::weak_ptr<uint8_t[]>;
             using ConstMapType = std::weak_ptr<const uint8_t[]>;
 
             using MapType32 = std::weak_ptr<uint32_t[]>;
             using ConstMapType32 = std::weak_ptr<const uint32_t[]>;
 
-            using MapTypeUUID = std::weak_ptr<UUID[]>;
-            using ConstMapTypeUUID = std::weak_ptr<const UUID[]>;
-
             MapData();
             MapData(uint32_t, uint32_t);
             explicit MapData(const MapData*);
@@ -38,16 +108,38 @@ namespace HMDT {
             std::pair<uint32_t, uint32_t> getDimensions() const;
 
             uint32_t getInputSize() const;
-            uint32_t getProvincesSize() const;
             uint32_t getProvinceColorsSize() const;
             uint32_t getProvinceOutlinesSize() const;
             uint32_t getCitiesSize() const;
             uint32_t getMatrixSize() const;
+            uint32_t getStateOutlinesSize() const;
             uint32_t getHeightMapSize() const;
             uint32_t getRiversSize() const;
 
             bool isClosed() const;
 
+            bool isLayerResident(Layer) const;
+
+            void setLayerLoader(Layer, const LayerLoaderCallback&,
+                                const LayerReleaseCallback& = nullptr);
+            void clearLayerLoaders();
+
+            LayerLease leaseLayer(Layer) const;
+            uint64_t releaseUnusedLayers();
+
+            std::shared_ptr<const TiledLayer> snapshotLayer(Layer);
+            std::shared_ptr<const TiledLayer> snapshotLayer(Layer, const Rectangle&) const;
+            bool restoreLayer(Layer, const TiledLayer&);
+
+            uint64_t getLayerGeneration(Layer) const;
+            void markLayerDirty(Layer);
+            void markLayerDirty(Layer, const Rectangle&);
+            std::optional<std::vector<Rectangle>> getLayerChangesSince(Layer, uint64_t) const;
+
+            void reportMemoryUsage(MemoryReport&) const;
+
+            static const char* getLayerName(Layer) noexcept;
+
             [[deprecated]] void setLabelMatrix(uint32_t[]);
             [[deprecated]] void setStateIDMatrix(uint32_t[]);
 
@@ -56,9 +148,6 @@ namespace HMDT {
             MapType getInput();
             ConstMapType getInput() const;
 
-            MapTypeUUID getProvinces();
-            ConstMapTypeUUID getProvinces() const;
-
             MapType getProvinceColors();
             ConstMapType getProvinceColors() const;
 
@@ -68,13 +157,26 @@ namespace HMDT {
             MapType getCities();
             ConstMapType getCities() const;
 
+            /**
+             * @brief Gets the label matrix.
+             * @details Every pixel holds the dense ProvinceIndex of the
+             *          province it belongs to. Use the ProvinceProject to map
+             *          between ProvinceIndex and ProvinceID.
+             */
             MapType32 getLabelMatrix();
             ConstMapType32 getLabelMatrix() const;
 
             MapType32 getStateIDMatrix();
             ConstMapType32 getStateIDMatrix() const;
 
-            uint32_t getStateIDMatrixUpdatedTag() const;
+            /**
+             * @brief Gets the state outlines.
+             * @details Every pixel is 0xFF if it lies on the border of a
+             *          state, and 0 otherwise. This is kept up to date
+             *          alongside the state ID matrix.
+             */
+            MapType getStateOutlines();
+            ConstMapType getStateOutlines() const;
 
             MapType getHeightMap();
             ConstMapType getHeightMap() const;
@@ -85,25 +187,76 @@ namespace HMDT {
         private:
             using InternalMapType = std::shared_ptr<uint8_t[]>;
             using InternalMapType32 = std::shared_ptr<uint32_t[]>;
-            using InternalMapTypeUUID = std::shared_ptr<UUID[]>;
+
+            template<typename T>
+            std::shared_ptr<T[]> getOrAllocateLayer(std::shared_ptr<T[]>&,
+                                                     Layer, uint32_t) const;
+
+            /**
+             * @brief Every change made to a layer since its oldest remembered
+             *        generation
+             */
+            struct LayerChangeLog {
+                //! The current generation of the layer
+                uint64_t generation = 0;
+
+                //! Changes since this generation are all still remembered
+                uint64_t oldest_generation = 0;
+
+                //! The generation of each change, and what area it touched
+                std::deque<std::pair<uint64_t, Rectangle>> changes;
+
+                //! Which tiles have been touched since the last snapshot
+                std::vector<bool> dirty_tiles;
+            };
+
+            std::shared_ptr<const TiledLayer> snapshotTiles(Layer, const std::vector<uint32_t>&) const;
+
+            std::shared_ptr<uint8_t[]> getLayerBytes(Layer) const;
+            uint32_t getLayerBytesPerPixel(Layer) const;
 
             uint32_t m_width;
             uint32_t m_height;
 
-            InternalMapType m_input;
-            InternalMapTypeUUID m_provinces;
-            InternalMapType m_province_colors;
-            InternalMapType m_province_outlines;
-            InternalMapType m_cities;
-            InternalMapType32 m_label_matrix;
-            InternalMapType32 m_state_id_matrix;
-            InternalMapType m_heightmap;
-            InternalMapType m_rivers;
+            // All layers are mutable so that they can be lazily allocated
+            //  from the const accessors as well
+            mutable InternalMapType m_input;
+            mutable InternalMapType m_province_colors;
+            mutable InternalMapType m_province_outlines;
+            mutable InternalMapType m_cities;
+            mutable InternalMapType32 m_label_matrix;
+            mutable InternalMapType32 m_state_id_matrix;
+            mutable InternalMapType m_state_outlines;
+            mutable InternalMapType m_heightmap;
+            mutable InternalMapType m_rivers;
             // More map representations as necessary
 
-            bool m_closed;
+            //! Loaders used to fill in a layer once it gets allocated
+            LayerLoaderCallback m_layer_loaders[static_cast<size_t>(Layer::COUNT)];
 
-            uint32_t m_state_id_matrix_updated_tag;
+            //! Called after a layer with a loader has been released
+            LayerReleaseCallback m_layer_releasers[static_cast<size_t>(Layer::COUNT)];
+
+            /**
+             * @brief Makes sure that the loader only runs once per allocation
+             *        of a layer, even though it runs outside of the lock.
+             * @details nullptr if the layer has nothing left to load.
+             */
+            mutable std::shared_ptr<std::once_flag> m_layer_load_flags[static_cast<size_t>(Layer::COUNT)];
+
+            //! How many LayerLeases are currently held on each layer
+            std::shared_ptr<std::atomic<uint32_t>> m_layer_leases[static_cast<size_t>(Layer::COUNT)];
+
+            //! The generation and recent changes of every layer
+            LayerChangeLog m_layer_changes[static_cast<size_t>(Layer::COUNT)];
+
+            /**
+             * @brief Guards lazy allocation of the layers.
+             * @details This is a pointer so that MapData can still be moved.
+             */
+            std::unique_ptr<std::recursive_mutex> m_layer_mutex;
+
+            bool m_closed;
 
         public:
             void setLabelMatrix(InternalMapType32);
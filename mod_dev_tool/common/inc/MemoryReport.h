@@ -0,0 +1,118 @@
+/**
+ * @file MemoryReport.h
+ *
+ * @brief Declares a tree of memory usage, used for accounting where memory
+ *        is being spent.
+ */
+
+#ifndef MEMORY_REPORT_H
+# define MEMORY_REPORT_H
+
+# include <cstdint>
+# include <list>
+# include <map>
+# include <set>
+# include <string>
+# include <unordered_map>
+# include <vector>
+
+namespace HMDT {
+    /**
+     * @brief Describes how many bytes a subsystem is using, broken down into
+     *        each of its parts.
+     * @details Every node only holds the bytes it owns directly. The total of a
+     *          node is its own bytes plus the totals of all of its children.
+     *          Byte counts are estimates: they count the data held, but not
+     *          the bookkeeping done by the allocator.
+     */
+    class MemoryReport {
+        public:
+            MemoryReport(const std::string& = "", uint64_t = 0);
+
+            const std::string& getName() const noexcept;
+
+            uint64_t getBytes() const noexcept;
+            uint64_t getTotalBytes() const noexcept;
+
+            void addBytes(uint64_t) noexcept;
+
+            MemoryReport& addChild(const std::string&, uint64_t = 0);
+            const std::list<MemoryReport>& getChildren() const noexcept;
+
+            void addWarning(const std::string&);
+            std::vector<std::string> getAllWarnings() const;
+
+            std::string toString() const;
+
+            void writeToLog(const std::string&) const;
+
+        private:
+            void toString(std::string&, uint32_t) const;
+
+            //! The name of the subsystem being reported on
+            std::string m_name;
+
+            //! The bytes owned directly by this subsystem
+            uint64_t m_bytes;
+
+            /**
+             * @brief Every part of this subsystem.
+             * @details A list is used so that references returned by
+             *          addChild() stay valid as more children get added.
+             */
+            std::list<MemoryReport> m_children;
+
+            //! Anything unusual that was noticed about this subsystem
+            std::vector<std::string> m_warnings;
+    };
+
+    std::string formatByteSize(uint64_t);
+
+    /**
+     * @brief Estimates the memory held by a vector, not counting anything its
+     *        elements point to.
+     */
+    template<typename T, typename A>
+    uint64_t estimateMemoryUsage(const std::vector<T, A>& vec) noexcept {
+        return vec.capacity() * sizeof(T);
+    }
+
+    /**
+     * @brief Estimates the memory held by a set, not counting anything its
+     *        elements point to.
+     * @details Every element is stored in its own tree node, which also holds
+     *          three pointers and a color.
+     */
+    template<typename T, typename C, typename A>
+    uint64_t estimateMemoryUsage(const std::set<T, C, A>& set) noexcept {
+        return set.size() * (sizeof(T) + 4 * sizeof(void*));
+    }
+
+    /**
+     * @brief Estimates the memory held by a map, not counting anything its
+     *        elements point to.
+     */
+    template<typename K, typename V, typename C, typename A>
+    uint64_t estimateMemoryUsage(const std::map<K, V, C, A>& map) noexcept {
+        return map.size() * (sizeof(typename std::map<K, V, C, A>::value_type) +
+                             4 * sizeof(void*));
+    }
+
+    /**
+     * @brief Estimates the memory held by an unordered_map, not counting
+     *        anything its elements point to.
+     * @details Every element is stored in its own node alongside a pointer to
+     *          the next node, and every bucket is a single pointer.
+     */
+    template<typename K, typename V, typename H, typename E, typename A>
+    uint64_t estimateMemoryUsage(const std::unordered_map<K, V, H, E, A>& map) noexcept
+    {
+        using ValueType = typename std::unordered_map<K, V, H, E, A>::value_type;
+
+        return map.size() * (sizeof(ValueType) + 2 * sizeof(void*)) +
+               map.bucket_count() * sizeof(void*);
+    }
+}
+
+#endif
+
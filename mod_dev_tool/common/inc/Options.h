@@ -55,6 +55,9 @@ namespace HMDT {
 
         //! --fix-warnings-on-load
         bool fix_warnings_on_load;
+
+        //! --memory-report
+        bool memory_report;
     };
 
     //! Global variable for storing program options.
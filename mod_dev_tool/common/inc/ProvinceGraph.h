@@ -0,0 +1,118 @@
+/**
+ * @file ProvinceGraph.h
+ *
+ * @brief Declares the graph of which provinces border each other.
+ */
+
+#ifndef PROVINCE_GRAPH_H
+# define PROVINCE_GRAPH_H
+
+# include <cstdint>
+# include <vector>
+
+# include "Types.h"
+# include "ProvinceList.h"
+
+namespace HMDT {
+    /**
+     * @brief What kinds of provinces are on either side of a border
+     */
+    enum class ProvinceCrossing: uint8_t {
+        UNKNOWN = 0,
+        LAND,      //!< LAND <-> LAND
+        SEA,       //!< SEA <-> SEA
+        LAKE,      //!< LAKE <-> LAKE
+        COAST,     //!< LAND <-> SEA
+        LAKESHORE, //!< LAND <-> LAKE
+        SEA_LAKE   //!< SEA <-> LAKE
+    };
+
+    ProvinceCrossing getProvinceCrossing(ProvinceType, ProvinceType) noexcept;
+
+    /**
+     * @brief A border shared by two provinces
+     */
+    struct ProvinceBorder {
+        ProvinceIndex first;
+        ProvinceIndex second;
+
+        //! How many pairs of neighbouring pixels lie across this border
+        uint32_t length;
+    };
+
+    /**
+     * @brief A single direction of a border, as seen from one province
+     */
+    struct ProvinceEdge {
+        //! The province on the other side of the border
+        ProvinceIndex neighbour;
+
+        //! How many pairs of neighbouring pixels lie across this border
+        uint32_t length;
+
+        ProvinceCrossing crossing;
+    };
+
+    /**
+     * @brief Which provinces border each other, stored in compressed sparse
+     *        row form.
+     * @details The edges of every province are stored next to each other in a
+     *          single array, sorted by neighbour, and a second array holds
+     *          where the edges of each ProvinceIndex start. Every border is
+     *          stored once in each direction.
+     */
+    class ProvinceGraph {
+        public:
+            /**
+             * @brief The edges of a single province
+             */
+            class EdgeRange {
+                public:
+                    EdgeRange(const ProvinceEdge* begin, const ProvinceEdge* end):
+                        m_begin(begin),
+                        m_end(end)
+                    { }
+
+                    const ProvinceEdge* begin() const noexcept { return m_begin; }
+                    const ProvinceEdge* end() const noexcept { return m_end; }
+
+                    size_t size() const noexcept { return m_end - m_begin; }
+                    bool empty() const noexcept { return m_begin == m_end; }
+
+                private:
+                    const ProvinceEdge* m_begin;
+                    const ProvinceEdge* m_end;
+            };
+
+            ProvinceGraph();
+
+            void build(size_t, const std::vector<ProvinceBorder>&);
+            void updateCrossings(const ProvinceList&) noexcept;
+            void clear() noexcept;
+
+            size_t getVertexCount() const noexcept;
+            size_t getEdgeCount() const noexcept;
+
+            EdgeRange getEdges(ProvinceIndex) const noexcept;
+            const ProvinceEdge* findEdge(ProvinceIndex, ProvinceIndex) const noexcept;
+            bool areAdjacent(ProvinceIndex, ProvinceIndex) const noexcept;
+
+            friend uint64_t estimateMemoryUsage(const ProvinceGraph&) noexcept;
+
+        private:
+            /**
+             * @brief Where the edges of every ProvinceIndex start in m_edges.
+             * @details Holds one more entry than there are vertices, so that
+             *          the edges of index i are [m_offsets[i], m_offsets[i+1]).
+             */
+            std::vector<uint32_t> m_offsets;
+
+            //! The edges of every province, sorted by neighbour
+            std::vector<ProvinceEdge> m_edges;
+    };
+
+    uint64_t estimateMemoryUsage(const ProvinceGraph&) noexcept;
+}
+
+#endif
+
@@ -0,0 +1,133 @@
+/**
+ * @file ProvinceList.h
+ *
+ * @brief Declares the store which holds every province.
+ */
+
+#ifndef PROVINCE_LIST_H
+# define PROVINCE_LIST_H
+
+# include <cstdint>
+# include <unordered_map>
+# include <utility>
+# include <vector>
+
+# include "Types.h"
+
+namespace HMDT {
+    /**
+     * @brief Holds every province contiguously, in ProvinceIndex order.
+     * @details The province at position i always has the ProvinceIndex i + 1,
+     *          as index 0 is never assigned to a province. Looking provinces up
+     *          by ProvinceID goes through a secondary hash index, but looking
+     *          them up by ProvinceIndex, or iterating over all of them, only
+     *          walks a single array.
+     *
+     * @par This otherwise behaves like an std::unordered_map from ProvinceID
+     *      to Province. Note however that inserting a new province may
+     *      invalidate references to the others.
+     *
+     * @par The fields which get scanned across every province are also kept
+     *      in dense columns, in the same order as the provinces. These are
+     *      kept up to date by the setters below, but anything which writes
+     *      those fields through a Province reference must call syncColumns()
+     *      (or rebuildColumns() after changing many provinces) afterwards.
+     */
+    class ProvinceList {
+        public:
+            using value_type = std::pair<const ProvinceID, Province>;
+            using iterator = std::vector<value_type>::iterator;
+            using const_iterator = std::vector<value_type>::const_iterator;
+
+            ProvinceList() = default;
+
+            ProvinceList(const ProvinceList&) = default;
+            ProvinceList(ProvinceList&&) = default;
+
+            ProvinceList& operator=(const ProvinceList&);
+            ProvinceList& operator=(ProvinceList&&) = default;
+
+            iterator begin() noexcept;
+            iterator end() noexcept;
+            const_iterator begin() const noexcept;
+            const_iterator end() const noexcept;
+
+            size_t size() const noexcept;
+            bool empty() const noexcept;
+
+            void clear() noexcept;
+            void reserve(size_t);
+
+            size_t count(const ProvinceID&) const noexcept;
+
+            iterator find(const ProvinceID&) noexcept;
+            const_iterator find(const ProvinceID&) const noexcept;
+
+            Province& at(const ProvinceID&);
+            const Province& at(const ProvinceID&) const;
+
+            Province& operator[](const ProvinceID&);
+
+            ProvinceIndex getIndex(const ProvinceID&) const noexcept;
+            const ProvinceID& getID(ProvinceIndex) const noexcept;
+
+            Province* atIndex(ProvinceIndex) noexcept;
+            const Province* atIndex(ProvinceIndex) const noexcept;
+
+            void reorder(const std::vector<ProvinceID>&);
+
+            const std::vector<ProvinceType>& getTypes() const noexcept;
+            const std::vector<uint8_t>& getCoastal() const noexcept;
+            const std::vector<StateID>& getStates() const noexcept;
+            const std::vector<Color>& getColors() const noexcept;
+            const std::vector<BoundingBox>& getBoundingBoxes() const noexcept;
+            const std::vector<ProvinceIndex>& getParentIndices() const noexcept;
+
+            void setType(ProvinceIndex, ProvinceType) noexcept;
+            void setCoastal(ProvinceIndex, bool) noexcept;
+            void setState(ProvinceIndex, StateID) noexcept;
+            void setParent(ProvinceIndex, const ProvinceID&) noexcept;
+
+            void syncColumns(ProvinceIndex) noexcept;
+            void rebuildColumns() noexcept;
+
+            friend uint64_t estimateMemoryUsage(const ProvinceList&) noexcept;
+
+        private:
+            void rebuildLookup();
+            void resizeColumns(size_t);
+
+            //! Every province, in ProvinceIndex order
+            std::vector<value_type> m_provinces;
+
+            //! Where every ProvinceID is in m_provinces
+            std::unordered_map<ProvinceID, size_t> m_lookup;
+
+            //! The type of every province, in the same order as m_provinces
+            std::vector<ProvinceType> m_types;
+
+            //! Whether every province is coastal
+            std::vector<uint8_t> m_coastal;
+
+            //! The state of every province
+            std::vector<StateID> m_states;
+
+            //! The unique color of every province
+            std::vector<Color> m_colors;
+
+            //! The bounding box of every province
+            std::vector<BoundingBox> m_bounding_boxes;
+
+            /**
+             * @brief The ProvinceIndex of the parent of every province
+             * @details INVALID_PROVINCE_INDEX if the province has no parent,
+             *          or if its parent is not in this list.
+             */
+            std::vector<ProvinceIndex> m_parent_indices;
+    };
+
+    uint64_t estimateMemoryUsage(const ProvinceList&) noexcept;
+}
+
+#endif
+
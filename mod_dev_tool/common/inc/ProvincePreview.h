@@ -0,0 +1,57 @@
+/**
+ * @file ProvincePreview.h
+ *
+ * @brief Declares the 1-bit mask used to preview a single province.
+ */
+
+#ifndef PROVINCE_PREVIEW_H
+# define PROVINCE_PREVIEW_H
+
+# include <cstdint>
+# include <memory>
+# include <vector>
+
+namespace HMDT {
+    /**
+     * @brief Marks which pixels within a province's bounding box are part of
+     *        that province, using a single bit per pixel.
+     * @details Every row starts on a new 64-bit word, so that whole words of
+     *          pixels can be checked at once. A preview only gets expanded to
+     *          a full color image when it is about to be drawn.
+     */
+    class ProvincePreview {
+        public:
+            ProvincePreview(uint32_t, uint32_t);
+
+            uint32_t getWidth() const noexcept;
+            uint32_t getHeight() const noexcept;
+
+            bool isSet(uint32_t, uint32_t) const noexcept;
+            void set(uint32_t, uint32_t) noexcept;
+
+            uint64_t* getRow(uint32_t) noexcept;
+            const uint64_t* getRow(uint32_t) const noexcept;
+
+            uint32_t getWordsPerRow() const noexcept;
+            uint64_t getByteSize() const noexcept;
+
+            void expandToARGB(unsigned char*, uint32_t, uint32_t) const noexcept;
+            std::unique_ptr<unsigned char[]> expandToARGB(uint32_t) const;
+
+        private:
+            //! The width of the preview in pixels
+            uint32_t m_width;
+
+            //! The height of the preview in pixels
+            uint32_t m_height;
+
+            //! How many 64-bit words make up a single row
+            uint32_t m_words_per_row;
+
+            //! Every row of pixels, one bit per pixel
+            std::vector<uint64_t> m_bits;
+    };
+}
+
+#endif
+
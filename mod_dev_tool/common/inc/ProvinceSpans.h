@@ -0,0 +1,96 @@
+/**
+ * @file ProvinceSpans.h
+ *
+ * @brief Declares the horizontal runs of pixels that make up every province.
+ */
+
+#ifndef PROVINCE_SPANS_H
+# define PROVINCE_SPANS_H
+
+# include <cstdint>
+# include <vector>
+
+# include "Types.h"
+
+namespace HMDT {
+    /**
+     * @brief A horizontal run of pixels which all belong to the same province
+     */
+    struct ProvinceSpan {
+        uint32_t y;
+
+        //! The first pixel of the run
+        uint32_t x;
+
+        //! How many pixels are in the run
+        uint32_t length;
+    };
+
+    /**
+     * @brief Every run of pixels in the label matrix, grouped by province.
+     * @details The spans of every province are stored next to each other in a
+     *          single array, in the order they appear in the label matrix, and
+     *          a second array holds where the spans of each ProvinceIndex
+     *          start. This allows every pixel of a province to be visited
+     *          without scanning the rest of the map.
+     */
+    class ProvinceSpans {
+        public:
+            /**
+             * @brief The spans of a single province
+             */
+            class SpanRange {
+                public:
+                    SpanRange(const ProvinceSpan* begin, const ProvinceSpan* end):
+                        m_begin(begin),
+                        m_end(end)
+                    { }
+
+                    const ProvinceSpan* begin() const noexcept { return m_begin; }
+                    const ProvinceSpan* end() const noexcept { return m_end; }
+
+                    size_t size() const noexcept { return m_end - m_begin; }
+                    bool empty() const noexcept { return m_begin == m_end; }
+
+                private:
+                    const ProvinceSpan* m_begin;
+                    const ProvinceSpan* m_end;
+            };
+
+            ProvinceSpans();
+
+            void build(const uint32_t*, uint32_t, uint32_t, size_t, uint64_t);
+            void clear() noexcept;
+
+            uint64_t getLabelGeneration() const noexcept;
+            size_t getProvinceCount() const noexcept;
+            size_t getSpanCount() const noexcept;
+
+            SpanRange getSpans(ProvinceIndex) const noexcept;
+
+            friend uint64_t estimateMemoryUsage(const ProvinceSpans&) noexcept;
+
+        private:
+            /**
+             * @brief Where the spans of every ProvinceIndex start in m_spans.
+             * @details Holds one more entry than there are provinces, so that
+             *          the spans of index i are [m_offsets[i], m_offsets[i+1]).
+             */
+            std::vector<uint32_t> m_offsets;
+
+            //! The spans of every province, from top to bottom
+            std::vector<ProvinceSpan> m_spans;
+
+            /**
+             * @brief The generation of the label matrix that the spans were
+             *        built from. Set to -1 when there are no spans, so that
+             *        it never matches any generation.
+             */
+            uint64_t m_label_generation;
+    };
+
+    uint64_t estimateMemoryUsage(const ProvinceSpans&) noexcept;
+}
+
+#endif
+
@@ -0,0 +1,93 @@
+/**
+ * @file ProvinceSpatialIndex.h
+ *
+ * @brief Declares the grid used to look up provinces by where they are on the
+ *        map.
+ */
+
+#ifndef PROVINCE_SPATIAL_INDEX_H
+# define PROVINCE_SPATIAL_INDEX_H
+
+# include <cstdint>
+# include <optional>
+# include <vector>
+
+# include "Types.h"
+# include "ProvinceList.h"
+
+namespace HMDT {
+    /**
+     * @brief Buckets the bounding box of every province into a uniform grid.
+     * @details A province is stored in every cell that its bounding box
+     *          touches. Queries therefore only need to look at the cells
+     *          around the area they are interested in, rather than at every
+     *          province.
+     *
+     * @par Provinces are referred to by their ProvinceIndex, and every query
+     *      returns its results in a stable order.
+     */
+    class ProvinceSpatialIndex {
+        public:
+            ProvinceSpatialIndex();
+            explicit ProvinceSpatialIndex(uint32_t);
+
+            void rebuild(const ProvinceList&, uint32_t, uint32_t);
+            void clear() noexcept;
+
+            size_t size() const noexcept;
+
+            std::vector<ProvinceIndex> queryRect(const Rectangle&) const;
+
+            friend uint64_t estimateMemoryUsage(const ProvinceSpatialIndex&) noexcept;
+
+        private:
+            /**
+             * @brief The pixels covered by a province, with every bound
+             *        being inclusive
+             */
+            struct Bounds {
+                uint32_t min_x;
+                uint32_t min_y;
+                uint32_t max_x;
+                uint32_t max_y;
+            };
+
+            //! A range of cells, with every bound being inclusive
+            struct CellRange {
+                uint32_t min_cx;
+                uint32_t min_cy;
+                uint32_t max_cx;
+                uint32_t max_cy;
+            };
+
+            static Bounds toBounds(const BoundingBox&) noexcept;
+
+            CellRange getCellRange(const Bounds&) const noexcept;
+
+            void resizeGrid(uint32_t, uint32_t);
+            void insertIntoCells(ProvinceIndex);
+
+            //! The width and height of every cell, in pixels
+            uint32_t m_cell_size;
+
+            //! How many cells there are horizontally
+            uint32_t m_cells_x;
+
+            //! How many cells there are vertically
+            uint32_t m_cells_y;
+
+            //! The number of provinces stored
+            size_t m_size;
+
+            //! The bounds of every province, by ProvinceIndex
+            std::vector<std::optional<Bounds>> m_bounds;
+
+            //! Every province whose bounding box touches each cell
+            std::vector<std::vector<ProvinceIndex>> m_cells;
+    };
+
+    uint64_t estimateMemoryUsage(const ProvinceSpatialIndex&) noexcept;
+}
+
+#endif
+
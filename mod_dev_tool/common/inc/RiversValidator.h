@@ -0,0 +1,19 @@
+/**
+ * @file RiversValidator.h
+ *
+ * @brief Declares the checks for the HoI4 river rules.
+ */
+
+#ifndef RIVERS_VALIDATOR_H
+# define RIVERS_VALIDATOR_H
+
+# include <cstdint>
+
+# include "ValidationReport.h"
+
+namespace HMDT {
+    ValidationReport validateRivers(const uint8_t*, uint32_t, uint32_t);
+}
+
+#endif
+
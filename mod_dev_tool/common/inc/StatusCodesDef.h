@@ -39,9 +39,22 @@
     Y(PROVINCE_PROJECT, 0x200) \
     X(PROVINCE_INVALID_STATE_ID, gettext("The Province's StateID is invalid.")) \
     X(PROVINCE_NOT_IN_STATE, gettext("The Province is not in the state it says it's in.")) \
+    X(PROVINCE_IN_MULTIPLE_STATES, gettext("The Province is listed by more than one state.")) \
+    X(PROVINCE_MERGE_MISMATCH, gettext("The Province's merge parent and children do not agree.")) \
     /* State Project Error Codes */ \
     Y(STATE_PROJECT, 0x300) \
     X(STATE_DOES_NOT_EXIST, gettext("The state does not exist.")) \
+    X(STATE_INVALID_PROVINCE, gettext("The state lists a province which does not exist.")) \
+    X(STATE_PROVINCE_MISMATCH, gettext("The state lists a province which belongs to a different state.")) \
+    /* Rivers Project Error Codes */ \
+    Y(RIVERS_PROJECT, 0x400) \
+    X(RIVER_DIAGONAL_CONNECTION, gettext("The river pixel only connects to another river pixel diagonally.")) \
+    X(RIVER_INVALID_BRANCH, gettext("The river splits without a flow-in or flow-out marker.")) \
+    X(RIVER_MISPLACED_MARKER, gettext("The river source or flow marker is not placed where it joins a river.")) \
+    X(RIVER_NO_SOURCE, gettext("The river has no source.")) \
+    X(RIVER_SOURCE_MISMATCH, gettext("The river does not have one more source than it has flow-in markers.")) \
+    X(RIVER_DANGLING_END, gettext("The river has more ends than it has flow-out markers.")) \
+    X(RIVER_LOOP, gettext("The river loops back on itself.")) \
     /* Gui Error Codes */ \
     Y(GUI, 0x2000) \
     X(DISPATCHER_DOES_NOT_EXIST, gettext("The provided dispatcher id does not exist.")) \
@@ -0,0 +1,104 @@
+/**
+ * @file TiledLayer.h
+ *
+ * @brief Declares a tiled, copy-on-write storage for a single map layer.
+ */
+
+#ifndef TILED_LAYER_H
+# define TILED_LAYER_H
+
+# include <cstdint>
+# include <memory>
+# include <vector>
+
+# include "Types.h"
+
+namespace HMDT {
+    /**
+     * @brief Stores a 2D pixel layer as a grid of tiles which are shared
+     *        between copies.
+     * @details Copying a TiledLayer only copies the tile pointers, so a copy
+     *          costs O(tiles) rather than O(pixels). A tile is only duplicated
+     *          once it gets modified while still being shared with another
+     *          copy. Tiles which are entirely zero are never allocated.
+     *
+     * @par Every tile is stored row-major, with each row being exactly as wide
+     *      as the tile itself (so tiles along the right and bottom edges of the
+     *      layer may be smaller than TILE_SIZE).
+     */
+    class TiledLayer {
+        public:
+            //! The width and height of a single tile, in pixels
+            static constexpr uint32_t TILE_SIZE = 256;
+
+            TiledLayer();
+            TiledLayer(uint32_t, uint32_t, uint32_t);
+
+            TiledLayer(const TiledLayer&) = default;
+            TiledLayer(TiledLayer&&) = default;
+
+            TiledLayer& operator=(const TiledLayer&) = default;
+            TiledLayer& operator=(TiledLayer&&) = default;
+
+            uint32_t getWidth() const noexcept;
+            uint32_t getHeight() const noexcept;
+            uint32_t getBytesPerPixel() const noexcept;
+
+            uint32_t getTileCountX() const noexcept;
+            uint32_t getTileCountY() const noexcept;
+            uint32_t getTileCount() const noexcept;
+
+            Rectangle getTileRect(uint32_t) const noexcept;
+            uint32_t getTileByteSize(uint32_t) const noexcept;
+
+            const uint8_t* getTile(uint32_t) const noexcept;
+            uint8_t* getMutableTile(uint32_t);
+
+            bool isTileShared(uint32_t) const noexcept;
+            bool sharesTileWith(const TiledLayer&, uint32_t) const noexcept;
+
+            std::vector<uint32_t> getTilesInRect(const Rectangle&) const noexcept;
+
+            static uint32_t getTileCount(uint32_t, uint32_t) noexcept;
+            static std::vector<uint32_t> getTilesInRect(uint32_t, uint32_t,
+                                                        const Rectangle&) noexcept;
+
+            void captureTile(uint32_t, const uint8_t*);
+            void copyTileToBuffer(uint32_t, uint8_t*) const noexcept;
+
+            bool isTileDirty(uint32_t) const noexcept;
+            std::vector<uint32_t> getDirtyTiles() const noexcept;
+            std::vector<Rectangle> getDirtyRects() const noexcept;
+            void markTileDirty(uint32_t) noexcept;
+            void clearDirtyTiles() noexcept;
+
+            uint64_t getAllocatedBytes() const noexcept;
+
+        private:
+            using TilePtr = std::shared_ptr<uint8_t[]>;
+
+            //! The width of the layer in pixels
+            uint32_t m_width;
+
+            //! The height of the layer in pixels
+            uint32_t m_height;
+
+            //! How many bytes make up a single pixel
+            uint32_t m_bytes_per_pixel;
+
+            //! How many tiles there are horizontally
+            uint32_t m_tile_count_x;
+
+            //! How many tiles there are vertically
+            uint32_t m_tile_count_y;
+
+            //! Every tile, nullptr if the tile is entirely zero
+            std::vector<TilePtr> m_tiles;
+
+            //! Which tiles have been modified since the last clearDirtyTiles()
+            std::vector<bool> m_dirty;
+    };
+}
+
+#endif
+
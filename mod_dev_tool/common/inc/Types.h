@@ -109,6 +109,12 @@ namespace HMDT {
     using Continent = std::string;
     using StateID = std::uint32_t;
 
+    /**
+     * @brief A dense index for a province, as stored in the label matrix.
+     * @details Index 0 is never assigned to a province.
+     */
+    using ProvinceIndex = std::uint32_t;
+
     /**
      * @brief A province as HOI4 will recognize it.
      */
@@ -138,12 +144,6 @@ namespace HMDT {
      */
     using PolygonList = std::vector<Polygon>;
 
-
-    /**
-     * @brief A list of all provinces
-     */
-    using ProvinceList = std::unordered_map<ProvinceID, Province>;
-
     /**
      * @brief A state as HOI4 will recognize it.
      */
@@ -14,10 +14,14 @@
 # include <filesystem>
 # include <functional>
 # include <optional>
+# include <string_view>
 # include <thread>
 # include <future>
+# include <type_traits>
+# include <vector>
 
 # include "Types.h"
+# include "ProvinceList.h"
 # include "Logger.h"
 # include "PreprocessorUtils.h"
 # include "TypeTraits.h"
@@ -53,6 +57,12 @@ namespace HMDT {
     std::pair<uint32_t, uint32_t> calcDims(const BoundingBox&);
     std::pair<uint32_t, uint32_t> calcShapeDims(const Polygon&);
 
+    uint64_t estimateMemoryUsage(const PolygonList&) noexcept;
+
+    Rectangle toRectangle(const BoundingBox&);
+    bool doRectanglesIntersect(const Rectangle&, const Rectangle&);
+    Rectangle uniteRectangles(const Rectangle&, const Rectangle&);
+
     void ltrim(std::string&);
     void rtrim(std::string&);
     void trim(std::string&);
@@ -467,6 +477,9 @@ namespace HMDT {
 
     std::filesystem::path getExecutablePath();
 
+    Maybe<bool> writeFileIfChanged(const std::filesystem::path&,
+                                   std::string_view);
+
     void dumpBacktrace(FILE* = stderr, std::uint32_t = 63,
                        int tid = -1) noexcept;
 
@@ -593,6 +606,71 @@ namespace HMDT {
         }
     }
 
+    /**
+     * @brief Splits the range [0, count) into one contiguous chunk per
+     *        hardware thread, and calls func(begin, end) on every chunk in
+     *        parallel.
+     * @details Blocks until every chunk has been processed. func will be called
+     *          concurrently on disjoint chunks, so anything it writes outside
+     *          of its own chunk must be synchronized. If func throws, then the
+     *          exception is re-thrown here once every chunk has finished.
+     *
+     * @param count The number of elements to split up
+     * @param func The function to call on every chunk
+     *
+     * @return The result of func for every chunk, in order
+     */
+    template<typename Func>
+    auto parallelMapChunks(uint32_t count, Func&& func)
+        -> std::vector<std::invoke_result_t<Func&, uint32_t, uint32_t>>
+    {
+        using Result = std::invoke_result_t<Func&, uint32_t, uint32_t>;
+
+        uint32_t thread_count = std::max(1U, std::thread::hardware_concurrency());
+        thread_count = std::min(thread_count, count);
+
+        std::vector<Result> results;
+
+        if(thread_count <= 1) {
+            if(count != 0) {
+                results.push_back(func(0U, count));
+            }
+            return results;
+        }
+
+        auto step = count / thread_count;
+        auto remainder = count % thread_count;
+
+        std::vector<std::future<Result>> futures;
+        futures.reserve(thread_count);
+
+        uint32_t begin = 0;
+        for(uint32_t i = 0; i < thread_count; ++i) {
+            // Spread the remainder out over the first few chunks
+            uint32_t end = begin + step + (i < remainder ? 1 : 0);
+
+            futures.push_back(std::async(std::launch::async,
+                                         [&func, begin, end]() {
+                                             return func(begin, end);
+                                         }));
+
+            begin = end;
+        }
+
+        // Wait for every chunk first, so that no chunk is still running if
+        //   one of them throws
+        for(auto&& future : futures) {
+            future.wait();
+        }
+
+        results.reserve(thread_count);
+        for(auto&& future : futures) {
+            results.push_back(future.get());
+        }
+
+        return results;
+    }
+
     /**
      * @brief Joins a range of values together into a string.
      *
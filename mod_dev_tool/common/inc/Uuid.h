@@ -11,6 +11,7 @@
 # define HMDT_UUID_H
 
 # include <string>
+# include <string_view>
 # include <optional>
 
 extern "C" {
@@ -93,6 +94,7 @@ namespace HMDT {
             std::size_t hash() const noexcept;
 
             static Maybe<UUID> parse(const std::string&) noexcept;
+            static Maybe<UUID> fromChars(std::string_view) noexcept;
 
         private:
             SystemUUIDType m_internal_uuid;
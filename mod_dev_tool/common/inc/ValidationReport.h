@@ -0,0 +1,115 @@
+/**
+ * @file ValidationReport.h
+ *
+ * @brief Declares a report of every issue found while validating a project.
+ */
+
+#ifndef VALIDATION_REPORT_H
+# define VALIDATION_REPORT_H
+
+# include <cstddef>
+# include <optional>
+# include <sstream>
+# include <string>
+# include <system_error>
+# include <vector>
+
+# include "Types.h"
+
+namespace HMDT {
+    /**
+     * @brief Collects the issues found by a set of validators.
+     * @details Validators can each fill in their own report independently of
+     *          one another, after which the reports are merged together.
+     *          Issues which have been fixed are kept in the report, but no
+     *          longer count against it.
+     */
+    class ValidationReport {
+        public:
+            /**
+             * @brief How severe an issue is
+             */
+            enum class Severity {
+                //! The data is inconsistent, but can still be used
+                WARNING,
+
+                //! The data cannot be used until the issue is fixed
+                ERROR
+            };
+
+            /**
+             * @brief A single problem found by a validator
+             */
+            struct Issue {
+                Severity severity;
+
+                //! The name of the validator which found the issue
+                std::string validator;
+
+                //! The status code describing the issue
+                std::error_code code;
+
+                std::string message;
+
+                //! The province the issue is about, if any
+                std::optional<ProvinceID> province;
+
+                //! The state the issue is about, if any
+                std::optional<StateID> state;
+
+                //! The pixel the issue is about, if any
+                std::optional<Point2D> position;
+
+                //! Whether the issue has since been fixed
+                bool fixed = false;
+            };
+
+            ValidationReport() = default;
+
+            Issue& addIssue(Severity, const std::string&, std::error_code,
+                            const std::string&);
+
+            /**
+             * @brief Adds a new issue, building its message from every
+             *        argument in the same way as the logging macros.
+             *
+             * @param severity How severe the issue is
+             * @param validator The name of the validator which found the issue
+             * @param code The status code describing the issue
+             * @param args Every part of the message
+             *
+             * @return The new issue, so that the province, state or pixel it is
+             *         about may be filled in.
+             */
+            template<typename... Args>
+            Issue& addIssue(Severity severity, const std::string& validator,
+                            std::error_code code, const Args&... args)
+            {
+                std::stringstream ss;
+                (ss << ... << args);
+
+                return addIssue(severity, validator, code, ss.str());
+            }
+
+            void merge(ValidationReport&&);
+
+            const std::vector<Issue>& getIssues() const noexcept;
+            std::vector<Issue>& getIssues() noexcept;
+
+            size_t count(Severity) const noexcept;
+            size_t countFixed() const noexcept;
+
+            bool empty() const noexcept;
+            bool hasErrors() const noexcept;
+
+            std::string toString(size_t) const;
+            void writeToLog(size_t) const;
+
+        private:
+            //! Every issue, in the order they were found
+            std::vector<Issue> m_issues;
+    };
+}
+
+#endif
+
@@ -14,10 +14,13 @@
 namespace HMDT {
     struct BitMap;
     struct BitMap2;
+    struct Rectangle;
 
     [[deprecated]] void generateWorldNormalMap(BitMap*, unsigned char*);
 
     MaybeVoid generateWorldNormalMap(const BitMap2&, unsigned char*);
+    MaybeVoid generateWorldNormalMap(const BitMap2&, unsigned char*,
+                                     const Rectangle&);
 }
 
 #endif
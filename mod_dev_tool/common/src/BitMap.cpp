@@ -6,6 +6,7 @@
 
 #include "BitMap.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <cstddef>
 #include <cerrno>
@@ -983,3 +984,26 @@ std::ostream& HMDT::operator<<(std::ostream& stream, const HMDT::BitMap2& bm) {
     return stream;
 }
 
+
+/**
+ * @brief Estimates how many bytes a BitMap2 is holding onto.
+ *
+ * @param bmp The BitMap to check
+ *
+ * @return The size of the image data and color table, in bytes
+ */
+uint64_t HMDT::estimateMemoryUsage(const BitMap2& bmp) noexcept {
+    uint64_t bytes = sizeof(BitMap2);
+
+    if(bmp.data != nullptr) {
+        bytes += static_cast<uint64_t>(std::abs(bmp.info_header.v1.width)) *
+                 std::abs(bmp.info_header.v1.height) *
+                 (bmp.info_header.v1.bitsPerPixel / 8);
+    }
+
+    if(bmp.color_table != nullptr) {
+        bytes += bmp.info_header.v1.colorsUsed * sizeof(RGBQuad);
+    }
+
+    return bytes;
+}
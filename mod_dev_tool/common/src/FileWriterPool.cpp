@@ -0,0 +1,160 @@
+/**
+ * @file FileWriterPool.cpp
+ *
+ * @brief Defines a pool of threads which write files in the background.
+ */
+
+#include "FileWriterPool.h"
+
+#include <algorithm>
+
+#include "Constants.h"
+#include "Logger.h"
+#include "StatusCodes.h"
+#include "Util.h"
+
+/**
+ * @brief Creates a new pool and starts every worker.
+ *
+ * @param thread_count How many files may be written at once
+ * @param max_queued_requests How many files may wait to be written before
+ *                            write() starts blocking
+ */
+HMDT::FileWriterPool::FileWriterPool(size_t thread_count,
+                                     size_t max_queued_requests):
+    m_mutex(),
+    m_request_queued(),
+    m_request_taken(),
+    m_idle(),
+    m_requests(),
+    m_max_queued_requests(std::max<size_t>(1, max_queued_requests)),
+    m_active_requests(0),
+    m_written_count(0),
+    m_skipped_count(0),
+    m_first_error(),
+    m_stopping(false),
+    m_workers()
+{
+    thread_count = std::max<size_t>(1, thread_count);
+
+    m_workers.reserve(thread_count);
+    for(size_t i = 0; i < thread_count; ++i) {
+        m_workers.emplace_back(&FileWriterPool::runWorker, this);
+    }
+}
+
+HMDT::FileWriterPool::FileWriterPool():
+    FileWriterPool(MAX_FILE_WRITER_THREADS, MAX_QUEUED_FILE_WRITES)
+{ }
+
+/**
+ * @brief Finishes writing every queued file, then stops every worker.
+ */
+HMDT::FileWriterPool::~FileWriterPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_request_queued.notify_all();
+
+    for(auto&& worker : m_workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Queues up a file to be written, blocking if too many files are
+ *        already waiting.
+ *
+ * @param path The file to write
+ * @param contents What the file should hold
+ */
+void HMDT::FileWriterPool::write(const std::filesystem::path& path,
+                                 std::string contents)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_request_taken.wait(lock, [this]() {
+            return m_requests.size() < m_max_queued_requests;
+        });
+
+        m_requests.push_back(WriteRequest{ path, std::move(contents) });
+    }
+
+    m_request_queued.notify_one();
+}
+
+/**
+ * @brief Waits for every queued file to be written.
+ *
+ * @return The first error hit while writing any file since the last call to
+ *         wait(), or STATUS_SUCCESS if there was none.
+ */
+auto HMDT::FileWriterPool::wait() -> MaybeVoid {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() {
+        return m_requests.empty() && m_active_requests == 0;
+    });
+
+    auto error = m_first_error;
+    m_first_error.clear();
+
+    RETURN_ERROR_IF(error, error);
+
+    return STATUS_SUCCESS;
+}
+
+size_t HMDT::FileWriterPool::getWrittenCount() const noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written_count;
+}
+
+size_t HMDT::FileWriterPool::getSkippedCount() const noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_skipped_count;
+}
+
+/**
+ * @brief Writes queued files until the pool is stopped and nothing is left in
+ *        the queue.
+ */
+void HMDT::FileWriterPool::runWorker() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while(true) {
+        m_request_queued.wait(lock, [this]() {
+            return m_stopping || !m_requests.empty();
+        });
+
+        if(m_requests.empty()) {
+            // Only reachable once stopping, with nothing left to write
+            return;
+        }
+
+        auto request = std::move(m_requests.front());
+        m_requests.pop_front();
+        ++m_active_requests;
+
+        lock.unlock();
+        m_request_taken.notify_one();
+
+        auto result = writeFileIfChanged(request.path, request.contents);
+
+        lock.lock();
+        --m_active_requests;
+
+        if(IS_FAILURE(result)) {
+            if(!m_first_error) {
+                m_first_error = result.error();
+            }
+        } else if(*result) {
+            ++m_written_count;
+        } else {
+            ++m_skipped_count;
+        }
+
+        if(m_requests.empty() && m_active_requests == 0) {
+            m_idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,280 @@
+/**
+ * @file HeightMapPyramid.cpp
+ *
+ * @brief Defines a pyramid of ever smaller copies of the heightmap.
+ */
+
+#include "HeightMapPyramid.h"
+
+#include <algorithm>
+
+#include "BitMap.h"
+#include "MemoryReport.h"
+#include "StatusCodes.h"
+#include "Util.h"
+
+namespace {
+    /**
+     * @brief Averages every 2x2 block of the source into a single pixel of
+     *        the destination.
+     * @details If the source has an odd width or height, then the last column
+     *          or row of the destination only covers a single source column or
+     *          row, which is treated as if it were repeated.
+     *
+     * @param palette The height of every source value
+     * @param src The source level
+     * @param src_width The width of the source level
+     * @param src_height The height of the source level
+     * @param dest The destination level
+     * @param dest_width The width of the destination level
+     * @param begin_x The first destination column to write
+     * @param end_x One past the last destination column to write
+     * @param begin_y The first destination row to write
+     * @param end_y One past the last destination row to write
+     */
+    void downsampleArea(const HMDT::HeightMapPyramid::Palette& palette,
+                        const uint8_t* src, uint32_t src_width,
+                        uint32_t src_height, uint8_t* dest, uint32_t dest_width,
+                        uint32_t begin_x, uint32_t end_x,
+                        uint32_t begin_y, uint32_t end_y)
+    {
+        // Every column before this covers two full source columns
+        auto full_end_x = std::min(end_x, src_width / 2);
+
+        for(uint32_t y = begin_y; y < end_y; ++y) {
+            const auto* top = src + static_cast<size_t>(y) * 2 * src_width;
+            const auto* bottom = (y * 2 + 1 < src_height) ? top + src_width : top;
+            auto* out = dest + static_cast<size_t>(y) * dest_width;
+
+            uint32_t x = begin_x;
+            for(; x < full_end_x; ++x) {
+                out[x] = static_cast<uint8_t>((palette[top[x * 2]] +
+                                               palette[top[x * 2 + 1]] +
+                                               palette[bottom[x * 2]] +
+                                               palette[bottom[x * 2 + 1]] +
+                                               2) / 4);
+            }
+
+            for(; x < end_x; ++x) {
+                out[x] = static_cast<uint8_t>((palette[top[x * 2]] +
+                                               palette[bottom[x * 2]] + 1) / 2);
+            }
+        }
+    }
+
+    /**
+     * @brief Builds a palette where every value is its own height.
+     */
+    auto makeIdentityPalette() noexcept -> HMDT::HeightMapPyramid::Palette {
+        HMDT::HeightMapPyramid::Palette palette{ };
+        for(size_t i = 0; i < palette.size(); ++i) {
+            palette[i] = static_cast<uint8_t>(i);
+        }
+
+        return palette;
+    }
+
+    //! Every level past the first already holds heights
+    const HMDT::HeightMapPyramid::Palette IDENTITY_PALETTE = makeIdentityPalette();
+}
+
+/**
+ * @brief Resolves the height of every palette index of an 8-bit heightmap.
+ * @details Heights are the average of each color's channels, the same
+ *          intensity that the world normal map is built from. Indices past the
+ *          end of the color table are treated as black, and a heightmap
+ *          without a color table is treated as plain greyscale.
+ *
+ * @param heightmap The heightmap
+ *
+ * @return The height of every palette index.
+ */
+auto HMDT::HeightMapPyramid::makePalette(const BitMap2& heightmap) noexcept
+    -> Palette
+{
+    if(heightmap.color_table == nullptr) {
+        return IDENTITY_PALETTE;
+    }
+
+    Palette palette{ };
+    auto num_colors = std::min<size_t>(palette.size(),
+                                       heightmap.info_header.v1.colorsUsed);
+    for(size_t i = 0; i < num_colors; ++i) {
+        const auto& color = heightmap.color_table[i];
+        palette[i] = static_cast<uint8_t>((color.red + color.green + color.blue +
+                                           1) / 3);
+    }
+
+    return palette;
+}
+
+HMDT::HeightMapPyramid::HeightMapPyramid():
+    m_width(0),
+    m_height(0),
+    m_palette(IDENTITY_PALETTE),
+    m_levels()
+{ }
+
+/**
+ * @brief Rebuilds every level from a full resolution heightmap.
+ *
+ * @param data The 8-bit heightmap data
+ * @param width The width of the heightmap
+ * @param height The height of the heightmap
+ * @param palette The height of every value in the heightmap data
+ */
+void HMDT::HeightMapPyramid::build(const uint8_t* data, uint32_t width,
+                                   uint32_t height, const Palette& palette)
+{
+    clear();
+
+    if(data == nullptr || width == 0 || height == 0) return;
+
+    m_width = width;
+    m_height = height;
+    m_palette = palette;
+
+    const uint8_t* src = data;
+    const Palette* src_palette = &m_palette;
+    while(width > 1 || height > 1) {
+        Level level{ (width + 1) / 2, (height + 1) / 2, { } };
+        level.data.resize(static_cast<size_t>(level.width) * level.height);
+
+        parallelMapChunks(level.height, [&](uint32_t begin_y, uint32_t end_y) {
+            downsampleArea(*src_palette, src, width, height, level.data.data(),
+                           level.width, 0, level.width, begin_y, end_y);
+            return true;
+        });
+
+        width = level.width;
+        height = level.height;
+
+        // Moving the level keeps its data where it is
+        m_levels.push_back(std::move(level));
+        src = m_levels.back().data.data();
+        src_palette = &IDENTITY_PALETTE;
+    }
+}
+
+/**
+ * @brief Refreshes every level after an area of the heightmap has changed.
+ *
+ * @param data The full resolution heightmap data, which must still be the same
+ *             size and use the same palette as the pyramid was built from
+ * @param area The area of the heightmap which changed
+ */
+void HMDT::HeightMapPyramid::update(const uint8_t* data, const Rectangle& area)
+{
+    if(data == nullptr || area.x >= m_width || area.y >= m_height ||
+       area.w == 0 || area.h == 0)
+    {
+        return;
+    }
+
+    auto begin_x = area.x;
+    auto begin_y = area.y;
+    auto end_x = area.x + std::min(area.w, m_width - area.x);
+    auto end_y = area.y + std::min(area.h, m_height - area.y);
+
+    const uint8_t* src = data;
+    auto src_width = m_width;
+    auto src_height = m_height;
+    const Palette* src_palette = &m_palette;
+
+    for(auto&& level : m_levels) {
+        begin_x /= 2;
+        begin_y /= 2;
+        end_x = (end_x + 1) / 2;
+        end_y = (end_y + 1) / 2;
+
+        downsampleArea(*src_palette, src, src_width, src_height,
+                       level.data.data(), level.width, begin_x, end_x, begin_y,
+                       end_y);
+
+        src = level.data.data();
+        src_palette = &IDENTITY_PALETTE;
+        src_width = level.width;
+        src_height = level.height;
+    }
+}
+
+void HMDT::HeightMapPyramid::clear() noexcept {
+    m_width = 0;
+    m_height = 0;
+    m_palette = IDENTITY_PALETTE;
+    m_levels.clear();
+}
+
+uint32_t HMDT::HeightMapPyramid::getWidth() const noexcept {
+    return m_width;
+}
+
+uint32_t HMDT::HeightMapPyramid::getHeight() const noexcept {
+    return m_height;
+}
+
+auto HMDT::HeightMapPyramid::getPalette() const noexcept -> const Palette& {
+    return m_palette;
+}
+
+size_t HMDT::HeightMapPyramid::getLevelCount() const noexcept {
+    return m_levels.size();
+}
+
+/**
+ * @brief Gets a single level of the pyramid.
+ *
+ * @param index The level to get, where 0 is half of the full resolution
+ *
+ * @return The level, or STATUS_OUT_OF_RANGE if there is no such level.
+ */
+auto HMDT::HeightMapPyramid::getLevel(size_t index) const noexcept
+    -> MaybeRef<const Level>
+{
+    if(index >= m_levels.size()) {
+        RETURN_ERROR(STATUS_OUT_OF_RANGE);
+    }
+
+    return std::ref(m_levels[index]);
+}
+
+/**
+ * @brief Finds the smallest level which is still at least a given size.
+ * @details Anything drawing the heightmap at a given size only needs to read
+ *          from this level, rather than from the full resolution heightmap.
+ *
+ * @param min_width The smallest width the level may have
+ * @param min_height The smallest height the level may have
+ *
+ * @return The level, or STATUS_VALUE_NOT_FOUND if even the largest level is
+ *         too small, in which case the full resolution heightmap is needed.
+ */
+auto HMDT::HeightMapPyramid::findLevel(uint32_t min_width,
+                                       uint32_t min_height) const noexcept
+    -> MaybeRef<const Level>
+{
+    auto it = std::find_if(m_levels.rbegin(), m_levels.rend(),
+                           [min_width, min_height](const Level& level) {
+                               return level.width >= min_width &&
+                                      level.height >= min_height;
+                           });
+
+    if(it == m_levels.rend()) {
+        RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
+    }
+
+    return std::ref(*it);
+}
+
+/**
+ * @brief Estimates the memory held by a HeightMapPyramid.
+ */
+uint64_t HMDT::estimateMemoryUsage(const HeightMapPyramid& pyramid) noexcept {
+    uint64_t bytes = estimateMemoryUsage(pyramid.m_levels);
+
+    for(auto&& level : pyramid.m_levels) {
+        bytes += estimateMemoryUsage(level.data);
+    }
+
+    return bytes;
+}
@@ -1,55 +1,106 @@
 #include "MapData.h"
 
+#include <algorithm>
+
+#include "Logger.h"
+
 #include "Util.h"
+#include "Constants.h"
 
 HMDT::MapData::MapData():
     m_width(0),
     m_height(0),
     m_input(nullptr),
-    m_provinces(nullptr),
+    m_province_colors(nullptr),
     m_province_outlines(nullptr),
     m_cities(nullptr),
     m_label_matrix(nullptr),
     m_state_id_matrix(nullptr),
+    m_state_outlines(nullptr),
     m_heightmap(nullptr),
     m_rivers(nullptr),
-    m_closed(false),
-    m_state_id_matrix_updated_tag(0)
+    m_layer_loaders(),
+    m_layer_releasers(),
+    m_layer_load_flags(),
+    m_layer_leases(),
+    m_layer_changes(),
+    m_layer_mutex(new std::recursive_mutex),
+    m_closed(false)
 {
-}
-
+    for(auto& leases : m_layer_leases) {
+        leases = std::make_shared<std::atomic<uint32_t>>(0);
+    }
+}
+
+/**
+ * @brief Creates a new MapData of the given size.
+ * @details No layers are allocated here, each one gets allocated the first
+ *          time it is accessed.
+ *
+ * @param width The width of the map
+ * @param height The height of the map
+ */
 HMDT::MapData::MapData(uint32_t width, uint32_t height):
     m_width(width),
     m_height(height),
-    m_input(new uint8_t[getInputSize()]{ 0 }),
-    m_provinces(new UUID[getProvincesSize()]{ EMPTY_UUID }),
-    m_province_colors(new uint8_t[getProvinceColorsSize()]{ 0 }),
-    m_province_outlines(new uint8_t[getProvinceOutlinesSize()]{ 0 }),
-    m_cities(new uint8_t[getCitiesSize()]{ 0 }),
-    m_label_matrix(new uint32_t[getMatrixSize()]{ 0 }),
-    m_state_id_matrix(new uint32_t[getMatrixSize()]{ 0 }),
-    m_heightmap(new uint8_t[getHeightMapSize()]{ 0 }),
-    m_rivers(new uint8_t[getRiversSize()]{ 0 }),
-    m_closed(false),
-    m_state_id_matrix_updated_tag(0)
+    m_input(nullptr),
+    m_province_colors(nullptr),
+    m_province_outlines(nullptr),
+    m_cities(nullptr),
+    m_label_matrix(nullptr),
+    m_state_id_matrix(nullptr),
+    m_state_outlines(nullptr),
+    m_heightmap(nullptr),
+    m_rivers(nullptr),
+    m_layer_loaders(),
+    m_layer_releasers(),
+    m_layer_load_flags(),
+    m_layer_leases(),
+    m_layer_changes(),
+    m_layer_mutex(new std::recursive_mutex),
+    m_closed(false)
 {
+    for(auto& leases : m_layer_leases) {
+        leases = std::make_shared<std::atomic<uint32_t>>(0);
+    }
 }
 
 HMDT::MapData::MapData(const MapData* other):
     m_width(other->m_width),
     m_height(other->m_height),
     m_input(other->m_input),
-    m_provinces(other->m_provinces),
     m_province_colors(other->m_province_colors),
     m_province_outlines(other->m_province_outlines),
     m_cities(other->m_cities),
     m_label_matrix(other->m_label_matrix),
     m_state_id_matrix(other->m_state_id_matrix),
+    m_state_outlines(other->m_state_outlines),
     m_heightmap(other->m_heightmap),
     m_rivers(other->m_rivers),
-    m_closed(other->m_closed),
-    m_state_id_matrix_updated_tag(other->m_state_id_matrix_updated_tag)
+    m_layer_loaders(),
+    m_layer_releasers(),
+    m_layer_load_flags(),
+    m_layer_leases(),
+    m_layer_changes(),
+    m_layer_mutex(new std::recursive_mutex),
+    m_closed(other->m_closed)
 {
+    std::copy(std::begin(other->m_layer_loaders),
+              std::end(other->m_layer_loaders),
+              std::begin(m_layer_loaders));
+    std::copy(std::begin(other->m_layer_releasers),
+              std::end(other->m_layer_releasers),
+              std::begin(m_layer_releasers));
+    std::copy(std::begin(other->m_layer_load_flags),
+              std::end(other->m_layer_load_flags),
+              std::begin(m_layer_load_flags));
+    std::copy(std::begin(other->m_layer_changes),
+              std::end(other->m_layer_changes),
+              std::begin(m_layer_changes));
+
+    for(auto& leases : m_layer_leases) {
+        leases = std::make_shared<std::atomic<uint32_t>>(0);
+    }
 }
 
 void HMDT::MapData::close() {
@@ -72,10 +123,6 @@ uint32_t HMDT::MapData::getInputSize() const {
     return m_width * m_height * 3;
 }
 
-uint32_t HMDT::MapData::getProvincesSize() const {
-    return m_width * m_height;
-}
-
 uint32_t HMDT::MapData::getProvinceColorsSize() const {
     return m_width * m_height * 3;
 }
@@ -92,6 +139,10 @@ uint32_t HMDT::MapData::getMatrixSize() const {
     return m_width * m_height;
 }
 
+uint32_t HMDT::MapData::getStateOutlinesSize() const {
+    return m_width * m_height;
+}
+
 uint32_t HMDT::MapData::getHeightMapSize() const {
     return m_width * m_height;
 }
@@ -104,99 +155,729 @@ bool HMDT::MapData::isClosed() const {
     return m_closed;
 }
 
+/**
+ * @brief Checks if a layer is currently allocated in memory
+ *
+ * @param layer The layer to check
+ *
+ * @return True if the layer is allocated, false otherwise
+ */
+bool HMDT::MapData::isLayerResident(Layer layer) const {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    switch(layer) {
+        case Layer::INPUT:
+            return m_input != nullptr;
+        case Layer::PROVINCE_COLORS:
+            return m_province_colors != nullptr;
+        case Layer::PROVINCE_OUTLINES:
+            return m_province_outlines != nullptr;
+        case Layer::CITIES:
+            return m_cities != nullptr;
+        case Layer::LABEL_MATRIX:
+            return m_label_matrix != nullptr;
+        case Layer::STATE_ID_MATRIX:
+            return m_state_id_matrix != nullptr;
+        case Layer::STATE_OUTLINES:
+            return m_state_outlines != nullptr;
+        case Layer::HEIGHTMAP:
+            return m_heightmap != nullptr;
+        case Layer::RIVERS:
+            return m_rivers != nullptr;
+        case Layer::COUNT:
+            break;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Registers a loader for a layer.
+ * @details The loader is called every time the layer gets (re-)allocated, and
+ *          should fill in the layer by way of the normal accessors. It is
+ *          called without holding any lock of MapData, and other threads
+ *          accessing the layer in the meantime wait until it has finished.
+ *          A layer with a loader is also allowed to be released by
+ *          releaseUnusedLayers(), as it can always be loaded again.
+ *
+ * @param layer The layer to register the loader for
+ * @param loader The loader to register. Pass an empty function to unregister.
+ * @param releaser Called after the layer has been released, so that whatever
+ *                 the loader reads from can be released as well. Optional.
+ */
+void HMDT::MapData::setLayerLoader(Layer layer,
+                                   const LayerLoaderCallback& loader,
+                                   const LayerReleaseCallback& releaser)
+{
+    if(layer == Layer::COUNT) return;
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+    m_layer_loaders[static_cast<size_t>(layer)] = loader;
+    m_layer_releasers[static_cast<size_t>(layer)] = releaser;
+}
+
+/**
+ * @brief Unregisters every layer loader. Must be called before anything the
+ *        loaders refer to is destroyed.
+ */
+void HMDT::MapData::clearLayerLoaders() {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    for(auto& loader : m_layer_loaders) {
+        loader = nullptr;
+    }
+
+    for(auto& releaser : m_layer_releasers) {
+        releaser = nullptr;
+    }
+}
+
+/**
+ * @brief Takes out a lease on a layer, which keeps releaseUnusedLayers() from
+ *        releasing it until the lease is destroyed.
+ * @details This does not allocate the layer.
+ *
+ * @param layer The layer to lease
+ *
+ * @return The lease, which is empty if the layer is invalid
+ */
+auto HMDT::MapData::leaseLayer(Layer layer) const -> LayerLease {
+    if(layer == Layer::COUNT) return LayerLease{};
+
+    // Taken under the lock so that the layer cannot get released in between
+    //  checking the lease count and the lease being taken
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    return LayerLease{m_layer_leases[static_cast<size_t>(layer)]};
+}
+
+/**
+ * @brief Frees every layer which can be re-loaded on demand and which is
+ *        neither leased nor currently locked by anything outside of MapData.
+ * @details The release callback of every freed layer is called after the
+ *          lock has been let go of.
+ *
+ * @return The number of bytes that were freed
+ */
+uint64_t HMDT::MapData::releaseUnusedLayers() {
+    uint64_t bytes_freed = 0;
+    std::vector<LayerReleaseCallback> releasers;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+        auto release = [this, &bytes_freed, &releasers](auto& layer,
+                                                        Layer layer_id,
+                                                        uint64_t size)
+        {
+            auto index = static_cast<size_t>(layer_id);
+
+            // Anything which still has the layer locked right now is also
+            //  still using it, even without a lease
+            if(layer != nullptr && *m_layer_leases[index] == 0 &&
+               layer.use_count() == 1 && m_layer_loaders[index])
+            {
+                layer.reset();
+                m_layer_load_flags[index].reset();
+                bytes_freed += size;
+
+                if(m_layer_releasers[index]) {
+                    releasers.push_back(m_layer_releasers[index]);
+                }
+            }
+        };
+
+        release(m_input, Layer::INPUT, getInputSize());
+        release(m_province_colors, Layer::PROVINCE_COLORS, getProvinceColorsSize());
+        release(m_province_outlines, Layer::PROVINCE_OUTLINES, getProvinceOutlinesSize());
+        release(m_cities, Layer::CITIES, getCitiesSize());
+        release(m_label_matrix, Layer::LABEL_MATRIX, getMatrixSize() * sizeof(uint32_t));
+        release(m_state_id_matrix, Layer::STATE_ID_MATRIX, getMatrixSize() * sizeof(uint32_t));
+        release(m_state_outlines, Layer::STATE_OUTLINES, getStateOutlinesSize());
+        release(m_heightmap, Layer::HEIGHTMAP, getHeightMapSize());
+        release(m_rivers, Layer::RIVERS, getRiversSize());
+    }
+
+    if(bytes_freed != 0) {
+        WRITE_DEBUG("Released ", bytes_freed, " bytes of unused map layers.");
+    }
+
+    // The release callbacks may need to take locks of their own, which the
+    //  loaders hold while accessing MapData
+    for(auto&& releaser : releasers) {
+        releaser();
+    }
+
+    return bytes_freed;
+}
+
+/**
+ * @brief Gets a layer, allocating and loading it first if it is not yet in
+ *        memory.
+ *
+ * @param layer The layer pointer
+ * @param layer_id Which layer is being accessed
+ * @param size The number of elements in the layer
+ *
+ * @return The layer. May be nullptr if there is no map or allocation failed.
+ */
+template<typename T>
+auto HMDT::MapData::getOrAllocateLayer(std::shared_ptr<T[]>& layer,
+                                       Layer layer_id,
+                                       uint32_t size) const
+    -> std::shared_ptr<T[]>
+{
+    // Every load which is currently running on this thread. The loaders access
+    //  their layer through the regular accessors, which must not wait on the
+    //  load that they are a part of.
+    static thread_local std::vector<const std::once_flag*> running_loads;
+
+    auto index = static_cast<size_t>(layer_id);
+
+    std::shared_ptr<T[]> result;
+    std::shared_ptr<std::once_flag> load_flag;
+    LayerLoaderCallback loader;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+        if(layer == nullptr && size != 0) {
+            try {
+                layer.reset(new T[size]());
+            } catch(const std::bad_alloc& e) {
+                WRITE_ERROR("Failed to allocate ", size * sizeof(T),
+                            " bytes for map layer ",
+                            static_cast<uint32_t>(layer_id), ": ", e.what());
+                return nullptr;
+            }
+
+            if(m_layer_loaders[index]) {
+                m_layer_load_flags[index] = std::make_shared<std::once_flag>();
+            }
+        }
+
+        result = layer;
+        load_flag = m_layer_load_flags[index];
+        loader = m_layer_loaders[index];
+    }
+
+    // The layer is already assigned, so the loader is free to access it
+    //  through the regular accessors
+    if(load_flag != nullptr && loader &&
+       std::find(running_loads.begin(), running_loads.end(),
+                 load_flag.get()) == running_loads.end())
+    {
+        std::call_once(*load_flag, [&]() {
+            WRITE_DEBUG("Loading map layer ", static_cast<uint32_t>(layer_id),
+                        " on first access.");
+
+            running_loads.push_back(load_flag.get());
+            loader();
+            running_loads.pop_back();
+        });
+    }
+
+    return result;
+}
+
+/**
+ * @brief Releases the lease.
+ */
+HMDT::MapData::LayerLease::~LayerLease() {
+    if(m_count != nullptr) {
+        --*m_count;
+    }
+}
+
+/**
+ * @brief Releases the currently held lease, and takes over another one.
+ */
+auto HMDT::MapData::LayerLease::operator=(LayerLease&& other) -> LayerLease& {
+    if(this != &other) {
+        if(m_count != nullptr) {
+            --*m_count;
+        }
+
+        m_count = std::move(other.m_count);
+    }
+
+    return *this;
+}
+
+/**
+ * @brief Checks if this lease is actually held on a layer.
+ */
+HMDT::MapData::LayerLease::operator bool() const noexcept {
+    return m_count != nullptr;
+}
+
+HMDT::MapData::LayerLease::LayerLease(std::shared_ptr<std::atomic<uint32_t>> count):
+    m_count(count)
+{
+    ++*m_count;
+}
+
+/**
+ * @brief Takes a snapshot of every tile of a layer which has been marked dirty
+ *        since the previous call to this function.
+ * @details The dirty tiles of the returned snapshot are exactly the tiles it
+ *          holds, no other tile is part of the snapshot.
+ *
+ * @param layer The layer to snapshot
+ *
+ * @return The snapshot, or nullptr if the layer could not be allocated
+ */
+auto HMDT::MapData::snapshotLayer(Layer layer)
+    -> std::shared_ptr<const TiledLayer>
+{
+    if(layer == Layer::COUNT) return nullptr;
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    auto& dirty_tiles = m_layer_changes[static_cast<size_t>(layer)].dirty_tiles;
+
+    std::vector<uint32_t> tiles;
+    for(uint32_t tile = 0; tile < dirty_tiles.size(); ++tile) {
+        if(dirty_tiles[tile]) {
+            tiles.push_back(tile);
+        }
+    }
+
+    auto snapshot = snapshotTiles(layer, tiles);
+    if(snapshot != nullptr) {
+        dirty_tiles.assign(dirty_tiles.size(), false);
+    }
+
+    return snapshot;
+}
+
+/**
+ * @brief Takes a snapshot of every tile of a layer which overlaps an area.
+ * @details This is meant to be used right before and after modifying that
+ *          area, so that the modification can be undone and redone with
+ *          restoreLayer(). Which tiles are marked dirty is not changed.
+ *
+ * @param layer The layer to snapshot
+ * @param area The area of the layer to snapshot
+ *
+ * @return The snapshot, or nullptr if the layer could not be allocated
+ */
+auto HMDT::MapData::snapshotLayer(Layer layer, const Rectangle& area) const
+    -> std::shared_ptr<const TiledLayer>
+{
+    if(layer == Layer::COUNT) return nullptr;
+
+    return snapshotTiles(layer,
+                         TiledLayer::getTilesInRect(m_width, m_height, area));
+}
+
+/**
+ * @brief Restores a layer from a snapshot.
+ * @details Only the tiles held by the snapshot (its dirty tiles) are written
+ *          back, and each of them is marked dirty.
+ *
+ * @param layer The layer to restore
+ * @param snapshot The snapshot to restore from
+ *
+ * @return True if the layer was restored, false if the snapshot does not match
+ *         the layer.
+ */
+bool HMDT::MapData::restoreLayer(Layer layer, const TiledLayer& snapshot) {
+    if(layer == Layer::COUNT) return false;
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    if(snapshot.getWidth() != m_width || snapshot.getHeight() != m_height ||
+       snapshot.getBytesPerPixel() != getLayerBytesPerPixel(layer))
+    {
+        WRITE_ERROR("Snapshot (", snapshot.getWidth(), 'x', snapshot.getHeight(),
+                    'x', snapshot.getBytesPerPixel(), ") does not match map layer ",
+                    static_cast<uint32_t>(layer), '.');
+        return false;
+    }
+
+    auto data = getLayerBytes(layer);
+    if(data == nullptr) {
+        return false;
+    }
+
+    auto tiles = snapshot.getDirtyTiles();
+    for(auto&& tile : tiles) {
+        snapshot.copyTileToBuffer(tile, data.get());
+        markLayerDirty(layer, snapshot.getTileRect(tile));
+    }
+
+    WRITE_DEBUG("Restored ", tiles.size(), '/', snapshot.getTileCount(),
+                " tiles of map layer ", static_cast<uint32_t>(layer), '.');
+
+    return true;
+}
+
+/**
+ * @brief Copies the given tiles of a layer into a new snapshot.
+ *
+ * @param layer The layer to snapshot
+ * @param tiles The index of every tile to copy
+ *
+ * @return The snapshot, or nullptr if the layer could not be allocated
+ */
+auto HMDT::MapData::snapshotTiles(Layer layer,
+                                  const std::vector<uint32_t>& tiles) const
+    -> std::shared_ptr<const TiledLayer>
+{
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    auto data = getLayerBytes(layer);
+    if(data == nullptr) {
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<TiledLayer>(m_width, m_height,
+                                                 getLayerBytesPerPixel(layer));
+    for(auto&& tile : tiles) {
+        snapshot->captureTile(tile, data.get());
+    }
+
+    WRITE_DEBUG("Snapshot of map layer ", static_cast<uint32_t>(layer),
+                " copied ", tiles.size(), '/', snapshot->getTileCount(),
+                " tiles.");
+
+    return snapshot;
+}
+
+/**
+ * @brief Gets the current generation of a layer, which is incremented every
+ *        time the layer is marked as dirty.
+ *
+ * @param layer The layer
+ */
+uint64_t HMDT::MapData::getLayerGeneration(Layer layer) const {
+    if(layer == Layer::COUNT) return 0;
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+    return m_layer_changes[static_cast<size_t>(layer)].generation;
+}
+
+/**
+ * @brief Marks an entire layer as changed.
+ * @details Every reader will have to refresh the entire layer.
+ *
+ * @param layer The layer which was changed
+ */
+void HMDT::MapData::markLayerDirty(Layer layer) {
+    if(layer == Layer::COUNT) return;
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    auto& change_log = m_layer_changes[static_cast<size_t>(layer)];
+    ++change_log.generation;
+
+    // There is no point in remembering anything older, as it has all been
+    //  overwritten
+    change_log.changes.clear();
+    change_log.changes.push_back({change_log.generation,
+                                  Rectangle{0, 0, m_width, m_height}});
+    change_log.oldest_generation = change_log.generation - 1;
+
+    change_log.dirty_tiles.assign(TiledLayer::getTileCount(m_width, m_height),
+                                  true);
+}
+
+/**
+ * @brief Marks an area of a layer as changed.
+ *
+ * @param layer The layer which was changed
+ * @param area The area of the layer which was changed
+ */
+void HMDT::MapData::markLayerDirty(Layer layer, const Rectangle& area) {
+    if(layer == Layer::COUNT) return;
+
+    // Clamp the area to the map, and skip it entirely if nothing is left
+    if(area.x >= m_width || area.y >= m_height || area.w == 0 || area.h == 0) {
+        return;
+    }
+
+    Rectangle clamped{ area.x, area.y,
+                       std::min(area.w, m_width - area.x),
+                       std::min(area.h, m_height - area.y) };
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    auto& change_log = m_layer_changes[static_cast<size_t>(layer)];
+    ++change_log.generation;
+
+    change_log.changes.push_back({change_log.generation, clamped});
+
+    if(change_log.changes.size() > MAX_LAYER_CHANGE_HISTORY) {
+        change_log.oldest_generation = change_log.changes.front().first;
+        change_log.changes.pop_front();
+    }
+
+    change_log.dirty_tiles.resize(TiledLayer::getTileCount(m_width, m_height),
+                                  false);
+    for(auto&& tile : TiledLayer::getTilesInRect(m_width, m_height, clamped)) {
+        change_log.dirty_tiles[tile] = true;
+    }
+}
+
+/**
+ * @brief Gets every area of a layer which has changed since a given generation
+ *
+ * @param layer The layer
+ * @param generation The last generation of the layer which the caller has seen
+ *
+ * @return Every changed area (which may overlap), or std::nullopt if the
+ *         changes since that generation are no longer known and the caller
+ *         must refresh the entire layer.
+ */
+auto HMDT::MapData::getLayerChangesSince(Layer layer, uint64_t generation) const
+    -> std::optional<std::vector<Rectangle>>
+{
+    if(layer == Layer::COUNT) return std::nullopt;
+
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    const auto& change_log = m_layer_changes[static_cast<size_t>(layer)];
+
+    if(generation < change_log.oldest_generation ||
+       generation > change_log.generation)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<Rectangle> changes;
+    for(auto&& [change_generation, area] : change_log.changes) {
+        if(change_generation > generation) {
+            changes.push_back(area);
+        }
+    }
+
+    return changes;
+}
+
+/**
+ * @brief Reports how much memory every layer is currently using.
+ * @details Layers which have not been allocated yet are reported as 0 bytes.
+ *
+ * @param report The report to add every layer to
+ */
+void HMDT::MapData::reportMemoryUsage(MemoryReport& report) const {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
+
+    auto& layers_report = report.addChild("Layers");
+    auto& changes_report = report.addChild("Change History");
+
+    for(size_t i = 0; i < static_cast<size_t>(Layer::COUNT); ++i) {
+        auto layer = static_cast<Layer>(i);
+
+        uint64_t layer_bytes = 0;
+        if(isLayerResident(layer)) {
+            layer_bytes = static_cast<uint64_t>(m_width) * m_height *
+                          getLayerBytesPerPixel(layer);
+        }
+        layers_report.addChild(getLayerName(layer), layer_bytes);
+
+        changes_report.addBytes(m_layer_changes[i].changes.size() *
+                                sizeof(decltype(m_layer_changes[i].changes)::value_type) +
+                                m_layer_changes[i].dirty_tiles.size() / 8);
+    }
+}
+
+/**
+ * @brief Gets a human-readable name for a layer
+ *
+ * @param layer The layer
+ */
+const char* HMDT::MapData::getLayerName(Layer layer) noexcept {
+    switch(layer) {
+        case Layer::INPUT:
+            return "Input";
+        case Layer::PROVINCE_COLORS:
+            return "Province Colors";
+        case Layer::PROVINCE_OUTLINES:
+            return "Province Outlines";
+        case Layer::CITIES:
+            return "Cities";
+        case Layer::LABEL_MATRIX:
+            return "Label Matrix";
+        case Layer::STATE_ID_MATRIX:
+            return "State ID Matrix";
+        case Layer::STATE_OUTLINES:
+            return "State Outlines";
+        case Layer::HEIGHTMAP:
+            return "HeightMap";
+        case Layer::RIVERS:
+            return "Rivers";
+        case Layer::COUNT:
+            break;
+    }
+
+    return "Unknown";
+}
+
+/**
+ * @brief Gets the raw bytes of a layer, allocating it if necessary.
+ *
+ * @param layer The layer to get
+ *
+ * @return The bytes of the layer, which share ownership with the layer itself
+ */
+auto HMDT::MapData::getLayerBytes(Layer layer) const
+    -> std::shared_ptr<uint8_t[]>
+{
+    auto as_bytes = [](auto&& ptr) -> std::shared_ptr<uint8_t[]> {
+        return std::shared_ptr<uint8_t[]>(ptr,
+                                          reinterpret_cast<uint8_t*>(ptr.get()));
+    };
+
+    switch(layer) {
+        case Layer::INPUT:
+            return getOrAllocateLayer(m_input, layer, getInputSize());
+        case Layer::PROVINCE_COLORS:
+            return getOrAllocateLayer(m_province_colors, layer, getProvinceColorsSize());
+        case Layer::PROVINCE_OUTLINES:
+            return getOrAllocateLayer(m_province_outlines, layer, getProvinceOutlinesSize());
+        case Layer::CITIES:
+            return getOrAllocateLayer(m_cities, layer, getCitiesSize());
+        case Layer::LABEL_MATRIX:
+            return as_bytes(getOrAllocateLayer(m_label_matrix, layer, getMatrixSize()));
+        case Layer::STATE_ID_MATRIX:
+            return as_bytes(getOrAllocateLayer(m_state_id_matrix, layer, getMatrixSize()));
+        case Layer::STATE_OUTLINES:
+            return getOrAllocateLayer(m_state_outlines, layer, getStateOutlinesSize());
+        case Layer::HEIGHTMAP:
+            return getOrAllocateLayer(m_heightmap, layer, getHeightMapSize());
+        case Layer::RIVERS:
+            return getOrAllocateLayer(m_rivers, layer, getRiversSize());
+        case Layer::COUNT:
+            break;
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Gets how many bytes make up a single pixel of a layer
+ *
+ * @param layer The layer
+ */
+uint32_t HMDT::MapData::getLayerBytesPerPixel(Layer layer) const {
+    switch(layer) {
+        case Layer::INPUT:
+        case Layer::PROVINCE_COLORS:
+        case Layer::CITIES:
+            return 3;
+        case Layer::PROVINCE_OUTLINES:
+            return 4;
+        case Layer::LABEL_MATRIX:
+        case Layer::STATE_ID_MATRIX:
+            return sizeof(uint32_t);
+        case Layer::STATE_OUTLINES:
+        case Layer::HEIGHTMAP:
+        case Layer::RIVERS:
+            return 1;
+        case Layer::COUNT:
+            break;
+    }
+
+    return 0;
+}
+
 void HMDT::MapData::setLabelMatrix(uint32_t label_matrix[]) {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
     m_label_matrix.reset(label_matrix);
+    markLayerDirty(Layer::LABEL_MATRIX);
 }
 
 void HMDT::MapData::setLabelMatrix(InternalMapType32 label_matrix) {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
     m_label_matrix = label_matrix;
+    markLayerDirty(Layer::LABEL_MATRIX);
 }
 
 void HMDT::MapData::setStateIDMatrix(uint32_t state_id_matrix[]) {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
     m_state_id_matrix.reset(state_id_matrix);
-    ++m_state_id_matrix_updated_tag;
+    markLayerDirty(Layer::STATE_ID_MATRIX);
 }
 
 void HMDT::MapData::setStateIDMatrix(InternalMapType32 state_id_matrix) {
+    std::lock_guard<std::recursive_mutex> lock(*m_layer_mutex);
     m_state_id_matrix = state_id_matrix;
-    ++m_state_id_matrix_updated_tag;
+    markLayerDirty(Layer::STATE_ID_MATRIX);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 auto HMDT::MapData::getInput() -> MapType {
-    return m_input;
+    return getOrAllocateLayer(m_input, Layer::INPUT, getInputSize());
 }
 
 auto HMDT::MapData::getInput() const -> ConstMapType {
-    return m_input;
-}
-
-auto HMDT::MapData::getProvinces() -> MapTypeUUID {
-    return m_provinces;
-}
-
-auto HMDT::MapData::getProvinces() const -> ConstMapTypeUUID {
-    return m_provinces;
+    return getOrAllocateLayer(m_input, Layer::INPUT, getInputSize());
 }
 
 auto HMDT::MapData::getProvinceColors() -> MapType {
-    return m_province_colors;
+    return getOrAllocateLayer(m_province_colors, Layer::PROVINCE_COLORS, getProvinceColorsSize());
 }
 
 auto HMDT::MapData::getProvinceColors() const -> ConstMapType {
-    return m_province_colors;
+    return getOrAllocateLayer(m_province_colors, Layer::PROVINCE_COLORS, getProvinceColorsSize());
 }
 
 auto HMDT::MapData::getProvinceOutlines() -> MapType {
-    return m_province_outlines;
+    return getOrAllocateLayer(m_province_outlines, Layer::PROVINCE_OUTLINES, getProvinceOutlinesSize());
 }
 
 auto HMDT::MapData::getProvinceOutlines() const -> ConstMapType {
-    return m_province_outlines;
+    return getOrAllocateLayer(m_province_outlines, Layer::PROVINCE_OUTLINES, getProvinceOutlinesSize());
 }
 
 auto HMDT::MapData::getCities() -> MapType {
-    return m_cities;
+    return getOrAllocateLayer(m_cities, Layer::CITIES, getCitiesSize());
 }
 
 auto HMDT::MapData::getCities() const -> ConstMapType {
-    return m_cities;
+    return getOrAllocateLayer(m_cities, Layer::CITIES, getCitiesSize());
 }
 
 auto HMDT::MapData::getLabelMatrix() -> MapType32 {
-    return m_label_matrix;
+    return getOrAllocateLayer(m_label_matrix, Layer::LABEL_MATRIX, getMatrixSize());
 }
 
 auto HMDT::MapData::getLabelMatrix() const -> ConstMapType32 {
-    return m_label_matrix;
+    return getOrAllocateLayer(m_label_matrix, Layer::LABEL_MATRIX, getMatrixSize());
 }
 
 auto HMDT::MapData::getStateIDMatrix() -> MapType32 {
-    return m_state_id_matrix;
+    return getOrAllocateLayer(m_state_id_matrix, Layer::STATE_ID_MATRIX, getMatrixSize());
 }
 
 auto HMDT::MapData::getStateIDMatrix() const -> ConstMapType32 {
-    return m_state_id_matrix;
+    return getOrAllocateLayer(m_state_id_matrix, Layer::STATE_ID_MATRIX, getMatrixSize());
+}
+
+auto HMDT::MapData::getStateOutlines() -> MapType {
+    return getOrAllocateLayer(m_state_outlines, Layer::STATE_OUTLINES, getStateOutlinesSize());
 }
 
-uint32_t HMDT::MapData::getStateIDMatrixUpdatedTag() const {
-    return m_state_id_matrix_updated_tag;
+auto HMDT::MapData::getStateOutlines() const -> ConstMapType {
+    return getOrAllocateLayer(m_state_outlines, Layer::STATE_OUTLINES, getStateOutlinesSize());
 }
 
 HMDT::MapData::MapType HMDT::MapData::getHeightMap() {
-    return m_heightmap;
+    return getOrAllocateLayer(m_heightmap, Layer::HEIGHTMAP, getHeightMapSize());
 }
 
 HMDT::MapData::ConstMapType HMDT::MapData::getHeightMap() const {
-    return m_heightmap;
+    return getOrAllocateLayer(m_heightmap, Layer::HEIGHTMAP, getHeightMapSize());
 }
 
 HMDT::MapData::MapType HMDT::MapData::getRivers() {
-    return m_rivers;
+    return getOrAllocateLayer(m_rivers, Layer::RIVERS, getRiversSize());
 }
 
 HMDT::MapData::ConstMapType HMDT::MapData::getRivers() const {
-    return m_rivers;
+    return getOrAllocateLayer(m_rivers, Layer::RIVERS, getRiversSize());
 }
 
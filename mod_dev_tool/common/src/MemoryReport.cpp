@@ -0,0 +1,175 @@
+/**
+ * @file MemoryReport.cpp
+ *
+ * @brief Defines the memory usage report tree.
+ */
+
+#include "MemoryReport.h"
+
+#include <array>
+#include <iomanip>
+#include <sstream>
+
+#include "Logger.h"
+
+/**
+ * @brief Creates a new report.
+ *
+ * @param name The name of the subsystem being reported on
+ * @param bytes The bytes owned directly by the subsystem
+ */
+HMDT::MemoryReport::MemoryReport(const std::string& name, uint64_t bytes):
+    m_name(name),
+    m_bytes(bytes),
+    m_children(),
+    m_warnings()
+{ }
+
+const std::string& HMDT::MemoryReport::getName() const noexcept {
+    return m_name;
+}
+
+/**
+ * @brief Gets the bytes owned directly by this subsystem, not including any
+ *        of its children.
+ */
+uint64_t HMDT::MemoryReport::getBytes() const noexcept {
+    return m_bytes;
+}
+
+/**
+ * @brief Gets the bytes owned by this subsystem and all of its children.
+ */
+uint64_t HMDT::MemoryReport::getTotalBytes() const noexcept {
+    uint64_t total = m_bytes;
+
+    for(auto&& child : m_children) {
+        total += child.getTotalBytes();
+    }
+
+    return total;
+}
+
+void HMDT::MemoryReport::addBytes(uint64_t bytes) noexcept {
+    m_bytes += bytes;
+}
+
+/**
+ * @brief Adds a new part to this subsystem.
+ *
+ * @param name The name of the part
+ * @param bytes The bytes owned directly by the part
+ *
+ * @return The report for the new part, which may have more parts added to it
+ */
+auto HMDT::MemoryReport::addChild(const std::string& name, uint64_t bytes)
+    -> MemoryReport&
+{
+    return m_children.emplace_back(name, bytes);
+}
+
+auto HMDT::MemoryReport::getChildren() const noexcept
+    -> const std::list<MemoryReport>&
+{
+    return m_children;
+}
+
+void HMDT::MemoryReport::addWarning(const std::string& warning) {
+    m_warnings.push_back(warning);
+}
+
+/**
+ * @brief Gets the warnings of this subsystem and all of its children.
+ * @details Every warning is prefixed with the name of the subsystem it was
+ *          reported on.
+ */
+auto HMDT::MemoryReport::getAllWarnings() const -> std::vector<std::string> {
+    std::vector<std::string> warnings;
+
+    for(auto&& warning : m_warnings) {
+        warnings.push_back(m_name + ": " + warning);
+    }
+
+    for(auto&& child : m_children) {
+        auto child_warnings = child.getAllWarnings();
+        warnings.insert(warnings.end(), child_warnings.begin(),
+                        child_warnings.end());
+    }
+
+    return warnings;
+}
+
+/**
+ * @brief Renders this report as an indented tree, one subsystem per line.
+ */
+std::string HMDT::MemoryReport::toString() const {
+    std::string str;
+
+    toString(str, 0);
+
+    return str;
+}
+
+/**
+ * @brief Writes this report to the log, along with every warning it contains.
+ *
+ * @param context What was happening when the report was taken
+ */
+void HMDT::MemoryReport::writeToLog(const std::string& context) const {
+    WRITE_INFO("Memory usage ", context, ":\n", toString());
+
+    for(auto&& warning : getAllWarnings()) {
+        WRITE_WARN(warning);
+    }
+}
+
+void HMDT::MemoryReport::toString(std::string& str, uint32_t depth) const {
+    str += std::string(depth * 2, ' ') + m_name + ": " +
+           formatByteSize(getTotalBytes());
+
+    // Only mention the bytes held directly when there is something to compare
+    //   them to
+    if(!m_children.empty() && m_bytes != 0) {
+        str += " (" + formatByteSize(m_bytes) + " own)";
+    }
+    str += '\n';
+
+    for(auto&& warning : m_warnings) {
+        str += std::string(depth * 2 + 2, ' ') + "WARNING: " + warning + '\n';
+    }
+
+    for(auto&& child : m_children) {
+        child.toString(str, depth + 1);
+    }
+}
+
+/**
+ * @brief Formats a number of bytes in the largest unit that keeps the value
+ *        above 1.
+ *
+ * @param bytes The number of bytes
+ *
+ * @return The formatted size, for example "1.50 MiB"
+ */
+std::string HMDT::formatByteSize(uint64_t bytes) {
+    constexpr std::array<const char*, 5> UNITS = {
+        "B", "KiB", "MiB", "GiB", "TiB"
+    };
+
+    if(bytes < 1024) {
+        return std::to_string(bytes) + " B";
+    }
+
+    double size = bytes;
+    size_t unit = 0;
+    while(size >= 1024.0 && unit < UNITS.size() - 1) {
+        size /= 1024.0;
+        ++unit;
+    }
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << size << ' ' << UNITS[unit];
+
+    return ss.str();
+}
+
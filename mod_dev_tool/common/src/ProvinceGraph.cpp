@@ -0,0 +1,207 @@
+/**
+ * @file ProvinceGraph.cpp
+ *
+ * @brief Defines the graph of which provinces border each other.
+ */
+
+#include "ProvinceGraph.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Constants.h"
+#include "MemoryReport.h"
+
+/**
+ * @brief Gets what kind of border lies between two types of province.
+ *
+ * @param first The type of the province on one side
+ * @param second The type of the province on the other side
+ */
+auto HMDT::getProvinceCrossing(ProvinceType first, ProvinceType second) noexcept
+    -> ProvinceCrossing
+{
+    if(first > second) std::swap(first, second);
+
+    switch(first) {
+        case ProvinceType::LAND:
+            switch(second) {
+                case ProvinceType::LAND: return ProvinceCrossing::LAND;
+                case ProvinceType::SEA: return ProvinceCrossing::COAST;
+                case ProvinceType::LAKE: return ProvinceCrossing::LAKESHORE;
+                default: break;
+            }
+            break;
+        case ProvinceType::SEA:
+            switch(second) {
+                case ProvinceType::SEA: return ProvinceCrossing::SEA;
+                case ProvinceType::LAKE: return ProvinceCrossing::SEA_LAKE;
+                default: break;
+            }
+            break;
+        case ProvinceType::LAKE:
+            return ProvinceCrossing::LAKE;
+        case ProvinceType::UNKNOWN:
+            break;
+    }
+
+    return ProvinceCrossing::UNKNOWN;
+}
+
+HMDT::ProvinceGraph::ProvinceGraph():
+    m_offsets(1, 0),
+    m_edges()
+{ }
+
+/**
+ * @brief Rebuilds the graph.
+ * @details Every border is stored in both directions, and the crossing of
+ *          every edge is UNKNOWN until updateCrossings() is called.
+ *
+ * @param vertex_count One more than the largest ProvinceIndex
+ * @param borders Every border, stored only once in either direction. Borders
+ *                touching an index outside of the graph are skipped.
+ */
+void HMDT::ProvinceGraph::build(size_t vertex_count,
+                                const std::vector<ProvinceBorder>& borders)
+{
+    auto is_valid = [vertex_count](const ProvinceBorder& border) {
+        return border.first < vertex_count && border.second < vertex_count &&
+               border.first != border.second;
+    };
+
+    // Count the degree of every vertex, then turn those into offsets
+    m_offsets.assign(vertex_count + 1, 0);
+    for(auto&& border : borders) {
+        if(!is_valid(border)) continue;
+
+        ++m_offsets[border.first + 1];
+        ++m_offsets[border.second + 1];
+    }
+
+    for(size_t i = 1; i < m_offsets.size(); ++i) {
+        m_offsets[i] += m_offsets[i - 1];
+    }
+
+    m_edges.assign(m_offsets.back(), ProvinceEdge{ });
+
+    std::vector<uint32_t> next(m_offsets.begin(), m_offsets.end() - 1);
+    for(auto&& border : borders) {
+        if(!is_valid(border)) continue;
+
+        m_edges[next[border.first]++] = ProvinceEdge{ border.second,
+                                                      border.length,
+                                                      ProvinceCrossing::UNKNOWN };
+        m_edges[next[border.second]++] = ProvinceEdge{ border.first,
+                                                       border.length,
+                                                       ProvinceCrossing::UNKNOWN };
+    }
+
+    for(size_t i = 0; i < vertex_count; ++i) {
+        std::sort(m_edges.begin() + m_offsets[i],
+                  m_edges.begin() + m_offsets[i + 1],
+                  [](const ProvinceEdge& a, const ProvinceEdge& b) {
+                      return a.neighbour < b.neighbour;
+                  });
+    }
+}
+
+/**
+ * @brief Recalculates the crossing of every edge from the current type of
+ *        each province.
+ *
+ * @param provinces Every province, in ProvinceIndex order
+ */
+void HMDT::ProvinceGraph::updateCrossings(const ProvinceList& provinces) noexcept
+{
+    const auto& types = provinces.getTypes();
+
+    auto type_of = [&types](ProvinceIndex index) {
+        if(index == INVALID_PROVINCE_INDEX || index > types.size()) {
+            return ProvinceType::UNKNOWN;
+        }
+
+        return types[index - 1];
+    };
+
+    for(ProvinceIndex index = 0; index < getVertexCount(); ++index) {
+        auto type = type_of(index);
+
+        for(uint32_t e = m_offsets[index]; e < m_offsets[index + 1]; ++e) {
+            m_edges[e].crossing = getProvinceCrossing(type,
+                                                      type_of(m_edges[e].neighbour));
+        }
+    }
+}
+
+void HMDT::ProvinceGraph::clear() noexcept {
+    m_offsets.assign(1, 0);
+    m_edges.clear();
+}
+
+size_t HMDT::ProvinceGraph::getVertexCount() const noexcept {
+    return m_offsets.size() - 1;
+}
+
+//! Gets the number of edges, which is twice the number of borders
+size_t HMDT::ProvinceGraph::getEdgeCount() const noexcept {
+    return m_edges.size();
+}
+
+/**
+ * @brief Gets every edge of a province.
+ *
+ * @param index The index of the province
+ *
+ * @return The edges, sorted by neighbour. Empty if the index is not in the
+ *         graph.
+ */
+auto HMDT::ProvinceGraph::getEdges(ProvinceIndex index) const noexcept
+    -> EdgeRange
+{
+    if(index >= getVertexCount()) {
+        return EdgeRange{ nullptr, nullptr };
+    }
+
+    return EdgeRange{ m_edges.data() + m_offsets[index],
+                      m_edges.data() + m_offsets[index + 1] };
+}
+
+/**
+ * @brief Finds the edge from one province to another.
+ *
+ * @param from The index of the first province
+ * @param to The index of the second province
+ *
+ * @return The edge, or nullptr if the provinces do not border each other
+ */
+auto HMDT::ProvinceGraph::findEdge(ProvinceIndex from, ProvinceIndex to) const noexcept
+    -> const ProvinceEdge*
+{
+    auto edges = getEdges(from);
+
+    const auto* it = std::lower_bound(edges.begin(), edges.end(), to,
+                                      [](const ProvinceEdge& edge, ProvinceIndex index) {
+                                          return edge.neighbour < index;
+                                      });
+
+    if(it == edges.end() || it->neighbour != to) {
+        return nullptr;
+    }
+
+    return it;
+}
+
+bool HMDT::ProvinceGraph::areAdjacent(ProvinceIndex first,
+                                      ProvinceIndex second) const noexcept
+{
+    return findEdge(first, second) != nullptr;
+}
+
+/**
+ * @brief Estimates the memory held by a ProvinceGraph.
+ */
+uint64_t HMDT::estimateMemoryUsage(const ProvinceGraph& graph) noexcept {
+    return estimateMemoryUsage(graph.m_offsets) +
+           estimateMemoryUsage(graph.m_edges);
+}
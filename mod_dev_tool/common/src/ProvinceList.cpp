@@ -0,0 +1,399 @@
+/**
+ * @file ProvinceList.cpp
+ *
+ * @brief Defines the store which holds every province.
+ */
+
+#include "ProvinceList.h"
+
+#include <stdexcept>
+
+#include "Constants.h"
+#include "MemoryReport.h"
+
+auto HMDT::ProvinceList::operator=(const ProvinceList& other) -> ProvinceList& {
+    // The keys are const, so the elements can only be copy-constructed
+    return *this = ProvinceList(other);
+}
+
+auto HMDT::ProvinceList::begin() noexcept -> iterator {
+    return m_provinces.begin();
+}
+
+auto HMDT::ProvinceList::end() noexcept -> iterator {
+    return m_provinces.end();
+}
+
+auto HMDT::ProvinceList::begin() const noexcept -> const_iterator {
+    return m_provinces.begin();
+}
+
+auto HMDT::ProvinceList::end() const noexcept -> const_iterator {
+    return m_provinces.end();
+}
+
+size_t HMDT::ProvinceList::size() const noexcept {
+    return m_provinces.size();
+}
+
+bool HMDT::ProvinceList::empty() const noexcept {
+    return m_provinces.empty();
+}
+
+void HMDT::ProvinceList::clear() noexcept {
+    m_provinces.clear();
+    m_lookup.clear();
+
+    resizeColumns(0);
+}
+
+void HMDT::ProvinceList::reserve(size_t count) {
+    m_provinces.reserve(count);
+    m_lookup.reserve(count);
+
+    m_types.reserve(count);
+    m_coastal.reserve(count);
+    m_states.reserve(count);
+    m_colors.reserve(count);
+    m_bounding_boxes.reserve(count);
+    m_parent_indices.reserve(count);
+}
+
+size_t HMDT::ProvinceList::count(const ProvinceID& id) const noexcept {
+    return m_lookup.count(id);
+}
+
+auto HMDT::ProvinceList::find(const ProvinceID& id) noexcept -> iterator {
+    if(auto it = m_lookup.find(id); it != m_lookup.end()) {
+        return m_provinces.begin() + it->second;
+    }
+
+    return m_provinces.end();
+}
+
+auto HMDT::ProvinceList::find(const ProvinceID& id) const noexcept
+    -> const_iterator
+{
+    if(auto it = m_lookup.find(id); it != m_lookup.end()) {
+        return m_provinces.begin() + it->second;
+    }
+
+    return m_provinces.end();
+}
+
+/**
+ * @brief Gets a province by its ID.
+ *
+ * @param id The ID of the province
+ *
+ * @throws std::out_of_range If no province has the given ID
+ */
+auto HMDT::ProvinceList::at(const ProvinceID& id) -> Province& {
+    return m_provinces[m_lookup.at(id)].second;
+}
+
+auto HMDT::ProvinceList::at(const ProvinceID& id) const -> const Province& {
+    return m_provinces[m_lookup.at(id)].second;
+}
+
+/**
+ * @brief Gets a province by its ID, adding a new default province at the end
+ *        of the list if no province has that ID yet.
+ *
+ * @param id The ID of the province
+ */
+auto HMDT::ProvinceList::operator[](const ProvinceID& id) -> Province& {
+    if(auto it = m_lookup.find(id); it != m_lookup.end()) {
+        return m_provinces[it->second].second;
+    }
+
+    m_lookup[id] = m_provinces.size();
+    m_provinces.emplace_back(id, Province{});
+
+    resizeColumns(m_provinces.size());
+    syncColumns(static_cast<ProvinceIndex>(m_provinces.size()));
+
+    return m_provinces.back().second;
+}
+
+/**
+ * @brief Gets the dense index of a province.
+ *
+ * @param id The ID of the province
+ *
+ * @return The index of the province, or INVALID_PROVINCE_INDEX if no
+ *         province has the given ID
+ */
+auto HMDT::ProvinceList::getIndex(const ProvinceID& id) const noexcept
+    -> ProvinceIndex
+{
+    if(auto it = m_lookup.find(id); it != m_lookup.end()) {
+        return static_cast<ProvinceIndex>(it->second + 1);
+    }
+
+    return INVALID_PROVINCE_INDEX;
+}
+
+/**
+ * @brief Gets the ID of the province with the given dense index.
+ *
+ * @param index The index of the province
+ *
+ * @return The ID of the province, or INVALID_PROVINCE if the index is out of
+ *         range
+ */
+auto HMDT::ProvinceList::getID(ProvinceIndex index) const noexcept
+    -> const ProvinceID&
+{
+    if(index == INVALID_PROVINCE_INDEX || index > m_provinces.size()) {
+        return INVALID_PROVINCE;
+    }
+
+    return m_provinces[index - 1].first;
+}
+
+/**
+ * @brief Gets the province with the given dense index.
+ *
+ * @param index The index of the province
+ *
+ * @return The province, or nullptr if the index is out of range
+ */
+auto HMDT::ProvinceList::atIndex(ProvinceIndex index) noexcept -> Province* {
+    if(index == INVALID_PROVINCE_INDEX || index > m_provinces.size()) {
+        return nullptr;
+    }
+
+    return &m_provinces[index - 1].second;
+}
+
+auto HMDT::ProvinceList::atIndex(ProvinceIndex index) const noexcept
+    -> const Province*
+{
+    if(index == INVALID_PROVINCE_INDEX || index > m_provinces.size()) {
+        return nullptr;
+    }
+
+    return &m_provinces[index - 1].second;
+}
+
+/**
+ * @brief Reorders every province, which changes their dense indices.
+ * @details Provinces are placed in the order given, skipping any IDs which
+ *          are not in this list. Any province which was not given keeps its
+ *          relative order, but is moved after all of the given provinces.
+ *          Note that this invalidates every reference into the list.
+ *
+ * @param ids The IDs of the provinces, in their new order
+ */
+void HMDT::ProvinceList::reorder(const std::vector<ProvinceID>& ids) {
+    std::vector<value_type> provinces;
+    provinces.reserve(m_provinces.size());
+
+    std::vector<bool> placed(m_provinces.size(), false);
+
+    for(auto&& id : ids) {
+        if(auto it = m_lookup.find(id);
+                it != m_lookup.end() && !placed[it->second])
+        {
+            placed[it->second] = true;
+            provinces.emplace_back(std::move(m_provinces[it->second]));
+        }
+    }
+
+    for(size_t i = 0; i < m_provinces.size(); ++i) {
+        if(!placed[i]) {
+            provinces.emplace_back(std::move(m_provinces[i]));
+        }
+    }
+
+    m_provinces = std::move(provinces);
+
+    rebuildLookup();
+    rebuildColumns();
+}
+
+void HMDT::ProvinceList::rebuildLookup() {
+    m_lookup.clear();
+    m_lookup.reserve(m_provinces.size());
+
+    for(size_t i = 0; i < m_provinces.size(); ++i) {
+        m_lookup[m_provinces[i].first] = i;
+    }
+}
+
+/**
+ * @brief Gets the type of every province, in ProvinceIndex order.
+ * @details The province with ProvinceIndex i is at position i - 1, which is
+ *          the same for every column.
+ */
+auto HMDT::ProvinceList::getTypes() const noexcept
+    -> const std::vector<ProvinceType>&
+{
+    return m_types;
+}
+
+/**
+ * @brief Gets whether every province is coastal, in ProvinceIndex order.
+ */
+auto HMDT::ProvinceList::getCoastal() const noexcept
+    -> const std::vector<uint8_t>&
+{
+    return m_coastal;
+}
+
+/**
+ * @brief Gets the state of every province, in ProvinceIndex order.
+ */
+auto HMDT::ProvinceList::getStates() const noexcept
+    -> const std::vector<StateID>&
+{
+    return m_states;
+}
+
+/**
+ * @brief Gets the unique color of every province, in ProvinceIndex order.
+ */
+auto HMDT::ProvinceList::getColors() const noexcept
+    -> const std::vector<Color>&
+{
+    return m_colors;
+}
+
+/**
+ * @brief Gets the bounding box of every province, in ProvinceIndex order.
+ */
+auto HMDT::ProvinceList::getBoundingBoxes() const noexcept
+    -> const std::vector<BoundingBox>&
+{
+    return m_bounding_boxes;
+}
+
+/**
+ * @brief Gets the ProvinceIndex of the parent of every province, in
+ *        ProvinceIndex order.
+ * @details Provinces without a parent, or whose parent is not in this list,
+ *          have INVALID_PROVINCE_INDEX.
+ */
+auto HMDT::ProvinceList::getParentIndices() const noexcept
+    -> const std::vector<ProvinceIndex>&
+{
+    return m_parent_indices;
+}
+
+/**
+ * @brief Sets the type of a province.
+ *
+ * @param index The index of the province, nothing happens if it is invalid
+ * @param type The new type of the province
+ */
+void HMDT::ProvinceList::setType(ProvinceIndex index, ProvinceType type) noexcept
+{
+    if(auto* province = atIndex(index); province != nullptr) {
+        province->type = type;
+        m_types[index - 1] = type;
+    }
+}
+
+/**
+ * @brief Sets whether a province is coastal.
+ *
+ * @param index The index of the province, nothing happens if it is invalid
+ * @param coastal Whether the province is coastal
+ */
+void HMDT::ProvinceList::setCoastal(ProvinceIndex index, bool coastal) noexcept
+{
+    if(auto* province = atIndex(index); province != nullptr) {
+        province->coastal = coastal;
+        m_coastal[index - 1] = coastal;
+    }
+}
+
+/**
+ * @brief Sets the state of a province.
+ * @details This does not add the province to the state itself.
+ *
+ * @param index The index of the province, nothing happens if it is invalid
+ * @param state The ID of the new state of the province
+ */
+void HMDT::ProvinceList::setState(ProvinceIndex index, StateID state) noexcept
+{
+    if(auto* province = atIndex(index); province != nullptr) {
+        province->state = state;
+        m_states[index - 1] = state;
+    }
+}
+
+/**
+ * @brief Sets the parent of a province.
+ * @details This does not add the province to the children of its parent.
+ *
+ * @param index The index of the province, nothing happens if it is invalid
+ * @param parent_id The ID of the new parent, or INVALID_PROVINCE for none
+ */
+void HMDT::ProvinceList::setParent(ProvinceIndex index,
+                                   const ProvinceID& parent_id) noexcept
+{
+    if(auto* province = atIndex(index); province != nullptr) {
+        province->parent_id = parent_id;
+        m_parent_indices[index - 1] = getIndex(parent_id);
+    }
+}
+
+/**
+ * @brief Copies the hot fields of a single province into the columns.
+ * @details Must be called after any of those fields have been written to
+ *          through a reference to the province.
+ *
+ * @param index The index of the province, nothing happens if it is invalid
+ */
+void HMDT::ProvinceList::syncColumns(ProvinceIndex index) noexcept {
+    const auto* province = atIndex(index);
+    if(province == nullptr) return;
+
+    auto i = index - 1;
+
+    m_types[i] = province->type;
+    m_coastal[i] = province->coastal;
+    m_states[i] = province->state;
+    m_colors[i] = province->unique_color;
+    m_bounding_boxes[i] = province->bounding_box;
+    m_parent_indices[i] = getIndex(province->parent_id);
+}
+
+/**
+ * @brief Copies the hot fields of every province into the columns.
+ * @details Meant to be called after many provinces have been written to at
+ *          once, such as after loading them.
+ */
+void HMDT::ProvinceList::rebuildColumns() noexcept {
+    resizeColumns(m_provinces.size());
+
+    for(size_t i = 0; i < m_provinces.size(); ++i) {
+        syncColumns(static_cast<ProvinceIndex>(i + 1));
+    }
+}
+
+void HMDT::ProvinceList::resizeColumns(size_t size) {
+    m_types.resize(size);
+    m_coastal.resize(size);
+    m_states.resize(size);
+    m_colors.resize(size);
+    m_bounding_boxes.resize(size);
+    m_parent_indices.resize(size, INVALID_PROVINCE_INDEX);
+}
+
+/**
+ * @brief Estimates the memory held by a ProvinceList, not counting anything
+ *        its provinces point to.
+ */
+uint64_t HMDT::estimateMemoryUsage(const ProvinceList& provinces) noexcept {
+    return estimateMemoryUsage(provinces.m_provinces) +
+           estimateMemoryUsage(provinces.m_lookup) +
+           estimateMemoryUsage(provinces.m_types) +
+           estimateMemoryUsage(provinces.m_coastal) +
+           estimateMemoryUsage(provinces.m_states) +
+           estimateMemoryUsage(provinces.m_colors) +
+           estimateMemoryUsage(provinces.m_bounding_boxes) +
+           estimateMemoryUsage(provinces.m_parent_indices);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file ProvincePreview.cpp
+ *
+ * @brief Defines the 1-bit mask used to preview a single province.
+ */
+
+#include "ProvincePreview.h"
+
+#include <algorithm>
+
+namespace {
+    //! How many pixels fit into a single word of a row
+    constexpr uint32_t BITS_PER_WORD = 64;
+}
+
+/**
+ * @brief Creates a new preview where no pixel is set.
+ *
+ * @param width The width of the preview in pixels
+ * @param height The height of the preview in pixels
+ */
+HMDT::ProvincePreview::ProvincePreview(uint32_t width, uint32_t height):
+    m_width(width),
+    m_height(height),
+    m_words_per_row((width + BITS_PER_WORD - 1) / BITS_PER_WORD),
+    m_bits(static_cast<uint64_t>(m_words_per_row) * height, 0)
+{ }
+
+uint32_t HMDT::ProvincePreview::getWidth() const noexcept {
+    return m_width;
+}
+
+uint32_t HMDT::ProvincePreview::getHeight() const noexcept {
+    return m_height;
+}
+
+bool HMDT::ProvincePreview::isSet(uint32_t x, uint32_t y) const noexcept {
+    return (getRow(y)[x / BITS_PER_WORD] >> (x % BITS_PER_WORD)) & 1;
+}
+
+void HMDT::ProvincePreview::set(uint32_t x, uint32_t y) noexcept {
+    getRow(y)[x / BITS_PER_WORD] |= uint64_t{1} << (x % BITS_PER_WORD);
+}
+
+/**
+ * @brief Gets the words making up a row. Pixel x of the row is stored in bit
+ *        (x % 64) of word (x / 64).
+ *
+ * @param y The row to get
+ */
+uint64_t* HMDT::ProvincePreview::getRow(uint32_t y) noexcept {
+    return m_bits.data() + static_cast<uint64_t>(y) * m_words_per_row;
+}
+
+const uint64_t* HMDT::ProvincePreview::getRow(uint32_t y) const noexcept {
+    return m_bits.data() + static_cast<uint64_t>(y) * m_words_per_row;
+}
+
+uint32_t HMDT::ProvincePreview::getWordsPerRow() const noexcept {
+    return m_words_per_row;
+}
+
+/**
+ * @brief Gets how many bytes the pixels of this preview take up.
+ */
+uint64_t HMDT::ProvincePreview::getByteSize() const noexcept {
+    return m_bits.size() * sizeof(uint64_t);
+}
+
+/**
+ * @brief Expands this preview into a 32-bit color image.
+ * @details Words which are entirely set or entirely unset are filled in all at
+ *          once, so provinces with large solid areas expand quickly.
+ *
+ * @param dest The image to write into. Must be at least stride * height bytes.
+ * @param stride How many bytes make up a single row of dest
+ * @param color The color to give every set pixel. Unset pixels are 0.
+ */
+void HMDT::ProvincePreview::expandToARGB(unsigned char* dest, uint32_t stride,
+                                         uint32_t color) const noexcept
+{
+    for(uint32_t y = 0; y < m_height; ++y) {
+        const auto* row = getRow(y);
+        auto* out = reinterpret_cast<uint32_t*>(dest + static_cast<uint64_t>(y) * stride);
+
+        for(uint32_t word = 0; word < m_words_per_row; ++word) {
+            auto bits = row[word];
+
+            auto begin_x = word * BITS_PER_WORD;
+            auto end_x = std::min(begin_x + BITS_PER_WORD, m_width);
+
+            if(bits == 0) {
+                std::fill(out + begin_x, out + end_x, 0U);
+            } else if(bits == ~uint64_t{0}) {
+                std::fill(out + begin_x, out + end_x, color);
+            } else {
+                for(auto x = begin_x; x < end_x; ++x, bits >>= 1) {
+                    out[x] = (bits & 1) ? color : 0;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Expands this preview into a new, tightly packed 32-bit color image.
+ *
+ * @param color The color to give every set pixel. Unset pixels are 0.
+ *
+ * @return The image, which is width * height * 4 bytes
+ */
+auto HMDT::ProvincePreview::expandToARGB(uint32_t color) const
+    -> std::unique_ptr<unsigned char[]>
+{
+    std::unique_ptr<unsigned char[]> image(new unsigned char[static_cast<uint64_t>(m_width) * m_height * 4]);
+
+    expandToARGB(image.get(), m_width * 4, color);
+
+    return image;
+}
+
@@ -0,0 +1,119 @@
+/**
+ * @file ProvinceSpans.cpp
+ *
+ * @brief Defines the horizontal runs of pixels that make up every province.
+ */
+
+#include "ProvinceSpans.h"
+
+#include "MemoryReport.h"
+
+HMDT::ProvinceSpans::ProvinceSpans():
+    m_offsets(1, 0),
+    m_spans(),
+    m_label_generation(-1)
+{ }
+
+/**
+ * @brief Rebuilds every span from a label matrix.
+ *
+ * @param labels The label matrix, holding the ProvinceIndex of every pixel
+ * @param width The width of the label matrix
+ * @param height The height of the label matrix
+ * @param province_count One more than the largest ProvinceIndex. Pixels with
+ *                       a label outside of this are skipped.
+ * @param label_generation The generation of the label matrix
+ */
+void HMDT::ProvinceSpans::build(const uint32_t* labels, uint32_t width,
+                                uint32_t height, size_t province_count,
+                                uint64_t label_generation)
+{
+    m_label_generation = label_generation;
+
+    // Calls func(label, x, y, length) for every run in the label matrix
+    auto forEachRun = [&](auto&& func) {
+        for(uint32_t y = 0; y < height; ++y) {
+            const uint32_t* row = labels + static_cast<size_t>(y) * width;
+
+            for(uint32_t x = 0; x < width;) {
+                auto label = row[x];
+
+                uint32_t start_x = x;
+                while(x < width && row[x] == label) ++x;
+
+                if(label < province_count) {
+                    func(label, start_x, y, x - start_x);
+                }
+            }
+        }
+    };
+
+    // Count the spans of every province, then turn those into offsets
+    m_offsets.assign(province_count + 1, 0);
+    forEachRun([this](uint32_t label, uint32_t, uint32_t, uint32_t) {
+        ++m_offsets[label + 1];
+    });
+
+    for(size_t i = 1; i < m_offsets.size(); ++i) {
+        m_offsets[i] += m_offsets[i - 1];
+    }
+
+    m_spans.assign(m_offsets.back(), ProvinceSpan{ });
+
+    std::vector<uint32_t> next(m_offsets.begin(), m_offsets.end() - 1);
+    forEachRun([this, &next](uint32_t label, uint32_t x, uint32_t y,
+                             uint32_t length)
+    {
+        m_spans[next[label]++] = ProvinceSpan{ y, x, length };
+    });
+}
+
+void HMDT::ProvinceSpans::clear() noexcept {
+    m_offsets.assign(1, 0);
+    m_spans.clear();
+    m_label_generation = -1;
+}
+
+/**
+ * @brief Gets the generation of the label matrix that the spans were built
+ *        from. The spans are out of date if this is not the label matrix's
+ *        current generation.
+ */
+uint64_t HMDT::ProvinceSpans::getLabelGeneration() const noexcept {
+    return m_label_generation;
+}
+
+//! Gets one more than the largest ProvinceIndex with spans
+size_t HMDT::ProvinceSpans::getProvinceCount() const noexcept {
+    return m_offsets.size() - 1;
+}
+
+size_t HMDT::ProvinceSpans::getSpanCount() const noexcept {
+    return m_spans.size();
+}
+
+/**
+ * @brief Gets every span of a province.
+ *
+ * @param index The index of the province
+ *
+ * @return The spans, from top to bottom. Empty if the index is not known.
+ */
+auto HMDT::ProvinceSpans::getSpans(ProvinceIndex index) const noexcept
+    -> SpanRange
+{
+    if(index >= getProvinceCount()) {
+        return SpanRange{ nullptr, nullptr };
+    }
+
+    return SpanRange{ m_spans.data() + m_offsets[index],
+                      m_spans.data() + m_offsets[index + 1] };
+}
+
+/**
+ * @brief Estimates the memory held by a ProvinceSpans.
+ */
+uint64_t HMDT::estimateMemoryUsage(const ProvinceSpans& spans) noexcept {
+    return estimateMemoryUsage(spans.m_offsets) +
+           estimateMemoryUsage(spans.m_spans);
+}
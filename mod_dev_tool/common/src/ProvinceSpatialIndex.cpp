@@ -0,0 +1,199 @@
+/**
+ * @file ProvinceSpatialIndex.cpp
+ *
+ * @brief Defines the grid used to look up provinces by where they are on the
+ *        map.
+ */
+
+#include "ProvinceSpatialIndex.h"
+
+#include <algorithm>
+
+#include "Constants.h"
+#include "MemoryReport.h"
+
+namespace {
+    /**
+     * @brief Divides two numbers, rounding up
+     */
+    constexpr uint32_t divCeil(uint32_t a, uint32_t b) {
+        return (a + b - 1) / b;
+    }
+}
+
+HMDT::ProvinceSpatialIndex::ProvinceSpatialIndex():
+    ProvinceSpatialIndex(PROVINCE_SPATIAL_INDEX_CELL_SIZE)
+{ }
+
+/**
+ * @brief Creates a new, empty spatial index.
+ *
+ * @param cell_size The width and height of every cell, in pixels
+ */
+HMDT::ProvinceSpatialIndex::ProvinceSpatialIndex(uint32_t cell_size):
+    m_cell_size(std::max(cell_size, 1U)),
+    m_cells_x(0),
+    m_cells_y(0),
+    m_size(0),
+    m_bounds(),
+    m_cells()
+{
+    resizeGrid(1, 1);
+}
+
+/**
+ * @brief Rebuilds the index from every province.
+ * @details The grid covers the whole map, and is grown if any bounding box
+ *          reaches outside of it.
+ *
+ * @param provinces Every province, in ProvinceIndex order
+ * @param width The width of the map
+ * @param height The height of the map
+ */
+void HMDT::ProvinceSpatialIndex::rebuild(const ProvinceList& provinces,
+                                         uint32_t width, uint32_t height)
+{
+    clear();
+
+    m_bounds.reserve(provinces.size() + 1);
+    m_bounds.emplace_back(std::nullopt); // INVALID_PROVINCE_INDEX
+
+    for(auto&& [_, province] : provinces) {
+        auto bounds = toBounds(province.bounding_box);
+
+        width = std::max(width, bounds.max_x + 1);
+        height = std::max(height, bounds.max_y + 1);
+
+        m_bounds.emplace_back(bounds);
+    }
+
+    resizeGrid(width, height);
+
+    for(ProvinceIndex index = 1; index < m_bounds.size(); ++index) {
+        insertIntoCells(index);
+    }
+
+    m_size = provinces.size();
+}
+
+void HMDT::ProvinceSpatialIndex::clear() noexcept {
+    m_bounds.clear();
+
+    for(auto&& cell : m_cells) {
+        cell.clear();
+    }
+
+    m_size = 0;
+}
+
+size_t HMDT::ProvinceSpatialIndex::size() const noexcept {
+    return m_size;
+}
+
+/**
+ * @brief Finds every province whose bounding box intersects a rectangle.
+ *
+ * @param rect The rectangle to check
+ *
+ * @return The index of every matching province, sorted by index
+ */
+auto HMDT::ProvinceSpatialIndex::queryRect(const Rectangle& rect) const
+    -> std::vector<ProvinceIndex>
+{
+    std::vector<ProvinceIndex> results;
+
+    if(rect.w == 0 || rect.h == 0) return results;
+
+    Bounds query{ rect.x, rect.y, rect.x + rect.w - 1, rect.y + rect.h - 1 };
+    auto query_cells = getCellRange(query);
+
+    for(uint32_t cy = query_cells.min_cy; cy <= query_cells.max_cy; ++cy) {
+        for(uint32_t cx = query_cells.min_cx; cx <= query_cells.max_cx; ++cx) {
+            for(auto&& index : m_cells[cy * m_cells_x + cx]) {
+                const auto& bounds = *m_bounds[index];
+
+                if(bounds.max_x < query.min_x || bounds.min_x > query.max_x ||
+                   bounds.max_y < query.min_y || bounds.min_y > query.max_y)
+                {
+                    continue;
+                }
+
+                // A province is in every cell that it touches, so only report
+                //   it from the first cell it shares with the query
+                auto cells = getCellRange(bounds);
+                if(cx == std::max(cells.min_cx, query_cells.min_cx) &&
+                   cy == std::max(cells.min_cy, query_cells.min_cy))
+                {
+                    results.push_back(index);
+                }
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+
+    return results;
+}
+
+/**
+ * @brief Converts a bounding box into inclusive bounds, regardless of which
+ *        corner is stored where.
+ */
+auto HMDT::ProvinceSpatialIndex::toBounds(const BoundingBox& bb) noexcept
+    -> Bounds
+{
+    return Bounds{ std::min(bb.bottom_left.x, bb.top_right.x),
+                   std::min(bb.bottom_left.y, bb.top_right.y),
+                   std::max(bb.bottom_left.x, bb.top_right.x),
+                   std::max(bb.bottom_left.y, bb.top_right.y) };
+}
+
+/**
+ * @brief Gets every cell that some bounds touch, clamped to the grid.
+ */
+auto HMDT::ProvinceSpatialIndex::getCellRange(const Bounds& bounds) const noexcept
+    -> CellRange
+{
+    return CellRange{ std::min(bounds.min_x / m_cell_size, m_cells_x - 1),
+                      std::min(bounds.min_y / m_cell_size, m_cells_y - 1),
+                      std::min(bounds.max_x / m_cell_size, m_cells_x - 1),
+                      std::min(bounds.max_y / m_cell_size, m_cells_y - 1) };
+}
+
+/**
+ * @brief Resizes the grid to cover an area. Every cell must be empty.
+ *
+ * @param width The width of the area, in pixels
+ * @param height The height of the area, in pixels
+ */
+void HMDT::ProvinceSpatialIndex::resizeGrid(uint32_t width, uint32_t height) {
+    m_cells_x = std::max(divCeil(width, m_cell_size), 1U);
+    m_cells_y = std::max(divCeil(height, m_cell_size), 1U);
+
+    m_cells.resize(m_cells_x * m_cells_y);
+}
+
+void HMDT::ProvinceSpatialIndex::insertIntoCells(ProvinceIndex index) {
+    const auto& bounds = *m_bounds[index];
+    auto cells = getCellRange(bounds);
+
+    for(uint32_t cy = cells.min_cy; cy <= cells.max_cy; ++cy) {
+        for(uint32_t cx = cells.min_cx; cx <= cells.max_cx; ++cx) {
+            m_cells[cy * m_cells_x + cx].push_back(index);
+        }
+    }
+}
+
+/**
+ * @brief Estimates the memory held by a ProvinceSpatialIndex.
+ */
+uint64_t HMDT::estimateMemoryUsage(const ProvinceSpatialIndex& index) noexcept {
+    uint64_t bytes = estimateMemoryUsage(index.m_bounds) +
+                     estimateMemoryUsage(index.m_cells);
+
+    for(auto&& cell : index.m_cells) {
+        bytes += estimateMemoryUsage(cell);
+    }
+
+    return bytes;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file RiversValidator.cpp
+ *
+ * @brief Defines the checks for the HoI4 river rules.
+ *
+ * @par See https://hoi4.paradoxwikis.com/Map_modding#Rivers for a description
+ *      of the rules being checked.
+ */
+
+#include "RiversValidator.h"
+
+#include <sstream>
+#include <vector>
+
+#include "Constants.h"
+#include "StatusCodes.h"
+#include "Util.h"
+
+namespace {
+    const std::string VALIDATOR = "Rivers";
+
+    bool isRiver(uint8_t value) noexcept {
+        return value <= HMDT::RIVER_WIDEST_INDEX;
+    }
+
+    bool isFlowMarker(uint8_t value) noexcept {
+        return value == HMDT::RIVER_FLOW_IN_INDEX ||
+               value == HMDT::RIVER_FLOW_OUT_INDEX;
+    }
+
+    /**
+     * @brief Every river pixel, grouped by the river it belongs to
+     * @details The pixels of every river are stored next to each other, in the
+     *          order that they were flood filled in.
+     */
+    struct Rivers {
+        /**
+         * @brief Where the pixels of every river start in pixels. Holds one
+         *        more entry than there are rivers, so that the pixels of river
+         *        i are [offsets[i], offsets[i+1]).
+         */
+        std::vector<size_t> offsets;
+
+        //! The index of every river pixel
+        std::vector<uint32_t> pixels;
+    };
+
+    /**
+     * @brief Finds every river, where pixels are only connected to the pixels
+     *        directly above, below, left and right of them.
+     * @details Each river is flood filled by using its own pixels as the queue,
+     *          so every pixel of the map is only visited once.
+     *
+     * @param rivers The 8-bit indexed rivers data
+     * @param width The width of the map
+     * @param height The height of the map
+     *
+     * @return Every river pixel, grouped by river
+     */
+    Rivers findRivers(const uint8_t* rivers, uint32_t width, uint32_t height) {
+        size_t size = static_cast<size_t>(width) * height;
+
+        std::vector<bool> visited(size, false);
+
+        Rivers found;
+        found.offsets.push_back(0);
+
+        for(size_t start = 0; start < size; ++start) {
+            if(visited[start] || !isRiver(rivers[start])) continue;
+
+            visited[start] = true;
+            found.pixels.push_back(static_cast<uint32_t>(start));
+
+            for(size_t head = found.offsets.back(); head < found.pixels.size(); ++head)
+            {
+                auto i = found.pixels[head];
+                auto x = i % width;
+                auto y = i / width;
+
+                auto visit = [&](uint32_t neighbour) {
+                    if(!visited[neighbour] && isRiver(rivers[neighbour])) {
+                        visited[neighbour] = true;
+                        found.pixels.push_back(neighbour);
+                    }
+                };
+
+                if(x > 0) visit(i - 1);
+                if(x + 1 < width) visit(i + 1);
+                if(y > 0) visit(i - width);
+                if(y + 1 < height) visit(i + width);
+            }
+
+            found.offsets.push_back(found.pixels.size());
+        }
+
+        return found;
+    }
+
+    /**
+     * @brief Checks a single river.
+     *
+     * @param rivers The 8-bit indexed rivers data
+     * @param width The width of the map
+     * @param height The height of the map
+     * @param begin The first pixel of the river
+     * @param end One past the last pixel of the river
+     * @param report The report to add every issue to
+     */
+    void validateRiver(const uint8_t* rivers, uint32_t width, uint32_t height,
+                       const uint32_t* begin, const uint32_t* end,
+                       HMDT::ValidationReport& report)
+    {
+        using Severity = HMDT::ValidationReport::Severity;
+
+        auto addIssue = [&report](std::error_code code, HMDT::Point2D position,
+                                  auto&&... args)
+        {
+            report.addIssue(Severity::WARNING, VALIDATOR, code, args...)
+                  .position = position;
+        };
+
+        size_t edges = 0;
+        size_t sources = 0;
+        size_t flow_ins = 0;
+        size_t flow_outs = 0;
+
+        // Every end of the river which isn't marked as anything
+        std::vector<HMDT::Point2D> ends;
+
+        for(const auto* it = begin; it != end; ++it) {
+            auto i = *it;
+            auto x = i % width;
+            auto y = i / width;
+            auto value = rivers[i];
+
+            // Callers must make sure that the neighbour is inside the map
+            auto riverAt = [&](int32_t dx, int32_t dy) {
+                auto offset = static_cast<int64_t>(dy) * width + dx;
+                return isRiver(rivers[static_cast<int64_t>(i) + offset]);
+            };
+
+            bool left = x > 0 && riverAt(-1, 0);
+            bool right = x + 1 < width && riverAt(1, 0);
+            bool up = y > 0 && riverAt(0, -1);
+            bool down = y + 1 < height && riverAt(0, 1);
+
+            uint32_t neighbours = left + right + up + down;
+            uint32_t marker_neighbours = (left && isFlowMarker(rivers[i - 1])) +
+                                         (right && isFlowMarker(rivers[i + 1])) +
+                                         (up && isFlowMarker(rivers[i - width])) +
+                                         (down && isFlowMarker(rivers[i + width]));
+
+            // Each connection is only counted from its left or top pixel
+            edges += right + down;
+
+            // Only look downwards, so that every diagonal pair is only
+            //  reported once
+            if(y + 1 < height) {
+                if(x + 1 < width && riverAt(1, 1) && !right && !down) {
+                    addIssue(HMDT::STATUS_RIVER_DIAGONAL_CONNECTION,
+                             HMDT::Point2D{ x, y }, "River pixel at (", x, ", ",
+                             y, ") only connects diagonally to (", x + 1,
+                             ", ", y + 1, ").");
+                }
+                if(x > 0 && riverAt(-1, 1) && !left && !down) {
+                    addIssue(HMDT::STATUS_RIVER_DIAGONAL_CONNECTION,
+                             HMDT::Point2D{ x, y }, "River pixel at (", x, ", ",
+                             y, ") only connects diagonally to (", x - 1,
+                             ", ", y + 1, ").");
+                }
+            }
+
+            switch(value) {
+                case HMDT::RIVER_SOURCE_INDEX:
+                    ++sources;
+
+                    if(neighbours > 1) {
+                        addIssue(HMDT::STATUS_RIVER_MISPLACED_MARKER,
+                                 HMDT::Point2D{ x, y }, "River source at (", x,
+                                 ", ", y, ") is not at the end of the river.");
+                    }
+                    break;
+                case HMDT::RIVER_FLOW_IN_INDEX:
+                case HMDT::RIVER_FLOW_OUT_INDEX:
+                    ++(value == HMDT::RIVER_FLOW_IN_INDEX ? flow_ins : flow_outs);
+
+                    // Markers join exactly one pixel of each river
+                    if(neighbours != 2) {
+                        addIssue(HMDT::STATUS_RIVER_MISPLACED_MARKER,
+                                 HMDT::Point2D{ x, y },
+                                 (value == HMDT::RIVER_FLOW_IN_INDEX ? "Flow-in"
+                                                                     : "Flow-out"),
+                                 " marker at (", x, ", ", y, ") touches ",
+                                 neighbours, " river pixels rather than 2.");
+                    }
+                    break;
+                default:
+                    // Rivers may only split off through a flow marker
+                    if(neighbours - marker_neighbours > 2) {
+                        addIssue(HMDT::STATUS_RIVER_INVALID_BRANCH,
+                                 HMDT::Point2D{ x, y }, "River splits at (", x,
+                                 ", ", y, ") without a flow-in or flow-out "
+                                 "marker.");
+                    }
+
+                    if(neighbours <= 1) {
+                        ends.push_back(HMDT::Point2D{ x, y });
+                    }
+                    break;
+            }
+        }
+
+        HMDT::Point2D first{ *begin % width, *begin / width };
+        size_t pixel_count = end - begin;
+
+        // Rivers without any loops are trees, which have one less connection
+        //  than they have pixels
+        if(edges >= pixel_count) {
+            addIssue(HMDT::STATUS_RIVER_LOOP, first, "River containing (",
+                     first.x, ", ", first.y, ") loops back on itself.");
+        }
+
+        // Every river joining this one through a flow-in marker brings its
+        //  own source
+        if(sources == 0) {
+            addIssue(HMDT::STATUS_RIVER_NO_SOURCE, first, "River containing (",
+                     first.x, ", ", first.y, ") has no source.");
+        } else if(sources != flow_ins + 1) {
+            addIssue(HMDT::STATUS_RIVER_SOURCE_MISMATCH, first,
+                     "River containing (", first.x, ", ", first.y, ") has ",
+                     sources, " sources, but ", flow_ins, " flow-in markers.");
+        }
+
+        // Every river branching off of this one through a flow-out marker
+        //  brings its own end
+        if(ends.size() > flow_outs + 1) {
+            std::stringstream ends_ss;
+            for(size_t e = 0; e < ends.size(); ++e) {
+                ends_ss << (e == 0 ? "" : ", ") << '(' << ends[e].x << ", "
+                        << ends[e].y << ')';
+            }
+
+            addIssue(HMDT::STATUS_RIVER_DANGLING_END, ends.front(),
+                     "River containing (", first.x, ", ", first.y, ") ends at ",
+                     ends_ss.str(), ", but only has ", flow_outs,
+                     " flow-out markers.");
+        }
+    }
+}
+
+/**
+ * @brief Checks that every river follows the HoI4 river rules.
+ * @details Rivers are first found by flood filling the map, after which every
+ *          river is checked on its own in parallel. Every issue is a warning,
+ *          as broken rivers do not stop anything else from working.
+ *
+ * @param rivers The 8-bit indexed rivers data
+ * @param width The width of the map
+ * @param height The height of the map
+ *
+ * @return Every issue found, with the pixel each one is about.
+ */
+auto HMDT::validateRivers(const uint8_t* rivers, uint32_t width,
+                          uint32_t height)
+    -> ValidationReport
+{
+    ValidationReport report;
+
+    if(rivers == nullptr || width == 0 || height == 0) {
+        return report;
+    }
+
+    auto found = findRivers(rivers, width, height);
+    auto river_count = static_cast<uint32_t>(found.offsets.size() - 1);
+
+    auto reports = parallelMapChunks(river_count,
+        [&](uint32_t begin, uint32_t end) {
+            ValidationReport chunk_report;
+
+            for(auto river = begin; river < end; ++river) {
+                validateRiver(rivers, width, height,
+                              found.pixels.data() + found.offsets[river],
+                              found.pixels.data() + found.offsets[river + 1],
+                              chunk_report);
+            }
+
+            return chunk_report;
+        });
+
+    for(auto&& chunk_report : reports) {
+        report.merge(std::move(chunk_report));
+    }
+
+    WRITE_DEBUG("Validated ", river_count, " rivers made up of ",
+                found.pixels.size(), " pixels.");
+
+    return report;
+}
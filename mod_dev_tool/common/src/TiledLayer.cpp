@@ -0,0 +1,345 @@
+/**
+ * @file TiledLayer.cpp
+ *
+ * @brief Defines the tiled, copy-on-write layer storage.
+ */
+
+#include "TiledLayer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    /**
+     * @brief Divides two numbers, rounding up
+     */
+    constexpr uint32_t divCeil(uint32_t a, uint32_t b) {
+        return (a + b - 1) / b;
+    }
+}
+
+HMDT::TiledLayer::TiledLayer():
+    TiledLayer(0, 0, 0)
+{ }
+
+/**
+ * @brief Creates a new, entirely zeroed TiledLayer.
+ *
+ * @param width The width of the layer in pixels
+ * @param height The height of the layer in pixels
+ * @param bytes_per_pixel How many bytes make up a single pixel
+ */
+HMDT::TiledLayer::TiledLayer(uint32_t width, uint32_t height,
+                             uint32_t bytes_per_pixel):
+    m_width(width),
+    m_height(height),
+    m_bytes_per_pixel(bytes_per_pixel),
+    m_tile_count_x(divCeil(width, TILE_SIZE)),
+    m_tile_count_y(divCeil(height, TILE_SIZE)),
+    m_tiles(m_tile_count_x * m_tile_count_y, nullptr),
+    m_dirty(m_tile_count_x * m_tile_count_y, false)
+{ }
+
+uint32_t HMDT::TiledLayer::getWidth() const noexcept {
+    return m_width;
+}
+
+uint32_t HMDT::TiledLayer::getHeight() const noexcept {
+    return m_height;
+}
+
+uint32_t HMDT::TiledLayer::getBytesPerPixel() const noexcept {
+    return m_bytes_per_pixel;
+}
+
+uint32_t HMDT::TiledLayer::getTileCountX() const noexcept {
+    return m_tile_count_x;
+}
+
+uint32_t HMDT::TiledLayer::getTileCountY() const noexcept {
+    return m_tile_count_y;
+}
+
+uint32_t HMDT::TiledLayer::getTileCount() const noexcept {
+    return m_tiles.size();
+}
+
+/**
+ * @brief Gets the area of the layer that a tile covers.
+ *
+ * @param tile The index of the tile
+ *
+ * @return The area covered by the tile, in pixels
+ */
+auto HMDT::TiledLayer::getTileRect(uint32_t tile) const noexcept -> Rectangle {
+    auto x = (tile % m_tile_count_x) * TILE_SIZE;
+    auto y = (tile / m_tile_count_x) * TILE_SIZE;
+
+    return Rectangle{ x, y,
+                      std::min(TILE_SIZE, m_width - x),
+                      std::min(TILE_SIZE, m_height - y) };
+}
+
+/**
+ * @brief Gets how many bytes a tile takes up.
+ *
+ * @param tile The index of the tile
+ *
+ * @return The size of the tile in bytes
+ */
+uint32_t HMDT::TiledLayer::getTileByteSize(uint32_t tile) const noexcept {
+    auto rect = getTileRect(tile);
+
+    return rect.w * rect.h * m_bytes_per_pixel;
+}
+
+/**
+ * @brief Gets the data for a tile.
+ *
+ * @param tile The index of the tile
+ *
+ * @return The data of the tile, or nullptr if the tile is entirely zero
+ */
+const uint8_t* HMDT::TiledLayer::getTile(uint32_t tile) const noexcept {
+    return m_tiles.at(tile).get();
+}
+
+/**
+ * @brief Gets the data for a tile so that it may be modified.
+ * @details If the tile is shared with any other copy of this layer (or has
+ *          not been allocated yet), then it will first be copied. The tile is
+ *          also marked as dirty.
+ *
+ * @param tile The index of the tile
+ *
+ * @return The data of the tile, which is owned solely by this layer
+ */
+uint8_t* HMDT::TiledLayer::getMutableTile(uint32_t tile) {
+    auto& tile_ptr = m_tiles.at(tile);
+
+    if(tile_ptr == nullptr || tile_ptr.use_count() > 1) {
+        auto size = getTileByteSize(tile);
+
+        TilePtr new_tile(new uint8_t[size]());
+        if(tile_ptr != nullptr) {
+            std::memcpy(new_tile.get(), tile_ptr.get(), size);
+        }
+
+        tile_ptr = new_tile;
+    }
+
+    m_dirty[tile] = true;
+
+    return tile_ptr.get();
+}
+
+/**
+ * @brief Checks if a tile is also being held by another copy of this layer.
+ *
+ * @param tile The index of the tile
+ */
+bool HMDT::TiledLayer::isTileShared(uint32_t tile) const noexcept {
+    return m_tiles.at(tile).use_count() > 1;
+}
+
+/**
+ * @brief Checks if a tile is the exact same tile as in another layer.
+ * @details Two unallocated tiles are considered to be shared, as they are both
+ *          entirely zero.
+ *
+ * @param other The other layer
+ * @param tile The index of the tile
+ */
+bool HMDT::TiledLayer::sharesTileWith(const TiledLayer& other,
+                                      uint32_t tile) const noexcept
+{
+    return tile < other.m_tiles.size() &&
+           m_tiles.at(tile) == other.m_tiles.at(tile);
+}
+
+/**
+ * @brief Gets every tile which overlaps an area of the layer.
+ *
+ * @param area The area, in pixels. Anything outside of the layer is ignored.
+ *
+ * @return The index of every overlapping tile, in order
+ */
+auto HMDT::TiledLayer::getTilesInRect(const Rectangle& area) const noexcept
+    -> std::vector<uint32_t>
+{
+    return getTilesInRect(m_width, m_height, area);
+}
+
+/**
+ * @brief Gets how many tiles a layer of the given size is split into.
+ *
+ * @param width The width of the layer in pixels
+ * @param height The height of the layer in pixels
+ */
+uint32_t HMDT::TiledLayer::getTileCount(uint32_t width, uint32_t height) noexcept
+{
+    return divCeil(width, TILE_SIZE) * divCeil(height, TILE_SIZE);
+}
+
+/**
+ * @brief Gets every tile of a layer of the given size which overlaps an area.
+ *
+ * @param width The width of the layer in pixels
+ * @param height The height of the layer in pixels
+ * @param area The area, in pixels. Anything outside of the layer is ignored.
+ *
+ * @return The index of every overlapping tile, in order
+ */
+auto HMDT::TiledLayer::getTilesInRect(uint32_t width, uint32_t height,
+                                      const Rectangle& area) noexcept
+    -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> tiles;
+
+    if(area.w == 0 || area.h == 0 || area.x >= width || area.y >= height) {
+        return tiles;
+    }
+
+    auto tile_count_x = divCeil(width, TILE_SIZE);
+    auto last_x = area.x + std::min(area.w, width - area.x) - 1;
+    auto last_y = area.y + std::min(area.h, height - area.y) - 1;
+
+    for(auto ty = area.y / TILE_SIZE; ty <= last_y / TILE_SIZE; ++ty) {
+        for(auto tx = area.x / TILE_SIZE; tx <= last_x / TILE_SIZE; ++tx) {
+            tiles.push_back(ty * tile_count_x + tx);
+        }
+    }
+
+    return tiles;
+}
+
+/**
+ * @brief Copies a single tile out of a flat, row-major buffer.
+ * @details The tile is marked dirty. If it is entirely zero, then it is not
+ *          allocated at all.
+ *
+ * @param tile The index of the tile
+ * @param buffer The buffer to read from. Must be at least
+ *               width * height * bytes_per_pixel bytes large.
+ */
+void HMDT::TiledLayer::captureTile(uint32_t tile, const uint8_t* buffer) {
+    auto rect = getTileRect(tile);
+    auto row_size = rect.w * m_bytes_per_pixel;
+    auto stride = static_cast<uint64_t>(m_width) * m_bytes_per_pixel;
+
+    const auto* src = buffer + rect.y * stride + rect.x * m_bytes_per_pixel;
+
+    bool all_zero = true;
+    for(uint32_t y = 0; y < rect.h && all_zero; ++y) {
+        const auto* src_row = src + y * stride;
+
+        all_zero = std::all_of(src_row, src_row + row_size,
+                               [](uint8_t b) { return b == 0; });
+    }
+
+    if(all_zero) {
+        m_tiles.at(tile).reset();
+        m_dirty[tile] = true;
+        return;
+    }
+
+    auto* dest = getMutableTile(tile);
+    for(uint32_t y = 0; y < rect.h; ++y) {
+        std::memcpy(dest + y * row_size, src + y * stride, row_size);
+    }
+}
+
+/**
+ * @brief Writes a single tile out into a flat, row-major buffer.
+ *
+ * @param tile The index of the tile
+ * @param buffer The buffer to write into. Must be at least
+ *               width * height * bytes_per_pixel bytes large.
+ */
+void HMDT::TiledLayer::copyTileToBuffer(uint32_t tile, uint8_t* buffer) const noexcept
+{
+    auto rect = getTileRect(tile);
+    auto row_size = rect.w * m_bytes_per_pixel;
+    auto stride = static_cast<uint64_t>(m_width) * m_bytes_per_pixel;
+
+    auto* dest = buffer + rect.y * stride + rect.x * m_bytes_per_pixel;
+    const auto* tile_data = m_tiles[tile].get();
+
+    for(uint32_t y = 0; y < rect.h; ++y) {
+        if(tile_data != nullptr) {
+            std::memcpy(dest + y * stride, tile_data + y * row_size, row_size);
+        } else {
+            std::memset(dest + y * stride, 0, row_size);
+        }
+    }
+}
+
+/**
+ * @brief Checks if a tile has been modified since the last call to
+ *        clearDirtyTiles()
+ *
+ * @param tile The index of the tile
+ */
+bool HMDT::TiledLayer::isTileDirty(uint32_t tile) const noexcept {
+    return m_dirty.at(tile);
+}
+
+/**
+ * @brief Gets the index of every dirty tile.
+ */
+auto HMDT::TiledLayer::getDirtyTiles() const noexcept -> std::vector<uint32_t> {
+    std::vector<uint32_t> dirty_tiles;
+
+    for(uint32_t tile = 0; tile < m_dirty.size(); ++tile) {
+        if(m_dirty[tile]) {
+            dirty_tiles.push_back(tile);
+        }
+    }
+
+    return dirty_tiles;
+}
+
+/**
+ * @brief Gets the area covered by every dirty tile.
+ */
+auto HMDT::TiledLayer::getDirtyRects() const noexcept -> std::vector<Rectangle> {
+    std::vector<Rectangle> dirty_rects;
+
+    for(auto&& tile : getDirtyTiles()) {
+        dirty_rects.push_back(getTileRect(tile));
+    }
+
+    return dirty_rects;
+}
+
+/**
+ * @brief Marks a tile as dirty without modifying it.
+ *
+ * @param tile The index of the tile
+ */
+void HMDT::TiledLayer::markTileDirty(uint32_t tile) noexcept {
+    if(tile < m_dirty.size()) {
+        m_dirty[tile] = true;
+    }
+}
+
+void HMDT::TiledLayer::clearDirtyTiles() noexcept {
+    std::fill(m_dirty.begin(), m_dirty.end(), false);
+}
+
+/**
+ * @brief Gets how many bytes of tile data this layer refers to, including
+ *        tiles that are shared with other copies.
+ */
+uint64_t HMDT::TiledLayer::getAllocatedBytes() const noexcept {
+    uint64_t bytes = 0;
+
+    for(uint32_t tile = 0; tile < m_tiles.size(); ++tile) {
+        if(m_tiles[tile] != nullptr) {
+            bytes += getTileByteSize(tile);
+        }
+    }
+
+    return bytes;
+}
+
@@ -4,9 +4,12 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cstdlib>
+#include <cerrno>
+#include <fstream>
 
 #include "Constants.h"
 #include "BitMap.h"
+#include "MemoryReport.h"
 
 #ifdef _WIN32
 # include "windows.h"
@@ -313,6 +316,69 @@ std::pair<uint32_t, uint32_t> HMDT::calcShapeDims(const Polygon& shape) {
     return calcDims(shape.bounding_box);
 }
 
+/**
+ * @brief Estimates how many bytes a list of shapes is holding onto, including
+ *        the pixels and adjacencies of every shape.
+ *
+ * @param shapes The shapes to check
+ */
+uint64_t HMDT::estimateMemoryUsage(const PolygonList& shapes) noexcept {
+    uint64_t bytes = shapes.capacity() * sizeof(Polygon);
+
+    for(auto&& shape : shapes) {
+        bytes += estimateMemoryUsage(shape.pixels);
+        bytes += estimateMemoryUsage(shape.adjacent_labels);
+    }
+
+    return bytes;
+}
+
+/**
+ * @brief Converts a bounding box into the rectangle that it covers
+ *
+ * @param bb The bounding box
+ *
+ * @return A rectangle covering the same area as the bounding box
+ */
+auto HMDT::toRectangle(const BoundingBox& bb) -> Rectangle {
+    auto [width, height] = calcDims(bb);
+
+    return Rectangle{ std::min(bb.bottom_left.x, bb.top_right.x),
+                      std::min(bb.bottom_left.y, bb.top_right.y),
+                      width, height };
+}
+
+/**
+ * @brief Checks if two rectangles overlap
+ *
+ * @param r1 The first rectangle
+ * @param r2 The second rectangle
+ *
+ * @return True if the rectangles share at least one pixel, false otherwise
+ */
+bool HMDT::doRectanglesIntersect(const Rectangle& r1, const Rectangle& r2) {
+    return r1.x < r2.x + r2.w && r2.x < r1.x + r1.w &&
+           r1.y < r2.y + r2.h && r2.y < r1.y + r1.h;
+}
+
+/**
+ * @brief Calculates the smallest rectangle containing both rectangles
+ *
+ * @param r1 The first rectangle
+ * @param r2 The second rectangle
+ *
+ * @return A rectangle containing both r1 and r2
+ */
+auto HMDT::uniteRectangles(const Rectangle& r1, const Rectangle& r2) -> Rectangle
+{
+    auto x = std::min(r1.x, r2.x);
+    auto y = std::min(r1.y, r2.y);
+
+    return Rectangle{ x, y,
+                      std::max(r1.x + r1.w, r2.x + r2.w) - x,
+                      std::max(r1.y + r1.h, r2.y + r2.h) - y };
+}
+
 void HMDT::writeColorTo(unsigned char* color_data, uint32_t w,
                         uint32_t x, uint32_t y, Color c)
 {
@@ -358,6 +424,8 @@ auto HMDT::createProvincesFromShapeList(const PolygonList& shapes)
         };
     }
 
+    provinces.rebuildColumns();
+
     return provinces;
 }
 
@@ -372,6 +440,48 @@ std::filesystem::path HMDT::getExecutablePath() {
     return std::filesystem::path(path).parent_path();
 }
 
+/**
+ * @brief Writes a file, unless it already holds exactly the given contents.
+ * @details Leaving unchanged files alone keeps their modification times, so
+ *          that anything watching them does not see a change.
+ *
+ * @param path The file to write
+ * @param contents What the file should hold
+ *
+ * @return true if the file was written, false if it was already up to date
+ */
+auto HMDT::writeFileIfChanged(const std::filesystem::path& path,
+                              std::string_view contents)
+    -> Maybe<bool>
+{
+    // Only bother reading the file back if it could possibly match
+    if(std::error_code ec; std::filesystem::file_size(path, ec) == contents.size() && !ec)
+    {
+        if(std::ifstream in(path, std::ios::binary); in) {
+            std::string existing(contents.size(), '\0');
+
+            if(in.read(existing.data(), existing.size()) && existing == contents)
+            {
+                return false;
+            }
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if(!out) {
+        WRITE_ERROR("Failed to open file ", path);
+        RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
+    }
+
+    out.write(contents.data(), contents.size());
+    if(!out) {
+        WRITE_ERROR("Failed to write to file ", path);
+        RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
+    }
+
+    return true;
+}
+
 /**
  * @brief Dump a demangled backtrace for the caller to 'out_file'
  *
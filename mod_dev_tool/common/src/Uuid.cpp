@@ -3,6 +3,7 @@
 #include <cstring>
 
 #include "Logger.h"
+#include "StatusCodes.h"
 
 const HMDT::UUID HMDT::EMPTY_UUID(HMDT::UUID::CreationParams::EMPTY);
 
@@ -165,6 +166,66 @@ HMDT::Maybe<HMDT::UUID> HMDT::UUID::parse(const std::string& str) noexcept {
     return uuid;
 }
 
+/**
+ * @brief Decodes a UUID from exactly STRING_REPR_LENGTH characters, without
+ *        allocating or logging anything.
+ * @details Unlike parse(), the string does not need to be null-terminated,
+ *          which allows decoding UUIDs directly out of a larger buffer.
+ *
+ * @param str The characters to decode, in the form
+ *            "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX"
+ *
+ * @return The decoded UUID, or STATUS_INVALID_VALUE if str is not a UUID.
+ */
+auto HMDT::UUID::fromChars(std::string_view str) noexcept -> Maybe<UUID> {
+    RETURN_ERROR_IF(str.size() != STRING_REPR_LENGTH, STATUS_INVALID_VALUE);
+
+    // Where each of the 16 bytes starts in the string
+    constexpr std::uint8_t BYTE_OFFSETS[16] = {
+        0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34
+    };
+
+    auto hexValue = [](char c) -> int {
+        if(c >= '0' && c <= '9') return c - '0';
+        if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    RETURN_ERROR_IF(str[8] != '-' || str[13] != '-' ||
+                    str[18] != '-' || str[23] != '-',
+                    STATUS_INVALID_VALUE);
+
+    std::uint8_t bytes[16];
+    for(std::size_t i = 0; i < 16; ++i) {
+        auto high = hexValue(str[BYTE_OFFSETS[i]]);
+        auto low = hexValue(str[BYTE_OFFSETS[i] + 1]);
+
+        RETURN_ERROR_IF(high < 0 || low < 0, STATUS_INVALID_VALUE);
+
+        bytes[i] = static_cast<std::uint8_t>((high << 4) | low);
+    }
+
+    UUID uuid(CreationParams::EMPTY);
+
+#ifdef WIN32
+    // The first three groups are stored as native integers rather than bytes
+    uuid.m_internal_uuid.Data1 = (static_cast<unsigned long>(bytes[0]) << 24) |
+                                 (static_cast<unsigned long>(bytes[1]) << 16) |
+                                 (static_cast<unsigned long>(bytes[2]) << 8) |
+                                  static_cast<unsigned long>(bytes[3]);
+    uuid.m_internal_uuid.Data2 = static_cast<unsigned short>((bytes[4] << 8) |
+                                                              bytes[5]);
+    uuid.m_internal_uuid.Data3 = static_cast<unsigned short>((bytes[6] << 8) |
+                                                              bytes[7]);
+    std::memcpy(uuid.m_internal_uuid.Data4, bytes + 8, 8);
+#else
+    std::memcpy(uuid.m_internal_uuid, bytes, sizeof(bytes));
+#endif
+
+    return uuid;
+}
+
 std::ostream& HMDT::operator<<(std::ostream& out, const UUID& uuid) noexcept {
     return out << std::to_string(uuid);
 
@@ -0,0 +1,160 @@
+/**
+ * @file ValidationReport.cpp
+ *
+ * @brief Defines the report of every issue found while validating a project.
+ */
+
+#include "ValidationReport.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+#include "Logger.h"
+
+/**
+ * @brief Adds a new issue.
+ *
+ * @param severity How severe the issue is
+ * @param validator The name of the validator which found the issue
+ * @param code The status code describing the issue
+ * @param message A description of the issue
+ *
+ * @return The new issue, so that the province, state or pixel it is about may
+ *         be filled in.
+ */
+auto HMDT::ValidationReport::addIssue(Severity severity,
+                                      const std::string& validator,
+                                      std::error_code code,
+                                      const std::string& message)
+    -> Issue&
+{
+    return m_issues.emplace_back(Issue{ severity, validator, code, message,
+                                        std::nullopt, std::nullopt,
+                                        std::nullopt, false });
+}
+
+/**
+ * @brief Moves every issue out of another report and onto the end of this one.
+ *
+ * @param other The report to merge into this one
+ */
+void HMDT::ValidationReport::merge(ValidationReport&& other) {
+    if(m_issues.empty()) {
+        m_issues = std::move(other.m_issues);
+    } else {
+        m_issues.insert(m_issues.end(),
+                        std::make_move_iterator(other.m_issues.begin()),
+                        std::make_move_iterator(other.m_issues.end()));
+    }
+
+    other.m_issues.clear();
+}
+
+auto HMDT::ValidationReport::getIssues() const noexcept
+    -> const std::vector<Issue>&
+{
+    return m_issues;
+}
+
+auto HMDT::ValidationReport::getIssues() noexcept -> std::vector<Issue>& {
+    return m_issues;
+}
+
+/**
+ * @brief Counts the issues of a given severity which have not been fixed.
+ */
+size_t HMDT::ValidationReport::count(Severity severity) const noexcept {
+    return std::count_if(m_issues.begin(), m_issues.end(),
+                         [severity](const Issue& issue) {
+                             return !issue.fixed && issue.severity == severity;
+                         });
+}
+
+size_t HMDT::ValidationReport::countFixed() const noexcept {
+    return std::count_if(m_issues.begin(), m_issues.end(),
+                         [](const Issue& issue) { return issue.fixed; });
+}
+
+bool HMDT::ValidationReport::empty() const noexcept {
+    return m_issues.empty();
+}
+
+/**
+ * @brief Checks if any error has not been fixed.
+ */
+bool HMDT::ValidationReport::hasErrors() const noexcept {
+    return std::any_of(m_issues.begin(), m_issues.end(),
+                       [](const Issue& issue) {
+                           return !issue.fixed &&
+                                  issue.severity == Severity::ERROR;
+                       });
+}
+
+/**
+ * @brief Renders a summary of this report, grouping issues by the validator
+ *        which found them.
+ *
+ * @param max_per_validator The most issues to list for each validator. Any
+ *                          more are only counted.
+ */
+std::string HMDT::ValidationReport::toString(size_t max_per_validator) const {
+    std::string str = std::to_string(count(Severity::ERROR)) + " errors, " +
+                      std::to_string(count(Severity::WARNING)) + " warnings, " +
+                      std::to_string(countFixed()) + " fixed\n";
+
+    // Group the issues by validator, keeping validators in the order they
+    //   first reported something
+    std::vector<std::string> validators;
+    std::map<std::string, std::vector<const Issue*>> issues_by_validator;
+    for(auto&& issue : m_issues) {
+        auto& issues = issues_by_validator[issue.validator];
+        if(issues.empty()) {
+            validators.push_back(issue.validator);
+        }
+
+        issues.push_back(&issue);
+    }
+
+    for(auto&& validator : validators) {
+        auto& issues = issues_by_validator.at(validator);
+
+        str += "  " + validator + ": " + std::to_string(issues.size()) +
+               " issues\n";
+
+        for(size_t i = 0; i < issues.size() && i < max_per_validator; ++i) {
+            auto* issue = issues[i];
+
+            str += std::string("    ") +
+                   (issue->severity == Severity::ERROR ? "ERROR: " : "WARNING: ") +
+                   issue->message +
+                   (issue->fixed ? " (fixed)" : "") + '\n';
+        }
+
+        if(issues.size() > max_per_validator) {
+            str += "    ... and " +
+                   std::to_string(issues.size() - max_per_validator) +
+                   " more\n";
+        }
+    }
+
+    return str;
+}
+
+/**
+ * @brief Writes a summary of this report to the log, at the level of the most
+ *        severe issue which has not been fixed.
+ *
+ * @param max_per_validator The most issues to list for each validator
+ */
+void HMDT::ValidationReport::writeToLog(size_t max_per_validator) const {
+    if(m_issues.empty()) {
+        WRITE_INFO("Validation found no issues.");
+    } else if(hasErrors()) {
+        WRITE_ERROR("Validation results: ", toString(max_per_validator));
+    } else if(count(Severity::WARNING) != 0) {
+        WRITE_WARN("Validation results: ", toString(max_per_validator));
+    } else {
+        WRITE_INFO("Validation results: ", toString(max_per_validator));
+    }
+}
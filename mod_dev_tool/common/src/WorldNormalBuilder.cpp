@@ -10,7 +10,10 @@
 
 #include "WorldNormalBuilder.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath> // std::sqrt
+#include <vector>
 
 #include "BitMap.h"
 #include "Util.h"
@@ -55,72 +58,197 @@ namespace {
     }
 }
 
-auto HMDT::generateWorldNormalMap(const BitMap2& heightmap,
-                                  unsigned char* normal_data)
-    -> MaybeVoid
-{
-    auto width = heightmap.info_header.v1.width;
-    auto height = heightmap.info_header.v1.height;
+namespace {
+    /**
+     * @brief The Z component of every normal, scaled the same way as the
+     *        sobel sums are. Intensities are summed up as r+g+b rather than
+     *        being divided down to [0, 1], so everything is 3*255 times larger.
+     */
+    constexpr float SCALED_SOBEL_Z = (3.0f * 255.0f) / 2.0f;
+
+    //! The intensity of every 8-bit heightmap value, as r+g+b
+    using IntensityTable = std::array<int32_t, 256>;
+
+    /**
+     * @brief Looks up the intensity of every value in a heightmap's color
+     *        table.
+     *
+     * @param heightmap The heightmap. Must be an 8-bit image with a color
+     *                  table.
+     *
+     * @return The intensity table, or an error code if the heightmap is not an
+     *         8-bit image with a color table.
+     */
+    auto buildIntensityTable(const HMDT::BitMap2& heightmap)
+        -> HMDT::Maybe<IntensityTable>
+    {
+        // Heightmaps _MUST_ be 8-bit images
+        if(heightmap.info_header.v1.bitsPerPixel != 8) {
+            RETURN_ERROR(HMDT::STATUS_INVALID_BIT_DEPTH);
+        }
+
+        if(heightmap.color_table == nullptr) {
+            WRITE_ERROR("8-bit bitmaps require a color table to be provided!");
+            RETURN_ERROR(HMDT::STATUS_COLOR_TABLE_REQUIRED);
+        }
+
+        // Values past the end of the color table are treated as black
+        IntensityTable intensities{ };
+        auto num_colors = std::min<size_t>(intensities.size(),
+                                           heightmap.info_header.v1.colorsUsed);
+        for(size_t i = 0; i < num_colors; ++i) {
+            const auto& color = heightmap.color_table[i];
+            intensities[i] = color.red + color.green + color.blue;
+        }
 
-    // Heightmaps _MUST_ be 8-bit images
-    if(heightmap.info_header.v1.bitsPerPixel != 8) {
-        RETURN_ERROR(STATUS_INVALID_BIT_DEPTH);
+        return intensities;
     }
 
-    // For every single pixel
-    for(int y = 0; y < height; ++y) {
-        for(int x = 0; x < width; ++x) {
-            // Index into normal_data based on our current X,Y coordinate
-            // Hardcode 3 because we want the output to have a pixel-depth of 3
-            auto index = xyToIndex(width * 3, x * 3, y);
+    /**
+     * @brief Writes the normals for a band of rows.
+     * @details The sobel filter is split into a vertical and a horizontal
+     *          pass. Every row first gets the vertically smoothed and the
+     *          vertically differenced sums of the rows around it, padded by
+     *          one pixel on either side, after which each normal only needs
+     *          the three neighbouring sums. All edges are clamped before the
+     *          inner loops, so that they never need to branch.
+     *
+     * @param data The 8-bit heightmap data
+     * @param intensities The intensity of every heightmap value
+     * @param width The width of the heightmap
+     * @param height The height of the heightmap
+     * @param begin_x The first column to write
+     * @param end_x One past the last column to write
+     * @param begin_y The first row to write
+     * @param end_y One past the last row to write
+     * @param normal_data The normals of the whole heightmap, as 24-bit color
+     */
+    void writeNormalRows(const uint8_t* data,
+                         const IntensityTable& intensities,
+                         uint32_t width, uint32_t height,
+                         uint32_t begin_x, uint32_t end_x,
+                         uint32_t begin_y, uint32_t end_y,
+                         unsigned char* normal_data)
+    {
+        auto span = end_x - begin_x;
 
-            // Surrounding pixels
-            auto top_left  = getAsPixel(heightmap, clamp(x - 1, 0, width), clamp(y - 1, 0, height));
-            RETURN_IF_ERROR(top_left);
-            auto top       = getAsPixel(heightmap, x, clamp(y - 1, 0, height));
-            RETURN_IF_ERROR(top);
-            auto top_right = getAsPixel(heightmap, clamp(x + 1, 0, width), clamp(y - 1, 0, height));
-            RETURN_IF_ERROR(top_right);
-            auto left      = getAsPixel(heightmap, clamp(x - 1, 0, width), y);
-            RETURN_IF_ERROR(left);
-            auto right     = getAsPixel(heightmap, clamp(x + 1, 0, width), y);
-            RETURN_IF_ERROR(right);
-            auto bot_left  = getAsPixel(heightmap, clamp(x - 1, 0, width), clamp(y + 1, 0, height));
-            RETURN_IF_ERROR(bot_left);
-            auto bot       = getAsPixel(heightmap, x, clamp(y + 1, 0, height));
-            RETURN_IF_ERROR(bot);
-            auto bot_right = getAsPixel(heightmap, clamp(x + 1, 0, width), clamp(y + 1, 0, height));
-            RETURN_IF_ERROR(bot_right);
+        // Both hold one extra pixel on either side of the span
+        std::vector<int32_t> smoothed(span + 2);
+        std::vector<int32_t> differences(span + 2);
 
-            // Get intensities of surrounding pixels
-            double tl_intensity = intensity(top_left->color);
-            double t_intensity = intensity(top->color);
-            double tr_intensity = intensity(top_right->color);
-            double l_intensity = intensity(left->color);
-            double r_intensity = intensity(right->color);
-            double bl_intensity = intensity(bot_left->color);
-            double b_intensity = intensity(bot->color);
-            double br_intensity = intensity(bot_right->color);
+        // The columns actually read, which only reach outside of the span
+        //  where it isn't on the edge of the map
+        auto first_x = begin_x > 0 ? begin_x - 1 : 0;
+        auto last_x = std::min(end_x + 1, width);
+        auto* smoothed_out = smoothed.data() + 1 - (begin_x - first_x);
+        auto* differences_out = differences.data() + 1 - (begin_x - first_x);
 
-            // sobel filter
-            double dX = (tr_intensity + 2.0 * r_intensity + br_intensity) - (tl_intensity + 2.0 * l_intensity + bl_intensity);
-            double dY = (bl_intensity + 2.0 * b_intensity + br_intensity) - (tl_intensity + 2.0 * t_intensity + tr_intensity);
-            double dZ = 1.0 / 2.0;
+        for(uint32_t y = begin_y; y < end_y; ++y) {
+            const auto* up = data + static_cast<size_t>(y > 0 ? y - 1 : y) * width + first_x;
+            const auto* row = data + static_cast<size_t>(y) * width + first_x;
+            const auto* down = data + static_cast<size_t>(y + 1 < height ? y + 1 : y) * width + first_x;
 
-            // Normalize the sobel filter values
-            auto [nX, nY, nZ] = normalize(dX, dY, dZ);
+            for(uint32_t i = 0; i < last_x - first_x; ++i) {
+                auto u = intensities[up[i]];
+                auto m = intensities[row[i]];
+                auto d = intensities[down[i]];
 
-            // Convert the coordinates back into color values
-            auto r = static_cast<std::uint8_t>((nX + 1.0) * (255.0 / 2.0));
-            auto g = static_cast<std::uint8_t>((nY + 1.0) * (255.0 / 2.0));
-            auto b = static_cast<std::uint8_t>((nZ + 1.0) * (255.0 / 2.0));
+                smoothed_out[i] = u + 2 * m + d;
+                differences_out[i] = d - u;
+            }
 
-            // Finally, place the new color data into the output array.
-            normal_data[index] = r;
-            normal_data[index + 1] = g;
-            normal_data[index + 2] = b;
+            if(begin_x == 0) {
+                smoothed[0] = smoothed[1];
+                differences[0] = differences[1];
+            }
+            if(end_x == width) {
+                smoothed[span + 1] = smoothed[span];
+                differences[span + 1] = differences[span];
+            }
+
+            auto* out = normal_data + (static_cast<size_t>(y) * width + begin_x) * 3;
+
+            for(uint32_t x = 0; x < span; ++x) {
+                auto dx = static_cast<float>(smoothed[x + 2] - smoothed[x]);
+                auto dy = static_cast<float>(differences[x] +
+                                             2 * differences[x + 1] +
+                                             differences[x + 2]);
+
+                // Normalize the sobel filter values, and convert them back
+                //   into color values
+                auto scale = (255.0f / 2.0f) /
+                             std::sqrt(dx * dx + dy * dy +
+                                       SCALED_SOBEL_Z * SCALED_SOBEL_Z);
+
+                out[x * 3] = static_cast<uint8_t>(dx * scale + (255.0f / 2.0f));
+                out[x * 3 + 1] = static_cast<uint8_t>(dy * scale + (255.0f / 2.0f));
+                out[x * 3 + 2] = static_cast<uint8_t>(SCALED_SOBEL_Z * scale + (255.0f / 2.0f));
+            }
         }
     }
+}
+
+/**
+ * @brief Generates a world normal map from the given heightmap.
+ *
+ * @param heightmap The input heightmap to generate a normal map from. Must be
+ *                  an 8-bit image with a color table.
+ * @param normal_data The output image data array. Must hold 3 bytes for every
+ *                    pixel of the heightmap.
+ *
+ * @return STATUS_SUCCESS on success, or an error code if the heightmap is not
+ *         an 8-bit image with a color table.
+ */
+auto HMDT::generateWorldNormalMap(const BitMap2& heightmap,
+                                  unsigned char* normal_data)
+    -> MaybeVoid
+{
+    return generateWorldNormalMap(heightmap, normal_data,
+                                  Rectangle{ 0, 0,
+                                             static_cast<uint32_t>(heightmap.info_header.v1.width),
+                                             static_cast<uint32_t>(heightmap.info_header.v1.height) });
+}
+
+/**
+ * @brief Regenerates part of a world normal map from the given heightmap.
+ * @details The intensity of every possible heightmap value is looked up from
+ *          the color table once, and the rows of the area are then split into
+ *          bands which are filtered in parallel. Normals outside of the area
+ *          are left untouched.
+ *
+ * @param heightmap The input heightmap to generate a normal map from. Must be
+ *                  an 8-bit image with a color table.
+ * @param normal_data The output image data array. Must hold 3 bytes for every
+ *                    pixel of the heightmap.
+ * @param area The area of the normal map to regenerate. Clamped to the map.
+ *
+ * @return STATUS_SUCCESS on success, or an error code if the heightmap is not
+ *         an 8-bit image with a color table.
+ */
+auto HMDT::generateWorldNormalMap(const BitMap2& heightmap,
+                                  unsigned char* normal_data,
+                                  const Rectangle& area)
+    -> MaybeVoid
+{
+    uint32_t width = heightmap.info_header.v1.width;
+    uint32_t height = heightmap.info_header.v1.height;
+
+    auto intensities = buildIntensityTable(heightmap);
+    RETURN_IF_ERROR(intensities);
+
+    if(area.x >= width || area.y >= height || area.w == 0 || area.h == 0) {
+        return STATUS_SUCCESS;
+    }
+
+    auto end_x = area.x + std::min(area.w, width - area.x);
+    auto end_y = area.y + std::min(area.h, height - area.y);
+
+    parallelMapChunks(end_y - area.y, [&](uint32_t begin, uint32_t end) {
+        writeNormalRows(heightmap.data.get(), *intensities, width, height,
+                        area.x, end_x, area.y + begin, area.y + end,
+                        normal_data);
+        return true;
+    });
 
     return STATUS_SUCCESS;
 }
@@ -29,6 +29,7 @@ void HMDT::printHelp() {
     std::cout << "\t   --debug                 Should debugging features be enabled." << std::endl;
     std::cout << "\t   --dont-write-logfiles   Should log files get written to a file." << std::endl;
     std::cout << "\t   --fix-warnings-on-load  Whether or not problems in a project file should attempt to be fixed when they are loaded." << std::endl;
+    std::cout << "\t   --memory-report         Print how much memory is being used once the shapes have been found. Only used in headless mode." << std::endl;
     std::cout << "\t-v,--verbose               Display all output." << std::endl;
     std::cout << "\t-q,--quiet                 Display only errors and warnings (does not affect this message)." << std::endl;
     std::cout << "\t-h,--help                  Display this message and exit." << std::endl;
@@ -65,11 +66,12 @@ auto HMDT::parseArgs(int argc, char** argv) -> ProgramOptions {
         { "debug", no_argument, NULL, 8 },
         { "dont-write-logfiles", no_argument, NULL, 9 },
         { "fix-warnings-on-load", no_argument, NULL, 10 },
+        { "memory-report", no_argument, NULL, 11 },
         { nullptr, 0, nullptr, 0}
     };
 
     // Setup default option values
-    ProgramOptions prog_opts { 0, "", "", false, false, "", "", false, "", false, false, false, false, false };
+    ProgramOptions prog_opts { 0, "", "", false, false, "", "", false, "", false, false, false, false, false, false };
 
     int optindex = 0;
     int c = 0;
@@ -139,6 +141,9 @@ auto HMDT::parseArgs(int argc, char** argv) -> ProgramOptions {
             case 10: // --fix-warnings-on-load
                 prog_opts.fix_warnings_on_load = true;
                 break;
+            case 11: // --memory-report
+                prog_opts.memory_report = true;
+                break;
             case 'v': // -v,--verbose
                 if(prog_opts.quiet) {
                     WRITE_ERROR("Conflicting command line arguments 'v' and 'q'");
@@ -13,6 +13,7 @@
 #include "Logger.h"
 #include "Util.h"
 #include "Options.h"
+#include "MemoryReport.h"
 
 // GUI
 #include "Driver.h"
@@ -166,6 +167,20 @@ int HMDT::runHeadless() {
 
     WRITE_INFO("Detected ", std::to_string(shapes.size()), " shapes.");
 
+    if(prog_opts.memory_report) {
+        MemoryReport report("Total");
+        report.addChild("Input Image", static_cast<uint64_t>(data_size));
+        report.addChild("Output Images", static_cast<uint64_t>(data_size) * 2);
+        report.addChild("Shapes (" + std::to_string(shapes.size()) + ")",
+                        estimateMemoryUsage(shapes));
+        map_data->reportMemoryUsage(report.addChild("Map Data"));
+
+        std::cout << report.toString();
+        for(auto&& warning : report.getAllWarnings()) {
+            std::cout << "WARNING: " << warning << std::endl;
+        }
+    }
+
     WRITE_INFO("Creating Provinces List.");
     auto provinces = createProvinceList(shapes);
 
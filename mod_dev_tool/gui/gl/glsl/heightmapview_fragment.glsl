@@ -0,0 +1,15 @@
+#version 410 core
+
+out vec4 FragColor; // Output color value
+
+// The heights of a single level of the heightmap pyramid
+uniform sampler2D heightmap;
+
+in vec2 texture_coords; // Input from vertex shader
+
+void main() {
+    float height = texture(heightmap, texture_coords).r;
+
+    FragColor = vec4(vec3(height), 1.0);
+}
+
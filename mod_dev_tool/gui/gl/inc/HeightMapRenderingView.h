@@ -0,0 +1,60 @@
+/**
+ * @file HeightMapRenderingView.h
+ *
+ * @file Defines the HeightMapRenderingView class
+ */
+
+#ifndef HEIGHTMAPRENDERINGVIEW_H
+# define HEIGHTMAPRENDERINGVIEW_H
+
+# include <memory>
+# include <utility>
+
+# include "MapRenderingViewBase.h"
+
+namespace HMDT {
+    class HeightMapPyramid;
+}
+
+namespace HMDT::GUI::GL {
+    /**
+     * @brief Renders the heightmap as greyscale.
+     * @details Only the smallest level of the heightmap's mip pyramid which
+     *          still covers the map at its current size on screen is uploaded,
+     *          so a zoomed out map never has to upload the full resolution
+     *          heightmap.
+     */
+    class HeightMapRenderingView: public MapRenderingViewBase {
+        public:
+            HeightMapRenderingView() = default;
+
+            virtual void init() override;
+            virtual void beginRender() override;
+            virtual void render() override;
+
+            virtual void onMapDataChanged(std::shared_ptr<const MapData>) override;
+
+        protected:
+            virtual void setupUniforms() override;
+
+            virtual const std::string& getVertexShaderSource() const override;
+            virtual const std::string& getFragmentShaderSource() const override;
+
+            void updateHeightMapTexture();
+
+        private:
+            std::shared_ptr<const MapData> m_map_data;
+
+            //! The uploaded level of the heightmap pyramid
+            Texture m_heightmap_texture;
+
+            //! The pyramid that the uploaded level belongs to
+            std::shared_ptr<const HeightMapPyramid> m_last_pyramid;
+
+            //! The size of the uploaded level
+            std::pair<uint32_t, uint32_t> m_last_level_size = { 0, 0 };
+    };
+}
+
+#endif
+
@@ -7,7 +7,12 @@
 #ifndef PROVINCERENDERINGVIEW_H
 # define PROVINCERENDERINGVIEW_H
 
+# include <memory>
 # include <optional>
+# include <set>
+# include <vector>
+
+# include "Types.h"
 
 # include "MapRenderingViewBase.h"
 
@@ -31,11 +36,50 @@ namespace HMDT::GUI::GL {
             Texture& getMapTexture();
             Texture& getLabelTexture();
 
+            const std::vector<uint32_t>& getAdjacentLabels(const IMapDrawingAreaBase::SelectionList&);
+
             virtual void setupUniforms() override;
             virtual const std::string& getVertexShaderSource() const override;
             virtual const std::string& getFragmentShaderSource() const override;
 
         private:
+            /**
+             * @brief The provinces bordering the selected merged province
+             * @details Shared with the merge listener, which marks it as stale
+             *          whenever the selected merged province is merged or
+             *          unmerged.
+             */
+            struct AdjacencyOverlay {
+                //! The province the overlay was built for
+                ProvinceID selection;
+
+                //! Every province merged with the selection
+                std::set<ProvinceIndex> members;
+
+                //! The label matrix generation the overlay was built from
+                uint64_t label_generation = -1;
+
+                //! The label of every province bordering the members
+                std::vector<uint32_t> adjacent_labels;
+
+                //! Whether the overlay must be rebuilt before being drawn
+                bool stale = true;
+            };
+
+            void listenForMerges();
+
+            //! The map data that the textures are built from
+            std::shared_ptr<const MapData> m_map_data;
+
+            //! The last uploaded generation of the province colors
+            uint64_t m_last_colors_generation = -1;
+
+            //! The last uploaded generation of the label matrix
+            uint64_t m_last_labels_generation = -1;
+
+            //! The last uploaded generation of the province outlines
+            uint64_t m_last_outlines_generation = -1;
+
             //! The shader for rendering the map outlines
             Program m_outline_shader;
 
@@ -50,6 +94,12 @@ namespace HMDT::GUI::GL {
 
             //! The outline texture
             Texture m_outline_texture;
+
+            //! The adjacency overlay of the current selection
+            std::shared_ptr<AdjacencyOverlay> m_adjacency_overlay = std::make_shared<AdjacencyOverlay>();
+
+            //! The province project that the merge listener is registered with
+            const void* m_merge_listener_project = nullptr;
     };
 }
 
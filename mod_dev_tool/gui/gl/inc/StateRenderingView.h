@@ -34,6 +34,8 @@ namespace HMDT::GUI::GL {
             Texture& getStateIDMatrixTexture();
 
             void updateStateIDTexture();
+            void updateStateOutlineTexture();
+            void updateStateColorTexture();
 
         private:
             std::shared_ptr<const MapData> m_map_data;
@@ -41,8 +43,23 @@ namespace HMDT::GUI::GL {
             //! The state ID texture
             Texture m_state_id_texture;
 
-            //! A tag for the last state ID matrix value, used to know if it needs to be refreshed
-            uint32_t m_last_state_id_matrix_updated_tag = -1;
+            //! The last uploaded generation of the state ID matrix
+            uint64_t m_last_state_id_matrix_generation = -1;
+
+            //! The state outlines, as a single channel mask
+            Texture m_state_outline_texture;
+
+            //! The last uploaded generation of the state outlines
+            uint64_t m_last_state_outlines_generation = -1;
+
+            //! The color of every state, indexed by its ID
+            Texture m_state_color_texture;
+
+            //! The last uploaded state color generation
+            uint64_t m_last_state_color_generation = -1;
+
+            //! The last state ID matrix generation the colors were uploaded for
+            uint64_t m_last_state_color_matrix_generation = -1;
     };
 }
 
@@ -13,6 +13,8 @@
 # include <string>
 # include <optional>
 
+# include "Types.h"
+
 namespace HMDT::GUI::GL {
     /**
      * @brief Represents an OpenGL texture
@@ -117,12 +119,38 @@ namespace HMDT::GUI::GL {
                                typeToDataType(typeid(T)), data, format);
             }
 
+            /**
+             * @brief Sends a part of the texture data to the GPU.
+             *
+             * @details Implicitly calls bind(). The texture must already have
+             *          been created with setTextureData().
+             *
+             * @tparam T The type of data being passed in
+             *
+             * @param internal_format The format of the data, which must match
+             *                        what the texture was created with.
+             * @param area The area of the texture to update
+             * @param data The data of the entire texture. Only the part
+             *             inside of area will be sent.
+             */
+            template<typename T>
+            void setSubTextureData(Format internal_format,
+                                   const Rectangle& area, const T* data,
+                                   std::optional<uint32_t> format = std::nullopt)
+            {
+                setSubTextureData(internal_format, area,
+                                  typeToDataType(typeid(T)), data, format);
+            }
+
             uint32_t getTextureUnitID() const;
             uint32_t getTextureID() const;
             uint32_t getWidth() const;
             uint32_t getHeight() const;
             std::pair<uint32_t, uint32_t> getDimensions() const;
 
+            uint64_t getAllocatedBytes() const;
+            static uint64_t getTotalAllocatedBytes();
+
             void bind(bool = true);
             uint32_t activate();
 
@@ -136,9 +164,12 @@ namespace HMDT::GUI::GL {
             static uint32_t filterToGLFilter(Filter);
             static uint32_t filterTypeToGLFilterType(FilterType);
             static uint32_t unitToGLUnit(Unit);
+            static uint32_t formatToBytesPerPixel(Format);
 
             void setTextureData(Format, uint32_t, uint32_t, uint32_t,
                                 const void*, std::optional<uint32_t>);
+            void setSubTextureData(Format, const Rectangle&, uint32_t,
+                                   const void*, std::optional<uint32_t>);
 
         private:
             //! The texture ID
@@ -152,6 +183,12 @@ namespace HMDT::GUI::GL {
 
             uint32_t m_width;
             uint32_t m_height;
+
+            //! An estimate of how many bytes this texture takes up on the GPU
+            uint64_t m_allocated_bytes;
+
+            //! An estimate of how many bytes every texture takes up on the GPU
+            static inline uint64_t total_allocated_bytes = 0;
     };
 }
 
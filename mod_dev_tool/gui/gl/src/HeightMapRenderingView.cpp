@@ -0,0 +1,143 @@
+/**
+ * @file HeightMapRenderingView.cpp
+ *
+ * @file Defines the HeightMapRenderingView class
+ */
+
+#include "HeightMapRenderingView.h"
+
+#include <cmath>
+
+#include <GL/glew.h>
+
+#include "GLShaderSources.h"
+
+#include "Logger.h"
+#include "HeightMapPyramid.h"
+
+#include "Driver.h"
+
+#include "MapDrawingAreaGL.h"
+
+/**
+ * @brief Initializes a HeightMapRenderingView
+ */
+void HMDT::GUI::GL::HeightMapRenderingView::init() {
+    MapRenderingViewBase::init();
+
+    m_heightmap_texture.setTextureUnitID(Texture::Unit::TEX_UNIT7);
+
+    m_heightmap_texture.setWrapping(Texture::Axis::S, Texture::WrapMode::CLAMP_TO_EDGE);
+    m_heightmap_texture.setWrapping(Texture::Axis::T, Texture::WrapMode::CLAMP_TO_EDGE);
+
+    // Levels are usually a bit larger than what is on screen, so filter them
+    m_heightmap_texture.setFiltering(Texture::FilterType::MAG, Texture::Filter::LINEAR);
+    m_heightmap_texture.setFiltering(Texture::FilterType::MIN, Texture::Filter::LINEAR);
+
+    updateHeightMapTexture();
+}
+
+void HMDT::GUI::GL::HeightMapRenderingView::beginRender() {
+    MapRenderingViewBase::beginRender();
+
+    updateHeightMapTexture();
+}
+
+/**
+ * @brief Uploads the level of the heightmap pyramid which fits the map's
+ *        current size on screen.
+ * @details Nothing is uploaded if that level is already on the GPU. The
+ *          largest level is used if even that is smaller than the map on
+ *          screen, as the full resolution heightmap holds palette indices
+ *          rather than heights.
+ */
+void HMDT::GUI::GL::HeightMapRenderingView::updateHeightMapTexture() {
+    if(m_map_data == nullptr) return;
+
+    auto opt_project = Driver::getInstance().getProject();
+    if(!opt_project) return;
+
+    const auto& heightmap_project = opt_project->get().getMapProject().getHeightMapProject();
+
+    auto pyramid = heightmap_project.getHeightMapPyramid();
+    if(IS_FAILURE(pyramid)) {
+        WRITE_ERROR("Failed to get the heightmap pyramid.");
+        WRITE_IF_ERROR(pyramid);
+        return;
+    }
+
+    if(*pyramid == nullptr || (*pyramid)->getLevelCount() == 0) return;
+
+    // How large the map currently is on screen
+    auto scale = getOwningGLDrawingArea()->getScaleFactor();
+    auto [width, height] = m_map_data->getDimensions();
+    auto screen_width = static_cast<uint32_t>(std::ceil(width * scale));
+    auto screen_height = static_cast<uint32_t>(std::ceil(height * scale));
+
+    auto level = (*pyramid)->findLevel(screen_width, screen_height);
+    if(IS_FAILURE(level)) {
+        level = (*pyramid)->getLevel(0);
+    }
+
+    const auto& [level_width, level_height, data] = level->get();
+
+    if(*pyramid == m_last_pyramid &&
+       m_last_level_size == std::make_pair(level_width, level_height))
+    {
+        return;
+    }
+
+    WRITE_DEBUG("Uploading ", level_width, "x", level_height,
+                " level of the heightmap pyramid.");
+
+    m_heightmap_texture.bind();
+    m_heightmap_texture.setTextureData(Texture::Format::RED,
+                                       level_width, level_height,
+                                       data.data());
+    m_heightmap_texture.bind(false);
+
+    m_last_pyramid = *pyramid;
+    m_last_level_size = std::make_pair(level_width, level_height);
+}
+
+/**
+ * @brief Renders the heightmap
+ */
+void HMDT::GUI::GL::HeightMapRenderingView::render() {
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Nothing has been uploaded without any map data
+    if(m_map_data == nullptr || m_last_pyramid == nullptr) return;
+
+    getMapProgram().uniform("heightmap", m_heightmap_texture);
+    m_heightmap_texture.activate();
+
+    MapRenderingViewBase::render();
+}
+
+void HMDT::GUI::GL::HeightMapRenderingView::setupUniforms() {
+    getMapProgram().uniform("heightmap", m_heightmap_texture);
+}
+
+const std::string& HMDT::GUI::GL::HeightMapRenderingView::getVertexShaderSource() const
+{
+    return ShaderSources::heightmapview_vertex;
+}
+
+const std::string& HMDT::GUI::GL::HeightMapRenderingView::getFragmentShaderSource() const
+{
+    return ShaderSources::heightmapview_fragment;
+}
+
+/**
+ * @brief Forgets the uploaded level, so that the next render uploads it again
+ *        for the new map data.
+ */
+void HMDT::GUI::GL::HeightMapRenderingView::onMapDataChanged(std::shared_ptr<const MapData> map_data)
+{
+    m_map_data = map_data;
+
+    m_last_pyramid.reset();
+    m_last_level_size = { 0, 0 };
+}
@@ -23,6 +23,7 @@
 #include "GLUtils.h"
 #include "ProvinceRenderingView.h"
 #include "StateRenderingView.h"
+#include "HeightMapRenderingView.h"
 
 HMDT::GUI::GL::MapDrawingArea::MapDrawingArea():
     m_initialized(false)
@@ -141,6 +142,7 @@ void HMDT::GUI::GL::MapDrawingArea::init() {
 
     m_rendering_views[ViewingMode::PROVINCE_VIEW].reset(new ProvinceRenderingView());
     m_rendering_views[ViewingMode::STATES_VIEW].reset(new StateRenderingView());
+    m_rendering_views[ViewingMode::HEIGHTMAP_VIEW].reset(new HeightMapRenderingView());
 
     WRITE_DEBUG("Initializing each rendering view.");
     for(auto&& [viewing_mode, rendering_view] : m_rendering_views) {
@@ -6,6 +6,8 @@
 
 #include "ProvinceRenderingView.h"
 
+#include <algorithm>
+
 #include <GL/glew.h>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -21,6 +23,51 @@
 
 #include "MapDrawingAreaGL.h"
 
+namespace {
+    /**
+     * @brief Uploads the parts of a layer that have changed since the last
+     *        upload into a texture.
+     *
+     * @tparam T The type of data in the layer
+     *
+     * @param map_data The map data the layer belongs to
+     * @param layer The layer to upload
+     * @param last_generation The generation of the layer which was last
+     *                        uploaded. Gets updated to the current generation.
+     * @param texture The texture to upload into
+     * @param internal_format The format of the texture
+     * @param data The data of the layer
+     * @param format The format of the data, if different from internal_format
+     */
+    template<typename T>
+    void uploadLayerChanges(const HMDT::MapData& map_data,
+                            HMDT::MapData::Layer layer,
+                            uint64_t& last_generation,
+                            HMDT::GUI::GL::Texture& texture,
+                            HMDT::GUI::GL::Texture::Format internal_format,
+                            const T* data,
+                            std::optional<uint32_t> format = std::nullopt)
+    {
+        auto generation = map_data.getLayerGeneration(layer);
+        if(generation == last_generation) return;
+
+        auto changes = map_data.getLayerChangesSince(layer, last_generation);
+
+        texture.bind();
+        if(changes) {
+            for(auto&& area : *changes) {
+                texture.setSubTextureData(internal_format, area, data, format);
+            }
+        } else {
+            auto [iwidth, iheight] = map_data.getDimensions();
+            texture.setTextureData(internal_format, iwidth, iheight, data, format);
+        }
+        texture.bind(false);
+
+        last_generation = generation;
+    }
+}
+
 /**
  * @brief Initializes a ProvinceRenderingView
  */
@@ -45,6 +92,25 @@ void HMDT::GUI::GL::ProvinceRenderingView::init() {
 void HMDT::GUI::GL::ProvinceRenderingView::beginRender() {
     MapRenderingViewBase::beginRender();
 
+    // Only re-upload the parts of each layer that have changed
+    if(m_map_data != nullptr) {
+        using Layer = MapData::Layer;
+
+        uploadLayerChanges(*m_map_data, Layer::PROVINCE_COLORS,
+                           m_last_colors_generation, m_texture,
+                           Texture::Format::RGB,
+                           m_map_data->getProvinceColors().lock().get());
+        uploadLayerChanges(*m_map_data, Layer::LABEL_MATRIX,
+                           m_last_labels_generation, m_label_texture,
+                           Texture::Format::RED32UI,
+                           m_map_data->getLabelMatrix().lock().get(),
+                           GL_RED_INTEGER);
+        uploadLayerChanges(*m_map_data, Layer::PROVINCE_OUTLINES,
+                           m_last_outlines_generation, m_outline_texture,
+                           Texture::Format::RGBA,
+                           m_map_data->getProvinceOutlines().lock().get());
+    }
+
     m_texture.activate();
 }
 
@@ -76,12 +142,16 @@ void HMDT::GUI::GL::ProvinceRenderingView::render() {
 
         // All other uniforms
         std::vector<uint32_t> selection_ids;
-        std::transform(selections.begin(),
-                       selections.end(),
-                       std::back_inserter(selection_ids),
-                       [](const auto& s) {
-                           return s.id.hash();
-                       });
+        if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
+            const auto& province_project = opt_project->get().getMapProject().getProvinceProject();
+
+            std::transform(selections.begin(),
+                           selections.end(),
+                           std::back_inserter(selection_ids),
+                           [&province_project](const auto& s) -> uint32_t {
+                               return province_project.getIndexForProvinceID(s.id);
+                           });
+        }
 
         m_selection_shader.uniform("province_labels", selection_ids);
         m_selection_shader.uniform("num_selected", static_cast<uint32_t>(selection_ids.size()));
@@ -95,11 +165,12 @@ void HMDT::GUI::GL::ProvinceRenderingView::render() {
         //  same VAO
         drawMapVAO();
 
-        // Render adjacencies only if we are selecting a single province
-        if(getOwningGLDrawingArea()->shouldDrawAdjacencies() && selections.size() == 1) {
-            if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
-                auto& map_project = opt_project->get().getMapProject();
-
+        // Render adjacencies only if we are selecting a single province,
+        //   which may be made up of several merged ones
+        if(getOwningGLDrawingArea()->shouldDrawAdjacencies()) {
+            if(const auto& adjacent_labels = getAdjacentLabels(selections);
+               !adjacent_labels.empty())
+            {
                 setupUniforms();
 
                 // Set up the textures
@@ -107,32 +178,8 @@ void HMDT::GUI::GL::ProvinceRenderingView::render() {
                 m_selection_shader.uniform("label_matrix", getLabelTexture());
 
                 // All other uniforms
-                std::set<uint32_t> adjacent_ids;
-                {
-                    // We only have one selection here, but do a loop anyway in case
-                    //   I change my mind on doing that later
-                    for(auto&& selection_info : selections) {
-                        if(!map_project.getProvinceProject().isValidProvinceID(selection_info.id))
-                        {
-                            WRITE_WARN("Unable to render adjacency for invalid province ID ", selection_info.id);
-                            continue;
-                        }
-
-                        const auto& selection = map_project.getProvinceProject().getProvinceForID(selection_info.id);
-
-                        std::transform(selection.adjacent_provinces.begin(),
-                                       selection.adjacent_provinces.end(),
-                                       std::inserter(adjacent_ids, adjacent_ids.begin()),
-                                       [](auto& id) -> uint32_t {
-                                           return id.hash();
-                                       });
-                    }
-                }
-
-                m_selection_shader.uniform("province_labels",
-                                           std::vector<uint32_t>(adjacent_ids.begin(),
-                                                                 adjacent_ids.end()));
-                m_selection_shader.uniform("num_selected", static_cast<uint32_t>(adjacent_ids.size()));
+                m_selection_shader.uniform("province_labels", adjacent_labels);
+                m_selection_shader.uniform("num_selected", static_cast<uint32_t>(adjacent_labels.size()));
 
                 m_selection_shader.uniform("selection_color", Color{ 255, 0, 255 });
 
@@ -167,6 +214,95 @@ void HMDT::GUI::GL::ProvinceRenderingView::render() {
     }
 }
 
+/**
+ * @brief Gets the labels of every province bordering the selection.
+ * @details The selection is treated as a single merged province, and only
+ *          gets an overlay if every selected province is part of it. The
+ *          neighbours are only looked up again once the selection, the label
+ *          matrix, or the selection's merged province changes.
+ *
+ * @param selections The current selections
+ *
+ * @return The label of every bordering province, or nothing if the selection
+ *         is not a single merged province.
+ */
+auto HMDT::GUI::GL::ProvinceRenderingView::getAdjacentLabels(const IMapDrawingAreaBase::SelectionList& selections)
+    -> const std::vector<uint32_t>&
+{
+    static const std::vector<uint32_t> NO_LABELS;
+
+    auto opt_project = Driver::getInstance().getProject();
+    if(!opt_project || selections.empty() || m_map_data == nullptr) {
+        return NO_LABELS;
+    }
+
+    const auto& province_project = opt_project->get().getMapProject().getProvinceProject();
+    auto& overlay = *m_adjacency_overlay;
+
+    auto selection = selections.begin()->id;
+    auto label_generation = m_map_data->getLayerGeneration(MapData::Layer::LABEL_MATRIX);
+
+    if(overlay.stale || overlay.selection != selection ||
+       overlay.label_generation != label_generation)
+    {
+        overlay.selection = selection;
+        overlay.label_generation = label_generation;
+        overlay.stale = false;
+        overlay.members.clear();
+        overlay.adjacent_labels.clear();
+
+        if(!province_project.isValidProvinceID(selection)) {
+            WRITE_WARN("Unable to render adjacency for invalid province ID ", selection);
+            return NO_LABELS;
+        }
+
+        for(auto&& member : province_project.getMergedProvinces(selection)) {
+            overlay.members.insert(province_project.getIndexForProvinceID(member));
+        }
+
+        auto adjacent = province_project.getMergedAdjacentProvinces(selection);
+        overlay.adjacent_labels.assign(adjacent.begin(), adjacent.end());
+    }
+
+    bool is_single_province = std::all_of(selections.begin(), selections.end(),
+        [&province_project, &overlay](const auto& s) {
+            return overlay.members.count(province_project.getIndexForProvinceID(s.id)) != 0;
+        });
+
+    return is_single_province ? overlay.adjacent_labels : NO_LABELS;
+}
+
+/**
+ * @brief Registers a merge listener with the current project, which marks the
+ *        adjacency overlay as stale whenever the selected merged province is
+ *        merged or unmerged.
+ * @details The listener only holds onto the overlay weakly, so it does nothing
+ *          once this view is gone.
+ */
+void HMDT::GUI::GL::ProvinceRenderingView::listenForMerges() {
+    auto opt_project = Driver::getInstance().getProject();
+    if(!opt_project) return;
+
+    auto& province_project = opt_project->get().getMapProject().getProvinceProject();
+
+    // The same project only ever needs to be listened to once
+    if(m_merge_listener_project == &province_project) return;
+    m_merge_listener_project = &province_project;
+
+    province_project.addMergeListener(
+        [weak_overlay = std::weak_ptr<AdjacencyOverlay>(m_adjacency_overlay)](const auto& event)
+        {
+            auto overlay = weak_overlay.lock();
+            if(overlay == nullptr || overlay->stale) return;
+
+            overlay->stale = std::any_of(event.provinces.begin(),
+                                         event.provinces.end(),
+                                         [&overlay](ProvinceIndex index) {
+                                             return overlay->members.count(index) != 0;
+                                         });
+        });
+}
+
 void HMDT::GUI::GL::ProvinceRenderingView::setupUniforms() {
     getMapProgram().uniform("map_texture", m_texture);
 }
@@ -176,6 +312,17 @@ void HMDT::GUI::GL::ProvinceRenderingView::setupUniforms() {
  */
 void HMDT::GUI::GL::ProvinceRenderingView::onMapDataChanged(std::shared_ptr<const MapData> map_data)
 {
+    m_map_data = map_data;
+
+    // The overlay may belong to another project's provinces
+    m_adjacency_overlay->stale = true;
+    listenForMerges();
+
+    // Everything is about to be uploaded, so start tracking changes from here
+    m_last_colors_generation = map_data->getLayerGeneration(MapData::Layer::PROVINCE_COLORS);
+    m_last_labels_generation = map_data->getLayerGeneration(MapData::Layer::LABEL_MATRIX);
+    m_last_outlines_generation = map_data->getLayerGeneration(MapData::Layer::PROVINCE_OUTLINES);
+
     // First build the base map texture
     {
         auto [iwidth, iheight] = map_data->getDimensions();
@@ -6,6 +6,8 @@
 
 #include "StateRenderingView.h"
 
+#include <vector>
+
 #include <GL/glew.h>
 
 #include "GLShaderSources.h"
@@ -18,6 +20,64 @@
 #include "MapDrawingAreaGL.h"
 #include "GuiUtils.h"
 
+namespace {
+    /**
+     * @brief Uploads the parts of a layer that have changed since the last
+     *        upload into a texture, or the whole layer if that is not known.
+     *
+     * @tparam T The type of data in the layer
+     *
+     * @param map_data The map data the layer belongs to
+     * @param layer The layer to upload
+     * @param last_generation The generation of the layer which was last
+     *                        uploaded. Gets updated to the current generation.
+     * @param texture The texture to upload into
+     * @param internal_format The format of the texture
+     * @param data The data of the layer
+     * @param format The format of the data, if different from internal_format
+     */
+    template<typename T>
+    void uploadLayerChanges(const HMDT::MapData& map_data,
+                            HMDT::MapData::Layer layer,
+                            uint64_t& last_generation,
+                            HMDT::GUI::GL::Texture& texture,
+                            HMDT::GUI::GL::Texture::Format internal_format,
+                            const T* data,
+                            std::optional<uint32_t> format = std::nullopt)
+    {
+        auto [iwidth, iheight] = map_data.getDimensions();
+
+        auto generation = map_data.getLayerGeneration(layer);
+        auto changes = map_data.getLayerChangesSince(layer, last_generation);
+
+        // The texture must be fully rebuilt if it has not been created yet, or
+        //   if it no longer matches the map
+        if(texture.getWidth() != iwidth || texture.getHeight() != iheight) {
+            changes.reset();
+        }
+
+        texture.bind();
+        if(changes) {
+            WRITE_DEBUG("Updating ", changes->size(), " areas of the ",
+                        HMDT::MapData::getLayerName(layer), " texture.");
+
+            for(auto&& area : *changes) {
+                texture.setSubTextureData(internal_format, area, data, format);
+            }
+        } else {
+            WRITE_DEBUG("Updating ", HMDT::MapData::getLayerName(layer),
+                        " texture.");
+
+            texture.setTextureData(internal_format, iwidth, iheight, data,
+                                   format);
+        }
+        texture.bind(false);
+
+        // Make sure we update what the current generation is
+        last_generation = generation;
+    }
+}
+
 /**
  * @brief Initializes a StateRenderingView
  */
@@ -37,40 +97,133 @@ void HMDT::GUI::GL::StateRenderingView::init() {
 
         updateStateIDTexture();
     }
+
+    {
+        m_state_outline_texture.setTextureUnitID(Texture::Unit::TEX_UNIT5);
+
+        m_state_outline_texture.setWrapping(Texture::Axis::S, Texture::WrapMode::CLAMP_TO_EDGE);
+        m_state_outline_texture.setWrapping(Texture::Axis::T, Texture::WrapMode::CLAMP_TO_EDGE);
+
+        m_state_outline_texture.setFiltering(Texture::FilterType::MAG, Texture::Filter::NEAREST);
+        m_state_outline_texture.setFiltering(Texture::FilterType::MIN, Texture::Filter::NEAREST);
+
+        updateStateOutlineTexture();
+    }
+
+    {
+        m_state_color_texture.setTextureUnitID(Texture::Unit::TEX_UNIT6);
+
+        m_state_color_texture.setWrapping(Texture::Axis::S, Texture::WrapMode::CLAMP_TO_EDGE);
+        m_state_color_texture.setWrapping(Texture::Axis::T, Texture::WrapMode::CLAMP_TO_EDGE);
+
+        m_state_color_texture.setFiltering(Texture::FilterType::MAG, Texture::Filter::NEAREST);
+        m_state_color_texture.setFiltering(Texture::FilterType::MIN, Texture::Filter::NEAREST);
+
+        updateStateColorTexture();
+    }
 }
 
 void HMDT::GUI::GL::StateRenderingView::beginRender() {
     MapRenderingViewBase::beginRender();
 
-    // Only update the state ID texture if the matrix has changed
+    // Only update the state textures if the matrix has changed
     if(m_map_data != nullptr &&
-       m_last_state_id_matrix_updated_tag != m_map_data->getStateIDMatrixUpdatedTag())
+       m_last_state_id_matrix_generation != m_map_data->getLayerGeneration(MapData::Layer::STATE_ID_MATRIX))
     {
         updateStateIDTexture();
     }
+
+    // States become transparent by losing all of their provinces, which only
+    //   shows up in the matrix, so the colors follow both generations
+    if(auto opt_project = Driver::getInstance().getProject();
+       m_map_data != nullptr && opt_project)
+    {
+        const auto& state_project = opt_project->get().getHistoryProject().getStateProject();
+
+        if(m_last_state_color_generation != state_project.getStateColorGeneration() ||
+           m_last_state_color_matrix_generation != m_map_data->getLayerGeneration(MapData::Layer::STATE_ID_MATRIX))
+        {
+            updateStateColorTexture();
+        }
+    }
+
+    if(m_map_data != nullptr &&
+       m_last_state_outlines_generation != m_map_data->getLayerGeneration(MapData::Layer::STATE_OUTLINES))
+    {
+        updateStateOutlineTexture();
+    }
 }
 
+/**
+ * @brief Uploads the parts of the state ID matrix that have changed since the
+ *        last upload, or the whole matrix if that is not known.
+ */
 void HMDT::GUI::GL::StateRenderingView::updateStateIDTexture() {
     if(m_map_data != nullptr) {
         if(auto state_id_mtx = m_map_data->getStateIDMatrix(); !state_id_mtx.expired())
         {
-            auto [iwidth, iheight] = m_map_data->getDimensions();
+            uploadLayerChanges(*m_map_data, MapData::Layer::STATE_ID_MATRIX,
+                               m_last_state_id_matrix_generation,
+                               m_state_id_texture, Texture::Format::RED32UI,
+                               state_id_mtx.lock().get(), GL_RED_INTEGER);
+        }
+    }
+}
 
-            WRITE_DEBUG("Updating State ID Matrix Texture.");
+/**
+ * @brief Uploads the parts of the state outlines that have changed since the
+ *        last upload, or all of them if that is not known.
+ */
+void HMDT::GUI::GL::StateRenderingView::updateStateOutlineTexture() {
+    if(m_map_data != nullptr) {
+        if(auto outlines = m_map_data->getStateOutlines(); !outlines.expired())
+        {
+            uploadLayerChanges(*m_map_data, MapData::Layer::STATE_OUTLINES,
+                               m_last_state_outlines_generation,
+                               m_state_outline_texture, Texture::Format::RED,
+                               outlines.lock().get());
+        }
+    }
+}
 
-            m_state_id_texture.bind();
-            {
-                m_state_id_texture.setTextureData(Texture::Format::RED32UI,
-                                                  iwidth, iheight,
-                                                  state_id_mtx.lock().get(),
-                                                  GL_RED_INTEGER);
-            }
-            m_state_id_texture.bind(false);
+/**
+ * @brief Rebuilds the table holding the color of every state, indexed by its
+ *        ID. IDs without a state, or whose state has no provinces, are left
+ *        fully transparent.
+ */
+void HMDT::GUI::GL::StateRenderingView::updateStateColorTexture() {
+    std::vector<uint8_t> colors(4, 0); // State ID 0 is never a valid state
+
+    if(m_map_data != nullptr) {
+        m_last_state_color_matrix_generation = m_map_data->getLayerGeneration(MapData::Layer::STATE_ID_MATRIX);
+    }
+
+    if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
+        const auto& state_project = opt_project->get().getHistoryProject().getStateProject();
+        const auto& states = state_project.getStates();
+
+        m_last_state_color_generation = state_project.getStateColorGeneration();
+
+        if(!states.empty()) {
+            colors.assign((static_cast<size_t>(states.rbegin()->first) + 1) * 4, 0);
+        }
+
+        for(auto&& [id, state] : states) {
+            if(state.provinces.empty()) continue;
 
-            // Make sure we update what the current tag is
-            m_last_state_id_matrix_updated_tag = m_map_data->getStateIDMatrixUpdatedTag();
+            auto* color = colors.data() + static_cast<size_t>(id) * 4;
+            color[0] = state.color.r;
+            color[1] = state.color.g;
+            color[2] = state.color.b;
+            color[3] = 255;
         }
     }
+
+    m_state_color_texture.bind();
+    m_state_color_texture.setTextureData(Texture::Format::RGBA,
+                                         colors.size() / 4, 1,
+                                         colors.data());
+    m_state_color_texture.bind(false);
 }
 
 /**
@@ -87,13 +240,16 @@ void HMDT::GUI::GL::StateRenderingView::render() {
 
     if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
         auto& map_project = opt_project->get().getMapProject();
-        auto& history_project = opt_project->get().getHistoryProject();
 
-        getMapProgram().uniform("tex_dimensions", glm::ivec2(m_state_id_texture.getWidth(),
-                                                             m_state_id_texture.getHeight()));
         getMapProgram().uniform("state_id_matrix", m_state_id_texture);
         m_state_id_texture.activate();
 
+        getMapProgram().uniform("state_outlines", m_state_outline_texture);
+        m_state_outline_texture.activate();
+
+        getMapProgram().uniform("state_colors", m_state_color_texture);
+        m_state_color_texture.activate();
+
         // Set uniforms related to selection
         {
             getMapProgram().uniform("selection", getSelectionTexture());
@@ -116,15 +272,9 @@ void HMDT::GUI::GL::StateRenderingView::render() {
             getMapProgram().uniform("num_selected", static_cast<uint32_t>(selection_ids.size()));
         }
 
-        // Render the normal map first for each state that exists
-        for(auto&& [id, state] : history_project.getStateProject().getStates()) {
-            if(state.provinces.empty()) continue;
-
-            getMapProgram().uniform("state_color", state.color);
-            getMapProgram().uniform("state_id", id);
-
-            MapRenderingViewBase::render();
-        }
+        // Every state is drawn at once, as their colors are looked up from
+        //   the state color texture
+        MapRenderingViewBase::render();
     }
 
     // TODO: Render selections
@@ -150,6 +300,12 @@ const std::string& HMDT::GUI::GL::StateRenderingView::getFragmentShaderSource()
 void HMDT::GUI::GL::StateRenderingView::onMapDataChanged(std::shared_ptr<const MapData> map_data)
 {
     m_map_data = map_data;
+
+    // Force the next update to rebuild the entire textures
+    m_last_state_id_matrix_generation = -1;
+    m_last_state_outlines_generation = -1;
+    m_last_state_color_generation = -1;
+    m_last_state_color_matrix_generation = -1;
 }
 
 /**
@@ -14,13 +14,18 @@
 #include "GLUtils.h"
 
 HMDT::GUI::GL::Texture::Texture(): m_texture_id(-1), m_texture_unit(-1),
-                                   m_target(Target::TEX_2D)
+                                   m_target(Target::TEX_2D),
+                                   m_width(0),
+                                   m_height(0),
+                                   m_allocated_bytes(0)
 {
     glGenTextures(1, &m_texture_id);
     HMDT_LOG_GL_ERRORS();
 }
 
 HMDT::GUI::GL::Texture::~Texture() {
+    total_allocated_bytes -= m_allocated_bytes;
+
     glDeleteTextures(1, &m_texture_id);
     HMDT_LOG_GL_ERRORS();
 }
@@ -100,12 +105,66 @@ void HMDT::GUI::GL::Texture::setTextureData(Format internal_format,
                 ", FORMAT=", gl_format, ", DATA_TYPE=", data_type, ", DATA=0x",
                 data, std::dec);
 
+    // Rows are always tightly packed, even for single-byte formats whose
+    //   width is not a multiple of 4
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
     glTexImage2D(gl_target, 0 /* mipmapping */,
                  gl_int_format, width, height, 0, gl_format, data_type, data);
     HMDT_LOG_GL_ERRORS();
 
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
     m_width = width;
     m_height = height;
+
+    // Re-creating the texture replaces whatever it held before
+    total_allocated_bytes -= m_allocated_bytes;
+    m_allocated_bytes = static_cast<uint64_t>(width) * height *
+                        formatToBytesPerPixel(internal_format);
+    total_allocated_bytes += m_allocated_bytes;
+}
+
+/**
+ * @brief Sends a part of the texture data to the GPU.
+ *
+ * @details Implicitly calls bind()
+ *
+ * @param internal_format The format of the data, which must match what the
+ *                        texture was created with.
+ * @param area The area of the texture to update
+ * @param data_type The data type being passed in
+ * @param data The data of the entire texture
+ */
+void HMDT::GUI::GL::Texture::setSubTextureData(Format internal_format,
+                                               const Rectangle& area,
+                                               uint32_t data_type,
+                                               const void* data,
+                                               std::optional<uint32_t> format)
+{
+    auto gl_target = targetToGLTarget(m_target);
+
+    uint32_t gl_format = formatToGLFormat(internal_format);
+    if(format) {
+        gl_format = *format;
+    }
+
+    bind();
+
+    // Let GL pick the area out of the full image for us
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, m_width);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, area.x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, area.y);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glTexSubImage2D(gl_target, 0 /* mipmapping */,
+                    area.x, area.y, area.w, area.h, gl_format, data_type, data);
+    HMDT_LOG_GL_ERRORS();
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 uint32_t HMDT::GUI::GL::Texture::getTextureUnitID() const {
@@ -128,6 +187,20 @@ std::pair<uint32_t, uint32_t> HMDT::GUI::GL::Texture::getDimensions() const {
     return std::make_pair(m_width, m_height);
 }
 
+/**
+ * @brief Gets an estimate of how many bytes this texture takes up on the GPU.
+ */
+uint64_t HMDT::GUI::GL::Texture::getAllocatedBytes() const {
+    return m_allocated_bytes;
+}
+
+/**
+ * @brief Gets an estimate of how many bytes every texture takes up on the GPU.
+ */
+uint64_t HMDT::GUI::GL::Texture::getTotalAllocatedBytes() {
+    return total_allocated_bytes;
+}
+
 /**
  * @brief Binds or unbinds this texture
  *
@@ -298,3 +371,25 @@ uint32_t HMDT::GUI::GL::Texture::filterTypeToGLFilterType(FilterType ftype) {
     return ftype == FilterType::MAG ? GL_TEXTURE_MAG_FILTER : GL_TEXTURE_MIN_FILTER;
 }
 
+/**
+ * @brief Gets how many bytes make up a single pixel of the given format
+ *
+ * @param format The format
+ */
+uint32_t HMDT::GUI::GL::Texture::formatToBytesPerPixel(Format format) {
+    switch(format) {
+        case Format::RED:
+        case Format::GREEN:
+        case Format::BLUE:
+        case Format::ALPHA:
+            return 1;
+        case Format::RGB:
+            return 3;
+        case Format::RGBA:
+        case Format::RED32I:
+        case Format::RED32UI:
+            return 4;
+    }
+
+    return 0;
+}
@@ -1,7 +1,10 @@
 #ifndef IMAPDRAWINGAREA_H
 # define IMAPDRAWINGAREA_H
 
+# include <algorithm>
 # include <functional>
+# include <optional>
+# include <utility>
 
 # include "gdkmm/event.h"
 # include "gtkmm/widget.h"
@@ -34,6 +37,7 @@ namespace HMDT::GUI {
             };
 
             using SelectionCallback = std::function<void(uint32_t, uint32_t)>;
+            using BoxSelectionCallback = std::function<void(const Rectangle&)>;
             using SelectionList = std::set<SelectionInfo, SelectionInfoLess>;
 
             enum class ZoomDirection {
@@ -45,6 +49,7 @@ namespace HMDT::GUI {
             enum class ViewingMode {
                 PROVINCE_VIEW,
                 STATES_VIEW,
+                HEIGHTMAP_VIEW,
             };
 
             constexpr static ViewingMode DEFAULT_VIEWING_MODE = ViewingMode::PROVINCE_VIEW;
@@ -72,6 +77,7 @@ namespace HMDT::GUI {
 
             void setOnProvinceSelectCallback(const SelectionCallback&);
             void setOnMultiProvinceSelectionCallback(const SelectionCallback&);
+            void setOnBoxSelectionCallback(const BoxSelectionCallback&);
 
             void setSelection();
             void setSelection(const SelectionInfo&);
@@ -104,6 +110,7 @@ namespace HMDT::GUI {
 
             const SelectionCallback& getOnSelect() const;
             const SelectionCallback& getOnMultiSelect() const;
+            const BoxSelectionCallback& getOnBoxSelect() const;
 
         private:
             std::shared_ptr<const MapData> m_map_data;
@@ -114,6 +121,9 @@ namespace HMDT::GUI {
             //! Called when a province is multi-selected (shift+click)
             SelectionCallback m_on_multiselect;
 
+            //! Called when an area of the map is selected (ctrl+drag)
+            BoxSelectionCallback m_on_box_select;
+
             //! The current selection
             SelectionList m_selections;
 
@@ -134,8 +144,9 @@ namespace HMDT::GUI {
     class IMapDrawingArea: public IMapDrawingAreaBase, public BaseGtkWidget {
         public:
             IMapDrawingArea() {
-                // Mark that we want to receive button presses
-                BaseGtkWidget::add_events(Gdk::BUTTON_PRESS_MASK);
+                // Mark that we want to receive button presses and releases
+                BaseGtkWidget::add_events(Gdk::BUTTON_PRESS_MASK |
+                                          Gdk::BUTTON_RELEASE_MASK);
             }
 
             virtual ~IMapDrawingArea() = default;
@@ -191,7 +202,10 @@ namespace HMDT::GUI {
                     auto x = event->x * (1 / getScaleFactor());
                     auto y = event->y * (1 / getScaleFactor());
 
-                    if(event->state & GDK_SHIFT_MASK) {
+                    if(event->state & GDK_CONTROL_MASK) {
+                        // The area only gets selected once the button is let go
+                        m_box_select_start = { std::max(x, 0.0), std::max(y, 0.0) };
+                    } else if(event->state & GDK_SHIFT_MASK) {
                         getOnMultiSelect()(x, y);
                     } else {
                         getOnSelect()(x, y);
@@ -201,9 +215,41 @@ namespace HMDT::GUI {
                 return true;
             }
 
+            virtual bool on_button_release_event(GdkEventButton* event) override {
+                if(event->button != 1 || !m_box_select_start) {
+                    return true;
+                }
+
+                auto [start_x, start_y] = *m_box_select_start;
+                m_box_select_start.reset();
+
+                if(!hasData()) {
+                    return true;
+                }
+
+                auto x = std::max(event->x * (1 / getScaleFactor()), 0.0);
+                auto y = std::max(event->y * (1 / getScaleFactor()), 0.0);
+
+                // The box may have been dragged in any direction
+                auto left = static_cast<uint32_t>(std::min(start_x, x));
+                auto top = static_cast<uint32_t>(std::min(start_y, y));
+                auto right = static_cast<uint32_t>(std::max(start_x, x));
+                auto bottom = static_cast<uint32_t>(std::max(start_y, y));
+
+                getOnBoxSelect()(Rectangle{ left, top,
+                                            right - left + 1,
+                                            bottom - top + 1 });
+
+                return true;
+            }
+
             virtual void setSizeRequest(int width = -1, int height = -1) {
                 BaseGtkWidget::set_size_request(width, height);
             }
+
+        private:
+            //! Where a box selection was started, in map coordinates
+            std::optional<std::pair<double, double>> m_box_select_start;
     };
 
     std::ostream& operator<<(std::ostream&,
@@ -20,6 +20,7 @@
 
 # include "ConfigEditorWindow.h"
 # include "LogViewerWindow.h"
+# include "MemoryReportWindow.h"
 # include "Toolbar.h"
 # include "AddFileWindow.h"
 
@@ -83,6 +84,10 @@ namespace HMDT::GUI {
             void exportProject();
             void exportProjectAs(const std::string& = "Export To...");
 
+            void releaseUnusedMapLayers();
+
+            MemoryReport buildMemoryReport() noexcept;
+
         private:
             //! The toolbar of the application
             Toolbar* m_toolbar;
@@ -96,6 +101,9 @@ namespace HMDT::GUI {
             //! The window for viewing the logs
             std::unique_ptr<LogViewerWindow> m_log_viewer_window;
 
+            //! The window for viewing how much memory is being used
+            std::unique_ptr<MemoryReportWindow> m_memory_report_window;
+
             //! The window for editing the config
             std::unique_ptr<ConfigEditorWindow> m_config_editor_window;
 
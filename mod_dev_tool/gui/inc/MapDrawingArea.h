@@ -2,10 +2,12 @@
 # define MAPDRAWINGAREA_H
 
 # include <functional>
+# include <memory>
 
 # include "gtkmm/drawingarea.h"
 # include "gdkmm/pixbuf.h"
 # include "gdkmm/event.h"
+# include "cairomm/surface.h"
 
 # include "BitMap.h"
 # include "MapProject.h"
@@ -14,6 +16,7 @@
 
 namespace HMDT {
     struct Rectangle;
+    class ProvincePreview;
 }
 
 namespace HMDT::GUI {
@@ -41,6 +44,13 @@ namespace HMDT::GUI {
              *        cache it so that we don't have to constantly rebuild it.
              */
             Glib::RefPtr<Gdk::Pixbuf> m_image_pixbuf;
+
+            //! The preview that m_selection_image was expanded from
+            std::weak_ptr<const ProvincePreview> m_selection_data;
+
+            //! The expanded selection preview, rebuilt only when the selection
+            //! changes
+            Cairo::RefPtr<Cairo::ImageSurface> m_selection_image;
     };
 }
 
@@ -0,0 +1,55 @@
+/**
+ * @file MemoryReportWindow.h
+ *
+ * @brief Defines a window for viewing how much memory is being used
+ */
+
+#ifndef MEMORY_REPORT_WINDOW_H
+# define MEMORY_REPORT_WINDOW_H
+
+# include <functional>
+
+# include "gtkmm/box.h"
+# include "gtkmm/button.h"
+# include "gtkmm/scrolledwindow.h"
+# include "gtkmm/textview.h"
+# include "gtkmm/window.h"
+
+# include "MemoryReport.h"
+
+namespace HMDT::GUI {
+    /**
+     * @brief A window for viewing how much memory every subsystem is using
+     */
+    class MemoryReportWindow: public Gtk::Window {
+        public:
+            //! Builds a fresh report every time the window is refreshed
+            using ReportBuilder = std::function<MemoryReport()>;
+
+            MemoryReportWindow(const ReportBuilder&);
+
+            void refresh();
+
+        protected:
+            void initWidgets();
+
+        private:
+            //! Builds the report to display
+            ReportBuilder m_report_builder;
+
+            //! The box holding every widget in the window
+            Gtk::Box m_box;
+
+            //! The scrolled window holding m_report_view
+            Gtk::ScrolledWindow m_swindow;
+
+            //! The view displaying the report
+            Gtk::TextView m_report_view;
+
+            //! The button for re-building the report
+            Gtk::Button m_refresh_button;
+    };
+}
+
+#endif
+
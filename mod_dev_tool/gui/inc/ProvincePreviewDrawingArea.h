@@ -6,8 +6,10 @@
 # include "gtkmm/drawingarea.h"
 # include "gdkmm/pixbuf.h"
 # include "gdkmm/event.h"
+# include "cairomm/surface.h"
 
 # include "IProvincePreviewDrawingArea.h"
+# include "ProvincePreview.h"
 
 namespace HMDT::GUI {
     /**
@@ -16,7 +18,7 @@ namespace HMDT::GUI {
     class ProvincePreviewDrawingArea: public IProvincePreviewDrawingArea<Gtk::DrawingArea>
     {
         public:
-            using DataPtr = std::weak_ptr<const unsigned char[]>;
+            using DataPtr = std::weak_ptr<const ProvincePreview>;
 
             ProvincePreviewDrawingArea();
             virtual ~ProvincePreviewDrawingArea() = default;
@@ -32,6 +34,9 @@ namespace HMDT::GUI {
 
         private:
             DataPtr m_data;
+
+            //! The expanded preview, only built once it is first drawn
+            Cairo::RefPtr<Cairo::ImageSurface> m_image;
     };
 }
 
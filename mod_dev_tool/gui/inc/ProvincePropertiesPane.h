@@ -66,6 +66,8 @@ namespace HMDT::GUI {
 
             void setPreview(ProvincePreviewDrawingArea::DataPtr);
 
+            void syncProvinceColumns(const ProvinceID&);
+
         private:
             //! The province currently being acted upon
             Province* m_province;
@@ -77,6 +77,7 @@ void HMDT::GUI::Application::on_startup() {
 
     createMenu("Root", gettext("View"), {
         { gettext("_Log Window"), "win.log_window", {} },
+        { gettext("_Memory Usage"), "win.memory_report", {} },
         { gettext("_Switch Renderers"), "win.switch_renderers", {
             { gettext("_Use OpenGL"), "win.switch_renderers.usegl" },
             { gettext("_Use Cairo (DEPRECATED)"), "win.switch_renderers.usecairo" },
@@ -84,6 +85,7 @@ void HMDT::GUI::Application::on_startup() {
         { gettext("_Switch Views"), "win.switch_views", {
             { gettext("_Province View"), "win.switch_views.province" },
             { gettext("_State View"), "win.switch_views.state" },
+            { gettext("_Height Map View"), "win.switch_views.heightmap" },
         } },
         { gettext("Debug"), "win.debug", {
             { gettext("Render Adjacencies"), "win.debug.render_adjacencies" },
@@ -11,6 +11,7 @@ HMDT::GUI::IMapDrawingAreaBase::IMapDrawingAreaBase():
     m_map_data(nullptr),
     m_on_select([](auto...) { }),      // The default callback does nothing
     m_on_multiselect([](auto...) { }),
+    m_on_box_select([](auto...) { }),
     m_selections(),
     m_scale_factor(DEFAULT_ZOOM),
     m_viewing_mode(DEFAULT_VIEWING_MODE)
@@ -67,6 +68,11 @@ void HMDT::GUI::IMapDrawingAreaBase::setOnMultiProvinceSelectionCallback(const S
     m_on_multiselect = callback;
 }
 
+void HMDT::GUI::IMapDrawingAreaBase::setOnBoxSelectionCallback(const BoxSelectionCallback& callback)
+{
+    m_on_box_select = callback;
+}
+
 void HMDT::GUI::IMapDrawingAreaBase::setSelection() {
     onSelectionChanged(std::nullopt);
     m_selections.clear();
@@ -160,6 +166,12 @@ auto HMDT::GUI::IMapDrawingAreaBase::getOnMultiSelect() const
     return m_on_multiselect;
 }
 
+auto HMDT::GUI::IMapDrawingAreaBase::getOnBoxSelect() const
+    -> const BoxSelectionCallback&
+{
+    return m_on_box_select;
+}
+
 auto HMDT::GUI::IMapDrawingAreaBase::getSelections() const
     -> const SelectionList&
 {
@@ -189,6 +201,9 @@ std::ostream& HMDT::GUI::operator<<(std::ostream& stream,
         case IMapDrawingAreaBase::ViewingMode::STATES_VIEW:
             stream << "STATES_VIEW";
             break;
+        case IMapDrawingAreaBase::ViewingMode::HEIGHTMAP_VIEW:
+            stream << "HEIGHTMAP_VIEW";
+            break;
     }
 
     return stream;
@@ -32,6 +32,8 @@
 
 #include "NodeKeyNames.h"
 
+#include "Texture.h"
+
 /**
  * @brief Constructs the main window.
  *
@@ -143,6 +145,18 @@ void HMDT::GUI::MainWindow::initializeViewActions() {
         }
     });
 
+    add_action("memory_report", [this]() {
+        if(m_memory_report_window == nullptr) {
+            m_memory_report_window.reset(new MemoryReportWindow([this]() {
+                return buildMemoryReport();
+            }));
+            m_memory_report_window->show_all();
+        } else {
+            m_memory_report_window->refresh();
+            m_memory_report_window->present();
+        }
+    });
+
     // Switch Renderers actions
 #if 0
     {
@@ -183,13 +197,18 @@ void HMDT::GUI::MainWindow::initializeViewActions() {
             auto self = lookup_action("switch_views.province");
             self->change_state(true);
 
-            // Change the state view to be disabled
+            // Change the other views to be disabled
             auto state_option = lookup_action("switch_views.state");
             state_option->change_state(false);
 
+            auto heightmap_option = lookup_action("switch_views.heightmap");
+            heightmap_option->change_state(false);
+
             auto prev_mode = m_drawing_area->setViewingMode(IMapDrawingAreaBase::ViewingMode::PROVINCE_VIEW);
             WRITE_DEBUG("Switched from rendering view ", prev_mode, " to ",
                         IMapDrawingAreaBase::ViewingMode::PROVINCE_VIEW);
+
+            releaseUnusedMapLayers();
         });
 
         auto stateview_action = add_action_bool("switch_views.state", [this]() {
@@ -197,13 +216,37 @@ void HMDT::GUI::MainWindow::initializeViewActions() {
             auto self = lookup_action("switch_views.state");
             self->change_state(true);
 
-            // Change the province view to be disabled
+            // Change the other views to be disabled
             auto province_option = lookup_action("switch_views.province");
             province_option->change_state(false);
 
+            auto heightmap_option = lookup_action("switch_views.heightmap");
+            heightmap_option->change_state(false);
+
             auto prev_mode = m_drawing_area->setViewingMode(IMapDrawingAreaBase::ViewingMode::STATES_VIEW);
             WRITE_DEBUG("Switched from rendering view ", prev_mode, " to ",
                         IMapDrawingAreaBase::ViewingMode::STATES_VIEW);
+
+            releaseUnusedMapLayers();
+        });
+
+        auto heightmapview_action = add_action_bool("switch_views.heightmap", [this]() {
+            // Change us to be enabled
+            auto self = lookup_action("switch_views.heightmap");
+            self->change_state(true);
+
+            // Change the other views to be disabled
+            auto province_option = lookup_action("switch_views.province");
+            province_option->change_state(false);
+
+            auto state_option = lookup_action("switch_views.state");
+            state_option->change_state(false);
+
+            auto prev_mode = m_drawing_area->setViewingMode(IMapDrawingAreaBase::ViewingMode::HEIGHTMAP_VIEW);
+            WRITE_DEBUG("Switched from rendering view ", prev_mode, " to ",
+                        IMapDrawingAreaBase::ViewingMode::HEIGHTMAP_VIEW);
+
+            releaseUnusedMapLayers();
         });
 
         provinceview_action->change_state(true);
@@ -1102,3 +1145,50 @@ void HMDT::GUI::MainWindow::exportProjectAs(const std::string& dtitle) {
     }
 }
 
+/**
+ * @brief Frees any map layers which are no longer used by the current view.
+ *        They will get loaded again if something needs them later.
+ */
+void HMDT::GUI::MainWindow::releaseUnusedMapLayers() {
+    if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
+        opt_project->get().getMapProject().getMapData()->releaseUnusedLayers();
+    }
+}
+
+/**
+ * @brief Builds a report of how much memory the current project, its
+ *        hierarchy, and every GL texture are using.
+ *
+ * @return The memory report
+ */
+auto HMDT::GUI::MainWindow::buildMemoryReport() noexcept -> MemoryReport {
+    MemoryReport report("Total");
+
+    if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
+        opt_project->get().reportMemoryUsage(report);
+    }
+
+    // The nodes themselves are polymorphic, so only count what every node is
+    //   guaranteed to hold
+    if(auto hierarchy = getHierarchy(); hierarchy != nullptr) {
+        uint64_t num_nodes = 0;
+        uint64_t bytes = 0;
+
+        auto result = hierarchy->visit([&num_nodes, &bytes](auto node)
+            -> MaybeVoid
+        {
+            ++num_nodes;
+            bytes += sizeof(Project::Hierarchy::INode) +
+                     node->getName().capacity();
+            return STATUS_SUCCESS;
+        });
+        WRITE_IF_ERROR(result);
+
+        report.addChild("Project Hierarchy (" + std::to_string(num_nodes) +
+                        " nodes)", bytes);
+    }
+
+    report.addChild("GL Textures", GL::Texture::getTotalAllocatedBytes());
+
+    return report;
+}
@@ -1,6 +1,8 @@
 
 #include "MainWindowDrawingAreaPart.h"
 
+#include <algorithm>
+
 #include "Constants.h"
 #include "Logger.h"
 #include "Util.h"
@@ -24,7 +26,7 @@ void HMDT::GUI::MainWindowDrawingAreaPart::MainWindowDrawingAreaPart::buildDrawi
                 auto& history_project = project.getHistoryProject();
 
                 auto map_data = project.getMapProject().getMapData();
-                auto lmatrix = map_data->getProvinces().lock();
+                auto lmatrix = map_data->getLabelMatrix().lock();
 
                 // If the click happens outside of the bounds of the image, then
                 //   deselect the province
@@ -34,8 +36,8 @@ void HMDT::GUI::MainWindowDrawingAreaPart::MainWindowDrawingAreaPart::buildDrawi
                     return;
                 }
 
-                // Get the label for the pixel that got clicked on
-                auto label = lmatrix[xyToIndex(map_data->getWidth(), x, y)];
+                // Get the province for the pixel that got clicked on
+                auto label = map_project.getProvinceProject().getProvinceIDForIndex(lmatrix[xyToIndex(map_data->getWidth(), x, y)]);
 
                 WRITE_DEBUG("Selecting province with ID ", label);
                 SelectionManager::getInstance().selectProvince(label);
@@ -68,14 +70,14 @@ void HMDT::GUI::MainWindowDrawingAreaPart::MainWindowDrawingAreaPart::buildDrawi
                 auto& map_project = project.getMapProject();
 
                 auto map_data = map_project.getMapData();
-                auto lmatrix = map_data->getProvinces().lock();
+                auto lmatrix = map_data->getLabelMatrix().lock();
 
                 // Multiselect out of bounds will simply not add to the selections
                 if(x > map_data->getWidth() || y > map_data->getHeight()) {
                     return;
                 }
 
-                auto label = lmatrix[xyToIndex(map_data->getWidth(), x, y)];
+                auto label = map_project.getProvinceProject().getProvinceIDForIndex(lmatrix[xyToIndex(map_data->getWidth(), x, y)]);
 
                 // Go over the list of already selected provinces and check if
                 //  we have clicked on one that is _already_ selected
@@ -109,6 +111,55 @@ void HMDT::GUI::MainWindowDrawingAreaPart::MainWindowDrawingAreaPart::buildDrawi
                 }
             }
         });
+
+        drawing_area->setOnBoxSelectionCallback([](const Rectangle& area) {
+            if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
+                auto& map_project = opt_project->get().getMapProject();
+                const auto& province_project = map_project.getProvinceProject();
+
+                auto map_data = map_project.getMapData();
+                const auto& spans = province_project.getProvinceSpans();
+                bool spans_are_current = spans.getLabelGeneration() ==
+                    map_data->getLayerGeneration(MapData::Layer::LABEL_MATRIX);
+
+                // Only provinces whose bounding box touches the area can be in
+                //   it, so the spatial index saves us from checking every one
+                auto candidates = province_project.getProvincesInRect(area);
+
+                WRITE_DEBUG("Box selecting ", area.w, 'x', area.h, " pixels at ",
+                            area.x, ',', area.y, ", which ", candidates.size(),
+                            " provinces may be in.");
+
+                for(auto&& index : candidates) {
+                    // A bounding box can overlap the area without the province
+                    //   itself doing so, so check the actual pixels if we can
+                    if(spans_are_current) {
+                        auto range = spans.getSpans(index);
+                        bool in_area = std::any_of(range.begin(), range.end(),
+                            [&area](const ProvinceSpan& span) {
+                                return span.y >= area.y && span.y < area.y + area.h &&
+                                       span.x < area.x + area.w &&
+                                       span.x + span.length > area.x;
+                            });
+
+                        if(!in_area) continue;
+                    }
+
+                    auto prov_id = province_project.getProvinceIDForIndex(index);
+
+                    const auto& selected_labels = SelectionManager::getInstance().getSelectedProvinceLabels();
+                    if(selected_labels.count(prov_id) != 0) continue;
+
+                    if(selected_labels.size() >= MAX_SELECTED_PROVINCES) {
+                        WRITE_WARN("Maximum number of provinces selected! Cannot select more than ",
+                                   MAX_SELECTED_PROVINCES, " at once!");
+                        break;
+                    }
+
+                    SelectionManager::getInstance().addProvinceSelection(prov_id);
+                }
+            }
+        });
     };
 
     // Setup each drawing area type
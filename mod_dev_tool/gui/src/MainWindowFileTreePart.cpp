@@ -1301,11 +1301,13 @@ auto HMDT::GUI::MainWindowFileTreePart::handleNodeValueSelection(
 /**
  * @brief Gets the project hierarchy
  *
- * @return The project hierarchy
+ * @return The project hierarchy, or nullptr if no project has been opened yet
  */
 auto HMDT::GUI::MainWindowFileTreePart::getHierarchy() noexcept
     -> std::shared_ptr<Project::Hierarchy::INode>
 {
+    if(!m_model) return nullptr;
+
     return m_model->getHierarchy();
 }
 
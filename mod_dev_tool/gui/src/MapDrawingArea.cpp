@@ -10,6 +10,7 @@
 #include "Constants.h"
 
 #include "GraphicalDebugger.h"
+#include "ProvincePreview.h"
 #include "Util.h"
 
 bool HMDT::GUI::MapDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
@@ -21,14 +22,25 @@ bool HMDT::GUI::MapDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 
     // If a province is selected, then go ahead and draw the province preview
     //  on top of the map again
-    if(!getSelections().empty()) {
-        auto&& [width, height] = calcDims(getSelections().begin()->bounding_box);
-
-        auto stride = Cairo::ImageSurface::format_stride_for_width(Cairo::FORMAT_ARGB32, width);
-        auto province_image = Cairo::ImageSurface::create(getSelections().begin()->data.get(),
-                                                          Cairo::FORMAT_ARGB32,
-                                                          width, height,
-                                                          stride);
+    if(!getSelections().empty() && getSelections().begin()->data != nullptr) {
+        const auto& preview = getSelections().begin()->data;
+
+        // Previews are only a mask, so expand it into a full image to draw.
+        //  Only do this when the selection actually changes, as redraws happen
+        //  far more often than that
+        if(!m_selection_image || m_selection_data.lock() != preview) {
+            m_selection_image = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+                                                            preview->getWidth(),
+                                                            preview->getHeight());
+            m_selection_image->flush();
+            preview->expandToARGB(m_selection_image->get_data(),
+                                  m_selection_image->get_stride(),
+                                  PROVINCE_HIGHLIGHT_COLOR);
+            m_selection_image->mark_dirty();
+
+            m_selection_data = preview;
+        }
+        const auto& province_image = m_selection_image;
 
         // Manually create the surface from the pixbuf so we can do extra stuff
         //  with it
@@ -72,6 +84,10 @@ bool HMDT::GUI::MapDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
         // TODO: We should have a way to move the image around/zoom
         //  Also, the specific image should not be affecting the size of the window itself
         Gdk::Cairo::set_source_pixbuf(cr, m_image_pixbuf, 0, 0);
+
+        // Nothing is selected anymore, so don't hold onto the old selection
+        m_selection_image.clear();
+        m_selection_data.reset();
     }
 
     cr->paint();
@@ -89,7 +105,7 @@ void HMDT::GUI::MapDrawingArea::rebuildImageCache() {
         auto siwidth = iwidth * getScaleFactor();
         auto siheight = iheight * getScaleFactor();
 
-        auto prov_ptr = getMapData()->getProvinces().lock();
+        auto prov_ptr = getMapData()->getInput().lock();
         m_image_pixbuf = Gdk::Pixbuf::create_from_data(prov_ptr.get(), Gdk::Colorspace::COLORSPACE_RGB, false, 8, iwidth, iheight, iwidth * 3);
 
         m_image_pixbuf = m_image_pixbuf->scale_simple(siwidth, siheight, Gdk::INTERP_BILINEAR);
@@ -0,0 +1,69 @@
+/**
+ * @file MemoryReportWindow.cpp
+ *
+ * @brief Implements the window for viewing how much memory is being used
+ */
+
+#include "MemoryReportWindow.h"
+
+#include <libintl.h>
+
+#include "Logger.h"
+
+/**
+ * @brief Constructs the window and displays an initial report
+ *
+ * @param report_builder Builds the report to display
+ */
+HMDT::GUI::MemoryReportWindow::MemoryReportWindow(const ReportBuilder& report_builder):
+    m_report_builder(report_builder),
+    m_box(Gtk::ORIENTATION_VERTICAL),
+    m_swindow(),
+    m_report_view(),
+    m_refresh_button(gettext("Refresh"))
+{
+    set_title(gettext("Memory Usage"));
+    set_default_size(640, 640);
+
+    initWidgets();
+
+    refresh();
+}
+
+void HMDT::GUI::MemoryReportWindow::initWidgets() {
+    add(m_box);
+
+    m_report_view.set_editable(false);
+    m_report_view.set_cursor_visible(false);
+    m_report_view.set_monospace(true);
+
+    m_swindow.add(m_report_view);
+    m_swindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+
+    m_refresh_button.signal_clicked().connect([this]() {
+        refresh();
+    });
+
+    m_box.pack_start(m_swindow);
+    m_box.pack_start(m_refresh_button, Gtk::PACK_SHRINK);
+}
+
+/**
+ * @brief Builds a new report and displays it
+ */
+void HMDT::GUI::MemoryReportWindow::refresh() {
+    if(!m_report_builder) {
+        WRITE_WARN("No memory report builder was provided, nothing to display.");
+        return;
+    }
+
+    auto report = m_report_builder();
+
+    std::string text = report.toString();
+    for(auto&& warning : report.getAllWarnings()) {
+        text += "\nWARNING: " + warning;
+    }
+
+    m_report_view.get_buffer()->set_text(text);
+}
+
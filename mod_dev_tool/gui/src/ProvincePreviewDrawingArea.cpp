@@ -5,8 +5,11 @@
 #include "gdkmm/general.h"
 #include "gtkmm/container.h"
 
+#include "Constants.h"
+
 HMDT::GUI::ProvincePreviewDrawingArea::ProvincePreviewDrawingArea():
-    m_data()
+    m_data(),
+    m_image()
 { }
 
 void HMDT::GUI::ProvincePreviewDrawingArea::setData(DataPtr data,
@@ -14,6 +17,7 @@ void HMDT::GUI::ProvincePreviewDrawingArea::setData(DataPtr data,
                                                     uint32_t height)
 {
     m_data = data;
+    m_image.clear();
 
     setDimensions(width, height);
 
@@ -41,19 +45,25 @@ bool HMDT::GUI::ProvincePreviewDrawingArea::on_draw(const Cairo::RefPtr<Cairo::C
         //  Pixbuf's from data with Alpha values.
         // Because of this, we will be using Cairo directly, and bypassing
         //  Gtk/Gdk completely
-        auto stride = Cairo::ImageSurface::format_stride_for_width(Cairo::FORMAT_ARGB32, width);
-
-        auto cairo_image = Cairo::ImageSurface::create(const_cast<unsigned char*>(data.get()),
-                                                       Cairo::FORMAT_ARGB32,
-                                                       width, height,
-                                                       stride);
+        // The preview is only a mask, so expand it into a full image once, the
+        //  first time it actually gets drawn
+        if(!m_image) {
+            m_image = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32,
+                                                  data->getWidth(),
+                                                  data->getHeight());
+
+            m_image->flush();
+            data->expandToARGB(m_image->get_data(), m_image->get_stride(),
+                               PROVINCE_HIGHLIGHT_COLOR);
+            m_image->mark_dirty();
+        }
 
         // Only scale if we have a non-zero scale
         if(scalex != 0 && scaley != 0) {
             cr->scale(scalex, scaley);
         }
 
-        cr->set_source(cairo_image, 0, 0);
+        cr->set_source(m_image, 0, 0);
 
         cr->paint();
 
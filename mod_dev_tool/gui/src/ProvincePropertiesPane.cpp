@@ -82,10 +82,13 @@ void HMDT::GUI::ProvincePropertiesPane::buildIsCoastalField() {
             Action::ActionManager::getInstance().doAction(
                 &NewSetPropertyAction(m_province, coastal,
                                      m_is_coastal_button->get_active())
-                    ->onValueChanged([this](const auto& old, const auto& _new)
+                    ->onValueChanged([this, id=m_province->id](const auto& old,
+                                                               const auto& _new)
                     {
                         WRITE_DEBUG("Update coastal from ", old, " to ", _new);
 
+                        syncProvinceColumns(id);
+
                         m_value_changed_callback(
                             Project::Hierarchy::Key{
                                 Project::Hierarchy::ProjectKeys::MAP,
@@ -122,10 +125,13 @@ void HMDT::GUI::ProvincePropertiesPane::buildProvinceTypeField() {
                 Action::ActionManager::getInstance().doAction(
                     &NewSetPropertyAction(m_province, type,
                                          static_cast<ProvinceType>(current + 1))
-                    ->onValueChanged([this](const auto& old, const auto& _new)
+                    ->onValueChanged([this, id=m_province->id](const auto& old,
+                                                               const auto& _new)
                     {
                         WRITE_DEBUG("Update type from ", old, " to ", _new);
 
+                        syncProvinceColumns(id);
+
                         m_value_changed_callback(
                             Project::Hierarchy::Key{
                                 Project::Hierarchy::ProjectKeys::MAP,
@@ -602,6 +608,20 @@ void HMDT::GUI::ProvincePropertiesPane::rebuildContinentMenu(const std::set<std:
     }
 }
 
+/**
+ * @brief Copies the fields of a province which were just edited into the
+ *        columns of the province list, as they are written to directly.
+ *
+ * @param id The ID of the province which was edited
+ */
+void HMDT::GUI::ProvincePropertiesPane::syncProvinceColumns(const ProvinceID& id)
+{
+    if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
+        auto& provinces = opt_project->get().getMapProject().getProvinceProject().getProvinces();
+        provinces.syncColumns(provinces.getIndex(id));
+    }
+}
+
 void HMDT::GUI::ProvincePropertiesPane::onProjectOpened() {
     if(auto opt_project = Driver::getInstance().getProject(); opt_project) {
         auto& map_project = opt_project->get().getMapProject();
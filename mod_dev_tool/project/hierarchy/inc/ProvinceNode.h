@@ -1,6 +1,7 @@
 #ifndef PROJECT_HIERARCHY_PROVINCENODE_H
 # define PROJECT_HIERARCHY_PROVINCENODE_H
 
+# include <functional>
 # include <vector>
 
 # include "Types.h"
@@ -13,6 +14,9 @@ namespace HMDT::Project::Hierarchy {
      */
     class ProvinceNode: public GroupNode {
         public:
+            //! Called after a property has been written to through its node
+            using ChangeCallback = std::function<void()>;
+
             using GroupNode::GroupNode;
 
             virtual ~ProvinceNode() = default;
@@ -24,9 +28,11 @@ namespace HMDT::Project::Hierarchy {
             MaybeVoid setColor(const IPropertyNode::ValueLookup<const Color>&,
                                const INodeVisitor&) noexcept;
             MaybeVoid setProvinceType(const IPropertyNode::ValueLookup<ProvinceType>&,
-                                      const INodeVisitor&) noexcept;
+                                      const INodeVisitor&,
+                                      const ChangeCallback& = nullptr) noexcept;
             MaybeVoid setCoastal(const IPropertyNode::ValueLookup<bool>&,
-                                 const INodeVisitor&) noexcept;
+                                 const INodeVisitor&,
+                                 const ChangeCallback& = nullptr) noexcept;
             MaybeVoid setTerrain(const IPropertyNode::ValueLookup<TerrainID>&,
                                  const INodeVisitor&) noexcept;
             MaybeVoid setContinent(const IPropertyNode::ValueLookup<Continent>&,
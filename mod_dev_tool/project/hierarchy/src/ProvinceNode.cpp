@@ -74,19 +74,22 @@ auto HMDT::Project::Hierarchy::ProvinceNode::setColor(const IPropertyNode::Value
  *
  * @param province_type The value to set
  * @param visitor The vistor callback
+ * @param on_change Called after the value has been written through the node
  *
  * @return A status code
  */
 auto HMDT::Project::Hierarchy::ProvinceNode::setProvinceType(const IPropertyNode::ValueLookup<ProvinceType>& lookup,
-                                                             const INodeVisitor& visitor) noexcept
+                                                             const INodeVisitor& visitor,
+                                                             const ChangeCallback& on_change) noexcept
     -> MaybeVoid
 {
     auto prov_type_node = std::make_shared<PropertyNode<ProvinceType>>(ProvinceKeys::TYPE,
             lookup,
-            [lookup](const auto& province_type) -> MaybeVoid {
+            [lookup, on_change](const auto& province_type) -> MaybeVoid {
                 auto result = lookup();
                 RETURN_IF_ERROR(result);
                 result->get() = province_type;
+                if(on_change) on_change();
                 return STATUS_SUCCESS;
             });
     visitor(prov_type_node);
@@ -102,19 +105,22 @@ auto HMDT::Project::Hierarchy::ProvinceNode::setProvinceType(const IPropertyNode
  *
  * @param coastal The value to set
  * @param visitor The vistor callback
+ * @param on_change Called after the value has been written through the node
  *
  * @return A status code
  */
 auto HMDT::Project::Hierarchy::ProvinceNode::setCoastal(const IPropertyNode::ValueLookup<bool>& lookup,
-                                                        const INodeVisitor& visitor) noexcept
+                                                        const INodeVisitor& visitor,
+                                                        const ChangeCallback& on_change) noexcept
     -> MaybeVoid
 {
     auto coastal_node = std::make_shared<PropertyNode<bool>>(ProvinceKeys::COASTAL,
             lookup,
-            [lookup](const auto& coastal) -> MaybeVoid {
+            [lookup, on_change](const auto& coastal) -> MaybeVoid {
                 auto result = lookup();
                 RETURN_IF_ERROR(result);
                 result->get() = coastal;
+                if(on_change) on_change();
                 return STATUS_SUCCESS;
             });
     visitor(coastal_node);
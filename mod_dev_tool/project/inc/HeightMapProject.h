@@ -1,7 +1,13 @@
 #ifndef HEIGHTMAP_PROJECT_H
 # define HEIGHTMAP_PROJECT_H
 
+# include <future>
+# include <mutex>
+# include <optional>
+# include <vector>
+
 # include "BitMap.h"
+# include "HeightMapPyramid.h"
 
 # include "IProject.h"
 
@@ -34,15 +40,69 @@ namespace HMDT::Project {
 
             virtual MaybeVoid loadFile(const std::filesystem::path&) noexcept override;
 
+            virtual Maybe<std::shared_ptr<const std::vector<unsigned char>>> getWorldNormalMap() const override;
+            virtual Maybe<std::shared_ptr<const HeightMapPyramid>> getHeightMapPyramid() const override;
+
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
-            MonadOptionalRef<const BitMap2> getBitMap() const;
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
+            std::shared_ptr<const BitMap2> getBitMap() const;
 
         private:
+            std::shared_ptr<const BitMap2> getLoadedBitMap() const;
+            MaybeVoid readBitMap(const std::filesystem::path&) const noexcept;
+            MaybeVoid ensureBitMapLoaded() const noexcept;
+            MaybeVoid updateWorldNormalMap() const noexcept;
+            void startPyramidBuild(std::shared_ptr<const BitMap2>) const;
+            void registerLayerLoader();
+            void releaseBitMap() noexcept;
+
             //! The parent project
             IRootMapProject& m_parent_project;
 
-            std::shared_ptr<BitMap2> m_heightmap_bmp;
+            // Mutable so that a deferred load can happen from const accessors
+            mutable std::shared_ptr<BitMap2> m_heightmap_bmp;
+
+            //! The file to load the heightmap from once it is first needed
+            mutable std::optional<std::filesystem::path> m_deferred_path;
+
+            /**
+             * @brief The file that the loaded bitmap matches, if any.
+             * @details The bitmap may only be released while this is set, as
+             *          it can then be read back from here.
+             */
+            mutable std::optional<std::filesystem::path> m_source_path;
+
+            //! Guards the deferred load of the bitmap
+            mutable std::mutex m_bitmap_mutex;
+
+            /**
+             * @brief The world normal map, as 24-bit color. nullptr until first
+             *        needed. Copied before being updated while shared.
+             */
+            mutable std::shared_ptr<std::vector<unsigned char>> m_normal_data;
+
+            //! The heightmap layer generation that m_normal_data was built from
+            mutable uint64_t m_normal_generation;
+
+            //! Guards the world normal map
+            mutable std::mutex m_normal_mutex;
+
+            //! The heightmap's mip pyramid, or nullptr until it is first built
+            mutable std::shared_ptr<const HeightMapPyramid> m_pyramid;
+
+            //! The heightmap layer generation that m_pyramid was built from
+            mutable uint64_t m_pyramid_generation;
+
+            //! The mip pyramid being built in the background, if any
+            mutable std::future<std::shared_ptr<HeightMapPyramid>> m_pending_pyramid;
+
+            //! The heightmap layer generation that m_pending_pyramid is built from
+            mutable uint64_t m_pending_pyramid_generation;
+
+            //! Guards the mip pyramid
+            mutable std::mutex m_pyramid_mutex;
     };
 }
 
@@ -29,6 +29,8 @@ namespace HMDT::Project {
 
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
         private:
             //! The State project
             StateProject m_state_project;
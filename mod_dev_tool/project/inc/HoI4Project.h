@@ -55,6 +55,8 @@ namespace HMDT::Project {
 
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
             MaybeVoid load();
             MaybeVoid save(bool = true);
             MaybeVoid export_() const noexcept;
@@ -2,16 +2,22 @@
 # define IPROJECT_H
 
 # include <filesystem>
+# include <functional>
 # include <system_error>
 # include <memory>
 # include <set>
 # include <map>
 # include <string>
+# include <vector>
 
 # include "fifo_map.hpp"
 
 # include "Maybe.h"
+# include "MemoryReport.h"
 # include "Types.h"
+# include "ProvinceList.h"
+# include "ProvinceGraph.h"
+# include "ProvinceSpans.h"
 # include "Version.h"
 
 # include "Terrain.h"
@@ -20,7 +26,9 @@
 
 // Forward declarations
 namespace HMDT {
+    class HeightMapPyramid;
     class MapData;
+    class ProvincePreview;
     class ShapeFinder;
 }
 
@@ -62,6 +70,8 @@ namespace HMDT::Project {
 
         virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept = 0;
 
+        virtual void reportMemoryUsage(MemoryReport&) const noexcept;
+
         void setPromptCallback(const PromptCallback&);
         void resetPromptCallback();
 
@@ -108,7 +118,25 @@ namespace HMDT::Project {
      * @brief The interface for the ProvinceProject
      */
     struct IProvinceProject: public IMapProject {
-        using ProvinceDataPtr = std::shared_ptr<unsigned char[]>;
+        using ProvinceDataPtr = std::shared_ptr<const ProvincePreview>;
+
+        /**
+         * @brief Describes which provinces were affected by merging or
+         *        unmerging provinces
+         */
+        struct MergeEvent {
+            //! Every province whose merge tree changed
+            std::vector<ProvinceIndex> provinces;
+
+            /**
+             * @brief The area in which anything drawn per merged province
+             *        may have changed
+             */
+            Rectangle area;
+        };
+
+        //! Callback type for being told about merged or unmerged provinces
+        using MergeCallback = std::function<void(const MergeEvent&)>;
 
         bool isValidProvinceLabel(uint32_t) const;
         bool isValidProvinceID(ProvinceID) const;
@@ -123,6 +151,7 @@ namespace HMDT::Project {
 
         virtual ProvinceDataPtr getPreviewData(ProvinceID) = 0;
         virtual ProvinceDataPtr getPreviewData(const Province*) = 0;
+        virtual void prefetchPreviewData(ProvinceID) = 0;
 
         virtual ProvinceList& getProvinces() = 0;
         virtual const ProvinceList& getProvinces() const = 0;
@@ -131,13 +160,48 @@ namespace HMDT::Project {
 
         virtual uint32_t getIDForProvinceID(const ProvinceID&) const noexcept = 0;
 
+        virtual ProvinceIndex getIndexForProvinceID(const ProvinceID&) const noexcept = 0;
+        virtual const ProvinceID& getProvinceIDForIndex(ProvinceIndex) const noexcept = 0;
+
+        virtual std::vector<ProvinceIndex> getProvincesInRect(const Rectangle&) const noexcept = 0;
+
+        virtual ProvinceGraph& getAdjacencyGraph() noexcept = 0;
+        virtual const ProvinceGraph& getAdjacencyGraph() const noexcept = 0;
+
+        virtual const ProvinceSpans& getProvinceSpans() const noexcept = 0;
+
         virtual MaybeRef<const Province> getRootProvinceParent(const ProvinceID&) const noexcept;
         virtual MaybeRef<Province> getRootProvinceParent(const ProvinceID&) noexcept;
 
+        virtual Maybe<ProvinceIndex> getRootProvinceIndex(ProvinceIndex) const noexcept;
+
         virtual MaybeVoid mergeProvinces(const ProvinceID&, const ProvinceID&) noexcept;
         virtual MaybeVoid unmergeProvince(const ProvinceID&) noexcept;
 
         virtual std::set<ProvinceID> getMergedProvinces(const ProvinceID&) const noexcept;
+        std::set<ProvinceIndex> getMergedAdjacentProvinces(const ProvinceID&) const noexcept;
+
+        size_t addMergeListener(const MergeCallback&);
+        void removeMergeListener(size_t);
+
+        protected:
+            virtual void invalidateRootProvinces(const std::set<ProvinceID>&) noexcept;
+
+            virtual void onProvincesMerged(const MergeEvent&) noexcept;
+
+            MaybeRef<const Province> findRootProvinceParent(const ProvinceID&) const noexcept;
+
+        private:
+            MaybeVoid unlinkProvince(const ProvinceID&) noexcept;
+
+            MergeEvent buildMergeEvent(const std::set<ProvinceID>&,
+                                       const std::set<ProvinceID>&) const noexcept;
+
+            //! Everything to tell about merged or unmerged provinces
+            std::map<size_t, MergeCallback> m_merge_listeners;
+
+            //! The ID to give to the next merge listener
+            size_t m_next_merge_listener_id = 0;
     };
 
     /**
@@ -147,6 +211,9 @@ namespace HMDT::Project {
         virtual ~IHeightMapProject() = default;
 
         virtual MaybeVoid loadFile(const std::filesystem::path&) noexcept = 0;
+
+        virtual Maybe<std::shared_ptr<const std::vector<unsigned char>>> getWorldNormalMap() const = 0;
+        virtual Maybe<std::shared_ptr<const HeightMapPyramid>> getHeightMapPyramid() const = 0;
     };
 
     /**
@@ -206,10 +273,18 @@ namespace HMDT::Project {
         virtual State& getStateForIterator(StateMap::const_iterator) = 0;
         virtual const State& getStateForIterator(StateMap::const_iterator) const = 0;
 
+        virtual MaybeVoid setStateColor(StateID, const Color&) = 0;
+        virtual uint64_t getStateColorGeneration() const noexcept = 0;
+
         virtual void updateStateIDMatrix() = 0;
+        virtual void updateStateIDMatrix(const std::vector<ProvinceID>&) = 0;
 
         virtual MaybeVoid addProvinceToState(StateID, ProvinceID) = 0;
         virtual MaybeVoid removeProvinceFromState(StateID, ProvinceID) = 0;
+        virtual void removeProvincesFromStates(const std::vector<ProvinceID>&) = 0;
+
+        virtual Maybe<StateID> getStateIDForProvince(const ProvinceID&) const noexcept = 0;
+        virtual bool isProvinceInState(StateID, const ProvinceID&) const noexcept = 0;
 
         protected:
             virtual StateMap& getStateMap() = 0;
@@ -11,6 +11,7 @@
 # include "Types.h"
 # include "BitMap.h"
 # include "MapData.h"
+# include "ValidationReport.h"
 
 # include "Terrain.h"
 
@@ -67,10 +68,32 @@ namespace HMDT::Project {
 
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
-        protected:
-            MaybeVoid validateProvinceStateID(StateID, ProvinceID);
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
+            const ValidationReport& getValidationReport() const noexcept;
 
         private:
+            /**
+             * @brief Reverse lookups from provinces to the states which list
+             *        them, built once for every validator to share.
+             */
+            struct StateMembershipIndex {
+                //! Every state listing each province, indexed by ProvinceIndex
+                std::vector<std::vector<StateID>> states_by_province;
+
+                //! Every province ID listed by a state which does not exist
+                std::vector<std::pair<StateID, ProvinceID>> unknown_provinces;
+            };
+
+            StateMembershipIndex buildStateMembershipIndex() const;
+
+            ValidationReport validateProvinceStates(const StateMembershipIndex&) const;
+            ValidationReport validateStateProvinces(const StateMembershipIndex&) const;
+            ValidationReport validateProvinceMerges() const;
+
+            void fixValidationIssues(ValidationReport&,
+                                     const StateMembershipIndex&);
+
             //! The Provinces project
             ProvinceProject m_provinces_project;
 
@@ -91,6 +114,9 @@ namespace HMDT::Project {
 
             //! The parent project that this MapProject belongs to
             IProject& m_parent_project;
+
+            //! Every issue found the last time the data was validated
+            ValidationReport m_validation_report;
     };
 }
 
@@ -1,7 +1,17 @@
 #ifndef PROVINCE_PROJECT_H
 # define PROVINCE_PROJECT_H
 
+# include <condition_variable>
+# include <deque>
+# include <mutex>
+# include <optional>
+# include <thread>
+# include <vector>
+
 # include "IProject.h"
+# include "LRUCache.h"
+# include "ProvinceGraph.h"
+# include "ProvinceSpatialIndex.h"
 # include "Types.h"
 
 namespace HMDT::Project {
@@ -34,16 +44,32 @@ namespace HMDT::Project {
 
             virtual ProvinceDataPtr getPreviewData(ProvinceID) override;
             virtual ProvinceDataPtr getPreviewData(const Province*) override;
+            virtual void prefetchPreviewData(ProvinceID) override;
 
             virtual const std::unordered_map<uint32_t, UUID>& getOldIDToUUIDMap() const noexcept override;
 
             virtual uint32_t getIDForProvinceID(const ProvinceID&) const noexcept override;
 
+            virtual ProvinceIndex getIndexForProvinceID(const ProvinceID&) const noexcept override;
+            virtual const ProvinceID& getProvinceIDForIndex(ProvinceIndex) const noexcept override;
+
+            virtual std::vector<ProvinceIndex> getProvincesInRect(const Rectangle&) const noexcept override;
+
+            virtual ProvinceGraph& getAdjacencyGraph() noexcept override;
+            virtual const ProvinceGraph& getAdjacencyGraph() const noexcept override;
+
+            virtual const ProvinceSpans& getProvinceSpans() const noexcept override;
+
+            virtual Maybe<ProvinceIndex> getRootProvinceIndex(ProvinceIndex) const noexcept override;
+
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
             Maybe<std::shared_ptr<Hierarchy::IGroupNode>> visitProvinces(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept;
 
             void buildProvinceOutlines();
+            void buildProvinceSpans();
         protected:
             MaybeVoid saveShapeLabels(const std::filesystem::path&);
             MaybeVoid saveProvinceData(const std::filesystem::path&, bool = false) const noexcept;
@@ -59,23 +85,112 @@ namespace HMDT::Project {
 
             void rebuildUUIDToIDMap() noexcept;
 
+            void rebuildProvinceIndexRegistry(const std::vector<ProvinceID>&) noexcept;
+            void rebuildProvinceIndexRegistry() noexcept;
+
+            virtual void invalidateRootProvinces(const std::set<ProvinceID>&) noexcept override;
+
         private:
-            void buildProvinceCache(const Province*);
+            //! The color of every ProvinceIndex, if it is a loaded province
+            using ColorPalette = std::vector<std::optional<Color>>;
+
+            Maybe<ColorPalette> buildColorPalette(bool) const noexcept;
+            Maybe<ProvinceIndex> resolveRootProvinceIndex(ProvinceIndex) const noexcept;
+
+            void writeColorsFromPalette(const ColorPalette&, unsigned char*, bool) const noexcept;
+
+            /**
+             * @brief A preview that the prefetch worker has been asked to build
+             */
+            struct PreviewRequest {
+                ProvinceID id;
+                ProvinceIndex index;
+                BoundingBox bounding_box;
+
+                //! The label matrix generation this request was made for
+                uint64_t label_generation;
+
+                //! Kept alive so the worker can lease the label matrix
+                std::shared_ptr<const MapData> map_data;
+            };
+
+            ProvinceDataPtr buildProvinceCache(const Province*);
+            void invalidateStalePreviews();
+            void clearPreviewCache();
+
+            void queuePreviewPrefetch(const Province&);
+            void runPreviewPrefetcher();
+            void stopPreviewPrefetcher();
 
             //! The parent project that this MapProject belongs to
             IRootMapProject& m_parent_project;
 
-            //! List of all provinces
+            /**
+             * @brief List of all provinces
+             * @details Provinces are stored in ProvinceIndex order, so this
+             *          also acts as the ProvinceID <-> ProvinceIndex registry.
+             */
             ProvinceList m_provinces;
 
+            /**
+             * @brief Looks up provinces by their bounding boxes
+             * @details Rebuilt whenever the ProvinceIndex of any province
+             *          changes.
+             */
+            ProvinceSpatialIndex m_spatial_index;
+
+            /**
+             * @brief The root of every ProvinceIndex that has been resolved.
+             * @details This is a union-find forest: every entry points at
+             *          another province in the same merge tree, roots point at
+             *          themselves, and INVALID_PROVINCE_INDEX means that the
+             *          province has not been resolved yet. Entries are
+             *          re-pointed at their root whenever they get resolved.
+             */
+            mutable std::vector<ProvinceIndex> m_root_index_cache;
+
+            //! Guards m_root_index_cache, which is modified by const lookups
+            mutable std::mutex m_root_index_cache_mutex;
+
+            //! Which provinces border each other, by ProvinceIndex
+            ProvinceGraph m_adjacency_graph;
+
+            /**
+             * @brief Every run of pixels belonging to each province
+             * @details Rebuilt whenever the label matrix changes.
+             */
+            ProvinceSpans m_province_spans;
+
             /**
              * @brief A cache of province previews
-             * @details Note: We use nlohmann::fifo_map for this so that we can
-             *          do hash-based lookup while still retaining FIFO access.
-             *          This is so that the least accessed (first in) can get
-             *          garbage collected and cleaned out
+             * @details Previews are evicted least recently used first once
+             *          they take up more than MAX_CACHED_PROVINCE_PREVIEW_BYTES.
+             */
+            LRUCache<ProvinceID, ProvinceDataPtr> m_data_cache;
+
+            //! The label matrix generation that m_data_cache was built from
+            uint64_t m_data_cache_label_generation;
+
+            /**
+             * @brief Guards m_data_cache and m_data_cache_label_generation, as
+             *        the prefetch worker adds previews from its own thread.
              */
-            nlohmann::fifo_map<ProvinceID, ProvinceDataPtr> m_data_cache;
+            mutable std::mutex m_data_cache_mutex;
+
+            //! Previews waiting to be prefetched, most recent first
+            std::deque<PreviewRequest> m_prefetch_queue;
+
+            //! Guards m_prefetch_queue and m_prefetch_stop
+            std::mutex m_prefetch_mutex;
+
+            //! Wakes the prefetch worker up when there is work or it must stop
+            std::condition_variable m_prefetch_condition;
+
+            //! Whether the prefetch worker should stop
+            bool m_prefetch_stop;
+
+            //! Builds previews in the background. Only started once needed.
+            std::thread m_prefetch_thread;
 
             //! Maps old IDs to UUIDs (only used when converting old projects)
             std::unordered_map<uint32_t, UUID> m_oldid_to_uuid;
@@ -1,7 +1,11 @@
 #ifndef RIVERS_PROJECT_H
 # define RIVERS_PROJECT_H
 
+# include <mutex>
+# include <optional>
+
 # include "BitMap.h"
+# include "ValidationReport.h"
 
 # include "IProject.h"
 
@@ -34,21 +38,44 @@ namespace HMDT::Project {
 
             virtual MaybeVoid loadFile(const std::filesystem::path&) noexcept override;
 
-            MonadOptionalRef<const BitMap2> getBitMap() const;
+            std::shared_ptr<const BitMap2> getBitMap() const;
+
+            ValidationReport validateRivers() const;
 
             virtual MaybeVoid writeTemplate(const std::filesystem::path&) const noexcept override;
 
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
         protected:
             MaybeVoid generateTemplate(std::unique_ptr<unsigned char[]>&) const noexcept;
             static ColorTable generateColorTable() noexcept;
 
         private:
+            MaybeVoid readBitMap(const std::filesystem::path&) const noexcept;
+            MaybeVoid ensureBitMapLoaded() const noexcept;
+            void registerLayerLoader();
+            void releaseBitMap() noexcept;
+
             //! The parent project
             IRootMapProject& m_parent_project;
 
-            std::shared_ptr<BitMap2> m_rivers_bmp;
+            // Mutable so that a deferred load can happen from const accessors
+            mutable std::shared_ptr<BitMap2> m_rivers_bmp;
+
+            //! The file to load the rivers from once it is first needed
+            mutable std::optional<std::filesystem::path> m_deferred_path;
+
+            /**
+             * @brief The file that the loaded bitmap matches, if any.
+             * @details The bitmap may only be released while this is set, as
+             *          it can then be read back from here.
+             */
+            mutable std::optional<std::filesystem::path> m_source_path;
+
+            //! Guards the deferred load of the bitmap
+            mutable std::mutex m_bitmap_mutex;
     };
 }
 
@@ -3,6 +3,7 @@
 
 # include <queue>
 # include <map>
+# include <unordered_map>
 # include <memory>
 # include <filesystem>
 
@@ -49,28 +50,88 @@ namespace HMDT::Project {
             virtual State& getStateForIterator(StateMap::const_iterator) override;
             virtual const State& getStateForIterator(StateMap::const_iterator) const override;
 
+            virtual MaybeVoid setStateColor(StateID, const Color&) override;
+            virtual uint64_t getStateColorGeneration() const noexcept override;
+
             virtual void updateStateIDMatrix() override;
+            virtual void updateStateIDMatrix(const std::vector<ProvinceID>&) override;
 
             virtual MaybeVoid addProvinceToState(StateID, ProvinceID) override;
             virtual MaybeVoid removeProvinceFromState(StateID, ProvinceID) override;
+            virtual void removeProvincesFromStates(const std::vector<ProvinceID>&) override;
+
+            virtual Maybe<StateID> getStateIDForProvince(const ProvinceID&) const noexcept override;
+            virtual bool isProvinceInState(StateID, const ProvinceID&) const noexcept override;
 
             virtual Maybe<std::shared_ptr<Hierarchy::INode>> visit(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept override;
 
+            virtual void reportMemoryUsage(MemoryReport&) const noexcept override;
+
             Maybe<std::shared_ptr<Hierarchy::IGroupNode>> visitStates(const std::function<MaybeVoid(std::shared_ptr<Hierarchy::INode>)>&) const noexcept;
 
             StateMap& getStateMap(Token) { return getStateMap(); };
         protected:
             virtual StateMap& getStateMap() override;
 
+            void rebuildProvinceStateIndex();
+
         private:
+            /**
+             * @brief Where a province is listed
+             */
+            struct StateMembership {
+                //! The state which lists the province
+                StateID state;
+
+                /**
+                 * @brief The position of the province in State::provinces,
+                 *        counting any removed positions which have not been
+                 *        compacted away yet
+                 */
+                size_t position;
+            };
+
+            void compactState(State&) const;
+            void compactStates() const;
+
             //! The parent project that this HistoryProject belongs to
             IRootHistoryProject& m_parent_project;
 
             //! All available state ids, which should be used before new ones
             std::queue<StateID> m_available_state_ids;
 
-            //! All states defined for this project
-            StateMap m_states;
+            /**
+             * @brief All states defined for this project
+             * @details Mutable so that removed provinces can be compacted away
+             *          from const accessors.
+             */
+            mutable StateMap m_states;
+
+            /**
+             * @brief Which state lists each province, and where
+             * @details Kept up to date by every function which changes the
+             *          provinces of a state, so that removing a province from
+             *          a state never has to search for it. If a province is
+             *          listed by more than one state, only the first one is
+             *          remembered.
+             */
+            mutable std::unordered_map<ProvinceID, StateMembership> m_province_states;
+
+            /**
+             * @brief The positions in State::provinces which were removed, but
+             *        are still waiting to be compacted away.
+             * @details Removing a province only records its position here.
+             *          Every state is compacted, keeping the order of its other
+             *          provinces, before anything outside of this class gets to
+             *          see its provinces.
+             */
+            mutable std::map<StateID, std::vector<size_t>> m_removed_positions;
+
+            /**
+             * @brief Changes every time the color of any state may have
+             *        changed, including when states are added or removed.
+             */
+            uint64_t m_state_color_generation;
     };
 }
 
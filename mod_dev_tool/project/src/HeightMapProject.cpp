@@ -20,9 +20,87 @@
 
 HMDT::Project::HeightMapProject::HeightMapProject(IRootMapProject& parent):
     m_parent_project(parent),
-    m_heightmap_bmp(nullptr)
+    m_heightmap_bmp(nullptr),
+    m_deferred_path(std::nullopt),
+    m_source_path(std::nullopt),
+    m_bitmap_mutex(),
+    m_normal_data(),
+    m_normal_generation(0),
+    m_normal_mutex(),
+    m_pyramid(nullptr),
+    m_pyramid_generation(0),
+    m_pending_pyramid(),
+    m_pending_pyramid_generation(0),
+    m_pyramid_mutex()
 { }
 
+namespace {
+    /**
+     * @brief Finds every area that differs between two versions of a heightmap
+     * @details Consecutive rows which changed are grouped into one rectangle,
+     *          spanning from the leftmost to the rightmost changed pixel of
+     *          any of those rows.
+     *
+     * @param previous The heightmap before the change
+     * @param current The heightmap after the change
+     *
+     * @return Every changed area, or std::nullopt if the entire heightmap must
+     *         be treated as changed.
+     */
+    auto findChangedAreas(const HMDT::BitMap2& previous,
+                          const HMDT::BitMap2& current)
+        -> std::optional<std::vector<HMDT::Rectangle>>
+    {
+        const auto& prev_header = previous.info_header.v1;
+        const auto& cur_header = current.info_header.v1;
+
+        if(prev_header.width != cur_header.width ||
+           prev_header.height != cur_header.height ||
+           prev_header.bitsPerPixel != 8 || cur_header.bitsPerPixel != 8 ||
+           prev_header.colorsUsed != cur_header.colorsUsed ||
+           previous.color_table == nullptr || current.color_table == nullptr ||
+           std::memcmp(previous.color_table.get(), current.color_table.get(),
+                       prev_header.colorsUsed * sizeof(HMDT::RGBQuad)) != 0)
+        {
+            return std::nullopt;
+        }
+
+        uint32_t width = prev_header.width;
+        uint32_t height = prev_header.height;
+
+        std::vector<HMDT::Rectangle> areas;
+        std::optional<HMDT::Rectangle> area;
+
+        for(uint32_t y = 0; y < height; ++y) {
+            const auto* prev_row = previous.data.get() + static_cast<size_t>(y) * width;
+            const auto* cur_row = current.data.get() + static_cast<size_t>(y) * width;
+
+            if(std::memcmp(prev_row, cur_row, width) == 0) {
+                if(area) {
+                    areas.push_back(*area);
+                    area.reset();
+                }
+                continue;
+            }
+
+            uint32_t begin_x = 0;
+            while(prev_row[begin_x] == cur_row[begin_x]) ++begin_x;
+
+            uint32_t end_x = width;
+            while(prev_row[end_x - 1] == cur_row[end_x - 1]) --end_x;
+
+            HMDT::Rectangle row_area{ begin_x, y, end_x - begin_x, 1 };
+            area = area ? HMDT::uniteRectangles(*area, row_area) : row_area;
+        }
+
+        if(area) {
+            areas.push_back(*area);
+        }
+
+        return areas;
+    }
+}
+
 /**
  * @brief Writes all continent data to root/$HEIGHTMAP_FILENAME
  *
@@ -34,17 +112,35 @@ HMDT::Project::HeightMapProject::HeightMapProject(IRootMapProject& parent):
 auto HMDT::Project::HeightMapProject::save(const std::filesystem::path& root)
     -> MaybeVoid
 {
-    if(m_heightmap_bmp == nullptr) {
+    auto path = root / HEIGHTMAP_FILENAME;
+
+    // If the heightmap was never needed, then the file on disk is already
+    //  up-to-date and there is no reason to load it just to write it back
+    if(std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+            m_deferred_path && *m_deferred_path == path)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    RETURN_IF_ERROR(ensureBitMapLoaded());
+
+    auto bitmap = getLoadedBitMap();
+    if(bitmap == nullptr) {
         WRITE_ERROR("No heightmap has been loaded, cannot save yet.");
         RETURN_ERROR(STATUS_NO_DATA_LOADED);
     }
 
-    auto path = root / HEIGHTMAP_FILENAME;
-
     // Write the heightmap to a file
-    auto res = writeBMP(path, m_heightmap_bmp);
+    auto res = writeBMP(path, bitmap);
     RETURN_IF_ERROR(res);
 
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+        if(m_heightmap_bmp == bitmap) {
+            m_source_path = path;
+        }
+    }
+
     return STATUS_SUCCESS;
 }
 
@@ -71,37 +167,54 @@ auto HMDT::Project::HeightMapProject::load(const std::filesystem::path& root)
         RETURN_ERROR(std::make_error_code(std::errc::no_such_file_or_directory));
     }
 
-    return loadFile(path);
+    // Don't actually read the heightmap until something needs it
+    WRITE_DEBUG("Deferring load of ", path, " until it is first accessed.");
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+        m_heightmap_bmp.reset();
+        m_deferred_path = path;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_normal_mutex);
+        m_normal_data.reset();
+    }
+
+    {
+        // Dropping a pending build waits for it to finish
+        std::lock_guard<std::mutex> lock(m_pyramid_mutex);
+        m_pending_pyramid = { };
+        m_pyramid.reset();
+    }
+
+    registerLayerLoader();
+
+    return STATUS_SUCCESS;
 }
 
 auto HMDT::Project::HeightMapProject::export_(const std::filesystem::path& root) const noexcept
     -> MaybeVoid
 {
+    auto res = ensureBitMapLoaded();
+    RETURN_IF_ERROR(res);
+
     // TODO: Do we want to export from MapData's heightmap? Or just use the
     //       BitMap object?
-    auto res = writeBMP2(root / HEIGHTMAP_FILENAME,
-                         getMapData()->getHeightMap().lock().get(),
-                         getMapData()->getWidth(), getMapData()->getHeight(),
-                         1 /* depth */,
-                         true /* is_greyscale */);
+    res = writeBMP2(root / HEIGHTMAP_FILENAME,
+                    getMapData()->getHeightMap().lock().get(),
+                    getMapData()->getWidth(), getMapData()->getHeight(),
+                    1 /* depth */,
+                    true /* is_greyscale */);
     RETURN_IF_ERROR(res);
 
     {
-        // Normal map is a 24-bit bitmap
-        auto normal_data_size = getMapData()->getWidth() *
-                                getMapData()->getWidth() * 3;
-        std::unique_ptr<unsigned char[]> normal_data;
-        try {
-            normal_data.reset(new unsigned char[normal_data_size]);
-        } catch(const std::bad_alloc& e) {
-            WRITE_ERROR("Failed to allocate enough space for the world normal data.");
-            RETURN_ERROR(STATUS_BADALLOC);
-        }
+        std::lock_guard<std::mutex> lock(m_normal_mutex);
 
-        res = generateWorldNormalMap(*m_heightmap_bmp, normal_data.get());
+        res = updateWorldNormalMap();
         RETURN_IF_ERROR(res);
 
-        res = writeBMP2(root / NORMALMAP_FILENAME, normal_data.get(),
+        // Normal map is a 24-bit bitmap
+        res = writeBMP2(root / NORMALMAP_FILENAME, m_normal_data->data(),
                         getMapData()->getWidth(), getMapData()->getHeight(),
                         3 /* depth */);
         RETURN_IF_ERROR(res);
@@ -147,36 +260,51 @@ auto HMDT::Project::HeightMapProject::getRootMapParent() const
     return m_parent_project.getRootMapParent();
 }
 
-auto HMDT::Project::HeightMapProject::loadFile(const std::filesystem::path& path) noexcept
+/**
+ * @brief Reads the heightmap bitmap from a file, converting it to an 8-bit
+ *        greyscale image if necessary. Does not touch MapData.
+ * @details m_bitmap_mutex must be held when calling this function. The
+ *          current bitmap is only replaced once the new one has been read
+ *          successfully, and is never modified in place. A converted bitmap
+ *          no longer matches the file, and so cannot be released.
+ *
+ * @param path The path to read from
+ *
+ * @return STATUS_SUCCESS on success, or an error code on failure.
+ */
+auto HMDT::Project::HeightMapProject::readBitMap(const std::filesystem::path& path) const noexcept
     -> MaybeVoid
 {
+    std::shared_ptr<BitMap2> bitmap;
+
     try {
-        m_heightmap_bmp.reset(new BitMap2);
+        bitmap.reset(new BitMap2);
     } catch(const std::bad_alloc& e) {
         WRITE_ERROR("Failed to allocate space for new bitmap: ", e.what());
         RETURN_ERROR(STATUS_BADALLOC);
     }
 
-    auto res = readBMP(path, m_heightmap_bmp);
+    auto res = readBMP(path, bitmap);
     RETURN_IF_ERROR(res);
 
-    WRITE_DEBUG(*m_heightmap_bmp);
+    WRITE_DEBUG(*bitmap);
 
     if(auto d = getMapData()->getDimensions();
-            d.first != m_heightmap_bmp->info_header.v1.width ||
-            d.second != m_heightmap_bmp->info_header.v1.height)
+            d.first != bitmap->info_header.v1.width ||
+            d.second != bitmap->info_header.v1.height)
     {
         WRITE_ERROR("Heightmap dimensions (",
-                    m_heightmap_bmp->info_header.v1.width, ", ",
-                    m_heightmap_bmp->info_header.v1.height, ") do not match the"
+                    bitmap->info_header.v1.width, ", ",
+                    bitmap->info_header.v1.height, ") do not match the"
                     " previously loaded dimensions (", d.first, ", ", d.second,
                     ")");
         RETURN_ERROR(STATUS_DIMENSION_MISMATCH);
     }
 
+    bool converted = false;
+
     // Just in case the input image is not actually an 8-bit images
-    uint8_t* heightmap_data;
-    if(auto bpp = m_heightmap_bmp->info_header.v1.bitsPerPixel; bpp != 8) {
+    if(auto bpp = bitmap->info_header.v1.bitsPerPixel; bpp != 8) {
         WRITE_WARN("Heightmaps must be 8-bit greyscale images, not ", bpp, ". "
                    "Checking if the user is okay with converting it.");
 
@@ -195,8 +323,9 @@ auto HMDT::Project::HeightMapProject::loadFile(const std::filesystem::path& path
 
         switch(*response) {
             case 0:
-                res = convertBitMapTo8BPPGreyscale(*m_heightmap_bmp);
+                res = convertBitMapTo8BPPGreyscale(*bitmap);
                 RETURN_IF_ERROR(res);
+                converted = true;
                 break;
             case 1:
                 WRITE_ERROR("Not converting input image. Cannot continue loading.");
@@ -208,26 +337,394 @@ auto HMDT::Project::HeightMapProject::loadFile(const std::filesystem::path& path
         }
     }
 
-    heightmap_data = m_heightmap_bmp->data.get();
+    m_heightmap_bmp = bitmap;
 
-    // Load heightmap data into MapData
-    // This operation is fairly simple, as we are not making any modifications
-    //   to the data itself, and just loading it into memory
-    std::memcpy(getMapData()->getHeightMap().lock().get(),
-                heightmap_data,
-                getMapData()->getHeightMapSize());
+    if(converted) {
+        m_source_path.reset();
+    } else {
+        m_source_path = path;
+    }
 
     return STATUS_SUCCESS;
 }
 
-auto HMDT::Project::HeightMapProject::getBitMap() const
-    -> MonadOptionalRef<const BitMap2>
+/**
+ * @brief Reads the deferred heightmap file if it hasn't been read yet
+ *
+ * @return STATUS_SUCCESS on success, or an error code on failure.
+ */
+auto HMDT::Project::HeightMapProject::ensureBitMapLoaded() const noexcept
+    -> MaybeVoid
+{
+    std::shared_ptr<const BitMap2> loaded_bitmap;
+
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+        if(m_heightmap_bmp == nullptr && m_deferred_path) {
+            WRITE_DEBUG("Reading deferred heightmap ", *m_deferred_path);
+
+            auto res = readBitMap(*m_deferred_path);
+            RETURN_IF_ERROR(res);
+
+            m_deferred_path.reset();
+            loaded_bitmap = m_heightmap_bmp;
+        }
+    }
+
+    startPyramidBuild(loaded_bitmap);
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Starts building the mip pyramid of a heightmap in the background.
+ * @details Waits for any earlier build to finish first, whose pyramid is then
+ *          thrown away. The pyramid averages the heights that the bitmap's
+ *          palette resolves to.
+ *
+ * @param bitmap The heightmap to build the pyramid from. Nothing is built if
+ *               this is nullptr.
+ */
+void HMDT::Project::HeightMapProject::startPyramidBuild(std::shared_ptr<const BitMap2> bitmap) const
+{
+    if(bitmap == nullptr) return;
+
+    auto map_data = getMapData();
+    auto [width, height] = map_data->getDimensions();
+    auto generation = map_data->getLayerGeneration(MapData::Layer::HEIGHTMAP);
+
+    std::lock_guard<std::mutex> lock(m_pyramid_mutex);
+
+    try {
+        m_pending_pyramid = std::async(std::launch::async,
+            [bitmap, width = width, height = height]() {
+                auto pyramid = std::make_shared<HeightMapPyramid>();
+                pyramid->build(bitmap->data.get(), width, height,
+                               HeightMapPyramid::makePalette(*bitmap));
+                return pyramid;
+            });
+        m_pending_pyramid_generation = generation;
+    } catch(const std::exception& e) {
+        // Not fatal, as the pyramid just gets built when first needed instead
+        WRITE_WARN("Failed to start building the heightmap pyramid: ", e.what());
+    }
+}
+
+/**
+ * @brief Registers the loader which fills MapData's heightmap layer whenever
+ *        it gets allocated.
+ */
+void HMDT::Project::HeightMapProject::registerLayerLoader() {
+    getMapData()->setLayerLoader(MapData::Layer::HEIGHTMAP, [this]() {
+        if(auto res = ensureBitMapLoaded(); IS_FAILURE(res)) {
+            WRITE_ERROR("Failed to load heightmap data.");
+            WRITE_IF_ERROR(res);
+            return;
+        }
+
+        auto bitmap = getLoadedBitMap();
+        if(bitmap == nullptr) return;
+
+        // Load heightmap data into MapData
+        // This operation is fairly simple, as we are not making any
+        //   modifications to the data itself, and just loading it into memory
+        std::memcpy(getMapData()->getHeightMap().lock().get(),
+                    bitmap->data.get(),
+                    getMapData()->getHeightMapSize());
+    }, [this]() {
+        releaseBitMap();
+    });
+}
+
+/**
+ * @brief Releases the bitmap, the world normal map and the mip pyramid after
+ *        MapData has released its heightmap layer.
+ * @details The bitmap is only released if it can be read back from its file,
+ *          in which case it is deferred again until it is next needed.
+ */
+void HMDT::Project::HeightMapProject::releaseBitMap() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+        if(m_heightmap_bmp != nullptr && m_source_path) {
+            WRITE_DEBUG("Releasing heightmap, it will be read again from ",
+                        *m_source_path, " once needed.");
+
+            m_heightmap_bmp.reset();
+            m_deferred_path = m_source_path;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_normal_mutex);
+        m_normal_data.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_pyramid_mutex);
+        m_pending_pyramid = { };
+        m_pyramid.reset();
+    }
+}
+
+auto HMDT::Project::HeightMapProject::loadFile(const std::filesystem::path& path) noexcept
+    -> MaybeVoid
 {
-    if(m_heightmap_bmp != nullptr) {
-        return *m_heightmap_bmp;
+    std::optional<std::vector<Rectangle>> changed_areas;
+    std::shared_ptr<const BitMap2> bitmap;
+
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+        auto previous = m_heightmap_bmp;
+
+        auto res = readBitMap(path);
+        RETURN_IF_ERROR(res);
+
+        m_deferred_path.reset();
+        bitmap = m_heightmap_bmp;
+
+        // Reimporting a partially changed file only needs to refresh what
+        //  actually changed
+        if(previous != nullptr) {
+            changed_areas = findChangedAreas(*previous, *m_heightmap_bmp);
+        }
+    }
+
+    registerLayerLoader();
+
+    // Only refresh the layer if it is already in memory, otherwise it will
+    //  get loaded the first time it is accessed
+    if(getMapData()->isLayerResident(MapData::Layer::HEIGHTMAP)) {
+        std::memcpy(getMapData()->getHeightMap().lock().get(),
+                    bitmap->data.get(),
+                    getMapData()->getHeightMapSize());
+    }
+
+    if(changed_areas) {
+        WRITE_DEBUG("Reloaded heightmap has ", changed_areas->size(),
+                    " changed areas.");
+
+        for(auto&& area : *changed_areas) {
+            getMapData()->markLayerDirty(MapData::Layer::HEIGHTMAP, area);
+        }
     } else {
-        return std::nullopt;
+        getMapData()->markLayerDirty(MapData::Layer::HEIGHTMAP);
+
+        // A partial change can just update the pyramid, but anything else has
+        //  to rebuild all of it
+        startPyramidBuild(bitmap);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Gets the heightmap bitmap, reading it first if it was deferred.
+ *
+ * @return The bitmap, or nullptr if no heightmap could be loaded.
+ */
+auto HMDT::Project::HeightMapProject::getBitMap() const
+    -> std::shared_ptr<const BitMap2>
+{
+    auto res = ensureBitMapLoaded();
+    WRITE_IF_ERROR(res);
+
+    return getLoadedBitMap();
+}
+
+/**
+ * @brief Gets the bitmap as it was last read, without reading it.
+ * @details A bitmap is never modified after it has been read, as reading a new
+ *          file replaces it entirely. The returned bitmap can therefore be
+ *          read from without holding any lock.
+ *
+ * @return The bitmap, or nullptr if it has not been read.
+ */
+auto HMDT::Project::HeightMapProject::getLoadedBitMap() const
+    -> std::shared_ptr<const BitMap2>
+{
+    std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+    return m_heightmap_bmp;
+}
+
+/**
+ * @brief Gets the world normal map, regenerating whatever parts of it are out
+ *        of date with the heightmap.
+ * @details The returned normal map is never changed afterwards, later updates
+ *          are made to a copy of it instead.
+ *
+ * @return The world normal map as 24-bit color, or an error code if it could
+ *         not be generated.
+ */
+auto HMDT::Project::HeightMapProject::getWorldNormalMap() const
+    -> Maybe<std::shared_ptr<const std::vector<unsigned char>>>
+{
+    std::lock_guard<std::mutex> lock(m_normal_mutex);
+
+    auto res = updateWorldNormalMap();
+    RETURN_IF_ERROR(res);
+
+    return std::shared_ptr<const std::vector<unsigned char>>(m_normal_data);
+}
+
+/**
+ * @brief Brings the cached world normal map up to date with the heightmap.
+ * @details Only the areas of the heightmap which were marked as changed since
+ *          the last update are regenerated, along with a one pixel apron
+ *          around each of them, since every normal also depends on the
+ *          heights around it. The whole map is regenerated if nothing has
+ *          been generated yet, or if too many changes were made since.
+ *
+ * @par m_normal_mutex must be held when calling this function.
+ *
+ * @return STATUS_SUCCESS on success, or an error code on failure.
+ */
+auto HMDT::Project::HeightMapProject::updateWorldNormalMap() const noexcept
+    -> MaybeVoid
+{
+    auto res = ensureBitMapLoaded();
+    RETURN_IF_ERROR(res);
+
+    auto map_data = getMapData();
+    auto normal_data_size = static_cast<size_t>(map_data->getWidth()) *
+                            map_data->getHeight() * 3;
+
+    // Grab the generation before the bitmap, so that a heightmap read in the
+    //  meantime gets picked up again by the next update
+    auto generation = map_data->getLayerGeneration(MapData::Layer::HEIGHTMAP);
+
+    auto bitmap = getLoadedBitMap();
+    if(bitmap == nullptr) {
+        WRITE_ERROR("No heightmap has been loaded, cannot generate the world "
+                    "normal map yet.");
+        RETURN_ERROR(STATUS_NO_DATA_LOADED);
+    }
+
+    std::optional<std::vector<Rectangle>> changes;
+    if(m_normal_data != nullptr && m_normal_data->size() == normal_data_size) {
+        changes = map_data->getLayerChangesSince(MapData::Layer::HEIGHTMAP,
+                                                 m_normal_generation);
+    }
+
+    try {
+        if(changes) {
+            // New references are only handed out while m_normal_mutex is held,
+            //  so a normal map nobody else holds onto can be changed in place
+            if(!changes->empty() && m_normal_data.use_count() > 1) {
+                m_normal_data = std::make_shared<std::vector<unsigned char>>(*m_normal_data);
+            }
+
+            for(auto&& area : *changes) {
+                auto x = area.x > 0 ? area.x - 1 : 0;
+                auto y = area.y > 0 ? area.y - 1 : 0;
+
+                // Extra pixels past the edge of the map get clamped away
+                res = generateWorldNormalMap(*bitmap, m_normal_data->data(),
+                                             Rectangle{ x, y,
+                                                        area.x + area.w + 1 - x,
+                                                        area.y + area.h + 1 - y });
+                RETURN_IF_ERROR(res);
+            }
+        } else {
+            WRITE_DEBUG("Generating the entire world normal map.");
+
+            auto normal_data = std::make_shared<std::vector<unsigned char>>(normal_data_size);
+
+            res = generateWorldNormalMap(*bitmap, normal_data->data());
+            RETURN_IF_ERROR(res);
+
+            m_normal_data = normal_data;
+        }
+    } catch(const std::bad_alloc& e) {
+        WRITE_ERROR("Failed to allocate enough space for the world normal data.");
+        RETURN_ERROR(STATUS_BADALLOC);
+    }
+
+    m_normal_generation = generation;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Gets the mip pyramid of the heightmap.
+ * @details The pyramid is normally built in the background as soon as the
+ *          heightmap is read, in which case this waits for that build to
+ *          finish. Areas of the heightmap which changed since the pyramid was
+ *          built are then refreshed, without touching anything held by
+ *          earlier callers. A heightmap whose palette changed is rebuilt
+ *          entirely.
+ *
+ * @return The pyramid, or an error code if no heightmap could be loaded.
+ */
+auto HMDT::Project::HeightMapProject::getHeightMapPyramid() const
+    -> Maybe<std::shared_ptr<const HeightMapPyramid>>
+{
+    auto res = ensureBitMapLoaded();
+    RETURN_IF_ERROR(res);
+
+    auto map_data = getMapData();
+    auto [width, height] = map_data->getDimensions();
+
+    std::lock_guard<std::mutex> lock(m_pyramid_mutex);
+
+    // Grab the generation before the bitmap, so that a heightmap read in the
+    //  meantime gets picked up again by the next call
+    auto generation = map_data->getLayerGeneration(MapData::Layer::HEIGHTMAP);
+
+    auto bitmap = getLoadedBitMap();
+    if(bitmap == nullptr) {
+        WRITE_ERROR("No heightmap has been loaded, cannot build the heightmap "
+                    "pyramid yet.");
+        RETURN_ERROR(STATUS_NO_DATA_LOADED);
+    }
+
+    try {
+        if(m_pending_pyramid.valid()) {
+            m_pyramid = m_pending_pyramid.get();
+            m_pyramid_generation = m_pending_pyramid_generation;
+        }
+
+        if(m_pyramid != nullptr && m_pyramid_generation == generation) {
+            return m_pyramid;
+        }
+
+        auto palette = HeightMapPyramid::makePalette(*bitmap);
+
+        std::optional<std::vector<Rectangle>> changes;
+        if(m_pyramid != nullptr && m_pyramid->getWidth() == width &&
+           m_pyramid->getHeight() == height &&
+           m_pyramid->getPalette() == palette)
+        {
+            changes = map_data->getLayerChangesSince(MapData::Layer::HEIGHTMAP,
+                                                     m_pyramid_generation);
+        }
+
+        std::shared_ptr<HeightMapPyramid> pyramid;
+        if(changes) {
+            // Copy it, as callers may still be reading from the old pyramid
+            pyramid = std::make_shared<HeightMapPyramid>(*m_pyramid);
+
+            for(auto&& area : *changes) {
+                pyramid->update(bitmap->data.get(), area);
+            }
+        } else {
+            WRITE_DEBUG("Building the entire heightmap pyramid.");
+
+            pyramid = std::make_shared<HeightMapPyramid>();
+            pyramid->build(bitmap->data.get(), width, height, palette);
+        }
+
+        m_pyramid = pyramid;
+        m_pyramid_generation = generation;
+    } catch(const std::bad_alloc& e) {
+        WRITE_ERROR("Failed to allocate space for the heightmap pyramid.");
+        m_pyramid.reset();
+        RETURN_ERROR(STATUS_BADALLOC);
     }
+
+    return m_pyramid;
 }
 
 /**
@@ -248,3 +745,39 @@ auto HMDT::Project::HeightMapProject::visit(const std::function<MaybeVoid(std::s
     return heightmap_project_node;
 }
 
+
+/**
+ * @brief Reports how much memory the heightmap is using. A heightmap which
+ *        has not been loaded yet is reported as 0 bytes, and does not get
+ *        loaded.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::HeightMapProject::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    uint64_t bytes = 0;
+
+    // The normal map is locked first everywhere else, so never hold both
+    {
+        std::lock_guard<std::mutex> lock(m_normal_mutex);
+        if(m_normal_data != nullptr) {
+            bytes += estimateMemoryUsage(*m_normal_data);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_pyramid_mutex);
+        if(m_pyramid != nullptr) {
+            bytes += estimateMemoryUsage(*m_pyramid);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+        if(m_heightmap_bmp != nullptr) {
+            bytes += estimateMemoryUsage(*m_heightmap_bmp);
+        }
+    }
+
+    report.addChild("HeightMap Project", bytes);
+}
@@ -115,3 +115,15 @@ auto HMDT::Project::HistoryProject::visit(const std::function<MaybeVoid(std::sha
     return history_project_node;
 }
 
+
+/**
+ * @brief Reports how much memory every history project is using.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::HistoryProject::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    auto& self = report.addChild("History Project");
+
+    m_state_project.reportMemoryUsage(self);
+}
@@ -256,6 +256,10 @@ auto HMDT::Project::HoI4Project::load(const std::filesystem::path& path)
 
     RETURN_ERROR_IF(!validateData(), STATUS_PROJECT_VALIDATION_FAILED);
 
+    MemoryReport report("Total");
+    reportMemoryUsage(report);
+    report.writeToLog("after loading " + path.generic_string());
+
     return STATUS_SUCCESS;
 }
 
@@ -520,3 +524,16 @@ auto HMDT::Project::HoI4Project::visit(const std::function<MaybeVoid(std::shared
     return hoi4_project_node;
 }
 
+
+/**
+ * @brief Reports how much memory the entire project is using.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::HoI4Project::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    auto& self = report.addChild("Project '" + m_name + "'");
+
+    m_map_project.reportMemoryUsage(self);
+    m_history_project.reportMemoryUsage(self);
+}
@@ -1,10 +1,15 @@
 
 #include "IProject.h"
 
+#include <algorithm>
+#include <optional>
 #include <queue>
+#include <stdexcept>
+#include <string>
 
 #include "StatusCodes.h"
 #include "Constants.h"
+#include "MapData.h"
 
 HMDT::Project::IProject::IProject() {
     resetPromptCallback();
@@ -29,6 +34,16 @@ void HMDT::Project::IProject::resetPromptCallback() {
     };
 }
 
+/**
+ * @brief Reports how much memory this project is using.
+ * @details The default implementation reports nothing, which is correct for
+ *          any project that does not hold onto significant amounts of data.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::IProject::reportMemoryUsage(MemoryReport&) const noexcept
+{ }
+
 auto HMDT::Project::IProject::getPromptCallback() const noexcept
     -> const PromptCallback&
 {
@@ -81,7 +96,7 @@ const HMDT::Project::IRootProject& HMDT::Project::IRootProject::getRootParent()
 
 bool HMDT::Project::IProvinceProject::isValidProvinceLabel(uint32_t label) const
 {
-    return getProvinces().count(HashOnlyUUID(label)) != 0;
+    return getProvinces().atIndex(label) != nullptr;
 }
 
 bool HMDT::Project::IProvinceProject::isValidProvinceID(ProvinceID label) const
@@ -101,20 +116,38 @@ auto HMDT::Project::IProvinceProject::getProvinceForID(ProvinceID id)
     return getProvinces().at(id);
 }
 
+/**
+ * @brief Gets the province with the given label.
+ *
+ * @param label The dense ProvinceIndex of the province
+ *
+ * @throws std::out_of_range If no province has the given label
+ */
 auto HMDT::Project::IProvinceProject::getProvinceForLabel(uint32_t label) const
     -> const Province&
 {
-    return getProvinces().at(HashOnlyUUID(label));
+    if(const auto* province = getProvinces().atIndex(label); province != nullptr)
+    {
+        return *province;
+    }
+
+    throw std::out_of_range("Invalid province label " + std::to_string(label));
 }
 
 auto HMDT::Project::IProvinceProject::getProvinceForLabel(uint32_t label)
     -> Province&
 {
-    return getProvinces().at(HashOnlyUUID(label));
+    if(auto* province = getProvinces().atIndex(label); province != nullptr) {
+        return *province;
+    }
+
+    throw std::out_of_range("Invalid province label " + std::to_string(label));
 }
 
 /**
  * @brief Gets the parent at the root of the child hierarchy for the given ID
+ * @details Provinces which are part of the label matrix are looked up through
+ *          getRootProvinceIndex(), which implementations may cache.
  *
  * @param id The province ID to check
  *
@@ -127,34 +160,23 @@ auto HMDT::Project::IProvinceProject::getProvinceForLabel(uint32_t label)
 auto HMDT::Project::IProvinceProject::getRootProvinceParent(const ProvinceID& id) const noexcept
     -> MaybeRef<const Province>
 {
-    for(ProvinceID root_id = id; root_id != INVALID_PROVINCE;) {
-        if(!isValidProvinceID(root_id)) {
-            RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
-        }
-
-        const Province& province = getProvinceForID(root_id);
+    auto index = getIndexForProvinceID(id);
 
-        // When we find an invalid province parent ID, then we are at the root
-        if(province.parent_id == INVALID_PROVINCE) {
-            return province;
-        }
-
-        if(province.parent_id == root_id) {
-            WRITE_ERROR("Province ", province.id,
-                        " is marked as its own parent! This should never be possible to happen.");
-            RETURN_ERROR(STATUS_UNEXPECTED);
-        }
-
-        root_id = province.parent_id;
+    // Provinces which are not in the label matrix cannot be cached
+    if(index == INVALID_PROVINCE_INDEX) {
+        return findRootProvinceParent(id);
     }
 
-    // We should never reach here. To do so implies that root_id somehow became
-    //   INVALID_PROVINCE and we ended up _not_ returning in the middle of it.
-    RETURN_ERROR(STATUS_UNEXPECTED);
+    auto maybe_root_index = getRootProvinceIndex(index);
+    RETURN_IF_ERROR(maybe_root_index);
+
+    return getProvinceForLabel(*maybe_root_index);
 }
 
 /**
  * @brief Gets the parent at the root of the child hierarchy for the given ID
+ * @details Provinces which are part of the label matrix are looked up through
+ *          getRootProvinceIndex(), which implementations may cache.
  *
  * @param id The province ID to check
  *
@@ -167,12 +189,90 @@ auto HMDT::Project::IProvinceProject::getRootProvinceParent(const ProvinceID& id
 auto HMDT::Project::IProvinceProject::getRootProvinceParent(const ProvinceID& id) noexcept
     -> MaybeRef<Province>
 {
-    for(ProvinceID root_id = id; root_id != INVALID_PROVINCE;) {
+    auto index = getIndexForProvinceID(id);
+
+    // Provinces which are not in the label matrix cannot be cached
+    if(index == INVALID_PROVINCE_INDEX) {
+        auto maybe_root = findRootProvinceParent(id);
+        RETURN_IF_ERROR(maybe_root);
+
+        return getProvinceForID(maybe_root->get().id);
+    }
+
+    auto maybe_root_index = getRootProvinceIndex(index);
+    RETURN_IF_ERROR(maybe_root_index);
+
+    return getProvinceForLabel(*maybe_root_index);
+}
+
+/**
+ * @brief Gets the index of the parent at the root of the child hierarchy for
+ *        the given province index.
+ * @details Implementations may cache the result, in which case they must
+ *          forget it when invalidateRootProvinces() is called.
+ *
+ * @param index The index of the province to check
+ *
+ * @return The ProvinceIndex of the root province, which is 'index' itself if
+ *         the province has no parent. Returns the same errors as
+ *         getRootProvinceParent(), and STATUS_VALUE_NOT_FOUND if the root is
+ *         not part of the label matrix.
+ */
+auto HMDT::Project::IProvinceProject::getRootProvinceIndex(ProvinceIndex index) const noexcept
+    -> Maybe<ProvinceIndex>
+{
+    if(index == INVALID_PROVINCE_INDEX) {
+        RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
+    }
+
+    auto maybe_root = findRootProvinceParent(getProvinceIDForIndex(index));
+    RETURN_IF_ERROR(maybe_root);
+
+    auto root_index = getIndexForProvinceID(maybe_root->get().id);
+    if(root_index == INVALID_PROVINCE_INDEX) {
+        WRITE_ERROR("Root province ", maybe_root->get().id,
+                    " is not part of the label matrix.");
+        RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
+    }
+
+    return root_index;
+}
+
+/**
+ * @brief Called whenever the root of any of the given provinces may have
+ *        changed.
+ * @details Called by every function which changes the parent or children of a
+ *          province, right after it has done so.
+ *
+ * @param provinces The provinces which may have a different root now
+ */
+void HMDT::Project::IProvinceProject::invalidateRootProvinces(const std::set<ProvinceID>&) noexcept
+{ }
+
+/**
+ * @brief Finds the root parent by walking up the parent IDs of every province.
+ *
+ * @param id The province ID to check
+ *
+ * @return The root Province, with the same errors as getRootProvinceParent()
+ */
+auto HMDT::Project::IProvinceProject::findRootProvinceParent(const ProvinceID& id) const noexcept
+    -> MaybeRef<const Province>
+{
+    // A chain of parents can never be longer than the number of provinces
+    //   unless it loops back on itself
+    size_t steps = 0;
+    for(ProvinceID root_id = id; root_id != INVALID_PROVINCE; ++steps) {
         if(!isValidProvinceID(root_id)) {
             RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
         }
 
-        Province& province = getProvinceForID(root_id);
+        if(steps > getProvinces().size()) {
+            WRITE_ERROR("The parents of province ", id, " loop back on themselves.");
+            RETURN_ERROR(STATUS_UNEXPECTED);
+        }
+
+        const Province& province = getProvinceForID(root_id);
 
         // When we find an invalid province parent ID, then we are at the root
         if(province.parent_id == INVALID_PROVINCE) {
@@ -231,15 +331,27 @@ auto HMDT::Project::IProvinceProject::mergeProvinces(const ProvinceID& id1,
         RETURN_ERROR(STATUS_UNEXPECTED);
     }
 
+    // Remember both sides of the merge so that everything drawn per merged
+    //   province can be updated afterwards
+    auto merged_provinces1 = getMergedProvinces(maybe_root1->get().id);
+    auto merged_provinces2 = getMergedProvinces(maybe_root2->get().id);
+
     WRITE_DEBUG("Setting root1 (", maybe_root1->get().id, ") parent=",
                 maybe_root2->get().id);
 
-    maybe_root1->get().parent_id = maybe_root2->get().id;
+    getProvinces().setParent(getIndexForProvinceID(maybe_root1->get().id),
+                             maybe_root2->get().id);
     maybe_root2->get().children.insert(maybe_root1->get().id);
 
+    // Everything which was under root1 is now under root2, so root1 is the only
+    //   province whose parent changed
+    invalidateRootProvinces({ maybe_root1->get().id });
+
     WRITE_DEBUG("New child tree after merging:\n",
                 genProvinceChildTree(maybe_root2->get().id).orElse(""));
 
+    onProvincesMerged(buildMergeEvent(merged_provinces1, merged_provinces2));
+
     return STATUS_SUCCESS;
 }
 
@@ -252,6 +364,185 @@ auto HMDT::Project::IProvinceProject::mergeProvinces(const ProvinceID& id1,
  */
 auto HMDT::Project::IProvinceProject::unmergeProvince(const ProvinceID& id) noexcept
     -> MaybeVoid
+{
+    // Remember the whole tree, so that it can be split up for the merge event
+    std::set<ProvinceID> merged_provinces;
+    if(isValidProvinceID(id)) {
+        merged_provinces = getMergedProvinces(id);
+    }
+
+    auto result = unlinkProvince(id);
+
+    if(IS_SUCCESS(result) && merged_provinces.size() > 1) {
+        // Split the old tree into the part that was unmerged and the rest
+        auto unmerged_provinces = getMergedProvinces(id);
+        for(auto&& unmerged_id : unmerged_provinces) {
+            merged_provinces.erase(unmerged_id);
+        }
+
+        onProvincesMerged(buildMergeEvent(unmerged_provinces, merged_provinces));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Gets every province that borders a merged province, but is not part
+ *        of it.
+ *
+ * @param id Any province that is part of the merged province
+ *
+ * @return The ProvinceIndex of every bordering province
+ */
+auto HMDT::Project::IProvinceProject::getMergedAdjacentProvinces(const ProvinceID& id) const noexcept
+    -> std::set<ProvinceIndex>
+{
+    std::set<ProvinceIndex> members;
+    for(auto&& merged_id : getMergedProvinces(id)) {
+        members.insert(getIndexForProvinceID(merged_id));
+    }
+
+    std::set<ProvinceIndex> adjacent_provinces;
+    for(auto&& member : members) {
+        for(auto&& edge : getAdjacencyGraph().getEdges(member)) {
+            if(members.count(edge.neighbour) == 0) {
+                adjacent_provinces.insert(edge.neighbour);
+            }
+        }
+    }
+
+    return adjacent_provinces;
+}
+
+/**
+ * @brief Registers a callback to be told whenever provinces get merged or
+ *        unmerged
+ *
+ * @param callback The callback
+ *
+ * @return An ID which can be passed to removeMergeListener()
+ */
+size_t HMDT::Project::IProvinceProject::addMergeListener(const MergeCallback& callback)
+{
+    auto id = m_next_merge_listener_id++;
+
+    m_merge_listeners[id] = callback;
+
+    return id;
+}
+
+void HMDT::Project::IProvinceProject::removeMergeListener(size_t id) {
+    m_merge_listeners.erase(id);
+}
+
+/**
+ * @brief Called after provinces have been merged or unmerged
+ * @details Implementations which derive anything from which provinces are
+ *          merged should update it here before calling this, which tells
+ *          every listener.
+ *
+ * @param event Which provinces were affected
+ */
+void HMDT::Project::IProvinceProject::onProvincesMerged(const MergeEvent& event) noexcept
+{
+    for(auto&& [_, callback] : m_merge_listeners) {
+        try {
+            callback(event);
+        } catch(const std::exception& e) {
+            WRITE_ERROR("Merge listener threw an exception: ", e.what());
+        }
+    }
+}
+
+/**
+ * @brief Describes a merge between two sets of provinces
+ * @details Only pixels along the border between both sets can change how
+ *          they are drawn, and every one of those pixels is within one pixel
+ *          of either set. The area is therefore around whichever set covers
+ *          less of the map, so that repeatedly merging single provinces into
+ *          a large one stays cheap.
+ *
+ * @param side1 Every province on one side of the merge
+ * @param side2 Every province on the other side of the merge
+ */
+auto HMDT::Project::IProvinceProject::buildMergeEvent(const std::set<ProvinceID>& side1,
+                                                      const std::set<ProvinceID>& side2) const noexcept
+    -> MergeEvent
+{
+    MergeEvent event{ { }, Rectangle{ 0, 0, 0, 0 } };
+
+    // Gets the pixels covered by every province in a set, as inclusive bounds
+    auto get_bounds = [&event, this](const std::set<ProvinceID>& ids)
+        -> std::optional<std::pair<Point2D, Point2D>>
+    {
+        std::optional<std::pair<Point2D, Point2D>> bounds;
+
+        for(auto&& id : ids) {
+            auto index = getIndexForProvinceID(id);
+            if(index == INVALID_PROVINCE_INDEX) continue;
+
+            event.provinces.push_back(index);
+
+            const auto& bb = getProvinceForLabel(index).bounding_box;
+            Point2D min{ std::min(bb.bottom_left.x, bb.top_right.x),
+                         std::min(bb.bottom_left.y, bb.top_right.y) };
+            Point2D max{ std::max(bb.bottom_left.x, bb.top_right.x),
+                         std::max(bb.bottom_left.y, bb.top_right.y) };
+
+            if(!bounds) {
+                bounds = std::make_pair(min, max);
+            } else {
+                bounds->first.x = std::min(bounds->first.x, min.x);
+                bounds->first.y = std::min(bounds->first.y, min.y);
+                bounds->second.x = std::max(bounds->second.x, max.x);
+                bounds->second.y = std::max(bounds->second.y, max.y);
+            }
+        }
+
+        return bounds;
+    };
+
+    auto area_of = [](const auto& bounds) -> uint64_t {
+        return static_cast<uint64_t>(bounds->second.x - bounds->first.x + 1) *
+               (bounds->second.y - bounds->first.y + 1);
+    };
+
+    auto bounds1 = get_bounds(side1);
+    auto bounds2 = get_bounds(side2);
+
+    auto bounds = bounds1;
+    if(!bounds1 || (bounds2 && area_of(bounds2) < area_of(bounds1))) {
+        bounds = bounds2;
+    }
+
+    if(!bounds) return event;
+
+    // Grow by a pixel to catch the other side of the border, but stay on the
+    //   map
+    auto [width, height] = getMapData()->getDimensions();
+    if(width == 0 || height == 0) return event;
+
+    auto min_x = bounds->first.x > 0 ? bounds->first.x - 1 : 0;
+    auto min_y = bounds->first.y > 0 ? bounds->first.y - 1 : 0;
+    auto max_x = std::min(bounds->second.x + 1, width - 1);
+    auto max_y = std::min(bounds->second.y + 1, height - 1);
+
+    if(min_x <= max_x && min_y <= max_y) {
+        event.area = Rectangle{ min_x, min_y, max_x - min_x + 1, max_y - min_y + 1 };
+    }
+
+    return event;
+}
+
+/**
+ * @brief Removes the specified province from its parent and children
+ *
+ * @param id The ID of the province to remove from its parent.
+ *
+ * @return STATUS_SUCCESS upon success, or a failure code otherwise.
+ */
+auto HMDT::Project::IProvinceProject::unlinkProvince(const ProvinceID& id) noexcept
+    -> MaybeVoid
 {
     if(!isValidProvinceID(id)) {
         WRITE_ERROR("The province ID is invalid: ", id);
@@ -261,6 +552,9 @@ auto HMDT::Project::IProvinceProject::unmergeProvince(const ProvinceID& id) noex
     // Get the province
     Province& province = getProvinceForID(id);
 
+    // Every province in the tree may end up with a different root
+    auto tree = getMergedProvinces(id);
+
     WRITE_DEBUG("Un-merging province ", id, " whose parent is ",
                 province.parent_id, " and which has ", province.children.size(),
                 " children.");
@@ -293,18 +587,22 @@ auto HMDT::Project::IProvinceProject::unmergeProvince(const ProvinceID& id) noex
 
         for(auto& child : child_provinces) {
             // Make sure we don't mark a child as its own parent
+            auto child_index = getIndexForProvinceID(child.get().id);
+
             if(child.get().id != new_parent_id) {
-                child.get().parent_id = new_parent_id;
+                getProvinces().setParent(child_index, new_parent_id);
                 new_parent.children.insert(child.get().id);
             } else {
                 // For the new parent, make it have a nil parent id
-                child.get().parent_id = INVALID_PROVINCE;
+                getProvinces().setParent(child_index, INVALID_PROVINCE);
             }
         }
 
         // Remove all of our children
         province.children.clear();
 
+        invalidateRootProvinces(tree);
+
         return STATUS_SUCCESS;
     }
 
@@ -364,18 +662,21 @@ auto HMDT::Project::IProvinceProject::unmergeProvince(const ProvinceID& id) noex
     WRITE_DEBUG("Modifying ", child_provinces.size(),
                 " children's parents to be ", province.parent_id);
     for(auto& child : child_provinces) {
-        child.get().parent_id = province.parent_id;
+        getProvinces().setParent(getIndexForProvinceID(child.get().id),
+                                 province.parent_id);
 
         // Make sure to insert the child into it's new parent's list of children
         root_children.insert(child.get().id);
     }
 
     // Remove the province's parent id to unlink it fully from the parent.
-    province.parent_id = INVALID_PROVINCE;
+    getProvinces().setParent(getIndexForProvinceID(id), INVALID_PROVINCE);
 
     // Make sure that after all of this we end up with no children.
     province.children.clear();
 
+    invalidateRootProvinces(tree);
+
     return STATUS_SUCCESS;
 }
 
@@ -476,7 +777,8 @@ auto HMDT::Project::IProvinceProject::getMergedProvinces(const ProvinceID& id) c
     to_search.push(id);
 
     while(!to_search.empty()) {
-        const auto& next_id = to_search.front();
+        // Copied, since popping it would leave a reference dangling
+        const auto next_id = to_search.front();
         to_search.pop();
 
         WRITE_DEBUG("Check ", next_id);
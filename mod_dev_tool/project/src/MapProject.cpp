@@ -1,9 +1,12 @@
 
 #include "MapProject.h"
 
+#include <algorithm>
 #include <fstream>
 #include <cstring>
 #include <cerrno>
+#include <future>
+#include <sstream>
 
 #include "Options.h"
 #include "Logger.h"
@@ -25,11 +28,15 @@ HMDT::Project::MapProject::MapProject(IProject& parent_project):
     m_rivers_project(*this),
     m_map_data(new MapData),
     m_terrains(getDefaultTerrains()),
-    m_parent_project(parent_project)
+    m_parent_project(parent_project),
+    m_validation_report()
 {
 }
 
 HMDT::Project::MapProject::~MapProject() {
+    // The sub-projects register layer loaders which refer back to themselves,
+    //  so make sure none of them can get called once we are gone
+    m_map_data->clearLayerLoaders();
 }
 
 /**
@@ -286,96 +293,396 @@ auto HMDT::Project::MapProject::export_(const std::filesystem::path& root) const
     return STATUS_SUCCESS;
 }
 
-auto HMDT::Project::MapProject::validateProvinceStateID(StateID province_state_id,
-                                                        ProvinceID province_id)
-    -> MaybeVoid
+/**
+ * @brief Validates the map data, along with how provinces are assigned to
+ *        states.
+ * @details Every validator runs in parallel and fills in its own report, which
+ *          are then merged together. If fixing warnings on load was requested,
+ *          any fixable issue gets fixed afterwards.
+ *
+ * @return false if any error was found and not fixed, true otherwise.
+ */
+bool HMDT::Project::MapProject::validateData() {
+    WRITE_DEBUG("Validating all project data.");
+
+    m_validation_report = ValidationReport();
+
+    if(!m_provinces_project.validateData()) {
+        return false;
+    }
+
+    auto index = buildStateMembershipIndex();
+
+    auto province_states = std::async(std::launch::async, [this, &index]() {
+        return validateProvinceStates(index);
+    });
+    auto state_provinces = std::async(std::launch::async, [this, &index]() {
+        return validateStateProvinces(index);
+    });
+    auto province_merges = std::async(std::launch::async, [this]() {
+        return validateProvinceMerges();
+    });
+    auto rivers = std::async(std::launch::async, [this]() {
+        return m_rivers_project.validateRivers();
+    });
+
+    m_validation_report.merge(province_states.get());
+    m_validation_report.merge(state_provinces.get());
+    m_validation_report.merge(province_merges.get());
+    m_validation_report.merge(rivers.get());
+
+    if(prog_opts.fix_warnings_on_load && !m_validation_report.empty()) {
+        fixValidationIssues(m_validation_report, index);
+    }
+
+    m_validation_report.writeToLog(MAX_LOGGED_VALIDATION_ISSUES);
+
+    return !m_validation_report.hasErrors();
+}
+
+/**
+ * @brief Gets every issue found the last time the data was validated.
+ */
+auto HMDT::Project::MapProject::getValidationReport() const noexcept
+    -> const ValidationReport&
 {
-    if(province_state_id != -1) {
-        const auto& state_project = getRootParent().getHistoryProject().getStateProject();
+    return m_validation_report;
+}
 
-        if(!state_project.isValidStateID(province_state_id)) {
-            WRITE_WARN("Province ", province_id, " has state ID of ", province_state_id, " which is invalid!");
-            return STATUS_PROVINCE_INVALID_STATE_ID;
+/**
+ * @brief Builds the lookup from every province to the states which list it.
+ *
+ * @return The index, sized to hold every province.
+ */
+auto HMDT::Project::MapProject::buildStateMembershipIndex() const
+    -> StateMembershipIndex
+{
+    const auto& provinces = m_provinces_project.getProvinces();
+    const auto& states = getRootParent().getHistoryProject().getStateProject().getStates();
+
+    StateMembershipIndex index;
+    index.states_by_province.resize(provinces.size() + 1);
+
+    for(auto&& [state_id, state] : states) {
+        for(auto&& province_id : state.provinces) {
+            if(auto prov_index = provinces.getIndex(province_id);
+                    prov_index != INVALID_PROVINCE_INDEX)
+            {
+                index.states_by_province[prov_index].push_back(state_id);
+            } else {
+                index.unknown_provinces.emplace_back(state_id, province_id);
+            }
         }
+    }
+
+    return index;
+}
+
+/**
+ * @brief Checks that every province is listed by the state it says it is in.
+ *
+ * @param index Which states list every province
+ *
+ * @return Every issue found. These are all errors.
+ */
+auto HMDT::Project::MapProject::validateProvinceStates(const StateMembershipIndex& index) const
+    -> ValidationReport
+{
+    static const std::string VALIDATOR = "Province States";
+
+    const auto& provinces = m_provinces_project.getProvinces();
+    const auto& state_project = getRootParent().getHistoryProject().getStateProject();
+
+    // Only the state column is scanned, the province itself is only looked at
+    //   to report an issue
+    const auto& states = provinces.getStates();
+
+    auto reports = parallelMapChunks(provinces.size(),
+        [&](uint32_t begin, uint32_t end) {
+            ValidationReport report;
 
-        MaybeRef<const State> state = state_project.getStateForID(province_state_id);
-        return state.andThen([&](auto state_ref) {
-            auto& state = state_ref.get();
-            if(std::find(state.provinces.begin(), state.provinces.end(), province_id) == state.provinces.end())
+            for(ProvinceIndex prov_index = begin + 1; prov_index <= end; ++prov_index)
             {
-                WRITE_WARN("State ", state.id, " does not contain province #", province_id, "!");
+                auto state_id = states[prov_index - 1];
+
+                if(state_id == static_cast<StateID>(-1)) continue;
+
+                if(!state_project.isValidStateID(state_id)) {
+                    const auto& prov_id = provinces.getID(prov_index);
+
+                    auto& issue = report.addIssue(ValidationReport::Severity::ERROR,
+                                                  VALIDATOR,
+                                                  STATUS_PROVINCE_INVALID_STATE_ID,
+                                                  "Province ", prov_id,
+                                                  " has state ID of ",
+                                                  state_id,
+                                                  " which is invalid.");
+                    issue.province = prov_id;
+                    issue.state = state_id;
+                    continue;
+                }
 
-                return STATUS_PROVINCE_NOT_IN_STATE;
+                const auto& listed_by = index.states_by_province[prov_index];
+                if(std::find(listed_by.begin(), listed_by.end(),
+                             state_id) == listed_by.end())
+                {
+                    const auto& prov_id = provinces.getID(prov_index);
+
+                    auto& issue = report.addIssue(ValidationReport::Severity::ERROR,
+                                                  VALIDATOR,
+                                                  STATUS_PROVINCE_NOT_IN_STATE,
+                                                  "State ", state_id,
+                                                  " does not contain province ",
+                                                  prov_id, '.');
+                    issue.province = prov_id;
+                    issue.state = state_id;
+                }
             }
 
-            return STATUS_SUCCESS;
+            return report;
         });
+
+    ValidationReport report;
+    for(auto&& chunk_report : reports) {
+        report.merge(std::move(chunk_report));
     }
 
-    return STATUS_SUCCESS;
+    return report;
 }
 
-bool HMDT::Project::MapProject::validateData() {
-    WRITE_DEBUG("Validating all project data.");
+/**
+ * @brief Checks that every province listed by a state exists, belongs to that
+ *        state, and is not listed by any other state.
+ * @details Provinces whose own state is wrong are left to
+ *          validateProvinceStates, so that each province is only ever reported
+ *          once.
+ *
+ * @param index Which states list every province
+ *
+ * @return Every issue found. These are all warnings.
+ */
+auto HMDT::Project::MapProject::validateStateProvinces(const StateMembershipIndex& index) const
+    -> ValidationReport
+{
+    static const std::string VALIDATOR = "State Provinces";
 
-    bool success = true;
-
-    success = success && m_provinces_project.validateData();
-
-    for(auto&& [_, local_province] : m_provinces_project.getProvinces()) {
-        auto& province = local_province;
-
-        auto result = validateProvinceStateID(province.state, province.id);
-
-        if(IS_FAILURE(result)) {
-            if(prog_opts.fix_warnings_on_load) {
-                WRITE_INFO("Attempting to fix warnings...");
-                if(result.error() == STATUS_PROVINCE_INVALID_STATE_ID) {
-                    WRITE_INFO("Setting province state ID to -1.");
-                    province.state = -1;
-                } else if(result.error() == STATUS_PROVINCE_NOT_IN_STATE) {
-                    getRootParent().getHistoryProject().getStateProject().getStateForID(province.state).andThen([&](auto prov_state_ref)
-                    {
-                        auto& prov_state = prov_state_ref.get();
-
-                        WRITE_INFO("Adding province ", province.id, " to state ", prov_state.id);
-                        prov_state.provinces.push_back(province.id);
-                    }).orElse<void>([&province]() {
-                        WRITE_ERROR("Unable to remove province ", province.id,
-                                    " from its old state ", province.state,
-                                    " as that state does not exist. Will"
-                                    " attempt to add it to the correct state"
-                                    " anyway.");
-                    });
-
-                    WRITE_INFO("Searching for any state that currently has this province...");
-                    std::vector<ProvinceID>::const_iterator province_it;
-                    auto it = std::find_if(getRootParent().getHistoryProject().getStateProject().getStates().begin(),
-                                           getRootParent().getHistoryProject().getStateProject().getStates().end(),
-                                           [&province, &province_it](auto& id_state_pair)
-                                           {
-                                               return (province_it = std::find(id_state_pair.second.provinces.begin(),
-                                                                               id_state_pair.second.provinces.end(),
-                                                                               province.id)) != id_state_pair.second.provinces.end();
-                                           });
-
-                    if(it == getRootParent().getHistoryProject().getStateProject().getStates().end()) {
-                        WRITE_INFO("No states found containing this province.");
-                    } else {
-                        WRITE_INFO("Found state ", it->second.id, " that contains province ", province.id, ". Removing the province from the state.");
-                        State& state = getRootParent().getHistoryProject().getStateProject().getStateForIterator(it);
-                        state.provinces.erase(province_it);
+    const auto& provinces = m_provinces_project.getProvinces();
+    const auto& state_project = getRootParent().getHistoryProject().getStateProject();
+
+    const auto& states = provinces.getStates();
+
+    auto reports = parallelMapChunks(provinces.size(),
+        [&](uint32_t begin, uint32_t end) {
+            ValidationReport report;
+
+            for(ProvinceIndex prov_index = begin + 1; prov_index <= end; ++prov_index)
+            {
+                const auto& listed_by = index.states_by_province[prov_index];
+                if(listed_by.empty()) continue;
+
+                auto state_id = states[prov_index - 1];
+                const auto& prov_id = provinces.getID(prov_index);
+
+                bool has_state = state_id != static_cast<StateID>(-1);
+                bool listed_by_own_state = std::find(listed_by.begin(),
+                                                     listed_by.end(),
+                                                     state_id) != listed_by.end();
+
+                if(has_state && (!state_project.isValidStateID(state_id) ||
+                                 !listed_by_own_state))
+                {
+                    continue;
+                }
+
+                if(listed_by.size() > 1) {
+                    std::stringstream states_ss;
+                    for(size_t i = 0; i < listed_by.size(); ++i) {
+                        states_ss << (i == 0 ? "" : ", ") << listed_by[i];
+                    }
+
+                    auto& issue = report.addIssue(ValidationReport::Severity::WARNING,
+                                                  VALIDATOR,
+                                                  STATUS_PROVINCE_IN_MULTIPLE_STATES,
+                                                  "Province ", prov_id,
+                                                  " is listed by states ",
+                                                  states_ss.str(),
+                                                  ", but belongs to state ",
+                                                  state_id, '.');
+                    issue.province = prov_id;
+                } else if(!has_state) {
+                    auto& issue = report.addIssue(ValidationReport::Severity::WARNING,
+                                                  VALIDATOR,
+                                                  STATUS_STATE_PROVINCE_MISMATCH,
+                                                  "State ", listed_by.front(),
+                                                  " lists province ", prov_id,
+                                                  " which does not belong to any state.");
+                    issue.province = prov_id;
+                    issue.state = listed_by.front();
+                }
+            }
+
+            return report;
+        });
+
+    ValidationReport report;
+
+    for(auto&& [state_id, province_id] : index.unknown_provinces) {
+        auto& issue = report.addIssue(ValidationReport::Severity::WARNING,
+                                      VALIDATOR,
+                                      STATUS_STATE_INVALID_PROVINCE,
+                                      "State ", state_id, " lists province ",
+                                      province_id, " which does not exist.");
+        issue.province = province_id;
+        issue.state = state_id;
+    }
+
+    for(auto&& chunk_report : reports) {
+        report.merge(std::move(chunk_report));
+    }
+
+    return report;
+}
+
+/**
+ * @brief Checks that the parent and children of every merged province agree
+ *        with each other.
+ *
+ * @return Every issue found. These are all warnings.
+ */
+auto HMDT::Project::MapProject::validateProvinceMerges() const
+    -> ValidationReport
+{
+    static const std::string VALIDATOR = "Province Merges";
+
+    const auto& provinces = m_provinces_project.getProvinces();
+    const auto& parent_indices = provinces.getParentIndices();
+
+    auto reports = parallelMapChunks(provinces.size(),
+        [&](uint32_t begin, uint32_t end) {
+            ValidationReport report;
+
+            auto addIssue = [&report](const Province& province, auto&&... args)
+            {
+                report.addIssue(ValidationReport::Severity::WARNING, VALIDATOR,
+                                STATUS_PROVINCE_MERGE_MISMATCH,
+                                "Province ", province.id, args...)
+                      .province = province.id;
+            };
+
+            for(ProvinceIndex prov_index = begin + 1; prov_index <= end; ++prov_index)
+            {
+                const Province& province = *provinces.atIndex(prov_index);
+                auto parent_index = parent_indices[prov_index - 1];
+
+                if(parent_index == prov_index) {
+                    addIssue(province, " is marked as its own parent.");
+                } else if(parent_index != INVALID_PROVINCE_INDEX) {
+                    if(provinces.atIndex(parent_index)->children.count(province.id) == 0) {
+                        addIssue(province, " has parent ", province.parent_id,
+                                 " which does not list it as a child.");
+                    }
+                } else if(province.parent_id != INVALID_PROVINCE) {
+                    addIssue(province, " has parent ", province.parent_id,
+                             " which does not exist.");
+                }
+
+                for(auto&& child_id : province.children) {
+                    auto child_index = provinces.getIndex(child_id);
+                    if(child_index == INVALID_PROVINCE_INDEX) {
+                        addIssue(province, " has child ", child_id,
+                                 " which does not exist.");
+                    } else if(parent_indices[child_index - 1] != prov_index) {
+                        addIssue(province, " has child ", child_id,
+                                 " whose parent is ",
+                                 provinces.atIndex(child_index)->parent_id, '.');
                     }
                 }
-            } else {
-                success = false;
             }
 
+            return report;
+        });
+
+    ValidationReport report;
+    for(auto&& chunk_report : reports) {
+        report.merge(std::move(chunk_report));
+    }
+
+    return report;
+}
+
+/**
+ * @brief Fixes every issue in a report which can be fixed automatically.
+ * @details The state stored on each province is treated as correct if it
+ *          exists. Provinces without a valid state instead join the first
+ *          state which lists them, if any does, rather than being taken out
+ *          of it. Every province is then only listed by its own state.
+ *
+ * @param report The report to fix issues from. Fixed issues are marked as such.
+ * @param index Which states list every province, as of validation
+ */
+void HMDT::Project::MapProject::fixValidationIssues(ValidationReport& report,
+                                                    const StateMembershipIndex& index)
+{
+    WRITE_INFO("Attempting to fix validation issues...");
+
+    auto& provinces = m_provinces_project.getProvinces();
+    auto& state_project = getRootParent().getHistoryProject().getStateProject();
+
+    // Several issues may be about the same province, so only fix each once
+    std::vector<bool> fixed_provinces(provinces.size() + 1, false);
+    std::vector<ProvinceID> changed_provinces;
+
+    for(auto&& issue : report.getIssues()) {
+        if(!issue.province) continue;
+
+        if(issue.code != STATUS_PROVINCE_INVALID_STATE_ID &&
+           issue.code != STATUS_PROVINCE_NOT_IN_STATE &&
+           issue.code != STATUS_PROVINCE_IN_MULTIPLE_STATES &&
+           issue.code != STATUS_STATE_PROVINCE_MISMATCH)
+        {
             continue;
         }
+
+        auto prov_index = provinces.getIndex(*issue.province);
+        if(prov_index == INVALID_PROVINCE_INDEX) continue;
+
+        if(!fixed_provinces[prov_index]) {
+            Province& province = *provinces.atIndex(prov_index);
+            const auto& listed_by = index.states_by_province[prov_index];
+
+            if(!state_project.isValidStateID(province.state)) {
+                StateID state_id = listed_by.empty() ? static_cast<StateID>(-1)
+                                                     : listed_by.front();
+
+                WRITE_INFO("Moving province ", province.id, " from state ",
+                           province.state, " to state ", state_id);
+
+                provinces.setState(prov_index, state_id);
+                changed_provinces.push_back(province.id);
+            }
+
+            // Taking the province out of every state first, its own
+            //   included, means it ends up listed exactly once
+            for(auto&& state_id : listed_by) {
+                state_project.removeProvinceFromState(state_id, province.id);
+            }
+
+            if(province.state != static_cast<StateID>(-1)) {
+                state_project.addProvinceToState(province.state, province.id);
+            }
+
+            fixed_provinces[prov_index] = true;
+        }
+
+        issue.fixed = true;
     }
 
-    return success;
+    WRITE_INFO("Fixed ", report.countFixed(), " validation issues.");
+
+    // Provinces may have been moved between states
+    if(!changed_provinces.empty()) {
+        state_project.updateStateIDMatrix(changed_provinces);
+    }
 }
 
 HMDT::Project::IRootProject& HMDT::Project::MapProject::getRootParent() {
@@ -413,6 +720,12 @@ void HMDT::Project::MapProject::import(const ShapeFinder& sf,
     {
         m_provinces_project.import(sf, map_data);
     }
+
+    MemoryReport report("Import");
+    report.addChild("Shapes (" + std::to_string(sf.getShapes().size()) + ")",
+                    estimateMemoryUsage(sf.getShapes()));
+    reportMemoryUsage(report);
+    report.writeToLog("after import");
 }
 
 auto HMDT::Project::MapProject::getProvinceProject() noexcept
@@ -500,11 +813,13 @@ void HMDT::Project::MapProject::moveProvinceToState(ProvinceID prov_id,
 void HMDT::Project::MapProject::moveProvinceToState(Province& province,
                                                     StateID state_id)
 {
-    removeProvinceFromState(province);
-    province.state = state_id;
+    auto& provinces = getProvinceProject().getProvinces();
+
+    removeProvinceFromState(province, false);
+    provinces.setState(provinces.getIndex(province.id), state_id);
     getRootParent().getHistoryProject().getStateProject().addProvinceToState(state_id, province.id);
 
-    getRootParent().getHistoryProject().getStateProject().updateStateIDMatrix();
+    getRootParent().getHistoryProject().getStateProject().updateStateIDMatrix({ province.id });
 }
 
 /**
@@ -515,15 +830,19 @@ void HMDT::Project::MapProject::moveProvinceToState(Province& province,
 void HMDT::Project::MapProject::removeProvinceFromState(Province& province,
                                                         bool update_state_id_matrix)
 {
-    // Remove from its old state
-    if(auto prov_state_id = province.state;
-            getRootParent().getHistoryProject().getStateProject().isValidStateID(prov_state_id))
+    auto& state_project = getRootParent().getHistoryProject().getStateProject();
+
+    // Remove from whichever state currently lists it
+    if(auto prov_state_id = state_project.getStateIDForProvince(province.id);
+            IS_SUCCESS(prov_state_id))
     {
-        getRootParent().getHistoryProject().getStateProject().removeProvinceFromState(prov_state_id, province.id);
+        state_project.removeProvinceFromState(*prov_state_id, province.id);
     }
-    province.state = -1;
 
-    if(update_state_id_matrix) getRootParent().getHistoryProject().getStateProject().updateStateIDMatrix();
+    auto& provinces = getProvinceProject().getProvinces();
+    provinces.setState(provinces.getIndex(province.id), -1);
+
+    if(update_state_id_matrix) state_project.updateStateIDMatrix({ province.id });
 }
 
 /**
@@ -535,28 +854,38 @@ void HMDT::Project::MapProject::removeProvinceFromState(Province& province,
  */
 void HMDT::Project::MapProject::calculateCoastalProvinces(bool dry) {
     WRITE_INFO("Calculating coastal provinces...");
-    for(auto&& [_, province] : getProvinceProject().getProvinces()) {
+
+    auto& provinces = getProvinceProject().getProvinces();
+
+    // Province types may have been edited since the graph was built
+    auto& graph = getProvinceProject().getAdjacencyGraph();
+    graph.updateCrossings(provinces);
+
+    // Only the type column is needed to decide which provinces to look at
+    const auto& types = provinces.getTypes();
+
+    for(ProvinceIndex index = 1; index <= types.size(); ++index) {
         // Only allow LAND provinces to be auto-marked as coastal
         //   I'm not actually sure if the game will allow LAKE and SEA to be
         //   coasts, but the cases where we would want that should be rare
         //   enough that I think it's fine to just require the user to configure
         //   that manually.
-        if(province.type != ProvinceType::LAND) {
-            WRITE_DEBUG("Skipping province ", province.id, " as it's not LAND.");
+        if(types[index - 1] != ProvinceType::LAND) {
+            WRITE_DEBUG("Skipping province ", provinces.getID(index), " as it's not LAND.");
             continue;
         }
 
         // A province is coastal if it is adjacent to any SEA province.
-        bool is_coastal = std::any_of(province.adjacent_provinces.begin(),
-                                      province.adjacent_provinces.end(),
-                                      [this](const auto& adj_prov_id) {
-                                          return m_provinces_project.getProvinceForID(adj_prov_id).type == ProvinceType::SEA;
+        auto edges = graph.getEdges(index);
+        bool is_coastal = std::any_of(edges.begin(), edges.end(),
+                                      [](const ProvinceEdge& edge) {
+                                          return edge.crossing == ProvinceCrossing::COAST;
                                       });
 
-        WRITE_DEBUG("Calculated that province '", province.id, "' is ",
+        WRITE_DEBUG("Calculated that province '", provinces.getID(index), "' is ",
                    (is_coastal ? "not " : ""), "coastal.");
         if(!dry) {
-            province.coastal = is_coastal;
+            provinces.setCoastal(index, is_coastal);
         } else {
             WRITE_DEBUG("Dry-Run enabled. Not modifying stored provinces.");
         }
@@ -618,3 +947,25 @@ auto HMDT::Project::MapProject::visit(const std::function<MaybeVoid(std::shared_
     return map_project_node;
 }
 
+
+/**
+ * @brief Reports how much memory every map project is using, as well as every
+ *        layer of the shared MapData.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::MapProject::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    auto& self = report.addChild("Map Project");
+
+    if(m_map_data != nullptr) {
+        m_map_data->reportMemoryUsage(self.addChild("Map Data"));
+    }
+
+    m_provinces_project.reportMemoryUsage(self);
+    m_continent_project.reportMemoryUsage(self);
+    m_heightmap_project.reportMemoryUsage(self);
+    m_rivers_project.reportMemoryUsage(self);
+
+    self.addChild("Terrains", estimateMemoryUsage(m_terrains));
+}
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <cerrno>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 
 #include "Constants.h"
 #include "MapData.h"
@@ -11,6 +14,7 @@
 #include "StatusCodes.h"
 #include "Options.h"
 #include "BitMap.h"
+#include "ProvincePreview.h"
 
 #include "ShapeFinder2.h"
 
@@ -24,11 +28,25 @@
 
 HMDT::Project::ProvinceProject::ProvinceProject(IRootMapProject& parent_project):
     m_parent_project(parent_project),
-    m_provinces()
+    m_provinces(),
+    m_spatial_index(),
+    m_root_index_cache(),
+    m_root_index_cache_mutex(),
+    m_adjacency_graph(),
+    m_province_spans(),
+    m_data_cache(MAX_CACHED_PROVINCE_PREVIEW_BYTES),
+    m_data_cache_label_generation(0),
+    m_data_cache_mutex(),
+    m_prefetch_queue(),
+    m_prefetch_mutex(),
+    m_prefetch_condition(),
+    m_prefetch_stop(false),
+    m_prefetch_thread()
 {
 }
 
 HMDT::Project::ProvinceProject::~ProvinceProject() {
+    stopPreviewPrefetcher();
 }
 
 auto HMDT::Project::ProvinceProject::save(const std::filesystem::path& path)
@@ -69,6 +87,9 @@ auto HMDT::Project::ProvinceProject::load(const std::filesystem::path& path)
                                                  m_oldid_to_uuid.end(),
                                                  ", "), "}");
 
+        // The registry must exist before the label matrix can be built
+        rebuildProvinceIndexRegistry();
+
         auto shapelabels_result = loadShapeLabels(path);
         RETURN_IF_ERROR(shapelabels_result);
     } else {
@@ -78,14 +99,23 @@ auto HMDT::Project::ProvinceProject::load(const std::filesystem::path& path)
         }
         RETURN_IF_ERROR(provdata_result);
 
+        // The registry must exist before the label matrix can be built
+        rebuildProvinceIndexRegistry();
+
         auto shapelabels_result = loadShapeLabels2(path);
         RETURN_IF_ERROR(shapelabels_result);
     }
 
+    getMapData()->markLayerDirty(MapData::Layer::LABEL_MATRIX);
+
+    // None of the old previews can be valid for the newly loaded labels
+    clearPreviewCache();
+
     // Note that order is important here, graphics data _must_ be built before
     //   the outlines
     buildGraphicsData();
     buildProvinceOutlines();
+    buildProvinceSpans();
 
     // Rebuild the uuid->id map last
     rebuildUUIDToIDMap();
@@ -161,10 +191,24 @@ void HMDT::Project::ProvinceProject::import(const ShapeFinder& sf, std::shared_p
 {
     m_provinces = createProvincesFromShapeList(sf.getShapes());
 
+    // ShapeFinder labels each shape with its (1-based) position in the list
+    //   of shapes, so the registry must use that same order
+    std::vector<ProvinceID> ids;
+    ids.reserve(sf.getShapes().size());
+    for(auto&& shape : sf.getShapes()) {
+        ids.push_back(shape.id);
+    }
+    rebuildProvinceIndexRegistry(ids);
+
+    // ShapeFinder has rebuilt both the labels and the colors of the map
+    getMapData()->markLayerDirty(MapData::Layer::LABEL_MATRIX);
+    getMapData()->markLayerDirty(MapData::Layer::PROVINCE_COLORS);
+
     // Clear out the province preview data
-    m_data_cache.clear();
+    clearPreviewCache();
 
     buildProvinceOutlines();
+    buildProvinceSpans();
 
     // Rebuild the uuid->id map last
     rebuildUUIDToIDMap();
@@ -224,14 +268,31 @@ auto HMDT::Project::ProvinceProject::saveShapeLabels(const std::filesystem::path
         writeData(out, getMapData()->getWidth(), 
                        getMapData()->getHeight());
 
-        auto num_bytes = getMapData()->getProvincesSize() * sizeof(UUID);
+        auto matrix_size = getMapData()->getMatrixSize();
+        auto label_matrix = getMapData()->getLabelMatrix().lock();
 
-        // Write the entire label matrix to the file
         WRITE_DEBUG("Writing province ID data [", getMapData()->getWidth(),
-                    " by ", getMapData()->getHeight(), ": ", num_bytes,
-                    " bytes.");
-        out.write(reinterpret_cast<const char*>(getMapData()->getProvinces().lock().get()),
-                  num_bytes);
+                    " by ", getMapData()->getHeight(), ": ",
+                    matrix_size * sizeof(UUID), " bytes.");
+
+        // The file stores the full ProvinceID of every pixel, so convert the
+        //   label matrix a chunk at a time rather than all at once
+        std::vector<ProvinceID> chunk(std::min(matrix_size, SHAPE_LABEL_CHUNK_SIZE),
+                                      INVALID_PROVINCE);
+        for(uint32_t offset = 0; offset < matrix_size; offset += chunk.size())
+        {
+            auto count = std::min<uint32_t>(chunk.size(), matrix_size - offset);
+
+            parallelTransform(label_matrix.get() + offset,
+                              label_matrix.get() + offset + count,
+                              chunk.data(),
+                              [this](ProvinceIndex index) -> ProvinceID {
+                                  return getProvinceIDForIndex(index);
+                              });
+
+            out.write(reinterpret_cast<const char*>(chunk.data()),
+                      count * sizeof(UUID));
+        }
         out << '\0';
     } else {
         WRITE_ERROR("Failed to open file ", path);
@@ -378,7 +439,6 @@ auto HMDT::Project::ProvinceProject::loadShapeLabels(const std::filesystem::path
         }
 
         auto label_matrix = getMapData()->getLabelMatrix().lock();
-        auto prov_matrix = getMapData()->getProvinces().lock();
 
         if(!safeRead(label_matrix.get(), getMapData()->getMatrixSize() * sizeof(uint32_t), in))
         {
@@ -386,31 +446,28 @@ auto HMDT::Project::ProvinceProject::loadShapeLabels(const std::filesystem::path
             RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
         }
 
-        // Generate the Provinces matrix
-        bool err = false;
+        // Convert every old ID into the index of its new province
+        std::atomic<bool> err = false;
         parallelTransform(label_matrix.get() /* first */,
                           label_matrix.get() + (width * height) /* last */,
-                          prov_matrix.get() /* dest */,
-                          [this, &err](uint32_t& oldid) -> ProvinceID
+                          label_matrix.get() /* dest */,
+                          [this, &err](uint32_t oldid) -> ProvinceIndex
                           {
-                              if(m_oldid_to_uuid.count(oldid) == 0) {
-                                  WRITE_ERROR("Failed to find ", oldid, " in map.");
-                                  err = true;
+                              if(auto it = m_oldid_to_uuid.find(oldid);
+                                      it != m_oldid_to_uuid.end())
+                              {
+                                  return getIndexForProvinceID(it->second);
                               }
 
-                              const auto& newid = m_oldid_to_uuid.at(oldid);
-
-                              // Convert the old ID to a hash to be the new "label"
-                              oldid = newid.hash();
-
-                              return newid;
+                              WRITE_ERROR("Failed to find ", oldid, " in map.");
+                              err = true;
+                              return INVALID_PROVINCE_INDEX;
                           });
         RETURN_ERROR_IF(err, STATUS_VALUE_NOT_FOUND);
 
         if(prog_opts.debug) {
             auto path = getRootParent().getDebugRoot();
             auto lmfname = path / "label_matrix.raw";
-            auto pmfname = path / "prov_matrix.raw";
 
             if(!std::filesystem::exists(path)) {
                 std::filesystem::create_directory(path);
@@ -424,15 +481,6 @@ auto HMDT::Project::ProvinceProject::loadShapeLabels(const std::filesystem::path
                 out.write(reinterpret_cast<char*>(label_matrix.get()),
                           getMapData()->getMatrixSize());
             }
-
-            WRITE_DEBUG("Writing province matrix (", getMapData()->getProvincesSize(),
-                        " bytes) to ", pmfname);
-
-            if(std::ofstream out(pmfname, std::ios::binary | std::ios::out); out)
-            {
-                out.write(reinterpret_cast<char*>(prov_matrix.get()),
-                          getMapData()->getProvincesSize());
-            }
         }
     } else {
         WRITE_ERROR("Failed to open file ", path);
@@ -466,48 +514,67 @@ auto HMDT::Project::ProvinceProject::loadShapeLabels2(const std::filesystem::pat
 
         // Validate that the width + height for the shape data matches what we
         //   expect.
-        if(auto input_size = width * height * sizeof(UUID);
-                input_size != getMapData()->getProvincesSize() * sizeof(UUID))
+        if(auto input_size = width * height;
+                input_size != getMapData()->getMatrixSize())
         {
-            WRITE_ERROR("Loaded shape data size (", input_size, ") does not "
-                        "match expected matrix size of (",
-                        getMapData()->getProvincesSize() * sizeof(UUID),
-                        ")");
+            WRITE_ERROR("Loaded shape data size (", input_size * sizeof(UUID),
+                        ") does not match expected matrix size of (",
+                        getMapData()->getMatrixSize() * sizeof(UUID), ")");
             RETURN_ERROR(std::make_error_code(std::errc::invalid_argument));
         }
 
-        auto prov_matrix = getMapData()->getProvinces().lock();
+        auto matrix_size = getMapData()->getMatrixSize();
         auto label_matrix = getMapData()->getLabelMatrix().lock();
 
-        WRITE_DEBUG("Reading provinces into prov_matrix! sizeof(HMDT::UUID)=",
+        WRITE_DEBUG("Reading provinces into label_matrix! sizeof(HMDT::UUID)=",
                     sizeof(HMDT::UUID));
 
-        if(!safeRead(prov_matrix.get(),
-                     getMapData()->getProvincesSize() * sizeof(UUID), in))
+        std::atomic<uint32_t> num_trans = 0;
+        std::atomic<uint32_t> num_unknown = 0;
+
+        // The file stores the full ProvinceID of every pixel, so read and
+        //   convert it a chunk at a time rather than holding all of it in
+        //   memory at once
+        std::vector<ProvinceID> chunk(std::min(matrix_size, SHAPE_LABEL_CHUNK_SIZE),
+                                      INVALID_PROVINCE);
+        for(uint32_t offset = 0; offset < matrix_size; offset += chunk.size())
         {
-            WRITE_ERROR("Failed to read full provinces matrix.");
-            RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
-        }
+            auto count = std::min<uint32_t>(chunk.size(), matrix_size - offset);
 
-        std::atomic<uint32_t> num_trans = 0;
+            if(!safeRead(chunk.data(), count * sizeof(UUID), in)) {
+                WRITE_ERROR("Failed to read full provinces matrix.");
+                RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
+            }
 
-        // Now build the label matrix as well
-        parallelTransform(prov_matrix.get() /* first */,
-                          prov_matrix.get() + (width * height) /* last */,
-                          label_matrix.get() /* dest */,
-                          [&num_trans](const ProvinceID& prov_id) -> uint32_t {
-                              ++num_trans;
-                              return prov_id.hash();
-                          });
+            parallelTransform(chunk.data() /* first */,
+                              chunk.data() + count /* last */,
+                              label_matrix.get() + offset /* dest */,
+                              [this, &num_trans, &num_unknown](const ProvinceID& prov_id)
+                                  -> ProvinceIndex
+                              {
+                                  ++num_trans;
+
+                                  auto index = getIndexForProvinceID(prov_id);
+                                  if(index == INVALID_PROVINCE_INDEX) {
+                                      ++num_unknown;
+                                  }
+
+                                  return index;
+                              });
+        }
 
         // Double check that we actually processed all of the UUIDs like we were
         //   supposed to
         RETURN_ERROR_IF(num_trans != width * height, STATUS_UNEXPECTED);
 
+        if(num_unknown != 0) {
+            WRITE_WARN(num_unknown.load(), " pixels refer to provinces which "
+                       "were not found in the list of loaded provinces.");
+        }
+
         if(prog_opts.debug) {
             auto path = getRootParent().getDebugRoot();
             auto lmfname = path / "label_matrix.raw";
-            auto pmfname = path / "prov_matrix.raw";
 
             if(!std::filesystem::exists(path)) {
                 std::filesystem::create_directory(path);
@@ -521,15 +588,6 @@ auto HMDT::Project::ProvinceProject::loadShapeLabels2(const std::filesystem::pat
                 out.write(reinterpret_cast<char*>(label_matrix.get()),
                           getMapData()->getMatrixSize());
             }
-
-            WRITE_DEBUG("Writing province matrix (", getMapData()->getProvincesSize(),
-                        " bytes) to ", pmfname);
-
-            if(std::ofstream out(pmfname, std::ios::binary | std::ios::out); out)
-            {
-                out.write(reinterpret_cast<char*>(prov_matrix.get()),
-                          getMapData()->getProvincesSize());
-            }
         }
     } else {
         WRITE_ERROR("Failed to open file ", path);
@@ -607,6 +665,8 @@ auto HMDT::Project::ProvinceProject::loadProvinceData(const std::filesystem::pat
             m_provinces[prov.id] = prov;
         }
 
+        m_provinces.rebuildColumns();
+
         WRITE_DEBUG("Loaded information for ",
                    m_provinces.size(), " provinces");
     } else {
@@ -694,6 +754,9 @@ auto HMDT::Project::ProvinceProject::loadProvinceData2(const std::filesystem::pa
             }
         }
 
+        // Every parent exists now, so they can all be found
+        m_provinces.rebuildColumns();
+
         WRITE_DEBUG("Loaded information for ",
                    m_provinces.size(), " provinces");
     } else {
@@ -712,71 +775,77 @@ const HMDT::ProvinceList& HMDT::Project::ProvinceProject::getProvinces() const {
     return m_provinces;
 }
 
+namespace {
+    /**
+     * @brief Builds the preview of a single province, which marks every pixel
+     *        within its bounding box that belongs to it.
+     *
+     * @param labels The label of the top left pixel within the bounding box
+     * @param stride How many labels there are between the start of each row
+     * @param index The ProvinceIndex of the province in the label matrix
+     * @param bb The bounding box of the province
+     *
+     * @return The preview, the size of the bounding box
+     */
+    HMDT::Project::IProvinceProject::ProvinceDataPtr buildProvincePreview(const uint32_t* labels,
+                                                                          uint64_t stride,
+                                                                          HMDT::ProvinceIndex index,
+                                                                          const HMDT::BoundingBox& bb)
+    {
+        auto&& [width, height] = HMDT::calcDims(bb);
+
+        auto preview = std::make_shared<HMDT::ProvincePreview>(width, height);
+
+        // Go row by row, so that the labels are read in order, and build up
+        //   every word of the mask without branching
+        for(uint32_t rely = 0; rely < height; ++rely) {
+            const auto* label_row = labels + rely * stride;
+            auto* row = preview->getRow(rely);
+
+            for(uint32_t relx = 0; relx < width; ++relx) {
+                row[relx / 64] |= static_cast<uint64_t>(label_row[relx] == index) << (relx % 64);
+            }
+        }
+
+        return preview;
+    }
+}
+
 /**
- * @brief Will build the province preview for the given province. If more than
- *        MAX_CACHED_PROVINCE_PREVIEWS are already stored, then the least
- *        accessed preview will be kicked out of the cache before a new preview
- *        is constructed.
+ * @brief Will build the province preview for the given province and add it to
+ *        the cache. If the cache goes over MAX_CACHED_PROVINCE_PREVIEW_BYTES,
+ *        then the least recently used previews are kicked out of it.
+ * @details m_data_cache_mutex must be held when calling this.
  *
  * @param province_ptr
+ *
+ * @return The newly built preview
  */
-void HMDT::Project::ProvinceProject::buildProvinceCache(const Province* province_ptr)
+auto HMDT::Project::ProvinceProject::buildProvinceCache(const Province* province_ptr)
+    -> ProvinceDataPtr
 {
     const auto& province = *province_ptr;
     auto id = province.id;
 
-    // If there are too many cached provinces, then remove the least accessed
-    //  one (which should be the first one in the cache)
-    if(m_data_cache.size() > MAX_CACHED_PROVINCE_PREVIEWS) {
-        // Do not clear out the first value if it is the one we are trying to
-        //  create.
-        if(m_data_cache.begin()->first == id) {
-            m_data_cache.erase(std::next(m_data_cache.begin()));
-        } else {
-            m_data_cache.erase(m_data_cache.begin());
-        }
-    }
-
-    auto& data = m_data_cache[id];
-
     WRITE_DEBUG("No preview data for province ", id, ". Building...");
 
-    // Some references first, to make the following code easier to read
-    //  id also starts at 1, so make sure we offset it down
-    auto label_matrix = getMapData()->getProvinces().lock();
-    auto iwidth = getMapData()->getWidth();
-
     auto&& bb = province.bounding_box;
     auto&& [width, height] = calcDims(bb);
 
-    constexpr auto depth = 4;
-
-    // Make sure we 0-initialize the array
-    //  We use a depth of 4 since we have RGBA
-    data.reset(new unsigned char[width * height * depth]());
-
-    WRITE_DEBUG("Allocated space for ", width * height * depth, " bytes.");
-    for(auto x = bb.bottom_left.x; x < bb.top_right.x; ++x) {
-        for(auto y = bb.top_right.y; y < bb.bottom_left.y; ++y) {
-            // Get the index into the label matrix
-            auto lindex = xyToIndex(iwidth, x, y);
-
-            // Offset the x,y so that we get 0-preview width/height
-            auto relx = x - bb.bottom_left.x;
-            auto rely = y - bb.top_right.y;
+    auto label_matrix = getMapData()->getLabelMatrix().lock();
+    auto iwidth = getMapData()->getWidth();
 
-            // Index into the cached data
-            //  Need a special one since the depth is different from the
-            //  stored graphics data
-            auto dindex = xyToIndex(width * depth, relx * depth, rely);
+    auto data = buildProvincePreview(label_matrix.get() +
+                                         static_cast<uint64_t>(bb.top_right.y) * iwidth +
+                                         bb.bottom_left.x,
+                                     iwidth, getIndexForProvinceID(id), bb);
 
-            auto label = label_matrix[lindex];
+    WRITE_DEBUG("Built ", data->getByteSize(), " bytes.");
 
-            if(label == id) {
-                // ARGB
-                *reinterpret_cast<uint32_t*>(&data[dindex]) = PROVINCE_HIGHLIGHT_COLOR;
-            }
-        }
+    if(auto evicted = m_data_cache.insert(id, data, data->getByteSize());
+            evicted != 0)
+    {
+        WRITE_DEBUG("Evicted ", evicted, " previews from the cache.");
     }
 
     WRITE_DEBUG("Done.");
@@ -792,165 +861,616 @@ void HMDT::Project::ProvinceProject::buildProvinceCache(const Province* province
         WRITE_DEBUG("Writing province ", width, 'x', height, " (", id, ") to ", fname);
 
         if(std::ofstream out(fname); out) {
+            auto image = data->expandToARGB(PROVINCE_HIGHLIGHT_COLOR);
+
             out << "P7\nWIDTH " << width << "\nHEIGHT " << height << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
             for(auto i = 0; i < width * height * 4; i += 4) {
                 // Write Alpha first
-                out.write(reinterpret_cast<char*>(&data[i + 3]), 1);
-                out.write(reinterpret_cast<char*>(&data[i + 1]), 3);
+                out.write(reinterpret_cast<char*>(&image[i + 3]), 1);
+                out.write(reinterpret_cast<char*>(&image[i + 1]), 3);
             }
         }
     }
+
+    return data;
 }
 
+namespace {
+    /**
+     * @brief Everything found while building the outlines for a band of rows
+     */
+    struct OutlineBand {
+        /**
+         * @brief Every pair of adjacent labels found in this band, packed as
+         *        (smaller_label << 32) | larger_label, along with how many
+         *        pairs of pixels were found along that border
+         */
+        std::vector<std::pair<uint64_t, uint32_t>> borders;
+
+        //! How many pixels had a label that is not a loaded province
+        uint64_t invalid_pixels = 0;
+
+        //! Where the first invalid pixel was found
+        uint32_t first_invalid_x = 0;
+        uint32_t first_invalid_y = 0;
+    };
+
+    //! How many border pixels a band may gather before they get merged
+    constexpr size_t MAX_UNSORTED_ADJACENCIES = 1 << 20;
+
+    /**
+     * @brief Merges every duplicate border, adding up their lengths, and
+     *        leaves them sorted
+     */
+    void sortAndMergeBorders(std::vector<std::pair<uint64_t, uint32_t>>& borders)
+    {
+        std::sort(borders.begin(), borders.end());
+
+        auto out = borders.begin();
+        for(auto it = borders.begin(); it != borders.end(); ++it) {
+            if(out != borders.begin() && std::prev(out)->first == it->first) {
+                std::prev(out)->second += it->second;
+            } else {
+                *out++ = *it;
+            }
+        }
+        borders.erase(out, borders.end());
+    }
+
+    /**
+     * @brief Gets the value to write into the outlines for a pixel
+     *
+     * @param is_outline Whether the pixel is part of an outline
+     *
+     * @return 0xFFFFFFFF if is_outline, otherwise 0
+     */
+    constexpr uint32_t toOutlineValue(bool is_outline) {
+        return 0U - static_cast<uint32_t>(is_outline);
+    }
+
+    /**
+     * @brief Compares two rows of labels, one pixel at a time
+     * @details There are no branches, so that this can be vectorized.
+     *
+     * @param a The first row
+     * @param b The second row
+     * @param mask Set to 1 wherever both rows differ, or 0 otherwise
+     * @param count How many pixels to compare
+     */
+    void compareLabelRows(const uint32_t* a, const uint32_t* b,
+                          uint8_t* mask, uint32_t count) noexcept
+    {
+        for(uint32_t x = 0; x < count; ++x) {
+            mask[x] = a[x] != b[x];
+        }
+    }
+
+    /**
+     * @brief Writes one row of outlines from the comparisons of that row
+     *        against its neighbours
+     * @details There are no branches, so that this can be vectorized.
+     *
+     * @param right Whether each pixel differs from the one to its right,
+     *              offset by one so that right[x] and right[x + 1] are the
+     *              left and right borders of pixel x. Must hold width + 1
+     *              values, and the first and last must be 0.
+     * @param up Whether each pixel differs from the one above it
+     * @param down Whether each pixel differs from the one below it
+     * @param out_row The row of outlines to write
+     * @param borders Set to 1 if the pixel borders the pixel to its right, and
+     *                2 if it borders the pixel below it
+     * @param width The width of the row
+     */
+    void writeOutlineRow(const uint8_t* right, const uint8_t* up,
+                         const uint8_t* down, uint32_t* out_row,
+                         uint8_t* borders, uint32_t width) noexcept
+    {
+        for(uint32_t x = 0; x < width; ++x) {
+            out_row[x] = toOutlineValue(right[x] | right[x + 1] | up[x] | down[x]);
+            borders[x] = right[x + 1] | (down[x] << 1);
+        }
+    }
+
+    /**
+     * @brief Every pixel found in a band of rows whose label is not a loaded
+     *        province
+     */
+    struct InvalidLabelBand {
+        //! How many pixels had a label that is not a loaded province
+        uint64_t invalid_pixels = 0;
+
+        //! Where the first invalid pixel was found
+        uint32_t first_invalid_x = 0;
+        uint32_t first_invalid_y = 0;
+    };
+}
+
+/**
+ * @brief Rebuilds the province outlines and the adjacencies of every province
+ *        from the label matrix.
+ * @details A pixel is part of an outline if its label differs from any of its
+ *          4 neighbours. Every province has its own unique color, so this is
+ *          the same as comparing colors, but without reading the color data.
+ *
+ * @par The map is split into bands of rows which are processed in parallel.
+ *      Each row is compared against its neighbours into byte masks with
+ *      branch-free loops so that they can be vectorized. The outlines are
+ *      built from those masks, and the adjacencies only visit the pixels
+ *      which the masks mark as borders. Every band gathers its adjacencies
+ *      locally before they are all merged together.
+ */
 void HMDT::Project::ProvinceProject::buildProvinceOutlines() {
     auto prov_outline_data = getMapData()->getProvinceOutlines().lock();
-    auto graphics_data = getMapData()->getProvinceColors().lock();
+    auto label_matrix = getMapData()->getLabelMatrix().lock();
 
     auto [width, height] = getMapData()->getDimensions();
-    Dimensions dimensions{width, height};
 
-    bool failure = false;
+    // The outlines are RGBA, so every pixel can be written all at once
+    auto* outlines = reinterpret_cast<uint32_t*>(prov_outline_data.get());
+    const auto* labels = label_matrix.get();
 
-    // Go over the map again and build extra data that depends on the previously
-    //  re-built province data
-    for(uint32_t x = 0; x < width; ++x) {
-        for(uint32_t y = 0; y < height; ++y) {
-            auto lindex = xyToIndex(width, x, y);
-            auto label = getMapData()->getProvinces().lock()[lindex];
-            auto gindex = xyToIndex(width * 4, x * 4, y);
+    // Look up which labels are valid once, rather than once per pixel
+    //   Every index into the province store is valid, and index 0 never is
+    std::vector<uint8_t> valid_labels(m_provinces.size() + 1, 1);
+    valid_labels[INVALID_PROVINCE_INDEX] = 0;
 
-            if(!isValidProvinceID(label)) {
-                WRITE_WARN("ProvinceID matrix has label ", label,
-                           " at position (", x, ',', y, "), which was not "
-                           "found in the list of loaded provinces.");
+    auto is_valid_label = [&valid_labels](uint32_t label) {
+        return label < valid_labels.size() && valid_labels[label] != 0;
+    };
 
-                if(!failure) {
-                    failure = true;
+    auto bands = parallelMapChunks(height, [&](uint32_t begin_y, uint32_t end_y)
+    {
+        OutlineBand band;
 
-                    WRITE_DEBUG("m_provinces=", [this]() {
-                        std::stringstream ss;
+        auto add_adjacency = [&band, &is_valid_label](uint32_t label,
+                                                      uint32_t adj_label)
+        {
+            if(!is_valid_label(adj_label)) return;
 
-                        for(auto it = m_provinces.begin(); it != m_provinces.end(); ++it) {
-                            if(it != m_provinces.begin()) ss << ", ";
-                            ss << it->first;
-                        }
+            auto [first, second] = std::minmax(label, adj_label);
+            band.borders.emplace_back((static_cast<uint64_t>(first) << 32) | second, 1);
+
+            if(band.borders.size() > MAX_UNSORTED_ADJACENCIES) {
+                sortAndMergeBorders(band.borders);
+            }
+        };
 
-                        return ss.str();
-                    }().c_str());
+        auto add_invalid_pixels = [&band](uint32_t x, uint32_t y, uint32_t count)
+        {
+            if(band.invalid_pixels == 0) {
+                band.first_invalid_x = x;
+                band.first_invalid_y = y;
+            }
+            band.invalid_pixels += count;
+        };
+
+        // Whether every pixel differs from its neighbours. right is offset by
+        //   one and padded with 0 on both ends, so that nothing outside of the
+        //   map is ever treated as a neighbour.
+        std::vector<uint8_t> right(width + 1, 0);
+        std::vector<uint8_t> up(width, 0);
+        std::vector<uint8_t> down(width, 0);
+        std::vector<uint8_t> borders(width, 0);
+
+        if(width == 0) return band;
+
+        // Only the first row of the band is compared against the row above it
+        //   here, every later row reuses the comparison made for the row
+        //   before it
+        if(begin_y > 0 && begin_y < end_y) {
+            const auto* row = labels + static_cast<uint64_t>(begin_y) * width;
+            compareLabelRows(row, row - width, up.data(), width);
+        }
+
+        for(uint32_t y = begin_y; y < end_y; ++y) {
+            const auto* row = labels + static_cast<uint64_t>(y) * width;
+            auto* out_row = outlines + static_cast<uint64_t>(y) * width;
+
+            if(width > 1) {
+                compareLabelRows(row, row + 1, right.data() + 1, width - 1);
+            }
+
+            // The last row has nothing below it
+            if(y + 1 < height) {
+                compareLabelRows(row, row + width, down.data(), width);
+            } else {
+                std::fill(down.begin(), down.end(), 0);
+            }
+
+            writeOutlineRow(right.data(), up.data(), down.data(), out_row,
+                            borders.data(), width);
+
+            // Adjacencies. Only the right and lower neighbours need to be
+            //   checked, as every border is the same in both directions.
+            //   Borders are rare, so whole words of pixels without any are
+            //   skipped at once. Labels come in runs which end wherever a
+            //   pixel borders the one to its right, so the validity of a
+            //   label is only looked up once per run.
+            uint32_t run_begin = 0;
+            bool run_valid = is_valid_label(row[0]);
+            for(uint32_t x = 0; x < width; ++x) {
+                if(uint64_t word = 0; x + sizeof(word) <= width) {
+                    std::memcpy(&word, borders.data() + x, sizeof(word));
+                    if(word == 0) {
+                        x += sizeof(word) - 1;
+                        continue;
+                    }
+                }
+
+                auto border = borders[x];
+                if(border == 0) continue;
+
+                if(run_valid) {
+                    if(border & 1) add_adjacency(row[x], row[x + 1]);
+                    if(border & 2) add_adjacency(row[x], row[x + width]);
                 }
 
-                continue;
+                if(border & 1) {
+                    if(!run_valid) {
+                        add_invalid_pixels(run_begin, y, x + 1 - run_begin);
+                    }
+
+                    run_begin = x + 1;
+                    run_valid = is_valid_label(row[run_begin]);
+                }
             }
 
-            // Look up the province itself
-            auto& province = getProvinceForID(label);
-
-            // Recalculate adjacencies for this pixel
-            auto is_adjacent = ShapeFinder::calculateAdjacency(dimensions,
-                                                               graphics_data.get(),
-                                                               getMapData()->getProvinces().lock().get(),
-                                                               province.adjacent_provinces,
-                                                               {x, y});
-            // If this pixel is adjacent to any others, then make it visible as
-            //  an outline
-            if(is_adjacent) {
-                prov_outline_data[gindex] = 0xFF;
-                prov_outline_data[gindex + 1] = 0xFF;
-                prov_outline_data[gindex + 2] = 0xFF;
-                prov_outline_data[gindex + 3] = 0xFF;
+            if(!run_valid) {
+                add_invalid_pixels(run_begin, y, width - run_begin);
             }
+
+            std::swap(up, down);
         }
+
+        sortAndMergeBorders(band.borders);
+
+        return band;
+    });
+
+    getMapData()->markLayerDirty(MapData::Layer::PROVINCE_OUTLINES);
+
+    // Merge every band together
+    std::vector<std::pair<uint64_t, uint32_t>> borders;
+    uint64_t invalid_pixels = 0;
+    for(auto&& band : bands) {
+        if(band.invalid_pixels != 0 && invalid_pixels == 0) {
+            WRITE_WARN("Label matrix has label ",
+                       labels[xyToIndex(width, band.first_invalid_x,
+                                        band.first_invalid_y)],
+                       " at position (", band.first_invalid_x, ',',
+                       band.first_invalid_y, "), which was not found in the "
+                       "list of loaded provinces.");
+        }
+        invalid_pixels += band.invalid_pixels;
+
+        borders.insert(borders.end(), band.borders.begin(),
+                       band.borders.end());
+    }
+
+    if(invalid_pixels != 0) {
+        WRITE_WARN(invalid_pixels, " pixels in total have a label which was "
+                   "not found in the list of loaded provinces.");
+
+        WRITE_DEBUG("m_provinces=", [this]() {
+            std::stringstream ss;
+
+            for(auto it = m_provinces.begin(); it != m_provinces.end(); ++it) {
+                if(it != m_provinces.begin()) ss << ", ";
+                ss << it->first;
+            }
+
+            return ss.str();
+        }().c_str());
+    }
+
+    sortAndMergeBorders(borders);
+
+    std::vector<ProvinceBorder> province_borders;
+    province_borders.reserve(borders.size());
+    for(auto&& [key, length] : borders) {
+        province_borders.push_back(ProvinceBorder{
+            static_cast<ProvinceIndex>(key >> 32),
+            static_cast<ProvinceIndex>(key & 0xFFFFFFFF),
+            length
+        });
+    }
+
+    m_adjacency_graph.build(m_provinces.size() + 1, province_borders);
+    m_adjacency_graph.updateCrossings(m_provinces);
+
+    // Finally, convert the adjacent labels back into ProvinceIDs
+    ProvinceIndex index = 1;
+    for(auto&& [_, province] : m_provinces) {
+        for(auto&& edge : m_adjacency_graph.getEdges(index)) {
+            province.adjacent_provinces.insert(getProvinceIDForIndex(edge.neighbour));
+        }
+        ++index;
     }
 }
 
 /**
- * @brief Builds the graphics data array
+ * @brief Gets which provinces border each other, by ProvinceIndex
+ * @details This is rebuilt along with the province outlines. Call
+ *          ProvinceGraph::updateCrossings() first if any province type may
+ *          have changed since then.
  */
-void HMDT::Project::ProvinceProject::buildGraphicsData() {
-    // Rebuild the graphics data
+auto HMDT::Project::ProvinceProject::getAdjacencyGraph() noexcept
+    -> ProvinceGraph&
+{
+    return m_adjacency_graph;
+}
+
+auto HMDT::Project::ProvinceProject::getAdjacencyGraph() const noexcept
+    -> const ProvinceGraph&
+{
+    return m_adjacency_graph;
+}
+
+/**
+ * @brief Rebuilds the runs of pixels belonging to every province from the
+ *        label matrix.
+ */
+void HMDT::Project::ProvinceProject::buildProvinceSpans() {
+    auto label_matrix = getMapData()->getLabelMatrix().lock();
     auto [width, height] = getMapData()->getDimensions();
 
-    auto prov_matrix = getMapData()->getProvinces().lock();
+    if(label_matrix == nullptr) {
+        m_province_spans.clear();
+        return;
+    }
 
-    auto graphics_data = getMapData()->getProvinceColors().lock();
+    m_province_spans.build(label_matrix.get(), width, height,
+                           m_provinces.size() + 1,
+                           getMapData()->getLayerGeneration(MapData::Layer::LABEL_MATRIX));
 
-    // Rebuild the map_data array and the adjacency lists
-    for(uint32_t x = 0; x < width; ++x) {
-        for(uint32_t y = 0; y < height; ++y) {
-            // Get the index into the prov matrix
-            auto lindex = xyToIndex(width, x, y);
+    WRITE_DEBUG("Found ", m_province_spans.getSpanCount(), " spans across ",
+                m_provinces.size(), " provinces.");
+}
 
-            // Get the index into the graphics data
-            //  3 == the depth
-            auto gindex = xyToIndex(width * 3, x * 3, y);
+/**
+ * @brief Gets every run of pixels belonging to each province, by
+ *        ProvinceIndex
+ * @details This is rebuilt whenever the label matrix is.
+ */
+auto HMDT::Project::ProvinceProject::getProvinceSpans() const noexcept
+    -> const ProvinceSpans&
+{
+    return m_province_spans;
+}
 
-            auto id = prov_matrix[lindex];
+/**
+ * @brief Gets the index of the parent at the root of the child hierarchy for
+ *        the given province index.
+ * @details Roots are cached, so looking up the same province again is a
+ *          single array read.
+ *
+ * @param index The index of the province to check
+ *
+ * @return The ProvinceIndex of the root province
+ */
+auto HMDT::Project::ProvinceProject::getRootProvinceIndex(ProvinceIndex index) const noexcept
+    -> Maybe<ProvinceIndex>
+{
+    std::lock_guard<std::mutex> lock(m_root_index_cache_mutex);
 
-            // Error check
-            if(!isValidProvinceID(id)) {
-                WRITE_WARN("Province matrix has ID ", id,
-                           " at position (", x, ',', y, "), which does not exist.");
-                continue;
-            }
+    return resolveRootProvinceIndex(index);
+}
 
-            // Rebuild color data
-            auto& province = getProvinceForID(id);
+/**
+ * @brief Forgets the cached root of every given province.
+ *
+ * @param provinces The provinces which may have a different root now
+ */
+void HMDT::Project::ProvinceProject::invalidateRootProvinces(const std::set<ProvinceID>& provinces) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_root_index_cache_mutex);
 
-            // Flip the colors from RGB to BGR because BitMap is a bad format
-            graphics_data[gindex] = province.unique_color.b;
-            graphics_data[gindex + 1] = province.unique_color.g;
-            graphics_data[gindex + 2] = province.unique_color.r;
+    for(auto&& id : provinces) {
+        if(auto index = getIndexForProvinceID(id);
+                index < m_root_index_cache.size())
+        {
+            m_root_index_cache[index] = INVALID_PROVINCE_INDEX;
         }
     }
 }
 
 /**
- * @brief Gets the province colors in a form that's ready to be exported.
+ * @brief Resolves the root of a province index through the cache, filling in
+ *        the cache if the province has not been resolved yet.
+ * @details m_root_index_cache_mutex must be held when calling this.
  *
- * @return A new flat array containing all pixel colors, or nullptr if a failure
- *         occurs
+ * @param index The index of the province to check
+ *
+ * @return The ProvinceIndex of the root province
  */
-auto HMDT::Project::ProvinceProject::getProvinceColorsForExport() const noexcept
-    -> std::unique_ptr<unsigned char[]>
+auto HMDT::Project::ProvinceProject::resolveRootProvinceIndex(ProvinceIndex index) const noexcept
+    -> Maybe<ProvinceIndex>
+{
+    if(index == INVALID_PROVINCE_INDEX) {
+        RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
+    }
+
+    auto& cache = m_root_index_cache;
+
+    if(cache.size() <= index) {
+        cache.resize(index + 1, INVALID_PROVINCE_INDEX);
+    }
+
+    // Follow the cache for as long as it knows where to go
+    ProvinceIndex root = index;
+    while(cache[root] != INVALID_PROVINCE_INDEX && cache[root] != root) {
+        root = cache[root];
+    }
+
+    // Nothing is known past this province, so walk up the actual parents
+    if(cache[root] == INVALID_PROVINCE_INDEX) {
+        auto maybe_root_index = IProvinceProject::getRootProvinceIndex(root);
+        RETURN_IF_ERROR(maybe_root_index);
+
+        auto root_index = *maybe_root_index;
+        if(cache.size() <= root_index) {
+            cache.resize(root_index + 1, INVALID_PROVINCE_INDEX);
+        }
+
+        cache[root] = root_index;
+        cache[root_index] = root_index;
+        root = root_index;
+    }
+
+    // Point everything we passed through directly at the root
+    for(ProvinceIndex i = index; i != root;) {
+        auto next = cache[i];
+        cache[i] = root;
+        i = next;
+    }
+
+    return root;
+}
+
+/**
+ * @brief Builds the color of every province, indexed by ProvinceIndex.
+ *
+ * @param use_root_colors If true, every province is given the color of its
+ *                        root parent, so that merged provinces share a color.
+ *
+ * @return The color of every ProvinceIndex, or std::nullopt for indices that
+ *         are not a loaded province. An error is returned if the root parent
+ *         of a province could not be found.
+ */
+auto HMDT::Project::ProvinceProject::buildColorPalette(bool use_root_colors) const noexcept
+    -> Maybe<ColorPalette>
 {
-    auto province_colors = getMapData()->getProvinceColors().lock();
-    auto prov_matrix = getMapData()->getProvinces().lock();
+    ColorPalette palette(m_provinces.size() + 1);
+
+    // The color column is in index order, so this is a single linear pass
+    //   that never touches the rest of each province
+    const auto& colors = m_provinces.getColors();
+    std::copy(colors.begin(), colors.end(), palette.begin() + 1);
+
+    if(use_root_colors) {
+        ColorPalette root_palette(palette.size());
+
+        for(ProvinceIndex index = 1; index < palette.size(); ++index) {
+            if(!palette[index]) continue;
+
+            auto maybe_root_index = getRootProvinceIndex(index);
+            RETURN_IF_ERROR(maybe_root_index);
+
+            root_palette[index] = palette[*maybe_root_index];
+        }
+
+        return root_palette;
+    }
+
+    return palette;
+}
+
+/**
+ * @brief Writes the color of every pixel by looking up its label in a palette.
+ * @details The map is split into bands of rows which are filled in parallel.
+ *          Pixels whose label has no color in the palette are left untouched.
+ *
+ * @param palette The color of every ProvinceIndex
+ * @param colors The buffer to write into, 3 bytes per pixel
+ * @param bgr Whether to write the colors as BGR rather than RGB
+ */
+void HMDT::Project::ProvinceProject::writeColorsFromPalette(const ColorPalette& palette,
+                                                            unsigned char* colors,
+                                                            bool bgr) const noexcept
+{
+    auto label_matrix = getMapData()->getLabelMatrix().lock();
+    const auto* labels = label_matrix.get();
+
     auto [width, height] = getMapData()->getDimensions();
 
-    std::unique_ptr<unsigned char[]> exportable_colors(new unsigned char[getMapData()->getProvinceColorsSize()]);
+    // The offsets of the red and blue channels within a pixel
+    const uint32_t r_offset = bgr ? 2 : 0;
+    const uint32_t b_offset = bgr ? 0 : 2;
+
+    auto bands = parallelMapChunks(height, [&](uint32_t begin_y, uint32_t end_y)
+    {
+        InvalidLabelBand band;
 
-    // TODO: Can we parallelize this?
-    for(uint32_t x = 0; x < width; ++x) {
-        for(uint32_t y = 0; y < height; ++y) {
-            // Get the index into the prov matrix
-            auto lindex = xyToIndex(width, x, y);
+        for(uint32_t y = begin_y; y < end_y; ++y) {
+            const auto* row = labels + static_cast<uint64_t>(y) * width;
+            auto* out_row = colors + static_cast<uint64_t>(y) * width * 3;
 
-            // Get the index into the graphics data
-            //  3 == the depth
-            auto gindex = xyToIndex(width * 3, x * 3, y);
+            for(uint32_t x = 0; x < width; ++x) {
+                auto label = row[x];
 
-            auto id = prov_matrix[lindex];
+                if(label >= palette.size() || !palette[label]) {
+                    if(band.invalid_pixels++ == 0) {
+                        band.first_invalid_x = x;
+                        band.first_invalid_y = y;
+                    }
+                    continue;
+                }
 
-            // Error check
-            if(!isValidProvinceID(id)) {
-                WRITE_WARN("Province matrix has ID ", id,
-                           " at position (", x, ',', y, "), which does not exist.");
-                continue;
+                const auto& color = *palette[label];
+                out_row[x * 3 + r_offset] = color.r;
+                out_row[x * 3 + 1] = color.g;
+                out_row[x * 3 + b_offset] = color.b;
             }
+        }
 
-            // Rebuild color data
-            auto maybe_root = getRootProvinceParent(id);
-            // TODO: We should really figure out how to return the error code up
-            //   from here. The reason we can't is because we cannot build a
-            //   Maybe<unique_ptr>
-            RETURN_VALUE_IF_ERROR(maybe_root, nullptr);
+        return band;
+    });
 
-            exportable_colors[gindex] = maybe_root->get().unique_color.r;
-            exportable_colors[gindex + 1] = maybe_root->get().unique_color.g;
-            exportable_colors[gindex + 2] = maybe_root->get().unique_color.b;
+    uint64_t invalid_pixels = 0;
+    for(auto&& band : bands) {
+        if(band.invalid_pixels != 0 && invalid_pixels == 0) {
+            auto x = band.first_invalid_x;
+            auto y = band.first_invalid_y;
+            WRITE_WARN("Label matrix has label ", labels[xyToIndex(width, x, y)],
+                       " at position (", x, ',', y, "), which does not exist.");
         }
+        invalid_pixels += band.invalid_pixels;
     }
 
+    if(invalid_pixels != 0) {
+        WRITE_WARN(invalid_pixels, " pixels have a label which does not exist.");
+    }
+}
+
+/**
+ * @brief Builds the graphics data array
+ * @details Every province's color is looked up once into a palette, which is
+ *          then gathered into every pixel. Recoloring therefore only costs one
+ *          lookup per province rather than one per pixel.
+ */
+void HMDT::Project::ProvinceProject::buildGraphicsData() {
+    auto graphics_data = getMapData()->getProvinceColors().lock();
+
+    // Cannot fail, as the root parents are not looked up
+    auto palette = buildColorPalette(false);
+
+    // Flip the colors from RGB to BGR because BitMap is a bad format
+    writeColorsFromPalette(*palette, graphics_data.get(), true);
+
+    getMapData()->markLayerDirty(MapData::Layer::PROVINCE_COLORS);
+}
+
+/**
+ * @brief Gets the province colors in a form that's ready to be exported.
+ * @details Every pixel gets the color of its province's root parent, so that
+ *          merged provinces are exported as one.
+ *
+ * @return A new flat array containing all pixel colors, or nullptr if a failure
+ *         occurs
+ */
+auto HMDT::Project::ProvinceProject::getProvinceColorsForExport() const noexcept
+    -> std::unique_ptr<unsigned char[]>
+{
+    auto palette = buildColorPalette(true);
+    // TODO: We should really figure out how to return the error code up
+    //   from here. The reason we can't is because we cannot build a
+    //   Maybe<unique_ptr>
+    RETURN_VALUE_IF_ERROR(palette, nullptr);
+
+    std::unique_ptr<unsigned char[]> exportable_colors(new unsigned char[getMapData()->getProvinceColorsSize()]);
+
+    writeColorsFromPalette(*palette, exportable_colors.get(), false);
+
     return exportable_colors;
 }
 
@@ -974,6 +1494,8 @@ auto HMDT::Project::ProvinceProject::getPreviewData(ProvinceID id)
 /**
  * @brief Gets the preview data for the given province. If no data currently
  *        exists, construct it and cache it.
+ * @details The previews of every adjacent province are then prefetched in the
+ *          background, as those are the most likely to be selected next.
  *
  * @param province_ptr
  *
@@ -985,22 +1507,229 @@ auto HMDT::Project::ProvinceProject::getPreviewData(const Province* province_ptr
     const auto& province = *province_ptr;
     auto id = province.id;
 
-    auto data = m_data_cache[id];
+    ProvinceDataPtr data;
+    {
+        std::lock_guard<std::mutex> lock(m_data_cache_mutex);
+
+        invalidateStalePreviews();
 
-    // If there is no cached data for the given province ID, then generate the
-    //  data for the preview
-    if(data == nullptr) {
-        buildProvinceCache(province_ptr);
+        // Looking the preview up also marks it as the most recently used one
+        if(auto* cached = m_data_cache.get(id); cached != nullptr) {
+            data = *cached;
+        } else {
+            // If there is no cached data for the given province ID, then
+            //  generate the data for the preview
+            data = buildProvinceCache(province_ptr);
+        }
     }
 
-    // Reset access time, cycles the element to the end of the FIFO queue
-    data = m_data_cache[id];
-    m_data_cache.erase(id);
-    m_data_cache[id] = data;
+    for(auto&& adjacent_id : province.adjacent_provinces) {
+        if(isValidProvinceID(adjacent_id)) {
+            queuePreviewPrefetch(getProvinceForID(adjacent_id));
+        }
+    }
 
     return data;
 }
 
+/**
+ * @brief Asks for the preview of a province to be built in the background, so
+ *        that it is already cached once it gets requested.
+ * @details Meant for provinces which are likely to be selected soon, such as
+ *          the one currently under the mouse.
+ *
+ * @param id The province to prefetch the preview of
+ */
+void HMDT::Project::ProvinceProject::prefetchPreviewData(ProvinceID id) {
+    if(isValidProvinceID(id)) {
+        queuePreviewPrefetch(getProvinceForID(id));
+    }
+}
+
+/**
+ * @brief Removes every cached preview which overlaps a part of the label
+ *        matrix that has changed since the previews were built.
+ * @details m_data_cache_mutex must be held when calling this.
+ */
+void HMDT::Project::ProvinceProject::invalidateStalePreviews() {
+    constexpr auto LABEL_MATRIX = MapData::Layer::LABEL_MATRIX;
+
+    auto generation = getMapData()->getLayerGeneration(LABEL_MATRIX);
+    if(generation == m_data_cache_label_generation) return;
+
+    auto changes = getMapData()->getLayerChangesSince(LABEL_MATRIX,
+                                                      m_data_cache_label_generation);
+    m_data_cache_label_generation = generation;
+
+    // We no longer know what changed, so nothing in the cache can be trusted
+    if(!changes) {
+        WRITE_DEBUG("Label matrix changes are unknown, clearing all ",
+                    m_data_cache.size(), " cached previews.");
+        m_data_cache.clear();
+        return;
+    }
+
+    m_data_cache.eraseIf([this, &changes](const auto& entry) {
+        if(!isValidProvinceID(entry.key)) return true;
+
+        auto area = toRectangle(getProvinceForID(entry.key).bounding_box);
+        return std::any_of(changes->begin(), changes->end(),
+                           [&area](const Rectangle& change) {
+                               return doRectanglesIntersect(area, change);
+                           });
+    });
+}
+
+/**
+ * @brief Throws away every cached preview, as well as every preview that is
+ *        still waiting to be prefetched.
+ */
+void HMDT::Project::ProvinceProject::clearPreviewCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+        m_prefetch_queue.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(m_data_cache_mutex);
+    m_data_cache.clear();
+    m_data_cache_label_generation = getMapData()->getLayerGeneration(MapData::Layer::LABEL_MATRIX);
+}
+
+/**
+ * @brief Queues the preview of a province to be built by the prefetch worker,
+ *        starting the worker if it is not running yet.
+ * @details The most recently queued previews get built first. If too many are
+ *          waiting, then the oldest requests are dropped.
+ *
+ * @param province The province to build the preview of
+ */
+void HMDT::Project::ProvinceProject::queuePreviewPrefetch(const Province& province)
+{
+    PreviewRequest request{ province.id,
+                            getIndexForProvinceID(province.id),
+                            province.bounding_box,
+                            0,
+                            getMapData() };
+
+    if(request.index == INVALID_PROVINCE_INDEX) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_data_cache_mutex);
+
+        if(m_data_cache.contains(province.id)) return;
+
+        request.label_generation = m_data_cache_label_generation;
+    }
+
+    std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+
+    if(m_prefetch_stop) return;
+
+    // Already waiting, so just move it to the front of the line
+    auto it = std::find_if(m_prefetch_queue.begin(), m_prefetch_queue.end(),
+                           [&province](const PreviewRequest& queued) {
+                               return queued.id == province.id;
+                           });
+    if(it != m_prefetch_queue.end()) {
+        m_prefetch_queue.erase(it);
+    }
+
+    m_prefetch_queue.push_front(std::move(request));
+
+    if(m_prefetch_queue.size() > MAX_QUEUED_PROVINCE_PREVIEW_PREFETCHES) {
+        m_prefetch_queue.pop_back();
+    }
+
+    if(!m_prefetch_thread.joinable()) {
+        m_prefetch_thread = std::thread(&ProvinceProject::runPreviewPrefetcher, this);
+    }
+
+    m_prefetch_condition.notify_one();
+}
+
+/**
+ * @brief The main loop of the prefetch worker, which builds queued previews
+ *        until stopPreviewPrefetcher() is called.
+ * @details The label matrix is read while holding a lease on it, so that it
+ *          cannot be released out from under the worker. Previews are only
+ *          added to the cache if the label matrix is still at the generation
+ *          that they were requested for once they are built. Any write that
+ *          races with the build is marked dirty afterwards, which evicts the
+ *          preview again the next time that the cache is looked at.
+ */
+void HMDT::Project::ProvinceProject::runPreviewPrefetcher() {
+    constexpr auto LABEL_MATRIX = MapData::Layer::LABEL_MATRIX;
+
+    while(true) {
+        PreviewRequest request;
+        {
+            std::unique_lock<std::mutex> lock(m_prefetch_mutex);
+            m_prefetch_condition.wait(lock, [this]() {
+                return m_prefetch_stop || !m_prefetch_queue.empty();
+            });
+
+            if(m_prefetch_stop) return;
+
+            request = std::move(m_prefetch_queue.front());
+            m_prefetch_queue.pop_front();
+        }
+
+        auto is_current = [this, &request]() {
+            return request.label_generation == m_data_cache_label_generation &&
+                   request.label_generation == request.map_data->getLayerGeneration(LABEL_MATRIX);
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(m_data_cache_mutex);
+            if(m_data_cache.contains(request.id) || !is_current()) continue;
+        }
+
+        // Never load the label matrix from here, it is only worth prefetching
+        //  previews while the label matrix is already in memory
+        auto lease = request.map_data->leaseLayer(LABEL_MATRIX);
+        if(!request.map_data->isLayerResident(LABEL_MATRIX)) continue;
+
+        auto label_matrix = request.map_data->getLabelMatrix().lock();
+        auto iwidth = request.map_data->getWidth();
+        auto&& bb = request.bounding_box;
+        auto [width, height] = calcDims(bb);
+
+        if(label_matrix == nullptr ||
+           static_cast<uint64_t>(bb.bottom_left.x) + width > iwidth ||
+           static_cast<uint64_t>(bb.top_right.y) + height > request.map_data->getHeight())
+        {
+            continue;
+        }
+
+        auto data = buildProvincePreview(label_matrix.get() +
+                                             static_cast<uint64_t>(bb.top_right.y) * iwidth +
+                                             bb.bottom_left.x,
+                                         iwidth, request.index, bb);
+
+        std::lock_guard<std::mutex> lock(m_data_cache_mutex);
+        if(is_current() && !m_data_cache.contains(request.id)) {
+            m_data_cache.insert(request.id, data, data->getByteSize());
+        }
+    }
+}
+
+/**
+ * @brief Stops the prefetch worker and waits for it to finish.
+ */
+void HMDT::Project::ProvinceProject::stopPreviewPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+        m_prefetch_stop = true;
+        m_prefetch_queue.clear();
+    }
+
+    m_prefetch_condition.notify_all();
+
+    if(m_prefetch_thread.joinable()) {
+        m_prefetch_thread.join();
+    }
+}
+
 auto HMDT::Project::ProvinceProject::getOldIDToUUIDMap() const noexcept
     -> const std::unordered_map<uint32_t, UUID>&
 {
@@ -1012,6 +1741,83 @@ uint32_t HMDT::Project::ProvinceProject::getIDForProvinceID(const ProvinceID& id
     return m_uuid_to_oldid.at(id);
 }
 
+/**
+ * @brief Gets the dense index of a province, as stored in the label matrix
+ *
+ * @param id The ID of the province
+ *
+ * @return The index of the province, or INVALID_PROVINCE_INDEX if no such
+ *         province is known
+ */
+auto HMDT::Project::ProvinceProject::getIndexForProvinceID(const ProvinceID& id) const noexcept
+    -> ProvinceIndex
+{
+    return m_provinces.getIndex(id);
+}
+
+/**
+ * @brief Gets the ID of the province with the given dense index
+ *
+ * @param index The index of the province, as stored in the label matrix
+ *
+ * @return The ID of the province, or INVALID_PROVINCE if the index is not
+ *         known
+ */
+auto HMDT::Project::ProvinceProject::getProvinceIDForIndex(ProvinceIndex index) const noexcept
+    -> const ProvinceID&
+{
+    return m_provinces.getID(index);
+}
+
+/**
+ * @brief Finds every province whose bounding box intersects a rectangle
+ *
+ * @param rect The area to search, in pixels
+ *
+ * @return The index of every matching province, sorted by index
+ */
+auto HMDT::Project::ProvinceProject::getProvincesInRect(const Rectangle& rect) const noexcept
+    -> std::vector<ProvinceIndex>
+{
+    return m_spatial_index.queryRect(rect);
+}
+
+/**
+ * @brief Rebuilds the ProvinceID <-> ProvinceIndex registry.
+ * @details The dense index of a province is its position in the province
+ *          store, so this reorders the store itself. Note that this does not
+ *          touch the label matrix, so the matrix must either already agree
+ *          with the given order, or be rebuilt afterwards.
+ *
+ * @param ids Every province ID, in the order in which they should be indexed
+ */
+void HMDT::Project::ProvinceProject::rebuildProvinceIndexRegistry(const std::vector<ProvinceID>& ids) noexcept
+{
+    m_provinces.reorder(ids);
+
+    auto [width, height] = getMapData()->getDimensions();
+    m_spatial_index.rebuild(m_provinces, width, height);
+
+    // Every cached root refers to the old indices
+    std::lock_guard<std::mutex> lock(m_root_index_cache_mutex);
+    m_root_index_cache.clear();
+}
+
+/**
+ * @brief Rebuilds the ProvinceID <-> ProvinceIndex registry from every
+ *        currently loaded province
+ */
+void HMDT::Project::ProvinceProject::rebuildProvinceIndexRegistry() noexcept {
+    std::vector<ProvinceID> ids;
+    ids.reserve(m_provinces.size());
+
+    for(auto&& [id, _] : m_provinces) {
+        ids.push_back(id);
+    }
+
+    rebuildProvinceIndexRegistry(ids);
+}
+
 /**
  * @brief Rebuilds the mapping of UUID->ID.
  * @details This should be called every time m_provinces changes/is updated.
@@ -1093,17 +1899,25 @@ auto HMDT::Project::ProvinceProject::visitProvinces(const std::function<MaybeVoi
             }, visitor);
         RETURN_IF_ERROR(result);
 
+        // Keeps the hot columns of the province list in sync with whatever
+        //   gets written through the property nodes
+        auto sync_columns = [_this=const_cast<ProvinceProject*>(this),
+                             province_id]()
+        {
+            _this->m_provinces.syncColumns(_this->getIndexForProvinceID(province_id));
+        };
+
         result = province_node->setProvinceType([_this=const_cast<ProvinceProject*>(this),
                                                  province_id]() -> auto& {
                 return _this->m_provinces[province_id].type;
-            }, visitor);
+            }, visitor, sync_columns);
         RETURN_IF_ERROR(result);
 
         result = province_node->setCoastal([_this=const_cast<ProvinceProject*>(this),
                                             province_id]() -> auto&
             {
                 return _this->m_provinces[province_id].coastal;
-            }, visitor);
+            }, visitor, sync_columns);
         RETURN_IF_ERROR(result);
 
         result = province_node->setTerrain([_this=const_cast<ProvinceProject*>(this),
@@ -1137,3 +1951,56 @@ auto HMDT::Project::ProvinceProject::visitProvinces(const std::function<MaybeVoi
     return provinces_group_node;
 }
 
+
+/**
+ * @brief Reports how much memory is used by the provinces, their cached
+ *        previews, and the lookup tables between the different ID types.
+ * @details A warning is added if the cached previews are over their byte
+ *          budget.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::ProvinceProject::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    auto& self = report.addChild("Provinces Project");
+
+    // Provinces
+    {
+        uint64_t bytes = estimateMemoryUsage(m_provinces);
+        for(auto&& [_, province] : m_provinces) {
+            bytes += estimateMemoryUsage(province.adjacent_provinces);
+            bytes += estimateMemoryUsage(province.children);
+        }
+
+        self.addChild("Provinces (" + std::to_string(m_provinces.size()) + ")",
+                      bytes);
+    }
+
+    // Preview cache
+    {
+        std::lock_guard<std::mutex> lock(m_data_cache_mutex);
+
+        auto& cache_report = self.addChild("Preview Cache (" +
+                                           std::to_string(m_data_cache.size()) +
+                                           ")", m_data_cache.getTotalBytes());
+
+        // Only possible if a single preview is larger than the entire budget
+        if(m_data_cache.getTotalBytes() > m_data_cache.getByteBudget()) {
+            cache_report.addWarning("Previews use " +
+                                    formatByteSize(m_data_cache.getTotalBytes()) +
+                                    ", which is over the budget of " +
+                                    formatByteSize(m_data_cache.getByteBudget()) +
+                                    ".");
+        }
+    }
+
+    self.addChild("Spatial Index", estimateMemoryUsage(m_spatial_index));
+    self.addChild("Adjacency Graph (" +
+                  std::to_string(m_adjacency_graph.getEdgeCount() / 2) +
+                  " borders)", estimateMemoryUsage(m_adjacency_graph));
+    self.addChild("Spans (" +
+                  std::to_string(m_province_spans.getSpanCount()) +
+                  " spans)", estimateMemoryUsage(m_province_spans));
+    self.addChild("Old ID Maps", estimateMemoryUsage(m_oldid_to_uuid) +
+                                 estimateMemoryUsage(m_uuid_to_oldid));
+}
@@ -1,9 +1,11 @@
 
 #include "RiversProject.h"
 
+#include <algorithm>
 #include <fstream>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #include "Logger.h"
 
@@ -11,6 +13,7 @@
 #include "StatusCodes.h"
 #include "MapData.h"
 #include "Util.h"
+#include "RiversValidator.h"
 
 #include "WorldNormalBuilder.h"
 
@@ -18,9 +21,38 @@
 #include "PropertyNode.h"
 #include "NodeKeyNames.h"
 
+namespace {
+    //! Marks labels in the template lookup table which are not provinces
+    constexpr uint8_t INVALID_TEMPLATE_VALUE = 0xFF;
+
+    /**
+     * @brief Gets the rivers color table index that the template uses for a
+     *        type of province.
+     *
+     * @param type The province type
+     *
+     * @return The index of one of the comment colors from generateColorTable()
+     */
+    constexpr uint8_t getTemplateValue(HMDT::ProvinceType type) noexcept {
+        switch(type) {
+            case HMDT::ProvinceType::LAND:
+                return 12;
+            case HMDT::ProvinceType::LAKE:
+            case HMDT::ProvinceType::SEA:
+                return 13;
+            case HMDT::ProvinceType::UNKNOWN:
+            default:
+                return 14;
+        }
+    }
+}
+
 HMDT::Project::RiversProject::RiversProject(IRootMapProject& parent):
     m_parent_project(parent),
-    m_rivers_bmp(nullptr)
+    m_rivers_bmp(nullptr),
+    m_deferred_path(std::nullopt),
+    m_source_path(std::nullopt),
+    m_bitmap_mutex()
 { }
 
 /**
@@ -34,17 +66,35 @@ HMDT::Project::RiversProject::RiversProject(IRootMapProject& parent):
 auto HMDT::Project::RiversProject::save(const std::filesystem::path& root)
     -> MaybeVoid
 {
+    auto path = root / RIVERS_FILENAME;
+
+    // If the rivers were never needed, then the file on disk is already
+    //  up-to-date and there is no reason to load it just to write it back
+    if(std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+            m_deferred_path && *m_deferred_path == path)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    RETURN_IF_ERROR(ensureBitMapLoaded());
+
     if(m_rivers_bmp == nullptr) {
         WRITE_ERROR("No rivers has been loaded, cannot save yet.");
         RETURN_ERROR(STATUS_NO_DATA_LOADED);
     }
 
-    auto path = root / RIVERS_FILENAME;
-
     // Write the rivers to a file
     auto res = writeBMP(path, m_rivers_bmp);
     RETURN_IF_ERROR(res);
 
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+        m_source_path = path;
+    }
+
+    // Broken rivers are still saved, but the user should know about them
+    validateRivers().writeToLog(MAX_LOGGED_VALIDATION_ISSUES);
+
     return STATUS_SUCCESS;
 }
 
@@ -71,13 +121,24 @@ auto HMDT::Project::RiversProject::load(const std::filesystem::path& root)
         RETURN_ERROR(std::make_error_code(std::errc::no_such_file_or_directory));
     }
 
-    return loadFile(path);
+    // Don't actually read the rivers until something needs them
+    WRITE_DEBUG("Deferring load of ", path, " until it is first accessed.");
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+        m_rivers_bmp.reset();
+        m_deferred_path = path;
+    }
+
+    registerLayerLoader();
+
+    return STATUS_SUCCESS;
 }
 
 auto HMDT::Project::RiversProject::export_(const std::filesystem::path& root) const noexcept
     -> MaybeVoid
 {
-    MaybeVoid res;
+    MaybeVoid res = ensureBitMapLoaded();
+    RETURN_IF_ERROR(res);
 
     if(m_rivers_bmp != nullptr) {
         res = writeBMP2(root / RIVERS_FILENAME,
@@ -156,7 +217,15 @@ auto HMDT::Project::RiversProject::getRootMapParent() const
     return m_parent_project.getRootMapParent();
 }
 
-auto HMDT::Project::RiversProject::loadFile(const std::filesystem::path& path) noexcept
+/**
+ * @brief Reads the rivers bitmap from a file. Does not touch MapData.
+ * @details m_bitmap_mutex must be held when calling this function.
+ *
+ * @param path The path to read from
+ *
+ * @return STATUS_SUCCESS on success, or an error code on failure.
+ */
+auto HMDT::Project::RiversProject::readBitMap(const std::filesystem::path& path) const noexcept
     -> MaybeVoid
 {
     try {
@@ -184,32 +253,140 @@ auto HMDT::Project::RiversProject::loadFile(const std::filesystem::path& path) n
     }
 
     // Just in case the input image is not actually an 8-bit images
-    uint8_t* rivers_data;
     if(auto bpp = m_rivers_bmp->info_header.v1.bitsPerPixel; bpp != 8) {
         WRITE_ERROR("Rivers must be 8-bit images, not ", bpp, ".");
         RETURN_ERROR(STATUS_INVALID_BIT_DEPTH);
     }
 
-    rivers_data = m_rivers_bmp->data.get();
+    m_source_path = path;
 
-    // Load rivers data into MapData
-    // This operation is fairly simple, as we are not making any modifications
-    //   to the data itself, and just loading it into memory
-    std::memcpy(getMapData()->getRivers().lock().get(),
-                rivers_data,
-                getMapData()->getRiversSize());
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Reads the deferred rivers file if it hasn't been read yet
+ *
+ * @return STATUS_SUCCESS on success, or an error code on failure.
+ */
+auto HMDT::Project::RiversProject::ensureBitMapLoaded() const noexcept
+    -> MaybeVoid
+{
+    std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+    if(m_rivers_bmp == nullptr && m_deferred_path) {
+        WRITE_DEBUG("Reading deferred rivers ", *m_deferred_path);
+
+        auto res = readBitMap(*m_deferred_path);
+        RETURN_IF_ERROR(res);
+
+        m_deferred_path.reset();
+    }
 
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Registers the loader which fills MapData's rivers layer whenever it
+ *        gets allocated.
+ */
+void HMDT::Project::RiversProject::registerLayerLoader() {
+    getMapData()->setLayerLoader(MapData::Layer::RIVERS, [this]() {
+        if(auto res = ensureBitMapLoaded(); IS_FAILURE(res)) {
+            WRITE_ERROR("Failed to load rivers data.");
+            WRITE_IF_ERROR(res);
+            return;
+        }
+
+        if(m_rivers_bmp == nullptr) return;
+
+        // Load rivers data into MapData
+        // This operation is fairly simple, as we are not making any
+        //   modifications to the data itself, and just loading it into memory
+        std::memcpy(getMapData()->getRivers().lock().get(),
+                    m_rivers_bmp->data.get(),
+                    getMapData()->getRiversSize());
+    }, [this]() {
+        releaseBitMap();
+    });
+}
+
+/**
+ * @brief Releases the bitmap after MapData has released its rivers layer.
+ * @details The bitmap is only released if it can be read back from its file,
+ *          in which case it is deferred again until it is next needed.
+ */
+void HMDT::Project::RiversProject::releaseBitMap() noexcept {
+    std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+    if(m_rivers_bmp != nullptr && m_source_path) {
+        WRITE_DEBUG("Releasing rivers, they will be read again from ",
+                    *m_source_path, " once needed.");
+
+        m_rivers_bmp.reset();
+        m_deferred_path = m_source_path;
+    }
+}
+
+auto HMDT::Project::RiversProject::loadFile(const std::filesystem::path& path) noexcept
+    -> MaybeVoid
+{
+    {
+        std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+        auto res = readBitMap(path);
+        RETURN_IF_ERROR(res);
+
+        m_deferred_path.reset();
+    }
+
+    registerLayerLoader();
+
+    // Only refresh the layer if it is already in memory, otherwise it will
+    //  get loaded the first time it is accessed
+    if(getMapData()->isLayerResident(MapData::Layer::RIVERS)) {
+        std::memcpy(getMapData()->getRivers().lock().get(),
+                    m_rivers_bmp->data.get(),
+                    getMapData()->getRiversSize());
+    }
+
+    getMapData()->markLayerDirty(MapData::Layer::RIVERS);
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Gets the rivers bitmap, reading it first if it was deferred.
+ *
+ * @return The bitmap, or nullptr if no rivers could be loaded.
+ */
 auto HMDT::Project::RiversProject::getBitMap() const
-    -> MonadOptionalRef<const BitMap2>
+    -> std::shared_ptr<const BitMap2>
 {
-    if(m_rivers_bmp != nullptr) {
-        return *m_rivers_bmp;
-    } else {
-        return std::nullopt;
+    auto res = ensureBitMapLoaded();
+    WRITE_IF_ERROR(res);
+
+    std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+    return m_rivers_bmp;
+}
+
+/**
+ * @brief Checks every river against the HoI4 river rules.
+ * @details Rivers which have not been read yet are not checked, as they cannot
+ *          have changed since they were last saved.
+ *
+ * @return Every issue found in the rivers.
+ */
+auto HMDT::Project::RiversProject::validateRivers() const -> ValidationReport {
+    std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+    if(m_rivers_bmp == nullptr) {
+        return ValidationReport{};
     }
+
+    auto width = static_cast<uint32_t>(m_rivers_bmp->info_header.v1.width);
+    auto height = static_cast<uint32_t>(m_rivers_bmp->info_header.v1.height);
+
+    return HMDT::validateRivers(m_rivers_bmp->data.get(), width, height);
 }
 
 auto HMDT::Project::RiversProject::writeTemplate(const std::filesystem::path& path) const noexcept
@@ -233,40 +410,69 @@ auto HMDT::Project::RiversProject::writeTemplate(const std::filesystem::path& pa
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Generates a rivers template, where every pixel is marked with the
+ *        type of province it belongs to.
+ * @details The template value of every province is looked up once, after
+ *          which every pixel is a single table read. Pixels are filled in by
+ *          chunks in parallel.
+ *
+ * @param data Where to write the template. Gets allocated to hold one byte
+ *             for every pixel of the map.
+ *
+ * @return STATUS_SUCCESS on success, or STATUS_VALUE_NOT_FOUND if any pixel of
+ *         the label matrix does not belong to a province.
+ */
 auto HMDT::Project::RiversProject::generateTemplate(std::unique_ptr<uint8_t[]>& data) const noexcept
     -> MaybeVoid
 {
+    auto map_data = getMapData();
+    auto rivers_size = map_data->getRiversSize();
+
     try {
-        data.reset(new uint8_t[getMapData()->getRiversSize()]);
+        data.reset(new uint8_t[rivers_size]);
     } catch(const std::bad_alloc& e) {
         WRITE_ERROR(e.what());
         RETURN_ERROR(STATUS_BADALLOC);
     }
 
-    for(auto i = 0U; i < getMapData()->getRiversSize(); ++i) {
-        auto province_label = getMapData()->getProvinces().lock()[i];
+    const auto& provinces = getRootMapParent().getProvinceProject().getProvinces();
+    auto province_count = static_cast<uint32_t>(provinces.size());
 
-        if(!getRootMapParent().getProvinceProject().isValidProvinceID(province_label))
+    // Index 0 is never a province, and the extra entry at the end stands in
+    //  for every label past the last province
+    std::vector<uint8_t> template_values(province_count + 2,
+                                         INVALID_TEMPLATE_VALUE);
+    for(ProvinceIndex index = 1; index <= province_count; ++index) {
+        template_values[index] = getTemplateValue(provinces.atIndex(index)->type);
+    }
+
+    auto label_matrix = map_data->getLabelMatrix().lock();
+    const auto* labels = label_matrix.get();
+    auto* out = data.get();
+    auto last_label = province_count + 1;
+
+    auto chunks_valid = parallelMapChunks(rivers_size,
+        [&template_values, labels, out, last_label](uint32_t begin, uint32_t end)
         {
-            WRITE_ERROR("Province ID ", province_label, " at river index ", i,
-                        " is not valid.");
-            RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
-        }
+            bool invalid = false;
+            for(auto i = begin; i < end; ++i) {
+                auto value = template_values[std::min(labels[i], last_label)];
+                out[i] = value;
+                invalid |= value == INVALID_TEMPLATE_VALUE;
+            }
 
-        auto prov_type = getRootMapParent().getProvinceProject().getProvinceForID(province_label).type;
-
-        switch(prov_type) {
-            case ProvinceType::LAND:
-                data[i] = 12;
-                break;
-            case ProvinceType::LAKE:
-            case ProvinceType::SEA:
-                data[i] = 13;
-                break;
-            case ProvinceType::UNKNOWN:
-                data[i] = 14;
-                break;
-        }
+            return !invalid;
+        });
+
+    if(!std::all_of(chunks_valid.begin(), chunks_valid.end(),
+                    [](bool valid) { return valid; }))
+    {
+        auto i = std::find(out, out + rivers_size, INVALID_TEMPLATE_VALUE) - out;
+
+        WRITE_ERROR("Province label ", labels[i], " at river index ", i,
+                    " is not valid.");
+        RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
     }
 
     return STATUS_SUCCESS;
@@ -327,3 +533,22 @@ auto HMDT::Project::RiversProject::visit(const std::function<MaybeVoid(std::shar
     return rivers_project_node;
 }
 
+
+/**
+ * @brief Reports how much memory the rivers map is using. A rivers map which
+ *        has not been loaded yet is reported as 0 bytes, and does not get
+ *        loaded.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::RiversProject::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_bitmap_mutex);
+
+    uint64_t bytes = 0;
+    if(m_rivers_bmp != nullptr) {
+        bytes = estimateMemoryUsage(*m_rivers_bmp);
+    }
+
+    report.addChild("Rivers Project", bytes);
+}
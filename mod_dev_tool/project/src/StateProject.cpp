@@ -4,6 +4,11 @@
 #include <fstream>
 #include <cstring>
 #include <cerrno>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <optional>
+#include <string_view>
 
 #include "Logger.h"
 
@@ -12,6 +17,7 @@
 #include "Constants.h"
 #include "StatusCodes.h"
 #include "UniqueColorGenerator.h"
+#include "FileWriterPool.h"
 
 #include "HoI4Project.h"
 
@@ -23,7 +29,10 @@
 HMDT::Project::StateProject::StateProject(IRootHistoryProject& parent_project):
     m_parent_project(parent_project),
     m_available_state_ids(),
-    m_states()
+    m_states(),
+    m_province_states(),
+    m_removed_positions(),
+    m_state_color_generation(0)
 {
 }
 
@@ -42,6 +51,8 @@ auto HMDT::Project::StateProject::save(const std::filesystem::path& root)
 {
     auto path = root / STATEDATA_FILENAME;
 
+    compactStates();
+
     if(std::ofstream out(path); out) {
         WRITE_DEBUG("Saving states to ", path);
 
@@ -82,13 +93,74 @@ auto HMDT::Project::StateProject::save(const std::filesystem::path& root)
     return STATUS_SUCCESS;
 }
 
+namespace {
+    /**
+     * @brief Splits the next field off of the front of a line.
+     *
+     * @param line The rest of the line. Will be advanced past the field and
+     *             its delimiter.
+     * @param delim The character separating each field
+     *
+     * @return The field, or std::nullopt if nothing is left in the line
+     */
+    std::optional<std::string_view> nextField(std::string_view& line,
+                                              char delim) noexcept
+    {
+        if(line.empty()) {
+            return std::nullopt;
+        }
+
+        auto pos = line.find(delim);
+        auto field = line.substr(0, pos);
+
+        line.remove_prefix(pos == std::string_view::npos ? line.size()
+                                                         : pos + 1);
+
+        return field;
+    }
+
+    /**
+     * @brief Parses a number which must take up an entire field.
+     *
+     * @param field The field to parse
+     * @param result Where to place the parsed value
+     *
+     * @return True if the whole field was a valid number, false otherwise
+     */
+    template<typename T>
+    bool parseNumber(std::string_view field, T& result) noexcept {
+        auto* end = field.data() + field.size();
+        auto [ptr, ec] = std::from_chars(field.data(), end, result);
+
+        return ec == std::errc{} && ptr == end;
+    }
+
+    /**
+     * @brief Parses a boolean field, written either as 0/1 or false/true.
+     */
+    bool parseBool(std::string_view field, bool& result) noexcept {
+        if(field == "1" || field == "true") {
+            result = true;
+        } else if(field == "0" || field == "false") {
+            result = false;
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+}
+
 /**
  * @brief Loads all state data from a file
+ * @details The whole file is read into memory at once and then parsed in a
+ *          single pass, with every field viewed in place rather than copied
+ *          out. Only the strings and province lists owned by each State are
+ *          allocated.
  *
  * @param root The root where the state data file should be found
- * @param ec The error code
  *
- * @return True if data was loaded correctly, false otherwise
+ * @return STATUS_SUCCESS if data was loaded correctly, an error otherwise
  */
 auto HMDT::Project::StateProject::load(const std::filesystem::path& root)
     -> MaybeVoid
@@ -105,110 +177,260 @@ auto HMDT::Project::StateProject::load(const std::filesystem::path& root)
         return std::make_error_code(std::errc::no_such_file_or_directory);
     }
 
-    if(std::ifstream in(path); in) {
-        // Make sure we clear out the states map first just in case there is
-        //   some data in here (there shouldn't be)
-        m_states.clear();
+    std::string data;
+    if(std::ifstream in(path, std::ios::binary); in) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        RETURN_ERROR_IF(ec.value() != 0, ec);
 
-        // FORMAT:
-        //   ID;<State Name>;MANPOWER;<CATEGORY>;BUILDINGS_MAX_LEVEL_FACTOR;IMPASSABLE;PROVID1,PROVID2,...
-        std::string line;
-        for(size_t line_num = 0; std::getline(in, line); ++line_num) {
-            if(line.empty()) continue;
-
-            std::istringstream iss(line);
-
-            State state;
-            state.color = Color{0,0,0}; // Initialize this to nothing
-
-            std::string prov_id_data;
-            if(!parseValuesSkipMissing<';'>(iss, &state.id,
-                                                 &state.name,
-                                                 &state.manpower,
-                                                 &state.category,
-                                                 &state.buildings_max_level_factor,
-                                                 &state.impassable,
-                                                 &prov_id_data, true,
-                                                 &state.color.r, true,
-                                                 &state.color.g, true,
-                                                 &state.color.b, true))
+        data.resize(size);
+        if(!in.read(data.data(), data.size())) {
+            WRITE_ERROR("Failed to read ", size, " bytes from ", path);
+            RETURN_ERROR(STATUS_READ_TOO_FEW_BYTES);
+        }
+    } else {
+        WRITE_ERROR("Failed to open file ", path, ". Reason: ", std::strerror(errno));
+        RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
+    }
+
+    // Make sure we clear out the states map first just in case there is
+    //   some data in here (there shouldn't be)
+    m_states.clear();
+    m_removed_positions.clear();
+
+    // Older projects refer to provinces by number rather than by UUID, so
+    //   look up how to convert those only once
+    const std::unordered_map<uint32_t, UUID>* oldid_to_uuid_map = nullptr;
+    if(getRootParent().getToolVersion() <= "0.25.0"_V) {
+        oldid_to_uuid_map = &getRootParent().getMapProject().getProvinceProject().getOldIDToUUIDMap();
+    }
+
+    // FORMAT:
+    //   ID;<State Name>;MANPOWER;<CATEGORY>;BUILDINGS_MAX_LEVEL_FACTOR;IMPASSABLE;PROVID1,PROVID2,...;R;G;B
+    std::string_view remaining(data);
+    for(size_t line_num = 0; !remaining.empty(); ++line_num) {
+        auto line = *nextField(remaining, '\n');
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        if(line.empty()) continue;
+
+        auto fields = line;
+        auto id = nextField(fields, ';');
+        auto name = nextField(fields, ';');
+        auto manpower = nextField(fields, ';');
+        auto category = nextField(fields, ';');
+        auto buildings_max_level_factor = nextField(fields, ';');
+        auto impassable = nextField(fields, ';');
+        auto prov_id_data = nextField(fields, ';').value_or(std::string_view{});
+
+        State state;
+        state.color = Color{0,0,0}; // Initialize this to nothing
+
+        if(!id || !name || !manpower || !category ||
+           !buildings_max_level_factor || !impassable ||
+           !parseNumber(*id, state.id) ||
+           !parseNumber(*manpower, state.manpower) ||
+           !parseNumber(*buildings_max_level_factor,
+                        state.buildings_max_level_factor) ||
+           !parseBool(*impassable, state.impassable))
+        {
+            WRITE_ERROR("Failed to parse line #", line_num, ": '", line, "'");
+            RETURN_ERROR(std::make_error_code(std::errc::bad_message));
+        }
+
+        state.name = *name;
+        state.category = *category;
+
+        // The color is optional, and is left as 0,0,0 if any part of it is
+        //   missing
+        if(auto r = nextField(fields, ';'), g = nextField(fields, ';'),
+                b = nextField(fields, ';');
+           r && g && b)
+        {
+            uint32_t cr = 0, cg = 0, cb = 0;
+            if(parseNumber(*r, cr) && parseNumber(*g, cg) && parseNumber(*b, cb))
             {
-                WRITE_ERROR("Failed to parse line #", line_num, ": '", line, "'");
-                RETURN_ERROR(std::make_error_code(std::errc::bad_message));
+                state.color = Color{ static_cast<uint8_t>(cr),
+                                     static_cast<uint8_t>(cg),
+                                     static_cast<uint8_t>(cb) };
             }
+        }
 
-            WRITE_DEBUG("Reading state data {"
-                        "id=", state.id, ", "
-                        "name=", state.name, ", "
-                        "manpower=", state.manpower, ", "
-                        "category=", state.category, ", "
-                        "buildings_max_level_factor=", state.buildings_max_level_factor, ", "
-                        "impassable=", state.impassable, ", "
-                        "prov_id_data=<DATA>, "
-                        "color={",
-                        "r=", state.color.r, ", "
-                        "g=", state.color.g, ", "
-                        "b=", state.color.b, "}"
-                        "}"
-            );
-
-            // If we did not load a state color, then the color should be 0,0,0
-            // In that case, we want to generate a new unique color value
-            if(state.color == Color{0,0,0}) {
-                WRITE_WARN("Saved state data did not have a color value, generating a new one...");
-                state.color = generateUniqueColor(ProvinceType::UNKNOWN);
-            } else {
-                generateUniqueColor(ProvinceType::UNKNOWN); // "generate" a color to advance the number of colors by 1
-            }
+        // If we did not load a state color, then the color should be 0,0,0
+        // In that case, we want to generate a new unique color value
+        if(state.color == Color{0,0,0}) {
+            WRITE_WARN("Saved state data did not have a color value, generating a new one...");
+            state.color = generateUniqueColor(ProvinceType::UNKNOWN);
+        } else {
+            generateUniqueColor(ProvinceType::UNKNOWN); // "generate" a color to advance the number of colors by 1
+        }
+
+        // We need to parse the provinces seperately
+        state.provinces.reserve(std::count(prov_id_data.begin(),
+                                           prov_id_data.end(), ',') + 1);
+        while(auto prov = nextField(prov_id_data, ',')) {
+            if(prov->empty()) continue;
+
+            if(oldid_to_uuid_map != nullptr) {
+                uint32_t oldid = 0;
+                auto it = parseNumber(*prov, oldid) ? oldid_to_uuid_map->find(oldid)
+                                                    : oldid_to_uuid_map->end();
+
+                if(it == oldid_to_uuid_map->end()) {
+                    WRITE_ERROR("Could not find old id '", *prov, "' in oldid to UUID mapping!");
+                    RETURN_ERROR(STATUS_VALUE_NOT_FOUND);
+                }
 
-            // We need to parse the provinces seperately
-            bool err = false;
-            state.provinces = splitAndTransform<ProvinceID>(prov_id_data, ',',
-                    [this, &err](const std::string& v) {
-                        if(getRootParent().getToolVersion() <= "0.25.0"_V) {
-                            auto oldid = std::atoi(v.c_str());
-
-                            const auto& oldid_to_uuid_map = getRootParent().getMapProject().getProvinceProject().getOldIDToUUIDMap();
-
-                            if(oldid_to_uuid_map.count(oldid) == 0) {
-                                WRITE_ERROR("Could not find old id ", oldid, " in oldid to UUID mapping!");
-                                err = true;
-                                return EMPTY_UUID;
-                            }
-
-                            return oldid_to_uuid_map.at(oldid);
-                        } else {
-                            return UUID::parse(v).orElse(EMPTY_UUID);
-                        }
-                    });
-            RETURN_ERROR_IF(err, STATUS_VALUE_NOT_FOUND);
-
-            if(m_states.count(state.id) != 0) {
-                WRITE_ERROR("Found multiple states with the same ID of ", state.id, "! We will skip the second one '", state.name, "' and keep '", m_states.at(state.id).name, '\'');
+                state.provinces.push_back(it->second);
+            } else if(auto uuid = UUID::fromChars(*prov); IS_SUCCESS(uuid)) {
+                state.provinces.push_back(*uuid);
             } else {
-                WRITE_DEBUG("Successfully loaded state ID ", state.id,
-                            " named ", state.name);
-                m_states[state.id] = state;
+                WRITE_ERROR("Failed to parse province '", *prov, "' of state ", state.id);
+                state.provinces.push_back(EMPTY_UUID);
             }
         }
 
-        // Now that we've loaded every single state, we need to track which IDs
-        //  have not been used yet
-        for(StateID id = 1; id < m_states.size(); ++id) {
-            if(m_states.count(id) == 0) {
-                m_available_state_ids.push(id);
-            }
+        if(auto it = m_states.find(state.id); it != m_states.end()) {
+            WRITE_ERROR("Found multiple states with the same ID of ", state.id, "! We will skip the second one '", state.name, "' and keep '", it->second.name, '\'');
+        } else {
+            m_states.emplace(state.id, std::move(state));
         }
+    }
 
-        updateStateIDMatrix();
-    } else {
-        WRITE_ERROR("Failed to open file ", path, ". Reason: ", std::strerror(errno));
-        RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
+    WRITE_DEBUG("Loaded ", m_states.size(), " states from ", path);
+
+    // Now that we've loaded every single state, we need to track which IDs
+    //  have not been used yet
+    for(StateID id = 1; id < m_states.size(); ++id) {
+        if(m_states.count(id) == 0) {
+            m_available_state_ids.push(id);
+        }
     }
 
+    rebuildProvinceStateIndex();
+
+    ++m_state_color_generation;
+
+    updateStateIDMatrix();
+
     return STATUS_SUCCESS;
 }
 
+namespace {
+    /**
+     * @brief Renders the history file of a single state.
+     *
+     * @param state The state to render
+     * @param prov_project Used to look up the ID HoI4 knows each province by
+     *
+     * @return The contents of the history file
+     */
+    std::string renderStateHistory(const HMDT::State& state,
+                                   const HMDT::Project::IProvinceProject& prov_project)
+    {
+        std::stringstream provinces_ss;
+        for(auto&& prov_id : state.provinces) {
+            provinces_ss << prov_project.getIDForProvinceID(prov_id) << ' ';
+        }
+
+        std::stringstream out;
+
+        out << "state={" << '\n';
+        // General state information
+        out << "\tid=" << state.id << '\n';
+        out << "\tname=\"" << state.name << '"' << '\n'; // TODO: HoI4 uses STATE_{ID} here, is that for localization?
+        out << "\tmanpower=" << state.manpower << '\n';
+        out << "\tstate_category = " << state.category << '\n';
+
+        // Leave this out of the export if it's left as the default 1.0
+        if(state.buildings_max_level_factor != 1.0) {
+            // TODO: wiki recommends avoiding this. Should we not support it at all?
+            out << "\tbuildings_max_level_factor=" << state.buildings_max_level_factor << '\n';
+        }
+
+        // TODO: Resources
+
+        if(state.impassable) {
+            out << "\timpassable = yes" << '\n';
+        }
+
+        // History here
+        out << "\thistory={" << '\n';
+
+        // NOTE (from wiki):
+        //   Only one province can be defined within one victory_points.
+        //   In order to have multiple provinces with victory points in one
+        //   state, several instances of victory_points = { ... } need to be
+        //   put in.
+        // TODO: This should be a for-loop, generating a 'victory_points={}'
+        //   block for each victory point
+        // out << "\t\tvictory_points={" << '\n';
+        // TODO Format is "PROVID AMOUNT"
+        // out << "\t\t}" << '\n';
+
+        // TODO: Owner
+        //   Game will load without owners, but doing stuff to this state
+        //   (like transferring it) will cause a crash
+        // For now, we are using a country that does not exist at the start
+        //   of the game and has no focus tree for testing.
+        out << "\t\towner = CHA" << '\n';
+
+        out << "\t\tbuildings={" << '\n';
+        // TODO
+        //  NOTE: Each of these can be left blank if their count is 0
+        //  NOTE: When designing how these buildings are outputted, we
+        //    should keep in mind that custom buildings can be added as well
+        //
+        //  infrastructure = ...
+        //  arms_factory = ...
+        //  industrial_complex = ...
+        //  dockyard = ...
+        //  airbase = ... // TODO: air_base? wiki disagrees with what's in the files
+        //  anti_air_building = ...
+        //  synthetic_refinery = ...
+        //  fuel_silo = ...
+        //  radar_station = ...
+        //  rocket_site = ...
+        //  nuclear_reactor = ...
+        //  for each province: // Skip if province has no buildings
+        //    id = {
+        //      naval_base = ...
+        //      bunker = ...
+        //      coastal_bunker = ...
+        //      supply_node = ...
+        //      rail_way = ...
+        //    }
+        out << "\t\t}" << '\n';
+
+        // TODO
+        //  This is optional, for if someone other than the owner should
+        //  start out controlling it
+        // out << "\t\tcontroller = " << '\n';
+
+        // TODO
+        // Optional, for if claimed by another country
+        // out << "\t\tadd_core_of = " << '\n';
+
+        // TODO: This serves as an effect block. Do we want to allow
+        //   defining other effects on a state?
+
+        out << "\t}" << '\n';
+        // More general state information
+        out << "\tprovinces={" << '\n';
+        out << "\t\t" << provinces_ss.str() << '\n';
+        out << "\t}" << '\n';
+        // TODO
+        //   This is optional, it is for defining the base supply of the
+        //    state
+        // out << "\tlocal_supplies=" << ... << '\n';
+        out << "}";
+
+        return out.str();
+    }
+}
+
 auto HMDT::Project::StateProject::export_(const std::filesystem::path& root) const noexcept
     -> MaybeVoid
 {
@@ -228,110 +450,33 @@ auto HMDT::Project::StateProject::export_(const std::filesystem::path& root) con
 
     const auto& prov_project = getRootParent().getMapProject().getProvinceProject();
 
-    for(auto&& [id, state] : m_states) {
-        auto filename = std::to_string(id) + "-" + state.name + ".txt";
-        auto state_path = root / filename;
+    compactStates();
 
-        if(std::ofstream out(state_path); out) {
-            std::stringstream provinces_ss;
-            for(auto&& id : state.provinces) {
-                provinces_ss << prov_project.getIDForProvinceID(id) << ' ';
-            }
+    std::vector<const State*> states;
+    states.reserve(m_states.size());
+    for(auto&& [_, state] : m_states) {
+        states.push_back(&state);
+    }
 
-            out << "state={" << std::endl;
-            // General state information
-            out << "\tid=" << id << std::endl;
-            out << "\tname=\"" << state.name << '"' << std::endl; // TODO: HoI4 uses STATE_{ID} here, is that for localization?
-            out << "\tmanpower=" << state.manpower << std::endl;
-            out << "\tstate_category = " << state.category << std::endl;
-
-            // Leave this out of the export if it's left as the default 1.0
-            if(state.buildings_max_level_factor != 1.0) {
-                // TODO: wiki recommends avoiding this. Should we not support it at all?
-                out << "\tbuildings_max_level_factor=" << state.buildings_max_level_factor << std::endl;
-            }
+    // States are rendered in parallel, and handed off to the writers as soon
+    //   as each one is ready
+    FileWriterPool writer;
+    parallelMapChunks(states.size(), [&](uint32_t begin, uint32_t end) {
+        for(uint32_t i = begin; i < end; ++i) {
+            const auto& state = *states[i];
 
-            // TODO: Resources
+            auto filename = std::to_string(state.id) + "-" + state.name + ".txt";
+            writer.write(root / filename, renderStateHistory(state, prov_project));
+        }
 
-            if(state.impassable) {
-                out << "\timpassable = yes" << std::endl;
-            }
+        return end - begin;
+    });
 
-            // History here
-            out << "\thistory={" << std::endl;
-
-            // NOTE (from wiki):
-            //   Only one province can be defined within one victory_points.
-            //   In order to have multiple provinces with victory points in one
-            //   state, several instances of victory_points = { ... } need to be
-            //   put in.
-            // TODO: This should be a for-loop, generating a 'victory_points={}'
-            //   block for each victory point
-            // out << "\t\tvictory_points={" << std::endl;
-            // TODO Format is "PROVID AMOUNT"
-            // out << "\t\t}" << std::endl;
-
-            // TODO: Owner
-            //   Game will load without owners, but doing stuff to this state
-            //   (like transferring it) will cause a crash
-            // For now, we are using a country that does not exist at the start
-            //   of the game and has no focus tree for testing.
-            out << "\t\towner = CHA" << std::endl;
-
-            out << "\t\tbuildings={" << std::endl;
-            // TODO
-            //  NOTE: Each of these can be left blank if their count is 0
-            //  NOTE: When designing how these buildings are outputted, we
-            //    should keep in mind that custom buildings can be added as well
-            //
-            //  infrastructure = ...
-            //  arms_factory = ...
-            //  industrial_complex = ...
-            //  dockyard = ...
-            //  airbase = ... // TODO: air_base? wiki disagrees with what's in the files
-            //  anti_air_building = ...
-            //  synthetic_refinery = ...
-            //  fuel_silo = ...
-            //  radar_station = ...
-            //  rocket_site = ...
-            //  nuclear_reactor = ...
-            //  for each province: // Skip if province has no buildings
-            //    id = {
-            //      naval_base = ...
-            //      bunker = ...
-            //      coastal_bunker = ...
-            //      supply_node = ...
-            //      rail_way = ...
-            //    }
-            out << "\t\t}" << std::endl;
-
-            // TODO
-            //  This is optional, for if someone other than the owner should
-            //  start out controlling it
-            // out << "\t\tcontroller = " << std::endl;
-
-            // TODO
-            // Optional, for if claimed by another country
-            // out << "\t\tadd_core_of = " << std::endl;
-
-            // TODO: This serves as an effect block. Do we want to allow
-            //   defining other effects on a state?
-
-            out << "\t}" << std::endl;
-            // More general state information
-            out << "\tprovinces={" << std::endl;
-            out << "\t\t" << provinces_ss.str() << std::endl;
-            out << "\t}" << std::endl;
-            // TODO
-            //   This is optional, it is for defining the base supply of the
-            //    state
-            // out << "\tlocal_supplies=" << ... << std::endl;
-            out << "}";
-        } else {
-            WRITE_ERROR("Failed to open file ", state_path);
-            RETURN_ERROR(std::make_error_code(static_cast<std::errc>(errno)));
-        }
-    }
+    auto result = writer.wait();
+    RETURN_IF_ERROR(result);
+
+    WRITE_DEBUG("Wrote ", writer.getWrittenCount(), " state history files, ",
+                writer.getSkippedCount(), " were unchanged.");
 
     // TODO: We should also export blank state files for all of the vanilla
     //   states (if they are supposed to be overridden, that is)
@@ -374,33 +519,172 @@ const HMDT::Project::IRootHistoryProject& HMDT::Project::StateProject::getRootHi
 }
 
 auto HMDT::Project::StateProject::getStateMap() -> StateMap& {
+    compactStates();
     return m_states;
 }
 
 auto HMDT::Project::StateProject::getStates() const -> const StateMap& {
+    compactStates();
     return m_states;
 }
 
+namespace {
+    /**
+     * @brief Writes the state outlines for an area of the map.
+     * @details A pixel is part of an outline if the pixel to its right or the
+     *          pixel below it belongs to a different state. Nothing outside of
+     *          the map is ever treated as a neighbour.
+     *
+     * @param outlines The outlines of the whole map
+     * @param state_ids The state ID matrix
+     * @param width The width of the map
+     * @param height The height of the map
+     * @param area The area to write the outlines of
+     *
+     * @return True if any pixel of the outlines changed, false otherwise
+     */
+    bool writeStateOutlines(uint8_t* outlines, const HMDT::StateID* state_ids,
+                            uint32_t width, uint32_t height,
+                            const HMDT::Rectangle& area)
+    {
+        bool changed = false;
+
+        for(uint32_t y = area.y; y < area.y + area.h; ++y) {
+            const auto* row = state_ids + static_cast<uint64_t>(y) * width;
+
+            // Rows outside of the map compare equal to this one
+            const auto* down = (y + 1 < height) ? row + width : row;
+
+            auto* out_row = outlines + static_cast<uint64_t>(y) * width;
+
+            for(uint32_t x = area.x; x < area.x + area.w; ++x) {
+                auto right = (x + 1 < width) ? row[x + 1] : row[x];
+
+                uint8_t value = 0U - static_cast<uint8_t>((row[x] != right) |
+                                                          (row[x] != down[x]));
+
+                changed |= out_row[x] != value;
+                out_row[x] = value;
+            }
+        }
+
+        return changed;
+    }
+
+    /**
+     * @brief Marks every run of changed rows in a layer as dirty
+     *
+     * @param map_data The map data the layer belongs to
+     * @param layer The layer to mark
+     * @param changed_rows Whether each row of the layer changed
+     */
+    template<typename Flags>
+    void markChangedRowsDirty(HMDT::MapData& map_data,
+                              HMDT::MapData::Layer layer,
+                              const Flags& changed_rows)
+    {
+        auto [width, height] = map_data.getDimensions();
+
+        for(uint32_t y = 0; y < height;) {
+            if(!changed_rows[y]) {
+                ++y;
+                continue;
+            }
+
+            auto start_y = y;
+            while(y < height && changed_rows[y]) ++y;
+
+            map_data.markLayerDirty(layer,
+                                    HMDT::Rectangle{ 0, start_y, width, y - start_y });
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the entire state ID matrix, along with the state outlines.
+ * @details The state of every province is looked up once, after which every
+ *          pixel only needs to index into that table with its label.
+ *
+ * @par The state outlines are then rebuilt in parallel bands of rows, so that
+ *      they only need to be computed once for every change to the state ID
+ *      matrix rather than every time the map is drawn.
+ */
 void HMDT::Project::StateProject::updateStateIDMatrix() {
     auto state_id_matrix = getMapData()->getStateIDMatrix().lock();
 
-    auto label_matrix = getMapData()->getProvinces().lock();
+    auto label_matrix = getMapData()->getLabelMatrix().lock();
 
     auto* label_matrix_start = label_matrix.get();
 
-    parallelTransform(label_matrix_start, label_matrix_start + getMapData()->getProvincesSize(),
+    auto [width, height] = getMapData()->getDimensions();
+
+    // The state of every province, indexed by its label. Index 0 is never a
+    //   valid label, so pixels with it are treated as having no state.
+    const auto& provinces = getRootParent().getMapProject().getProvinceProject().getProvinces();
+    const auto& states = provinces.getStates();
+
+    std::vector<StateID> province_states(states.size() + 1, 0);
+    std::copy(states.begin(), states.end(), province_states.begin() + 1);
+
+    std::atomic<uint64_t> invalid_labels = 0;
+
+    // Remember which rows actually changed, so that only those get marked as
+    //   dirty
+    std::unique_ptr<std::atomic<bool>[]> changed_rows(new std::atomic<bool>[height]());
+
+    parallelTransform(label_matrix_start, label_matrix_start + getMapData()->getMatrixSize(),
                       state_id_matrix.get(),
-                      [this](ProvinceID prov_id) -> StateID {
-                          if(getRootParent().getMapProject().getProvinceProject().isValidProvinceID(prov_id))
+                      [&](const ProvinceIndex& label) -> StateID {
+                          StateID state_id = 0;
+
+                          if(label != INVALID_PROVINCE_INDEX &&
+                             label < province_states.size())
                           {
-                              return getRootParent().getMapProject().getProvinceProject().getProvinceForID(prov_id).state;
+                              state_id = province_states[label];
                           } else {
-                              WRITE_WARN("Invalid province ID ", prov_id,
-                                         " detected when building state id matrix. Treating as though there's no state here.");
-                              return 0;
+                              invalid_labels.fetch_add(1, std::memory_order_relaxed);
                           }
+
+                          // Each pixel is only ever written by the thread
+                          //   which reads it here
+                          auto index = &label - label_matrix_start;
+                          if(state_id_matrix[index] != state_id) {
+                              changed_rows[index / width].store(true, std::memory_order_relaxed);
+                          }
+
+                          return state_id;
                       });
 
+    if(invalid_labels != 0) {
+        WRITE_WARN("Found ", invalid_labels.load(), " pixels with an invalid "
+                   "province label when building state id matrix. Treating "
+                   "them as though there's no state there.");
+    }
+
+    markChangedRowsDirty(*getMapData(), MapData::Layer::STATE_ID_MATRIX,
+                         changed_rows);
+
+    // Every row gets rebuilt, as the outlines may not have been built yet
+    {
+        auto state_outlines = getMapData()->getStateOutlines().lock();
+
+        std::vector<uint8_t> changed_outline_rows(height, 0);
+
+        parallelMapChunks(height, [&](uint32_t begin_y, uint32_t end_y) {
+            for(uint32_t y = begin_y; y < end_y; ++y) {
+                changed_outline_rows[y] = writeStateOutlines(state_outlines.get(),
+                                                             state_id_matrix.get(),
+                                                             width, height,
+                                                             Rectangle{ 0, y, width, 1 });
+            }
+
+            return true;
+        });
+
+        markChangedRowsDirty(*getMapData(), MapData::Layer::STATE_OUTLINES,
+                             changed_outline_rows);
+    }
+
     if(prog_opts.debug) {
         auto path = getRootParent().getDebugRoot();
         auto fname = path / "stateidmtx.txt";
@@ -427,6 +711,86 @@ void HMDT::Project::StateProject::updateStateIDMatrix() {
     WRITE_DEBUG("Done updating State ID matrix.");
 }
 
+/**
+ * @brief Updates the state ID matrix for only the given provinces.
+ * @details Only the pixels of each province are visited, and only the area
+ *          around the pixels which actually changed is marked as dirty and
+ *          has its state outlines rebuilt. Falls back to rebuilding the entire
+ *          matrix if the pixels of each province are not known.
+ *
+ * @param province_ids Every province whose state may have changed
+ */
+void HMDT::Project::StateProject::updateStateIDMatrix(const std::vector<ProvinceID>& province_ids)
+{
+    const auto& province_project = getRootParent().getMapProject().getProvinceProject();
+    const auto& provinces = province_project.getProvinces();
+    const auto& spans = province_project.getProvinceSpans();
+
+    // The spans only hold for the labels they were built from, and a new
+    //   label matrix may well have just as many provinces as the old one
+    if(spans.getLabelGeneration() != getMapData()->getLayerGeneration(MapData::Layer::LABEL_MATRIX) ||
+       spans.getProvinceCount() != provinces.size() + 1)
+    {
+        WRITE_DEBUG("Province spans are out of date, rebuilding the entire "
+                    "State ID matrix instead.");
+        updateStateIDMatrix();
+        return;
+    }
+
+    auto state_id_matrix = getMapData()->getStateIDMatrix().lock();
+    auto state_outlines = getMapData()->getStateOutlines().lock();
+    auto [width, height] = getMapData()->getDimensions();
+
+    for(auto&& province_id : province_ids) {
+        auto index = province_project.getIndexForProvinceID(province_id);
+        if(index == INVALID_PROVINCE_INDEX) {
+            WRITE_WARN("Cannot update the state of unknown province ", province_id);
+            continue;
+        }
+
+        StateID state_id = provinces.getStates()[index - 1];
+
+        // The area covering every span which changed
+        std::optional<Rectangle> changed;
+
+        for(auto&& span : spans.getSpans(index)) {
+            auto* begin = state_id_matrix.get() + static_cast<size_t>(span.y) * width + span.x;
+            auto* end = begin + span.length;
+
+            if(std::all_of(begin, end, [state_id](StateID id) { return id == state_id; }))
+            {
+                continue;
+            }
+
+            std::fill(begin, end, state_id);
+
+            Rectangle span_area{ span.x, span.y, span.length, 1 };
+            changed = changed ? uniteRectangles(*changed, span_area) : span_area;
+        }
+
+        if(changed) {
+            const auto& area = *changed;
+
+            getMapData()->markLayerDirty(MapData::Layer::STATE_ID_MATRIX, area);
+
+            // Pixels to the left of and above the changed area compare
+            //   against it, so their outlines may have changed too
+            Rectangle outline_area{ area.x > 0 ? area.x - 1 : 0,
+                                    area.y > 0 ? area.y - 1 : 0,
+                                    0, 0 };
+            outline_area.w = area.x + area.w - outline_area.x;
+            outline_area.h = area.y + area.h - outline_area.y;
+
+            if(writeStateOutlines(state_outlines.get(), state_id_matrix.get(),
+                                  width, height, outline_area))
+            {
+                getMapData()->markLayerDirty(MapData::Layer::STATE_OUTLINES,
+                                             outline_area);
+            }
+        }
+    }
+}
+
 /**
  * @brief Creates a new state composed of all provinces in province_ids.
  * @details The provinces detailed in province_ids will get removed from their
@@ -458,10 +822,22 @@ auto HMDT::Project::StateProject::addNewState(const std::vector<ProvinceID>& pro
 
     WRITE_DEBUG("Creating new state with ID ", id);
 
-    // Make sure that the provinces are decoupled from their original state
+    // Make sure that the provinces are decoupled from their original states
+    removeProvincesFromStates(province_ids);
+
+    // Every province is only listed once, in the order it was given
+    std::vector<ProvinceID> state_province_ids;
+    state_province_ids.reserve(provinces.size());
+    auto& province_list = getRootParent().getMapProject().getProvinceProject().getProvinces();
+
     for(auto&& prov : provinces) {
-        getRootParent().getMapProject().removeProvinceFromState(prov, false);
-        prov.get().state = id;
+        province_list.setState(province_list.getIndex(prov.get().id), id);
+
+        if(m_province_states.emplace(prov.get().id,
+                                     StateMembership{ id, state_province_ids.size() }).second)
+        {
+            state_province_ids.push_back(prov.get().id);
+        }
     }
 
     // Note that we default the name to 'STATE#'
@@ -473,11 +849,13 @@ auto HMDT::Project::StateProject::addNewState(const std::vector<ProvinceID>& pro
         "", /* category */
         DEFAULT_BUILDINGS_MAX_LEVEL_FACTOR, /* buildings_max_level_factor */
         false, /* impassable */
-        province_ids,
+        std::move(state_province_ids),
         generateUniqueColor(ProvinceType::UNKNOWN)
     };
 
-    updateStateIDMatrix();
+    ++m_state_color_generation;
+
+    updateStateIDMatrix(province_ids);
 
     return id;
 }
@@ -492,17 +870,30 @@ auto HMDT::Project::StateProject::removeState(StateID id) noexcept -> MaybeVoid
     MaybeRef<State> state = getStateForID(id);
     RETURN_IF_ERROR(state);
 
-    state.andThen([this](const State& state) {
+    std::vector<ProvinceID> province_ids;
+    state.andThen([this, &province_ids](const State& state) {
         // Disconnect each province from this state first
+        auto& province_list = getRootParent().getMapProject().getProvinceProject().getProvinces();
+
         for(auto&& prov_id : state.provinces) {
-            getRootParent().getMapProject().getProvinceProject().getProvinceForID(prov_id).state = -1;
+            province_list.setState(province_list.getIndex(prov_id), -1);
+
+            if(auto it = m_province_states.find(prov_id);
+                    it != m_province_states.end() && it->second.state == state.id)
+            {
+                m_province_states.erase(it);
+            }
         }
+
+        province_ids = state.provinces;
     });
 
     m_available_state_ids.push(id);
     m_states.erase(id);
 
-    updateStateIDMatrix();
+    ++m_state_color_generation;
+
+    updateStateIDMatrix(province_ids);
 
     return STATUS_SUCCESS;
 }
@@ -520,31 +911,248 @@ auto HMDT::Project::StateProject::getStateForIterator(StateMap::const_iterator c
     return cit->second;
 }
 
+/**
+ * @brief Changes the color of a state. Colors should only ever be changed
+ *        through here, so that anything drawing the states knows to redraw
+ *        them.
+ *
+ * @param state_id The state to change the color of
+ * @param color The new color
+ *
+ * @return STATUS_STATE_DOES_NOT_EXIST if there is no state with state_id
+ */
+auto HMDT::Project::StateProject::setStateColor(StateID state_id,
+                                                const Color& color)
+    -> MaybeVoid
+{
+    RETURN_ERROR_IF(!isValidStateID(state_id), STATUS_STATE_DOES_NOT_EXIST);
+
+    m_states.at(state_id).color = color;
+    ++m_state_color_generation;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Gets a number which changes every time the color of any state may
+ *        have changed.
+ *
+ * @return The current state color generation
+ */
+auto HMDT::Project::StateProject::getStateColorGeneration() const noexcept
+    -> uint64_t
+{
+    return m_state_color_generation;
+}
+
+/**
+ * @brief Adds a province to a state.
+ * @details A province can only be listed by one state, so it is removed from
+ *          any other state which lists it first. Nothing happens if the state
+ *          already lists the province.
+ *
+ * @param state_id The state to add the province to
+ * @param province_id The province to add
+ *
+ * @return STATUS_STATE_DOES_NOT_EXIST if there is no state with state_id
+ */
 auto HMDT::Project::StateProject::addProvinceToState(StateID state_id,
                                                      ProvinceID province_id)
     -> MaybeVoid
 {
-    return getStateForID(state_id).andThen([&province_id](auto state_ref)
+    RETURN_ERROR_IF(!isValidStateID(state_id), STATUS_STATE_DOES_NOT_EXIST);
+
+    if(auto it = m_province_states.find(province_id);
+            it != m_province_states.end())
     {
-        state_ref.get().provinces.push_back(province_id);
-    });
+        if(it->second.state == state_id) {
+            return STATUS_SUCCESS;
+        }
+
+        auto result = removeProvinceFromState(it->second.state, province_id);
+        RETURN_IF_ERROR(result);
+    }
+
+    auto& provinces = m_states.at(state_id).provinces;
+    m_province_states[province_id] = StateMembership{ state_id, provinces.size() };
+    provinces.push_back(province_id);
+
+    return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Removes a province from a state, keeping the order of every other
+ *        province in the state.
+ * @details The province's position is only recorded as removed, and gets
+ *          compacted away the next time the state's provinces are needed.
+ *
+ * @param state_id The state to remove the province from
+ * @param province_id The province to remove
+ *
+ * @return STATUS_STATE_DOES_NOT_EXIST if there is no state with state_id
+ */
 auto HMDT::Project::StateProject::removeProvinceFromState(StateID state_id,
                                                           ProvinceID province_id)
     -> MaybeVoid
 {
-    return getStateForID(state_id).andThen([&province_id](auto state_ref)
+    RETURN_ERROR_IF(!isValidStateID(state_id), STATUS_STATE_DOES_NOT_EXIST);
+
+    if(auto it = m_province_states.find(province_id);
+            it != m_province_states.end() && it->second.state == state_id)
     {
-        auto& state = state_ref.get();
-        for(auto it = state.provinces.begin(); it != state.provinces.end(); ++it)
+        m_removed_positions[state_id].push_back(it->second.position);
+        m_province_states.erase(it);
+    } else {
+        // The index only remembers the first state listing a province, so
+        //   any other state which also lists it has to be searched
+        auto& state = m_states.at(state_id);
+        compactState(state);
+
+        auto& provinces = state.provinces;
+        if(auto pit = std::find(provinces.begin(), provinces.end(), province_id);
+                pit != provinces.end())
         {
-            if(*it == province_id) {
-                state.provinces.erase(it);
-                break;
+            m_removed_positions[state_id].push_back(pit - provinces.begin());
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Removes many provinces from whichever states list them, keeping the
+ *        order of the remaining provinces.
+ *
+ * @param province_ids The provinces to remove
+ */
+void HMDT::Project::StateProject::removeProvincesFromStates(const std::vector<ProvinceID>& province_ids)
+{
+    for(auto&& province_id : province_ids) {
+        if(auto it = m_province_states.find(province_id);
+                it != m_province_states.end())
+        {
+            m_removed_positions[it->second.state].push_back(it->second.position);
+            m_province_states.erase(it);
+        }
+    }
+}
+
+/**
+ * @brief Compacts away every removed position of a state, keeping the order
+ *        of its remaining provinces.
+ * @details Every state is only walked over once, no matter how many of its
+ *          provinces were removed since it was last compacted.
+ *
+ * @param state The state to compact
+ */
+void HMDT::Project::StateProject::compactState(State& state) const {
+    auto removed_it = m_removed_positions.find(state.id);
+    if(removed_it == m_removed_positions.end()) return;
+
+    auto& removed = removed_it->second;
+    std::sort(removed.begin(), removed.end());
+
+    auto& provinces = state.provinces;
+    auto next_removed = removed.begin();
+
+    size_t kept = 0;
+    for(size_t position = 0; position < provinces.size(); ++position) {
+        if(next_removed != removed.end() && *next_removed == position) {
+            next_removed = std::upper_bound(next_removed, removed.end(),
+                                            position);
+            continue;
+        }
+
+        if(kept != position) {
+            provinces[kept] = provinces[position];
+
+            if(auto it = m_province_states.find(provinces[kept]);
+                    it != m_province_states.end() &&
+                    it->second.state == state.id &&
+                    it->second.position == position)
+            {
+                it->second.position = kept;
             }
         }
-    });
+
+        ++kept;
+    }
+
+    provinces.resize(kept);
+    m_removed_positions.erase(removed_it);
+}
+
+/**
+ * @brief Compacts away the removed positions of every state.
+ */
+void HMDT::Project::StateProject::compactStates() const {
+    while(!m_removed_positions.empty()) {
+        auto state_id = m_removed_positions.begin()->first;
+
+        if(auto it = m_states.find(state_id); it != m_states.end()) {
+            compactState(it->second);
+        } else {
+            m_removed_positions.erase(state_id);
+        }
+    }
+}
+
+/**
+ * @brief Gets the state which lists a province.
+ *
+ * @param province_id The province to look up
+ *
+ * @return The ID of the state, or STATUS_VALUE_NOT_FOUND if no state lists the
+ *         province
+ */
+auto HMDT::Project::StateProject::getStateIDForProvince(const ProvinceID& province_id) const noexcept
+    -> Maybe<StateID>
+{
+    if(auto it = m_province_states.find(province_id);
+            it != m_province_states.end())
+    {
+        return it->second.state;
+    }
+
+    return STATUS_VALUE_NOT_FOUND;
+}
+
+bool HMDT::Project::StateProject::isProvinceInState(StateID state_id,
+                                                    const ProvinceID& province_id) const noexcept
+{
+    auto it = m_province_states.find(province_id);
+
+    return it != m_province_states.end() && it->second.state == state_id;
+}
+
+/**
+ * @brief Rebuilds which state lists each province from every state.
+ */
+void HMDT::Project::StateProject::rebuildProvinceStateIndex() {
+    compactStates();
+
+    m_province_states.clear();
+
+    for(auto&& [state_id, state] : m_states) {
+        auto& provinces = state.provinces;
+
+        size_t kept = 0;
+        for(auto&& province_id : provinces) {
+            auto [it, inserted] = m_province_states.emplace(province_id,
+                                                            StateMembership{ state_id, kept });
+
+            // A state listing the same province twice only keeps the first
+            if(!inserted && it->second.state == state_id) {
+                WRITE_WARN("State ", state_id, " lists province ", province_id,
+                           " more than once.");
+                continue;
+            }
+
+            provinces[kept++] = province_id;
+        }
+
+        provinces.resize(kept);
+    }
 }
 
 /**
@@ -586,6 +1194,8 @@ auto HMDT::Project::StateProject::visitStates(const std::function<MaybeVoid(std:
 {
     auto states_group_node = std::make_shared<Hierarchy::GroupNode>(Hierarchy::GroupKeys::STATES);
 
+    compactStates();
+
     const auto& children = states_group_node->getChildren();
     for(auto&& [id, state] : m_states) {
         auto state_node = std::make_shared<Hierarchy::StateNode>(state.name);
@@ -647,3 +1257,23 @@ auto HMDT::Project::StateProject::visitStates(const std::function<MaybeVoid(std:
     return states_group_node;
 }
 
+
+/**
+ * @brief Reports how much memory is used by the states.
+ *
+ * @param report The report to add this project's memory usage to
+ */
+void HMDT::Project::StateProject::reportMemoryUsage(MemoryReport& report) const noexcept
+{
+    uint64_t bytes = estimateMemoryUsage(m_states) +
+                     estimateMemoryUsage(m_province_states) +
+                     m_available_state_ids.size() * sizeof(StateID);
+
+    for(auto&& [_, state] : m_states) {
+        bytes += estimateMemoryUsage(state.provinces);
+        bytes += state.name.capacity() + state.category.capacity();
+    }
+
+    report.addChild("States Project (" + std::to_string(m_states.size()) + ")",
+                    bytes);
+}
@@ -17,6 +17,7 @@
 # define PROVINCE_MAP_BUILDER
 
 # include "Types.h"
+# include "ProvinceList.h"
 
 namespace HMDT {
     /**
@@ -77,12 +77,12 @@ uint32_t HMDT::ShapeFinder::pass1() {
     uint32_t width = m_image->info_header.width;
     uint32_t height = m_image->info_header.height;
 
-    UUID next_label;
+    // Label 0 is reserved for borders
+    uint32_t next_label = 1;
 
     uint32_t num_border_pixels = 0;
 
     auto label_matrix = m_map_data->getLabelMatrix().lock();
-    auto prov_matrix = m_map_data->getProvinces().lock();
 
     WRITE_INFO("Performing Pass #1 of CCL.");
 
@@ -96,8 +96,7 @@ uint32_t HMDT::ShapeFinder::pass1() {
             Color color = getColorAt(m_image, x, y);
             uint32_t index = xyToIndex(m_image, x, y);
 
-            UUID& label = prov_matrix[index] = next_label;
-            label_matrix[index] = label.hash();
+            uint32_t& label = label_matrix[index] = next_label;
 
             // Skip this pixel if it is part of a border
             if(color == BORDER_COLOR) {
@@ -112,8 +111,8 @@ uint32_t HMDT::ShapeFinder::pass1() {
             MonadOptional<Point2D> up = getAdjacentPoint(Point2D{x, y},
                                                          Direction::UP);
 
-            UUID label_left = EMPTY_UUID;
-            UUID label_up = EMPTY_UUID;
+            uint32_t label_left = 0;
+            uint32_t label_up = 0;
 
             Color color_left = BORDER_COLOR;
             Color color_up = BORDER_COLOR;
@@ -143,20 +142,20 @@ uint32_t HMDT::ShapeFinder::pass1() {
                     //   smaller one and mark the larger one as a child
                     if(label != label_up) {
                         // NOTE! We have to make copies here rather than
-                        //  references because otherwise smaller_uuid can become
-                        //  equal to larger_uuid (due to the fact that we
-                        //  overwrite and re-use 'label' further down), which
+                        //  references because otherwise smaller_label can
+                        //  become equal to larger_label (due to the fact that
+                        //  we overwrite and re-use 'label' further down), which
                         //  means we can get into a situation where
                         //  label_parents ends up mapping a label to itself,
                         //  resulting in an infinite loop in getRootLabel.
-                        UUID smaller_uuid = std::min(label, label_up);
-                        UUID larger_uuid = std::max(label, label_up);
+                        uint32_t smaller_label = std::min(label, label_up);
+                        uint32_t larger_label = std::max(label, label_up);
 
-                        label = getRootLabel(smaller_uuid);
+                        label = getRootLabel(smaller_label);
 
                         // Mark who the parent of the label is
                         // TODO: Do we have to worry about if the label already has a parent?
-                        m_label_parents[larger_uuid] = smaller_uuid;
+                        m_label_parents[larger_label] = smaller_label;
                     }
                 } else {
                     label = label_up;
@@ -165,7 +164,7 @@ uint32_t HMDT::ShapeFinder::pass1() {
 
             // Only increment to the next label if we actually used this one
             if(label == next_label) {
-                next_label = UUID();
+                ++next_label;
             }
 
             if(m_label_to_color.count(label) == 0)
@@ -195,7 +194,6 @@ auto HMDT::ShapeFinder::pass2(LabelShapeIdxMap& label_to_shapeidx)
     uint32_t height = m_image->info_header.height;
 
     auto label_matrix = m_map_data->getLabelMatrix().lock();
-    auto prov_matrix = m_map_data->getProvinces().lock();
 
     m_shapes.clear();
 
@@ -209,7 +207,7 @@ auto HMDT::ShapeFinder::pass2(LabelShapeIdxMap& label_to_shapeidx)
             }
 
             uint32_t index = xyToIndex(m_image, x, y);
-            UUID& label = prov_matrix[index];
+            uint32_t& label = label_matrix[index];
             Color color = getColorAt(m_image, x, y);
             Point2D point{x, y};
 
@@ -252,7 +250,6 @@ bool HMDT::ShapeFinder::mergeBorders(PolygonList& shapes,
     uint32_t height = m_image->info_header.height;
 
     auto label_matrix = m_map_data->getLabelMatrix().lock();
-    auto prov_matrix = m_map_data->getProvinces().lock();
 
     if(!prog_opts.quiet)
         WRITE_INFO("Performing Pass #3 of CCL.");
@@ -317,14 +314,13 @@ bool HMDT::ShapeFinder::mergeBorders(PolygonList& shapes,
         }
 
         uint32_t index = xyToIndex(m_image, merge_with.x, merge_with.y);
-        const UUID& label = prov_matrix[index];
+        uint32_t label = label_matrix[index];
 
         Polygon& shape = shapes[label_to_shapeidx.at(label)];
 
         addPixelToShape(shape, pixel);
 
-        prov_matrix[xyToIndex(m_image, x, y)] = label;
-        label_matrix[xyToIndex(m_image, x, y)] = label.hash();
+        label_matrix[xyToIndex(m_image, x, y)] = label;
 
         m_worker.writeDebugColor(x, y, shape.unique_color);
     }
@@ -359,7 +355,7 @@ const HMDT::PolygonList& HMDT::ShapeFinder::findAllShapes() {
     m_stage = Stage::OUTPUT_PASS1;
 
     if(prog_opts.output_stages) {
-        m_label_to_color[EMPTY_UUID] = BORDER_COLOR;
+        m_label_to_color[0] = BORDER_COLOR;
         m_worker.updateCallback({0, 0, 0, 0});
         outputStage("labels1.bmp");
         if(m_do_estop) {
@@ -516,10 +512,9 @@ void HMDT::ShapeFinder::outputStage(const std::filesystem::path& filename) {
     unsigned char* label_data = new unsigned char[m_map_data->getMatrixSize() * 3];
 
     auto label_matrix = m_map_data->getLabelMatrix().lock();
-    auto prov_matrix = m_map_data->getProvinces().lock();
 
     for(uint32_t i = 0; i < m_map_data->getMatrixSize(); ++i) {
-        const UUID& label = prov_matrix[i];
+        uint32_t label = label_matrix[i];
         const HMDT::Color& c = m_label_to_color[label];
         label_data[i * 3] = c.b;
         label_data[(i * 3) + 1] = c.g;
@@ -542,16 +537,16 @@ void HMDT::ShapeFinder::outputStage(const std::filesystem::path& filename) {
  */
 auto HMDT::ShapeFinder::getLabelAndColor(const Point2D& point,
                                          const Color& color)
-    -> std::pair<UUID, Color>
+    -> std::pair<uint32_t, Color>
 {
-    UUID label = m_map_data->getProvinces().lock()[xyToIndex(m_image, point.x, point.y)];
+    uint32_t label = m_map_data->getLabelMatrix().lock()[xyToIndex(m_image, point.x, point.y)];
     Color color_at = getColorAt(m_image, point.x, point.y);
 
     if(color_at != BORDER_COLOR && color_at != color) {
         WRITE_WARN("Multiple colors found in shape! See pixel at ", point);
 
         // Set to the default values
-        label = EMPTY_UUID;
+        label = 0;
         color_at = BORDER_COLOR;
     }
 
@@ -565,8 +560,8 @@ auto HMDT::ShapeFinder::getLabelAndColor(const Point2D& point,
  *
  * @return The root of label
  */
-HMDT::UUID HMDT::ShapeFinder::getRootLabel(const UUID& label) const noexcept {
-    UUID root = label;
+uint32_t HMDT::ShapeFinder::getRootLabel(uint32_t label) const noexcept {
+    uint32_t root = label;
 
     while(m_label_parents.count(root) != 0) {
         root = m_label_parents.at(root);
@@ -683,7 +678,7 @@ auto HMDT::ShapeFinder::getAdjacentPixel(const Dimensions& dimensions,
  * @param shapes The list of shapes
  * @param label_to_shapeidx The mapping of labels to their corresponding shapes
  */
-void HMDT::ShapeFinder::buildShape(const UUID& label, const Pixel& pixel,
+void HMDT::ShapeFinder::buildShape(uint32_t label, const Pixel& pixel,
                                    PolygonList& shapes,
                                    LabelShapeIdxMap& label_to_shapeidx)
 {
@@ -697,8 +692,10 @@ void HMDT::ShapeFinder::buildShape(const UUID& label, const Pixel& pixel,
         auto prov_type = getProvinceType(pixel.color);
         auto unique_color = generateUniqueColor(prov_type);
 
+        // Every shape gets a brand new ID, as labels are only meaningful
+        //  while shapes are still being found
         shapes.push_back(Polygon{
-            label,
+            UUID(),
             { },
             pixel.color,
             unique_color,
@@ -723,8 +720,8 @@ void HMDT::ShapeFinder::buildShape(const UUID& label, const Pixel& pixel,
  * @return True if the point is adjacent to any other point, false otherwise
  */
 bool HMDT::ShapeFinder::calculateAdjacency(const BitMap* image,
-                                           const ProvinceID* label_matrix,
-                                           std::set<ProvinceID>& adjacency_list,
+                                           const uint32_t* label_matrix,
+                                           std::set<uint32_t>& adjacency_list,
                                            const Point2D& point)
 {
     return calculateAdjacency({static_cast<uint32_t>(image->info_header.width),
@@ -744,8 +741,8 @@ bool HMDT::ShapeFinder::calculateAdjacency(const BitMap* image,
  */
 bool HMDT::ShapeFinder::calculateAdjacency(const Dimensions& dimensions,
                                            const uint8_t* data,
-                                           const ProvinceID* label_matrix,
-                                           std::set<ProvinceID>& adjacency_list,
+                                           const uint32_t* label_matrix,
+                                           std::set<uint32_t>& adjacency_list,
                                            const Point2D& point)
 {
     bool is_adjacent = false;
@@ -836,13 +833,22 @@ auto HMDT::ShapeFinder::getShapes() const -> const PolygonList& {
 }
 
 void HMDT::ShapeFinder::calculateAdjacencies(PolygonList& shapes) const {
-    auto prov_matrix = m_map_data->getProvinces().lock();
+    auto label_matrix = m_map_data->getLabelMatrix().lock();
 
     for(Polygon& shape : shapes) {
+        std::set<uint32_t> adjacent_labels;
+
         for(auto&& pixel : shape.pixels) {
-            calculateAdjacency(m_image, prov_matrix.get(), shape.adjacent_labels,
+            calculateAdjacency(m_image, label_matrix.get(), adjacent_labels,
                                pixel.point);
         }
+
+        // By now every label is the (1-based) index of its shape
+        for(auto&& label : adjacent_labels) {
+            if(label != 0 && label <= shapes.size()) {
+                shape.adjacent_labels.insert(shapes[label - 1].id);
+            }
+        }
     }
 }
 
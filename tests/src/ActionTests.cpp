@@ -1,12 +1,18 @@
 
 #include "ActionTests.h"
 
+#include <algorithm>
+
 #include "gtest/gtest.h"
 
 #include "IAction.h"
 #include "ActionManager.h"
 
 #include "SetPropertyAction.h"
+#include "LayerEditAction.h"
+
+#include "MapData.h"
+#include "TiledLayer.h"
 
 namespace HMDT::UnitTests {
     void ActionTests::SetUp() { }
@@ -179,5 +185,41 @@ namespace HMDT::UnitTests {
         ASSERT_EQ(s1.b, 'a');
         ASSERT_EQ(s1.c, 3.1415f);
     }
-}
 
+    TEST_F(ActionTests, LayerEditActionTests) {
+        using Layer = MapData::Layer;
+        constexpr auto TILE_SIZE = TiledLayer::TILE_SIZE;
+
+        auto map_data = std::make_shared<MapData>(TILE_SIZE * 2, TILE_SIZE * 2);
+        {
+            auto heightmap = map_data->getHeightMap().lock();
+            std::fill(heightmap.get(), heightmap.get() + map_data->getHeightMapSize(), 1);
+        }
+
+        // Edit a single pixel in the bottom-right tile
+        Rectangle area{ TILE_SIZE + 5, TILE_SIZE + 5, 1, 1 };
+        auto index = area.y * map_data->getWidth() + area.x;
+
+        ASSERT_TRUE(Action::ActionManager::getInstance().doAction(
+                    new Action::LayerEditAction(map_data, Layer::HEIGHTMAP, area,
+                        [index](MapData& map_data) {
+                            map_data.getHeightMap().lock()[index] = 99;
+                            return true;
+                        })));
+        ASSERT_EQ(map_data->getHeightMap().lock()[index], 99);
+
+        // Undoing and redoing only writes back the edited tile
+        auto generation = map_data->getLayerGeneration(Layer::HEIGHTMAP);
+        ASSERT_TRUE(Action::ActionManager::getInstance().undoAction());
+        ASSERT_EQ(map_data->getHeightMap().lock()[index], 1);
+        ASSERT_EQ(map_data->getLayerChangesSince(Layer::HEIGHTMAP, generation)->size(), 1);
+
+        ASSERT_TRUE(Action::ActionManager::getInstance().redoAction());
+        ASSERT_EQ(map_data->getHeightMap().lock()[index], 99);
+
+        // Every other pixel must have been left alone
+        auto heightmap = map_data->getHeightMap().lock();
+        ASSERT_EQ(std::count(heightmap.get(), heightmap.get() + map_data->getHeightMapSize(), 1),
+                  map_data->getHeightMapSize() - 1);
+    }
+}
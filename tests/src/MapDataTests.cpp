@@ -0,0 +1,315 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "MapData.h"
+#include "Constants.h"
+
+#include "TestOverrides.h"
+#include "TestUtils.h"
+
+TEST(MapDataTests, LayersAreLazilyAllocated) {
+    using Layer = HMDT::MapData::Layer;
+
+    SET_PROGRAM_OPTION(quiet, true);
+
+    HMDT::MapData map_data(16, 8);
+
+    ASSERT_FALSE(map_data.isLayerResident(Layer::HEIGHTMAP));
+    ASSERT_FALSE(map_data.isLayerResident(Layer::RIVERS));
+
+    auto heightmap = map_data.getHeightMap().lock();
+    ASSERT_NE(heightmap, nullptr);
+    ASSERT_TRUE(map_data.isLayerResident(Layer::HEIGHTMAP));
+    ASSERT_FALSE(map_data.isLayerResident(Layer::RIVERS));
+
+    // Newly allocated layers must be zeroed out
+    for(auto i = 0U; i < map_data.getHeightMapSize(); ++i) {
+        ASSERT_EQ(heightmap[i], 0);
+    }
+}
+
+TEST(MapDataTests, LayerLoaderIsCalledOnFirstAccess) {
+    using Layer = HMDT::MapData::Layer;
+
+    SET_PROGRAM_OPTION(quiet, true);
+
+    HMDT::MapData map_data(16, 8);
+
+    uint32_t times_loaded = 0;
+    uint32_t times_released = 0;
+    map_data.setLayerLoader(Layer::RIVERS, [&map_data, &times_loaded]() {
+        ++times_loaded;
+
+        auto rivers = map_data.getRivers().lock();
+        std::fill(rivers.get(), rivers.get() + map_data.getRiversSize(), 7);
+    }, [&times_released]() {
+        ++times_released;
+    });
+
+    ASSERT_EQ(times_loaded, 0);
+
+    {
+        auto rivers = map_data.getRivers().lock();
+        ASSERT_EQ(times_loaded, 1);
+        ASSERT_EQ(rivers[0], 7);
+        ASSERT_EQ(rivers[map_data.getRiversSize() - 1], 7);
+
+        // Layer is still held, so it should not get released
+        ASSERT_EQ(map_data.releaseUnusedLayers(), 0);
+        ASSERT_TRUE(map_data.isLayerResident(Layer::RIVERS));
+    }
+
+    // Layers without a loader cannot be released, as they cannot be restored
+    map_data.getHeightMap();
+
+    // Leased layers are not released, even if nothing has them locked
+    {
+        auto lease = map_data.leaseLayer(Layer::RIVERS);
+        ASSERT_TRUE(lease);
+
+        ASSERT_EQ(map_data.releaseUnusedLayers(), 0);
+        ASSERT_TRUE(map_data.isLayerResident(Layer::RIVERS));
+    }
+    ASSERT_EQ(times_released, 0);
+
+    ASSERT_EQ(map_data.releaseUnusedLayers(), map_data.getRiversSize());
+    ASSERT_FALSE(map_data.isLayerResident(Layer::RIVERS));
+    ASSERT_TRUE(map_data.isLayerResident(Layer::HEIGHTMAP));
+    ASSERT_EQ(times_released, 1);
+
+    // Accessing it again should load it back up
+    auto rivers = map_data.getRivers().lock();
+    ASSERT_EQ(times_loaded, 2);
+    ASSERT_EQ(rivers[0], 7);
+}
+
+TEST(MapDataTests, LayerLoaderRunsOnceOutsideOfTheLock) {
+    using Layer = HMDT::MapData::Layer;
+
+    SET_PROGRAM_OPTION(quiet, true);
+
+    HMDT::MapData map_data(16, 8);
+
+    std::atomic<uint32_t> times_loaded = 0;
+    map_data.setLayerLoader(Layer::HEIGHTMAP, [&map_data, &times_loaded]() {
+        ++times_loaded;
+
+        // Another thread must be able to use MapData while the loader runs
+        std::thread([&map_data]() {
+            map_data.getRivers();
+        }).join();
+
+        auto heightmap = map_data.getHeightMap().lock();
+        std::fill(heightmap.get(), heightmap.get() + map_data.getHeightMapSize(), 3);
+    });
+
+    // Every thread must wait for the one load, and see its result
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> times_seen_loaded = 0;
+    for(auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&map_data, &times_seen_loaded]() {
+            auto heightmap = map_data.getHeightMap().lock();
+            if(heightmap[map_data.getHeightMapSize() - 1] == 3) {
+                ++times_seen_loaded;
+            }
+        });
+    }
+
+    for(auto&& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(times_loaded, 1);
+    ASSERT_EQ(times_seen_loaded, 4);
+    ASSERT_TRUE(map_data.isLayerResident(Layer::RIVERS));
+}
+
+TEST(MapDataTests, TiledLayerCopyOnWrite) {
+    constexpr auto TILE_SIZE = HMDT::TiledLayer::TILE_SIZE;
+
+    // 2x2 tiles, with the right and bottom tiles being partial
+    HMDT::TiledLayer layer(TILE_SIZE + 10, TILE_SIZE + 5, 2);
+
+    ASSERT_EQ(layer.getTileCount(), 4);
+    ASSERT_EQ(layer.getTileRect(3).w, 10);
+    ASSERT_EQ(layer.getTileRect(3).h, 5);
+
+    // Untouched tiles are never allocated
+    ASSERT_EQ(layer.getAllocatedBytes(), 0);
+    ASSERT_EQ(layer.getTile(0), nullptr);
+
+    layer.getMutableTile(1)[0] = 42;
+    ASSERT_EQ(layer.getAllocatedBytes(), layer.getTileByteSize(1));
+    ASSERT_TRUE(layer.isTileDirty(1));
+
+    // Copies share every tile until one of them writes to it
+    HMDT::TiledLayer copy = layer;
+    ASSERT_TRUE(copy.sharesTileWith(layer, 1));
+    ASSERT_TRUE(layer.isTileShared(1));
+
+    copy.getMutableTile(1)[0] = 7;
+    ASSERT_FALSE(copy.sharesTileWith(layer, 1));
+    ASSERT_EQ(layer.getTile(1)[0], 42);
+    ASSERT_EQ(copy.getTile(1)[0], 7);
+}
+
+TEST(MapDataTests, SnapshotOnlyCopiesChangedTiles) {
+    using Layer = HMDT::MapData::Layer;
+    constexpr auto TILE_SIZE = HMDT::TiledLayer::TILE_SIZE;
+
+    SET_PROGRAM_OPTION(quiet, true);
+
+    HMDT::MapData map_data(TILE_SIZE * 2, TILE_SIZE * 2);
+
+    {
+        auto heightmap = map_data.getHeightMap().lock();
+        std::fill(heightmap.get(), heightmap.get() + map_data.getHeightMapSize(), 1);
+    }
+    map_data.markLayerDirty(Layer::HEIGHTMAP);
+
+    auto first = map_data.snapshotLayer(Layer::HEIGHTMAP);
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(first->getDirtyTiles().size(), 4);
+
+    // Nothing has been touched since the last snapshot
+    ASSERT_TRUE(map_data.snapshotLayer(Layer::HEIGHTMAP)->getDirtyTiles().empty());
+
+    // Change a single pixel in the bottom-right tile
+    map_data.getHeightMap().lock()[map_data.getHeightMapSize() - 1] = 99;
+    map_data.markLayerDirty(Layer::HEIGHTMAP,
+                            HMDT::Rectangle{ TILE_SIZE * 2 - 1, TILE_SIZE * 2 - 1, 1, 1 });
+
+    auto second = map_data.snapshotLayer(Layer::HEIGHTMAP);
+    ASSERT_EQ(second->getDirtyTiles(), std::vector<uint32_t>{ 3 });
+    ASSERT_EQ(second->getAllocatedBytes(), second->getTileByteSize(3));
+
+    // Restoring the first snapshot should undo the change, and marks every
+    //  tile it wrote back as dirty again
+    ASSERT_TRUE(map_data.restoreLayer(Layer::HEIGHTMAP, *first));
+    ASSERT_EQ(map_data.getHeightMap().lock()[map_data.getHeightMapSize() - 1], 1);
+    ASSERT_EQ(map_data.snapshotLayer(Layer::HEIGHTMAP)->getDirtyTiles().size(), 4);
+
+    // Restoring the second snapshot only writes back the bottom-right tile
+    auto generation = map_data.getLayerGeneration(Layer::HEIGHTMAP);
+    ASSERT_TRUE(map_data.restoreLayer(Layer::HEIGHTMAP, *second));
+    ASSERT_EQ(map_data.getHeightMap().lock()[map_data.getHeightMapSize() - 1], 99);
+
+    auto changes = map_data.getLayerChangesSince(Layer::HEIGHTMAP, generation);
+    ASSERT_TRUE(changes.has_value());
+    ASSERT_EQ(changes->size(), 1);
+    ASSERT_EQ(changes->front().x, TILE_SIZE);
+    ASSERT_EQ(changes->front().y, TILE_SIZE);
+
+    // Area snapshots hold every tile overlapping the area, and leave the dirty
+    //  tiles alone
+    auto area = map_data.snapshotLayer(Layer::HEIGHTMAP,
+                                       HMDT::Rectangle{ TILE_SIZE - 1, 0, 2, 1 });
+    ASSERT_EQ(area->getDirtyTiles(), (std::vector<uint32_t>{ 0, 1 }));
+    ASSERT_EQ(map_data.snapshotLayer(Layer::HEIGHTMAP)->getDirtyTiles(),
+              std::vector<uint32_t>{ 3 });
+
+    // Snapshots of the wrong layer type cannot be restored
+    ASSERT_FALSE(map_data.restoreLayer(Layer::LABEL_MATRIX, *first));
+}
+
+TEST(MapDataTests, LayerChangesAreTrackedPerGeneration) {
+    using Layer = HMDT::MapData::Layer;
+
+    SET_PROGRAM_OPTION(quiet, true);
+
+    HMDT::MapData map_data(64, 32);
+
+    auto start = map_data.getLayerGeneration(Layer::RIVERS);
+
+    // Nothing has changed yet
+    auto changes = map_data.getLayerChangesSince(Layer::RIVERS, start);
+    ASSERT_TRUE(changes.has_value());
+    ASSERT_TRUE(changes->empty());
+
+    map_data.markLayerDirty(Layer::RIVERS, HMDT::Rectangle{ 4, 4, 8, 8 });
+    map_data.markLayerDirty(Layer::RIVERS, HMDT::Rectangle{ 60, 30, 10, 10 });
+
+    // Other layers are unaffected
+    ASSERT_EQ(map_data.getLayerGeneration(Layer::HEIGHTMAP), 0);
+    ASSERT_EQ(map_data.getLayerGeneration(Layer::RIVERS), start + 2);
+
+    changes = map_data.getLayerChangesSince(Layer::RIVERS, start);
+    ASSERT_TRUE(changes.has_value());
+    ASSERT_EQ(changes->size(), 2);
+
+    // Changes get clamped to the map
+    ASSERT_EQ((*changes)[1].w, 4);
+    ASSERT_EQ((*changes)[1].h, 2);
+
+    // Only changes after the given generation are reported
+    changes = map_data.getLayerChangesSince(Layer::RIVERS, start + 1);
+    ASSERT_EQ(changes->size(), 1);
+    ASSERT_EQ((*changes)[0].x, 60);
+
+    // Readers that fall too far behind must refresh the whole layer
+    for(auto i = 0U; i <= HMDT::MAX_LAYER_CHANGE_HISTORY; ++i) {
+        map_data.markLayerDirty(Layer::RIVERS, HMDT::Rectangle{ 0, 0, 1, 1 });
+    }
+    ASSERT_FALSE(map_data.getLayerChangesSince(Layer::RIVERS, start).has_value());
+
+    // Marking the whole layer dirty reports the entire map as changed
+    auto before_full = map_data.getLayerGeneration(Layer::RIVERS);
+    map_data.markLayerDirty(Layer::RIVERS);
+
+    changes = map_data.getLayerChangesSince(Layer::RIVERS, before_full);
+    ASSERT_TRUE(changes.has_value());
+    ASSERT_EQ(changes->size(), 1);
+    ASSERT_EQ((*changes)[0].w, map_data.getWidth());
+    ASSERT_EQ((*changes)[0].h, map_data.getHeight());
+}
+
+TEST(MapDataTests, MemoryReportCountsResidentLayers) {
+    using Layer = HMDT::MapData::Layer;
+
+    SET_PROGRAM_OPTION(quiet, true);
+
+    HMDT::MapData map_data(64, 32);
+
+    // Nothing has been allocated yet
+    {
+        HMDT::MemoryReport report("Map Data");
+        map_data.reportMemoryUsage(report);
+
+        ASSERT_EQ(report.getTotalBytes(), 0);
+    }
+
+    // Allocate a single layer
+    auto rivers = map_data.getRivers().lock();
+    auto label_matrix = map_data.getLabelMatrix().lock();
+
+    HMDT::MemoryReport report("Map Data");
+    map_data.reportMemoryUsage(report);
+
+    ASSERT_EQ(report.getTotalBytes(), 64 * 32 * (1 + sizeof(uint32_t)));
+
+    // Every layer gets reported, even when it is not resident
+    const auto& layers = report.getChildren().front();
+    ASSERT_EQ(layers.getName(), "Layers");
+    ASSERT_EQ(layers.getChildren().size(), static_cast<size_t>(Layer::COUNT));
+
+    for(auto&& child : layers.getChildren()) {
+        if(child.getName() == HMDT::MapData::getLayerName(Layer::RIVERS)) {
+            ASSERT_EQ(child.getBytes(), 64 * 32);
+        } else if(child.getName() == HMDT::MapData::getLayerName(Layer::LABEL_MATRIX)) {
+            ASSERT_EQ(child.getBytes(), 64 * 32 * sizeof(uint32_t));
+        } else {
+            ASSERT_EQ(child.getBytes(), 0);
+        }
+    }
+
+    // Warnings are collected from every child
+    report.addChild("Cache").addWarning("too large");
+    ASSERT_EQ(report.getAllWarnings().size(), 1);
+    ASSERT_EQ(report.getAllWarnings().front(), "Cache: too large");
+
+    ASSERT_EQ(HMDT::formatByteSize(512), "512 B");
+    ASSERT_EQ(HMDT::formatByteSize(1536), "1.50 KiB");
+}
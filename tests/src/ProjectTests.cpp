@@ -2,9 +2,11 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <cstring>
 #include <fstream>
+#include <map>
 #include <stack>
 #include <vector>
 
@@ -16,6 +18,8 @@
 #include "Util.h"
 #include "ProjectNode.h"
 #include "LinkNode.h"
+#include "WorldNormalBuilder.h"
+#include "HeightMapPyramid.h"
 
 #include "TestUtils.h"
 #include "TestMocks.h"
@@ -476,17 +480,23 @@ TEST(ProjectTests, ProvinceProjectSaveAndLoad) {
 
     // Save a copy of the map data here before loading so we can compare against
     //   it
-    std::unique_ptr<HMDT::UUID[]> prov_data(new HMDT::UUID[map_data->getProvincesSize()]{ HMDT::EMPTY_UUID });
-    std::memcpy(prov_data.get(),
-                map_data->getProvinces().lock().get(),
-                map_data->getProvincesSize() * sizeof(HMDT::UUID));
+    std::vector<HMDT::UUID> prov_data(map_data->getMatrixSize(), HMDT::EMPTY_UUID);
+    {
+        auto label_matrix = map_data->getLabelMatrix().lock();
+        std::transform(label_matrix.get(),
+                       label_matrix.get() + map_data->getMatrixSize(),
+                       prov_data.begin(),
+                       [&prov_project](HMDT::ProvinceIndex label) {
+                           return prov_project.getProvinceIDForIndex(label);
+                       });
+    }
 
     // Load in the saved province data manually and verify that it matches what
     //   we initially saved
     WRITE_INFO("Reading saved province data from ",
                prov_path / HMDT::SHAPEDATA_FILENAME);
     if(std::ifstream in(prov_path / HMDT::SHAPEDATA_FILENAME); in) {
-        std::unique_ptr<HMDT::UUID[]> temp_data(new HMDT::UUID[map_data->getProvincesSize()]{ HMDT::EMPTY_UUID });
+        std::vector<HMDT::UUID> temp_data(map_data->getMatrixSize(), HMDT::EMPTY_UUID);
 
         unsigned char magic[4];
         uint32_t width = 0;
@@ -503,12 +513,12 @@ TEST(ProjectTests, ProvinceProjectSaveAndLoad) {
         // Verify that the dimensions match
         ASSERT_EQ(width * height, map_data->getMatrixSize());
 
-        in.read(reinterpret_cast<char*>(temp_data.get()),
-                map_data->getProvincesSize() * sizeof(HMDT::UUID));
+        in.read(reinterpret_cast<char*>(temp_data.data()),
+                map_data->getMatrixSize() * sizeof(HMDT::UUID));
 
-        ASSERT_TRUE(HMDT::UnitTests::dynamicArraysMatch(prov_data.get(),
-                                                        temp_data.get(),
-                                                        map_data->getProvincesSize()));
+        ASSERT_TRUE(HMDT::UnitTests::dynamicArraysMatch(prov_data.data(),
+                                                        temp_data.data(),
+                                                        map_data->getMatrixSize()));
     } else {
         WRITE_ERROR("Failed to load province data.");
         ASSERT_TRUE(false);
@@ -519,9 +529,18 @@ TEST(ProjectTests, ProvinceProjectSaveAndLoad) {
     ASSERT_SUCCEEDED(result);
 
     // Verify that the loaded province data matchces what was saved to disk
-    ASSERT_TRUE(std::equal(prov_data.get(),
-                           prov_data.get() + map_data->getProvincesSize(),
-                           map_data->getProvinces().lock().get()));
+    //   (the indices may have been reassigned, but every pixel must still
+    //   belong to the same province)
+    {
+        auto label_matrix = map_data->getLabelMatrix().lock();
+        ASSERT_TRUE(std::equal(prov_data.begin(), prov_data.end(),
+                               label_matrix.get(),
+                               [&prov_project](const HMDT::UUID& id,
+                                               HMDT::ProvinceIndex label)
+                               {
+                                   return id == prov_project.getProvinceIDForIndex(label);
+                               }));
+    }
 
     ::Log::Logger::getInstance().reset();
 }
@@ -590,6 +609,20 @@ TEST(ProjectTests, MergeProvinceTests) {
     WRITE_DEBUG("prov1.id=", prov1.id, ", prov1.parent_id=", prov1.parent_id,
                 ", prov2.id=", prov2.id, ", prov2.parent_id=", prov2.parent_id);
 
+    // Outlines are drawn around every single province, so merging must never
+    //   change them
+    auto [width, height] = map_data->getDimensions();
+    auto outlines = map_data->getProvinceOutlines().lock();
+    ASSERT_NE(outlines, nullptr);
+    std::vector<unsigned char> outlines_before(outlines.get(),
+                                               outlines.get() + static_cast<size_t>(width) * height * 4);
+
+    // Every merge and unmerge should say which provinces it affected
+    std::vector<HMDT::Project::IProvinceProject::MergeEvent> merge_events;
+    prov_project.addMergeListener([&merge_events](const auto& event) {
+        merge_events.push_back(event);
+    });
+
     // Attempt to merge two unrelated provinces together
     auto result = prov_project.mergeProvinces(prov1.id, prov2.id);
     ASSERT_SUCCEEDED(result);
@@ -598,6 +631,13 @@ TEST(ProjectTests, MergeProvinceTests) {
     ASSERT_EQ(prov1.parent_id, prov2.id);
     ASSERT_THAT(prov2.children, ::testing::UnorderedElementsAre(prov1.id));
 
+    ASSERT_EQ(merge_events.size(), 1);
+    ASSERT_THAT(merge_events.back().provinces,
+                ::testing::UnorderedElementsAre(prov_project.getIndexForProvinceID(prov1.id),
+                                                prov_project.getIndexForProvinceID(prov2.id)));
+    ASSERT_NE(merge_events.back().area.w, 0);
+    ASSERT_NE(merge_events.back().area.h, 0);
+
     // Attempt to merge a 3rd province into one that already has a parent
     const auto& prov3 = provinces_it->second;
     provinces_it = ++provinces_it;
@@ -632,6 +672,18 @@ TEST(ProjectTests, MergeProvinceTests) {
     ASSERT_THAT(prov2.children, ::testing::UnorderedElementsAre(prov1.id, prov3.id, prov5.id));
     ASSERT_THAT(prov5.children, ::testing::UnorderedElementsAre(prov4.id));
 
+    // Every merged province should resolve to the same root
+    auto root_index_of = [&prov_project](const HMDT::ProvinceID& id) {
+        return prov_project.getRootProvinceIndex(prov_project.getIndexForProvinceID(id));
+    };
+
+    const auto prov2_index = prov_project.getIndexForProvinceID(prov2.id);
+    for(auto&& id : { prov1.id, prov2.id, prov3.id, prov4.id, prov5.id }) {
+        auto root_index = root_index_of(id);
+        ASSERT_SUCCEEDED(root_index);
+        ASSERT_EQ(*root_index, prov2_index);
+    }
+
     // Validate getMergedProvinces
     auto&& prov1_merged = prov_project.getMergedProvinces(prov1.id);
     WRITE_INFO("Got ", prov1_merged.size(), " provinces merged with ", prov1.id);
@@ -680,6 +732,8 @@ TEST(ProjectTests, MergeProvinceTests) {
     ASSERT_EQ(prov3.parent_id, HMDT::INVALID_PROVINCE);
     ASSERT_THAT(prov2.children, ::testing::UnorderedElementsAre(prov1.id, prov5.id));
     ASSERT_THAT(prov5.children, ::testing::UnorderedElementsAre(prov4.id));
+    ASSERT_EQ(*root_index_of(prov3.id), prov_project.getIndexForProvinceID(prov3.id));
+    ASSERT_EQ(*root_index_of(prov4.id), prov2_index);
 
     // Attempt to unmerge prov5 (node in middle of tree, has 1 child)
     //   prov5 should no longer have a parent or children, and all of its old
@@ -693,6 +747,8 @@ TEST(ProjectTests, MergeProvinceTests) {
     ASSERT_EQ(prov5.parent_id, HMDT::INVALID_PROVINCE);
     ASSERT_THAT(prov2.children, ::testing::UnorderedElementsAre(prov1.id, prov4.id));
     ASSERT_THAT(prov5.children, ::testing::UnorderedElementsAre());
+    ASSERT_EQ(*root_index_of(prov5.id), prov_project.getIndexForProvinceID(prov5.id));
+    ASSERT_EQ(*root_index_of(prov4.id), prov2_index);
 
     // Attempt to unmerge prov2 (root node)
     //   prov2 should no longer have a parent or children, and all of its old
@@ -728,9 +784,130 @@ TEST(ProjectTests, MergeProvinceTests) {
     // Logical XOR
     ASSERT_TRUE(!prov1.children.empty() != !prov4.children.empty());
 
+    // prov1 and prov4 must still share a root, which can no longer be prov2
+    ASSERT_EQ(*root_index_of(prov2.id), prov2_index);
+    ASSERT_EQ(*root_index_of(prov1.id), *root_index_of(prov4.id));
+    ASSERT_NE(*root_index_of(prov1.id), prov2_index);
+
+    // 4 merges and 3 unmerges
+    ASSERT_EQ(merge_events.size(), 7);
+    ASSERT_THAT(merge_events.back().provinces,
+                ::testing::UnorderedElementsAre(prov2_index,
+                                                prov_project.getIndexForProvinceID(prov1.id),
+                                                prov_project.getIndexForProvinceID(prov4.id)));
+
+    // Merge prov2 with one of its neighbours, whose shared border must still be
+    //   drawn afterwards
+    auto prov2_edges = prov_project.getAdjacencyGraph().getEdges(prov2_index);
+    ASSERT_FALSE(prov2_edges.empty());
+
+    const auto& neighbour = prov_project.getProvinceForLabel(prov2_edges.begin()->neighbour);
+    result = prov_project.mergeProvinces(prov2.id, neighbour.id);
+    ASSERT_SUCCEEDED(result);
+
+    ASSERT_TRUE(std::equal(outlines_before.begin(), outlines_before.end(),
+                           outlines.get()));
+
     ::Log::Logger::getInstance().reset();
 }
 
+TEST(ProjectTests, ProvinceOutlinesAndAdjacenciesFollowLabels) {
+    auto project_path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.hoi4proj";
+
+    HMDT::Project::Project hproject(project_path);
+
+    {
+        // Load in province data
+        auto path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.bmp";
+
+        std::shared_ptr<HMDT::BitMap> image(new HMDT::BitMap);
+        ASSERT_NE(HMDT::readBMP(path, image.get()), nullptr);
+
+        std::shared_ptr<HMDT::MapData> map_data(new HMDT::MapData(image->info_header.width,
+                                                                  image->info_header.height));
+
+        HMDT::ShapeFinder finder(image.get(),
+                                 HMDT::UnitTests::GraphicsWorkerMock::getInstance(),
+                                 map_data);
+        finder.findAllShapes();
+
+        hproject.getMapProject().import(finder, map_data);
+    }
+
+    auto& prov_project = dynamic_cast<HMDT::Project::ProvinceProject&>(hproject.getMapProject().getProvinceProject());
+    auto map_data = hproject.getMapProject().getMapData();
+
+    auto [width, height] = map_data->getDimensions();
+    auto labels = map_data->getLabelMatrix().lock();
+    auto outlines = map_data->getProvinceOutlines().lock();
+    ASSERT_NE(labels, nullptr);
+    ASSERT_NE(outlines, nullptr);
+
+    const auto num_provinces = prov_project.getProvinces().size();
+
+    // Checks every pixel and border against a plain per-pixel scan
+    auto check_against_labels = [&]() {
+        auto is_valid_label = [num_provinces](uint32_t label) {
+            return label != HMDT::INVALID_PROVINCE_INDEX && label <= num_provinces;
+        };
+
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> expected_borders;
+
+        for(uint32_t y = 0; y < height; ++y) {
+            for(uint32_t x = 0; x < width; ++x) {
+                auto label = labels[HMDT::xyToIndex(width, x, y)];
+
+                bool is_outline = false;
+                if(x > 0) is_outline |= labels[HMDT::xyToIndex(width, x - 1, y)] != label;
+                if(y > 0) is_outline |= labels[HMDT::xyToIndex(width, x, y - 1)] != label;
+
+                for(auto [nx, ny] : { std::make_pair(x + 1, y), std::make_pair(x, y + 1) }) {
+                    if(nx >= width || ny >= height) continue;
+
+                    auto neighbour = labels[HMDT::xyToIndex(width, nx, ny)];
+                    if(neighbour == label) continue;
+
+                    is_outline = true;
+                    if(is_valid_label(label) && is_valid_label(neighbour)) {
+                        ++expected_borders[std::minmax(label, neighbour)];
+                    }
+                }
+
+                uint32_t outline;
+                std::memcpy(&outline, outlines.get() + HMDT::xyToIndex(width, x, y) * 4, sizeof(outline));
+                ASSERT_EQ(outline, is_outline ? 0xFFFFFFFF : 0) << "at (" << x << ',' << y << ')';
+            }
+        }
+
+        const auto& graph = prov_project.getAdjacencyGraph();
+
+        size_t num_edges = 0;
+        for(HMDT::ProvinceIndex index = 1; index <= num_provinces; ++index) {
+            for(auto&& edge : graph.getEdges(index)) {
+                auto it = expected_borders.find(std::minmax(index, edge.neighbour));
+                ASSERT_NE(it, expected_borders.end());
+                ASSERT_EQ(edge.length, it->second);
+                ++num_edges;
+            }
+        }
+        ASSERT_EQ(num_edges, expected_borders.size() * 2);
+    };
+
+    ASSERT_NO_FATAL_FAILURE(check_against_labels());
+
+    // Labels which are not a loaded province still get outlines, but never
+    //   border anything
+    const uint32_t unknown_label = num_provinces + 7;
+    for(uint32_t x = 3; x < 40 && x < width; ++x) {
+        labels[HMDT::xyToIndex(width, x, height / 2)] = unknown_label;
+    }
+    labels[HMDT::xyToIndex(width, width - 1, height - 1)] = unknown_label;
+
+    prov_project.buildProvinceOutlines();
+
+    ASSERT_NO_FATAL_FAILURE(check_against_labels());
+}
+
 TEST(ProjectTests, SimpleHierarchyTest) {
     // We also want to see log outputs in the test output
     HMDT::UnitTests::registerTestLogOutputFunction(true, true, true, true);
@@ -954,3 +1131,484 @@ TEST(ProjectTests, SimpleHierarchyIterationTest) {
     ASSERT_EQ(c, num_nodes);
 }
 
+
+TEST(ProjectTests, StateMembershipTests) {
+    auto project_path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.hoi4proj";
+
+    HMDT::Project::Project hproject(project_path);
+    ASSERT_STATUS(hproject.load(), HMDT::STATUS_SUCCESS);
+
+    auto path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.bmp";
+
+    std::shared_ptr<HMDT::BitMap> image(new HMDT::BitMap);
+    ASSERT_NE(HMDT::readBMP(path, image.get()), nullptr);
+
+    std::shared_ptr<HMDT::MapData> map_data(new HMDT::MapData(image->info_header.width,
+                                                              image->info_header.height));
+
+    HMDT::ShapeFinder finder(image.get(),
+                             HMDT::UnitTests::GraphicsWorkerMock::getInstance(),
+                             map_data);
+    finder.findAllShapes();
+
+    hproject.getMapProject().import(finder, map_data);
+
+    auto& prov_proj = hproject.getMapProject().getProvinceProject();
+    auto& state_proj = hproject.getHistoryProject().getStateProject();
+
+    std::vector<HMDT::ProvinceID> provs;
+    std::transform(prov_proj.getProvinces().begin(),
+                   std::next(prov_proj.getProvinces().begin(), 8),
+                   std::back_inserter(provs),
+                   [](auto&& kv) { return kv.first; });
+
+    auto state1 = state_proj.addNewState({ provs[0], provs[1], provs[2], provs[3], provs[4] });
+
+    // The second state takes provinces away from the first one, and lists a
+    //   province twice
+    auto state2 = state_proj.addNewState({ provs[4], provs[3], provs[5], provs[6], provs[7], provs[5] });
+
+    ASSERT_THAT(state_proj.getStates().at(state1).provinces,
+                ::testing::ElementsAre(provs[0], provs[1], provs[2]));
+    ASSERT_THAT(state_proj.getStates().at(state2).provinces,
+                ::testing::ElementsAre(provs[4], provs[3], provs[5], provs[6], provs[7]));
+
+    ASSERT_TRUE(state_proj.isProvinceInState(state1, provs[0]));
+    ASSERT_FALSE(state_proj.isProvinceInState(state1, provs[3]));
+    ASSERT_TRUE(state_proj.isProvinceInState(state2, provs[3]));
+    ASSERT_EQ(*state_proj.getStateIDForProvince(provs[4]), state2);
+
+    // Adding a province to a state which already lists it does nothing
+    ASSERT_SUCCEEDED(state_proj.addProvinceToState(state2, provs[5]));
+    ASSERT_EQ(state_proj.getStates().at(state2).provinces.size(), 5);
+
+    // Moving a province keeps the order of everything else
+    hproject.getMapProject().moveProvinceToState(provs[3], state1);
+    ASSERT_THAT(state_proj.getStates().at(state1).provinces,
+                ::testing::ElementsAre(provs[0], provs[1], provs[2], provs[3]));
+    ASSERT_THAT(state_proj.getStates().at(state2).provinces,
+                ::testing::ElementsAre(provs[4], provs[5], provs[6], provs[7]));
+    ASSERT_EQ(prov_proj.getProvinceForID(provs[3]).state, state1);
+
+    // Removing provinces keeps the order of everything else too, even when
+    //  several are removed before the state is next looked at
+    ASSERT_SUCCEEDED(state_proj.removeProvinceFromState(state2, provs[4]));
+    ASSERT_SUCCEEDED(state_proj.removeProvinceFromState(state2, provs[6]));
+    ASSERT_SUCCEEDED(state_proj.addProvinceToState(state2, provs[4]));
+    ASSERT_THAT(state_proj.getStates().at(state2).provinces,
+                ::testing::ElementsAre(provs[5], provs[7], provs[4]));
+    ASSERT_FALSE(state_proj.isProvinceInState(state2, provs[6]));
+    ASSERT_STATUS(state_proj.removeProvinceFromState(state2 + 1, provs[5]),
+                  HMDT::STATUS_STATE_DOES_NOT_EXIST);
+
+    // Provinces behind a compacted position are still found where they went
+    ASSERT_SUCCEEDED(state_proj.removeProvinceFromState(state2, provs[7]));
+    ASSERT_SUCCEEDED(state_proj.removeProvinceFromState(state2, provs[4]));
+    ASSERT_THAT(state_proj.getStates().at(state2).provinces,
+                ::testing::ElementsAre(provs[5]));
+
+    ASSERT_SUCCEEDED(state_proj.addProvinceToState(state2, provs[4]));
+
+    ASSERT_SUCCEEDED(state_proj.removeState(state2));
+    ASSERT_STATUS(state_proj.getStateIDForProvince(provs[4]),
+                  HMDT::STATUS_VALUE_NOT_FOUND);
+    ASSERT_TRUE(state_proj.isProvinceInState(state1, provs[0]));
+}
+
+TEST(ProjectTests, StateOutlinesFollowStateIDMatrix) {
+    auto project_path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.hoi4proj";
+
+    HMDT::Project::Project hproject(project_path);
+    ASSERT_STATUS(hproject.load(), HMDT::STATUS_SUCCESS);
+
+    auto path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.bmp";
+
+    std::shared_ptr<HMDT::BitMap> image(new HMDT::BitMap);
+    ASSERT_NE(HMDT::readBMP(path, image.get()), nullptr);
+
+    std::shared_ptr<HMDT::MapData> map_data(new HMDT::MapData(image->info_header.width,
+                                                              image->info_header.height));
+
+    HMDT::ShapeFinder finder(image.get(),
+                             HMDT::UnitTests::GraphicsWorkerMock::getInstance(),
+                             map_data);
+    finder.findAllShapes();
+
+    hproject.getMapProject().import(finder, map_data);
+
+    auto& prov_proj = hproject.getMapProject().getProvinceProject();
+    auto& state_proj = hproject.getHistoryProject().getStateProject();
+    auto map = hproject.getMapProject().getMapData();
+
+    auto width = map->getWidth();
+    auto height = map->getHeight();
+
+    // Checks the outlines against the state ID matrix, pixel by pixel
+    auto checkOutlines = [&]() {
+        auto state_ids = map->getStateIDMatrix().lock();
+        auto outlines = map->getStateOutlines().lock();
+
+        for(uint32_t y = 0; y < height; ++y) {
+            for(uint32_t x = 0; x < width; ++x) {
+                auto i = y * width + x;
+                bool is_border = (x + 1 < width && state_ids[i] != state_ids[i + 1]) ||
+                                 (y + 1 < height && state_ids[i] != state_ids[i + width]);
+
+                ASSERT_EQ(outlines[i], is_border ? 0xFF : 0) << "at " << x << ',' << y;
+            }
+        }
+    };
+
+    std::vector<HMDT::ProvinceID> provs;
+    std::transform(prov_proj.getProvinces().begin(),
+                   std::next(prov_proj.getProvinces().begin(), 8),
+                   std::back_inserter(provs),
+                   [](auto&& kv) { return kv.first; });
+
+    auto start = map->getLayerGeneration(HMDT::MapData::Layer::STATE_OUTLINES);
+
+    auto state1 = state_proj.addNewState({ provs[0], provs[1], provs[2] });
+    auto state2 = state_proj.addNewState({ provs[3], provs[4], provs[5] });
+    checkOutlines();
+
+    // Only the areas around each changed province should have been updated
+    auto changes = map->getLayerChangesSince(HMDT::MapData::Layer::STATE_OUTLINES, start);
+    ASSERT_TRUE(changes.has_value());
+    ASSERT_FALSE(changes->empty());
+
+    hproject.getMapProject().moveProvinceToState(provs[2], state2);
+    checkOutlines();
+
+    ASSERT_SUCCEEDED(state_proj.removeState(state1));
+    checkOutlines();
+
+    // A full rebuild finds nothing left to change
+    auto before_full = map->getLayerGeneration(HMDT::MapData::Layer::STATE_OUTLINES);
+    state_proj.updateStateIDMatrix();
+    ASSERT_EQ(map->getLayerGeneration(HMDT::MapData::Layer::STATE_OUTLINES), before_full);
+
+    // Relabelling the map without changing how many provinces there are
+    //   leaves the spans out of date, so they must not be used any more
+    {
+        auto labels = map->getLabelMatrix().lock();
+        for(uint32_t i = 0; i < width * height; ++i) {
+            if(labels[i] == 1) {
+                labels[i] = 2;
+            } else if(labels[i] == 2) {
+                labels[i] = 1;
+            }
+        }
+    }
+    map->markLayerDirty(HMDT::MapData::Layer::LABEL_MATRIX);
+
+    auto state3 = state_proj.addNewState({ prov_proj.getProvinces().atIndex(1)->id });
+    {
+        auto state_ids = map->getStateIDMatrix().lock();
+        auto labels = map->getLabelMatrix().lock();
+
+        for(uint32_t i = 0; i < width * height; ++i) {
+            auto expected = labels[i] == 0 ? 0 : prov_proj.getProvinces().atIndex(labels[i])->state;
+            ASSERT_EQ(state_ids[i], expected) << "at pixel " << i;
+        }
+        ASSERT_EQ(prov_proj.getProvinces().atIndex(1)->state, state3);
+    }
+    checkOutlines();
+
+    // Recoloring a state leaves the matrix alone, but must still be noticed
+    auto before_color = state_proj.getStateColorGeneration();
+    auto before_matrix = map->getLayerGeneration(HMDT::MapData::Layer::STATE_ID_MATRIX);
+
+    ASSERT_SUCCEEDED(state_proj.setStateColor(state2, HMDT::Color{ 1, 2, 3 }));
+    ASSERT_EQ(state_proj.getStates().at(state2).color, (HMDT::Color{ 1, 2, 3 }));
+    ASSERT_NE(state_proj.getStateColorGeneration(), before_color);
+    ASSERT_EQ(map->getLayerGeneration(HMDT::MapData::Layer::STATE_ID_MATRIX), before_matrix);
+
+    auto missing_state = state_proj.getStates().rbegin()->first + 1;
+    ASSERT_STATUS(state_proj.setStateColor(missing_state, HMDT::Color{ 1, 2, 3 }),
+                  HMDT::STATUS_STATE_DOES_NOT_EXIST);
+}
+
+TEST(ProjectTests, WorldNormalMapFollowsHeightMapEdits) {
+    auto input_heightmap = HMDT::UnitTests::getTestProgramPath() / "bin" / "complex_heightmap.bmp";
+    auto edited_heightmap = HMDT::UnitTests::getTestProgramPath() / "tmp" / "edited_heightmap.bmp";
+    std::filesystem::create_directories(edited_heightmap.parent_path());
+
+    HMDT::Project::Project hproject;
+
+    {
+        uint32_t width = 1024;
+        uint32_t height = 1024;
+
+        auto map_data_ptr = hproject.getMapProject().getMapData();
+
+        map_data_ptr->~MapData();
+        new (map_data_ptr.get()) HMDT::MapData(width, height);
+    }
+
+    auto& heightmap_project = hproject.getMapProject().getHeightMapProject();
+    ASSERT_SUCCEEDED(heightmap_project.loadFile(input_heightmap));
+
+    // The heightmap as it should be after every edit
+    auto expected_heightmap = std::make_shared<HMDT::BitMap2>();
+    ASSERT_SUCCEEDED(HMDT::readBMP(input_heightmap, expected_heightmap));
+
+    // Compares the cached normal map against one generated from scratch
+    auto checkNormals = [&]() {
+        auto normals = heightmap_project.getWorldNormalMap();
+        ASSERT_SUCCEEDED(normals);
+
+        std::vector<unsigned char> expected((*normals)->size());
+        ASSERT_SUCCEEDED(HMDT::generateWorldNormalMap(*expected_heightmap,
+                                                      expected.data()));
+
+        ASSERT_TRUE(**normals == expected);
+    };
+
+    // Compares the cached pyramid against one built from scratch
+    auto checkPyramid = [&]() {
+        auto pyramid = heightmap_project.getHeightMapPyramid();
+        ASSERT_SUCCEEDED(pyramid);
+
+        HMDT::HeightMapPyramid expected;
+        expected.build(expected_heightmap->data.get(), 1024, 1024,
+                       HMDT::HeightMapPyramid::makePalette(*expected_heightmap));
+
+        ASSERT_EQ((*pyramid)->getLevelCount(), expected.getLevelCount());
+        for(size_t i = 0; i < expected.getLevelCount(); ++i) {
+            ASSERT_TRUE((*pyramid)->getLevel(i)->get().data ==
+                        expected.getLevel(i)->get().data) << "level " << i;
+        }
+    };
+
+    checkNormals();
+    checkPyramid();
+
+    // Callers keep the normal map they were given, even after it gets updated
+    auto original_normals = heightmap_project.getWorldNormalMap();
+    ASSERT_SUCCEEDED(original_normals);
+    auto original_copy = **original_normals;
+
+    // Raise a plateau, and then another one touching the edge of the map
+    for(auto&& area : { HMDT::Rectangle{ 100, 200, 40, 30 },
+                        HMDT::Rectangle{ 1024 - 40, 0, 40, 30 } })
+    {
+        for(uint32_t y = area.y; y < area.y + area.h; ++y) {
+            std::memset(expected_heightmap->data.get() + y * 1024 + area.x,
+                        0xFF, area.w);
+        }
+    }
+    ASSERT_SUCCEEDED(HMDT::writeBMP(edited_heightmap, *expected_heightmap));
+
+    auto map = hproject.getMapProject().getMapData();
+    auto before = map->getLayerGeneration(HMDT::MapData::Layer::HEIGHTMAP);
+
+    // Reimporting the edited file only marks the edited areas as changed
+    ASSERT_SUCCEEDED(heightmap_project.loadFile(edited_heightmap));
+
+    auto changes = map->getLayerChangesSince(HMDT::MapData::Layer::HEIGHTMAP, before);
+    ASSERT_TRUE(changes.has_value());
+    ASSERT_FALSE(changes->empty());
+    for(auto&& area : *changes) {
+        ASSERT_LE(area.w, 40U);
+        ASSERT_LE(area.h, 30U);
+    }
+
+    checkNormals();
+    checkPyramid();
+    ASSERT_TRUE(**original_normals == original_copy);
+
+    // And reimporting the original file puts everything back
+    ASSERT_SUCCEEDED(heightmap_project.loadFile(input_heightmap));
+    ASSERT_SUCCEEDED(HMDT::readBMP(input_heightmap, expected_heightmap));
+
+    checkNormals();
+    checkPyramid();
+}
+
+TEST(ProjectTests, RiversTemplateMatchesProvinceTypes) {
+    auto project_path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.hoi4proj";
+
+    HMDT::Project::Project hproject(project_path);
+    ASSERT_STATUS(hproject.load(), HMDT::STATUS_SUCCESS);
+
+    auto path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.bmp";
+
+    std::shared_ptr<HMDT::BitMap> image(new HMDT::BitMap);
+    ASSERT_NE(HMDT::readBMP(path, image.get()), nullptr);
+
+    std::shared_ptr<HMDT::MapData> map_data(new HMDT::MapData(image->info_header.width,
+                                                              image->info_header.height));
+
+    HMDT::ShapeFinder finder(image.get(),
+                             HMDT::UnitTests::GraphicsWorkerMock::getInstance(),
+                             map_data);
+    finder.findAllShapes();
+
+    hproject.getMapProject().import(finder, map_data);
+
+    auto& prov_proj = hproject.getMapProject().getProvinceProject();
+    auto map = hproject.getMapProject().getMapData();
+
+    // Give the provinces every type there is
+    constexpr HMDT::ProvinceType types[] = {
+        HMDT::ProvinceType::UNKNOWN, HMDT::ProvinceType::LAND,
+        HMDT::ProvinceType::SEA, HMDT::ProvinceType::LAKE
+    };
+    auto& provinces = prov_proj.getProvinces();
+    for(HMDT::ProvinceIndex index = 1; index <= provinces.size(); ++index) {
+        provinces.setType(index, types[(index - 1) % std::size(types)]);
+    }
+
+    auto template_path = HMDT::UnitTests::getTestProgramPath() / "tmp" / "rivers_template.bmp";
+    std::filesystem::create_directories(template_path.parent_path());
+
+    ASSERT_SUCCEEDED(hproject.getMapProject().getRiversProject().writeTemplate(template_path));
+
+    HMDT::BitMap2 rivers_template;
+    ASSERT_SUCCEEDED(HMDT::readBMP(template_path, rivers_template));
+
+    auto labels = map->getLabelMatrix().lock();
+    for(uint32_t p = 0; p < map->getWidth() * map->getHeight(); ++p) {
+        uint8_t expected = 14;
+        switch(prov_proj.getProvinceForLabel(labels[p]).type) {
+            case HMDT::ProvinceType::LAND:
+                expected = 12;
+                break;
+            case HMDT::ProvinceType::SEA:
+            case HMDT::ProvinceType::LAKE:
+                expected = 13;
+                break;
+            default:
+                break;
+        }
+
+        ASSERT_EQ(rivers_template.data[p], expected) << "at pixel " << p;
+    }
+}
+
+TEST(ProjectTests, MapValidationFindsAndFixesStateIssues) {
+    SET_PROGRAM_OPTION(fix_warnings_on_load, true);
+
+    auto project_path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.hoi4proj";
+
+    HMDT::Project::Project hproject(project_path);
+    ASSERT_STATUS(hproject.load(), HMDT::STATUS_SUCCESS);
+
+    {
+        // Load in province data
+        auto path = HMDT::UnitTests::getTestProgramPath() / "bin" / "simple.bmp";
+
+        std::shared_ptr<HMDT::BitMap> image(new HMDT::BitMap);
+        ASSERT_NE(HMDT::readBMP(path, image.get()), nullptr);
+
+        std::shared_ptr<HMDT::MapData> map_data(new HMDT::MapData(image->info_header.width,
+                                                                  image->info_header.height));
+
+        HMDT::ShapeFinder finder(image.get(),
+                                 HMDT::UnitTests::GraphicsWorkerMock::getInstance(),
+                                 map_data);
+        finder.findAllShapes();
+
+        hproject.getMapProject().import(finder, map_data);
+    }
+
+    auto& map_proj = dynamic_cast<HMDT::Project::MapProject&>(hproject.getMapProject());
+    auto& prov_proj = map_proj.getProvinceProject();
+    auto& state_proj = hproject.getHistoryProject().getStateProject();
+
+    std::vector<HMDT::ProvinceID> provs;
+    std::transform(prov_proj.getProvinces().begin(),
+                   std::next(prov_proj.getProvinces().begin(), 9),
+                   std::back_inserter(provs),
+                   [](auto&& kv) { return kv.first; });
+
+    // Imported provinces are in state 0, which is not a valid state either
+    auto& provinces = prov_proj.getProvinces();
+    for(HMDT::ProvinceIndex index = 1; index <= provinces.size(); ++index) {
+        provinces.setState(index, -1);
+    }
+
+    auto state1 = state_proj.addNewState({ provs[0], provs[1] });
+    auto state2 = state_proj.addNewState({ provs[2], provs[3] });
+
+    // Break the data the same way a hand-edited project could be broken
+    auto& state1_provs = state_proj.getStateForID(state1)->get().provinces;
+    auto& state2_provs = state_proj.getStateForID(state2)->get().provinces;
+
+    provinces.setState(provinces.getIndex(provs[4]), 999);    // Invalid state
+    provinces.setState(provinces.getIndex(provs[5]), state1); // Not in its state
+    state2_provs.push_back(provs[0]);                    // In two states
+    state2_provs.push_back(provs[6]);                    // Belongs to no state
+    state1_provs.push_back(provs[7]);                    // Belongs to no state,
+    state2_provs.push_back(provs[7]);                    //   but in two states
+
+    HMDT::ProvinceID unknown_province;
+    state1_provs.push_back(unknown_province);            // Does not exist
+
+    provinces.setParent(provinces.getIndex(provs[8]), provs[8]); // Own parent
+
+    // Invalid state IDs are errors, but get fixed
+    ASSERT_TRUE(map_proj.validateData());
+
+    const auto& report = map_proj.getValidationReport();
+
+    // Every broken province is reported exactly once
+    auto expectIssue = [&report](const HMDT::ProvinceID& province_id,
+                                 std::error_code code, bool fixed)
+    {
+        auto count = std::count_if(report.getIssues().begin(),
+                                   report.getIssues().end(),
+                                   [&province_id](auto&& issue) {
+                                       return issue.province == province_id;
+                                   });
+        ASSERT_EQ(count, 1) << "for province " << province_id;
+
+        auto it = std::find_if(report.getIssues().begin(),
+                               report.getIssues().end(),
+                               [&province_id](auto&& issue) {
+                                   return issue.province == province_id;
+                               });
+        ASSERT_EQ(it->code, code) << "for province " << province_id;
+        ASSERT_EQ(it->fixed, fixed) << "for province " << province_id;
+    };
+
+    expectIssue(provs[4], HMDT::STATUS_PROVINCE_INVALID_STATE_ID, true);
+    expectIssue(provs[5], HMDT::STATUS_PROVINCE_NOT_IN_STATE, true);
+    expectIssue(provs[0], HMDT::STATUS_PROVINCE_IN_MULTIPLE_STATES, true);
+    expectIssue(provs[6], HMDT::STATUS_STATE_PROVINCE_MISMATCH, true);
+    expectIssue(provs[7], HMDT::STATUS_PROVINCE_IN_MULTIPLE_STATES, true);
+    expectIssue(unknown_province, HMDT::STATUS_STATE_INVALID_PROVINCE, false);
+    expectIssue(provs[8], HMDT::STATUS_PROVINCE_MERGE_MISMATCH, false);
+
+    for(auto&& id : { provs[1], provs[2], provs[3] }) {
+        ASSERT_TRUE(std::none_of(report.getIssues().begin(),
+                                 report.getIssues().end(),
+                                 [&id](auto&& issue) { return issue.province == id; }));
+    }
+
+    ASSERT_EQ(report.countFixed(), 5);
+
+    // Provinces without a state join the state listing them rather than
+    //   being taken out of it
+    ASSERT_EQ(prov_proj.getProvinceForID(provs[4]).state, static_cast<HMDT::StateID>(-1));
+    ASSERT_EQ(prov_proj.getProvinceForID(provs[6]).state, state2);
+    ASSERT_EQ(prov_proj.getProvinceForID(provs[7]).state, state1);
+
+    ASSERT_THAT(state_proj.getStates().at(state1).provinces,
+                ::testing::UnorderedElementsAre(provs[0], provs[1], provs[5],
+                                                provs[7], unknown_province));
+    ASSERT_THAT(state_proj.getStates().at(state2).provinces,
+                ::testing::UnorderedElementsAre(provs[2], provs[3], provs[6]));
+
+    for(auto&& [id, state] : { std::pair{ provs[0], state1 },
+                               std::pair{ provs[5], state1 },
+                               std::pair{ provs[6], state2 },
+                               std::pair{ provs[7], state1 } })
+    {
+        ASSERT_EQ(*state_proj.getStateIDForProvince(id), state);
+    }
+
+    // Only the issues which cannot be fixed are left
+    ASSERT_TRUE(map_proj.validateData());
+    ASSERT_EQ(map_proj.getValidationReport().getIssues().size(), 2);
+}
@@ -8,6 +8,6 @@
 #include "TestOverrides.h"
 
 HMDT::ProgramOptions HMDT::prog_opts = {
-    0, "", "", false, false, "", "", false, "", false, false, false, false, false
+    0, "", "", false, false, "", "", false, "", false, false, false, false, false, false
 };
 
@@ -1,11 +1,31 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
 #include <random>
+#include <tuple>
 
 #include <libintl.h>
 
 #include "Util.h"
+#include "LRUCache.h"
+#include "ProvincePreview.h"
+#include "ProvinceList.h"
+#include "ProvinceSpatialIndex.h"
+#include "ProvinceGraph.h"
+#include "ProvinceSpans.h"
+#include "ValidationReport.h"
+#include "FileWriterPool.h"
+#include "WorldNormalBuilder.h"
+#include "HeightMapPyramid.h"
+#include "RiversValidator.h"
+#include "BitMap.h"
+#include "Constants.h"
 #include "Monad.h"
 #include "Maybe.h"
 #include "StatusCodes.h"
@@ -559,3 +579,780 @@ TEST(UtilTests, LargeParallelTransformTest) {
         ASSERT_EQ(output_data[i], expected_output_data[i]);
     }
 }
+
+TEST(UtilTests, ParallelMapChunksCoversEveryElementOnce) {
+    constexpr uint32_t num_test_values = 100003;
+
+    std::vector<uint8_t> visited(num_test_values, 0);
+
+    auto chunk_sizes = HMDT::parallelMapChunks(num_test_values,
+        [&visited](uint32_t begin, uint32_t end) {
+            for(auto i = begin; i < end; ++i) {
+                ++visited[i];
+            }
+
+            return end - begin;
+        });
+
+    // Chunks are returned in order, and together cover the entire range
+    ASSERT_FALSE(chunk_sizes.empty());
+    ASSERT_EQ(std::accumulate(chunk_sizes.begin(), chunk_sizes.end(), 0U),
+              num_test_values);
+
+    for(uint32_t i = 0; i < num_test_values; ++i) {
+        ASSERT_EQ(visited[i], 1);
+    }
+
+    // Nothing to split up means nothing gets called
+    auto empty = HMDT::parallelMapChunks(0, [](uint32_t, uint32_t) {
+        return 0;
+    });
+    ASSERT_TRUE(empty.empty());
+}
+
+TEST(UtilTests, LRUCacheEvictsLeastRecentlyUsedByBytes) {
+    HMDT::LRUCache<int, std::string> cache(100);
+
+    ASSERT_EQ(cache.insert(1, "one", 40), 0);
+    ASSERT_EQ(cache.insert(2, "two", 40), 0);
+    ASSERT_EQ(cache.getTotalBytes(), 80);
+
+    // Using 1 makes 2 the least recently used entry
+    ASSERT_NE(cache.get(1), nullptr);
+    ASSERT_EQ(*cache.get(1), "one");
+
+    ASSERT_EQ(cache.insert(3, "three", 40), 1);
+    ASSERT_TRUE(cache.contains(1));
+    ASSERT_FALSE(cache.contains(2));
+    ASSERT_TRUE(cache.contains(3));
+    ASSERT_EQ(cache.getTotalBytes(), 80);
+
+    // Replacing an entry updates its size rather than adding to it
+    ASSERT_EQ(cache.insert(3, "THREE", 10), 0);
+    ASSERT_EQ(cache.size(), 2);
+    ASSERT_EQ(cache.getTotalBytes(), 50);
+    ASSERT_EQ(*cache.peek(3), "THREE");
+
+    // An entry larger than the whole budget is still kept on its own
+    ASSERT_EQ(cache.insert(4, "four", 500), 2);
+    ASSERT_EQ(cache.size(), 1);
+    ASSERT_TRUE(cache.contains(4));
+
+    ASSERT_EQ(cache.setByteBudget(1000), 0);
+    cache.insert(5, "five", 1);
+    cache.insert(6, "six", 1);
+    ASSERT_EQ(cache.eraseIf([](const auto& entry) { return entry.bytes == 1; }), 2);
+    ASSERT_EQ(cache.getTotalBytes(), 500);
+
+    ASSERT_TRUE(cache.erase(4));
+    ASSERT_FALSE(cache.erase(4));
+    ASSERT_TRUE(cache.empty());
+    ASSERT_EQ(cache.getTotalBytes(), 0);
+}
+
+TEST(UtilTests, ProvincePreviewExpandsMaskToARGB) {
+    constexpr uint32_t width = 130;
+    constexpr uint32_t height = 3;
+    constexpr uint32_t color = 0xFF112233;
+
+    HMDT::ProvincePreview preview(width, height);
+
+    // 3 words per row, packed as 1 bit per pixel
+    ASSERT_EQ(preview.getWordsPerRow(), 3);
+    ASSERT_EQ(preview.getByteSize(), 3 * height * sizeof(uint64_t));
+
+    // Row 0 is entirely set, row 1 has a few scattered pixels, row 2 is empty
+    for(uint32_t x = 0; x < width; ++x) {
+        preview.set(x, 0);
+    }
+    preview.set(0, 1);
+    preview.set(63, 1);
+    preview.set(64, 1);
+    preview.set(129, 1);
+
+    ASSERT_TRUE(preview.isSet(63, 1));
+    ASSERT_FALSE(preview.isSet(62, 1));
+
+    auto image = preview.expandToARGB(color);
+    const auto* pixels = reinterpret_cast<const uint32_t*>(image.get());
+
+    for(uint32_t y = 0; y < height; ++y) {
+        for(uint32_t x = 0; x < width; ++x) {
+            ASSERT_EQ(pixels[y * width + x], preview.isSet(x, y) ? color : 0)
+                << "x=" << x << ", y=" << y;
+        }
+    }
+
+    ASSERT_EQ(pixels[0], color);
+    ASSERT_EQ(pixels[width + 129], color);
+    ASSERT_EQ(pixels[2 * width + 5], 0);
+}
+
+TEST(UtilTests, ProvinceListKeepsDenseIndexOrder) {
+    HMDT::ProvinceList provinces;
+
+    std::vector<HMDT::ProvinceID> ids(4);
+    for(auto&& id : ids) {
+        provinces[id].id = id;
+    }
+
+    // Provinces are indexed in insertion order, starting at 1
+    ASSERT_EQ(provinces.size(), 4);
+    for(HMDT::ProvinceIndex i = 0; i < ids.size(); ++i) {
+        ASSERT_EQ(provinces.getIndex(ids[i]), i + 1);
+        ASSERT_EQ(provinces.getID(i + 1), ids[i]);
+        ASSERT_EQ(provinces.atIndex(i + 1)->id, ids[i]);
+    }
+
+    ASSERT_EQ(provinces.atIndex(HMDT::INVALID_PROVINCE_INDEX), nullptr);
+    ASSERT_EQ(provinces.atIndex(5), nullptr);
+    ASSERT_EQ(provinces.getID(5), HMDT::INVALID_PROVINCE);
+    ASSERT_EQ(provinces.getIndex(HMDT::INVALID_PROVINCE), HMDT::INVALID_PROVINCE_INDEX);
+    ASSERT_THROW(provinces.at(HMDT::INVALID_PROVINCE), std::out_of_range);
+
+    // Unlisted provinces keep their relative order after the listed ones
+    provinces.reorder({ ids[2], ids[0] });
+
+    const std::vector<HMDT::ProvinceID> expected{ ids[2], ids[0], ids[1], ids[3] };
+
+    HMDT::ProvinceIndex index = 1;
+    for(auto&& [id, province] : provinces) {
+        ASSERT_EQ(id, expected[index - 1]);
+        ASSERT_EQ(province.id, id);
+        ASSERT_EQ(provinces.getIndex(id), index);
+        ASSERT_EQ(&provinces.at(id), provinces.atIndex(index));
+        ++index;
+    }
+}
+
+TEST(UtilTests, ProvinceListKeepsColumnsInSync) {
+    HMDT::ProvinceList provinces;
+
+    std::vector<HMDT::ProvinceID> ids(3);
+    for(auto&& id : ids) {
+        provinces[id].id = id;
+    }
+
+    // Fields written through a reference only show up once synced
+    provinces.at(ids[0]).unique_color = HMDT::Color{ 1, 2, 3 };
+    provinces.at(ids[0]).parent_id = ids[2];
+    provinces.syncColumns(1);
+
+    provinces.setType(2, HMDT::ProvinceType::SEA);
+    provinces.setCoastal(3, true);
+    provinces.setState(3, 7);
+    provinces.setParent(2, ids[2]);
+
+    // Invalid indices are ignored
+    provinces.setState(HMDT::INVALID_PROVINCE_INDEX, 9);
+    provinces.setState(4, 9);
+
+    auto checkColumns = [&provinces]() {
+        ASSERT_EQ(provinces.getTypes().size(), provinces.size());
+
+        HMDT::ProvinceIndex index = 1;
+        for(auto&& [id, province] : provinces) {
+            auto i = index - 1;
+
+            ASSERT_EQ(provinces.getTypes()[i], province.type);
+            ASSERT_EQ(provinces.getCoastal()[i], province.coastal);
+            ASSERT_EQ(provinces.getStates()[i], province.state);
+            ASSERT_EQ(provinces.getColors()[i], province.unique_color);
+            ASSERT_EQ(provinces.getParentIndices()[i],
+                      provinces.getIndex(province.parent_id));
+            ++index;
+        }
+    };
+
+    checkColumns();
+    ASSERT_EQ(provinces.at(ids[1]).type, HMDT::ProvinceType::SEA);
+    ASSERT_EQ(provinces.getStates()[2], 7);
+    ASSERT_EQ(provinces.getParentIndices()[0], 3);
+
+    // Reordering moves the columns along with the provinces
+    provinces.reorder({ ids[2], ids[1], ids[0] });
+    checkColumns();
+    ASSERT_EQ(provinces.getParentIndices()[2], 1);
+    ASSERT_EQ(provinces.getParentIndices()[1], 1);
+    ASSERT_EQ(provinces.getParentIndices()[0], HMDT::INVALID_PROVINCE_INDEX);
+}
+
+TEST(UtilTests, ProvinceSpatialIndexMatchesLinearScan) {
+    constexpr uint32_t width = 500;
+    constexpr uint32_t height = 300;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> x_dist(0, width - 1);
+    std::uniform_int_distribution<uint32_t> y_dist(0, height - 1);
+    std::uniform_int_distribution<uint32_t> size_dist(0, 80);
+
+    HMDT::ProvinceList provinces;
+    for(uint32_t i = 0; i < 200; ++i) {
+        auto x = x_dist(rng);
+        auto y = y_dist(rng);
+
+        HMDT::ProvinceID id;
+        auto& province = provinces[id];
+        province.id = id;
+
+        // Same corner order as the ShapeFinder produces
+        province.bounding_box = HMDT::BoundingBox {
+            { x, std::min(y + size_dist(rng), height - 1) },
+            { std::min(x + size_dist(rng), width - 1), y }
+        };
+    }
+
+    HMDT::ProvinceSpatialIndex index(32);
+    index.rebuild(provinces, width, height);
+
+    ASSERT_EQ(index.size(), provinces.size());
+
+    auto intersects = [](const HMDT::BoundingBox& bb, const HMDT::Rectangle& r) {
+        return bb.bottom_left.x < r.x + r.w && bb.top_right.x >= r.x &&
+               bb.top_right.y < r.y + r.h && bb.bottom_left.y >= r.y;
+    };
+
+    for(uint32_t i = 0; i < 100; ++i) {
+        HMDT::Rectangle rect{ x_dist(rng), y_dist(rng),
+                              size_dist(rng) + 1, size_dist(rng) + 1 };
+
+        std::vector<HMDT::ProvinceIndex> expected;
+        for(auto&& [id, province] : provinces) {
+            if(intersects(province.bounding_box, rect)) {
+                expected.push_back(provinces.getIndex(id));
+            }
+        }
+
+        ASSERT_EQ(index.queryRect(rect), expected);
+    }
+
+    auto everything = index.queryRect(HMDT::Rectangle{ 0, 0, width, height });
+    ASSERT_EQ(everything.size(), provinces.size());
+
+    index.clear();
+    ASSERT_EQ(index.size(), 0);
+    ASSERT_TRUE(index.queryRect(HMDT::Rectangle{ 0, 0, width, height }).empty());
+}
+
+TEST(UtilTests, ProvinceGraphStoresBordersInBothDirections) {
+    HMDT::ProvinceList provinces;
+
+    const HMDT::ProvinceType types[] = {
+        HMDT::ProvinceType::LAND, HMDT::ProvinceType::LAND,
+        HMDT::ProvinceType::SEA, HMDT::ProvinceType::LAKE
+    };
+    for(auto&& type : types) {
+        HMDT::ProvinceID id;
+        provinces[id].id = id;
+        provinces.setType(provinces.getIndex(id), type);
+    }
+
+    // 1 - 2 - 3, 1 - 3, 2 - 4. Also one border to an unknown index.
+    HMDT::ProvinceGraph graph;
+    graph.build(provinces.size() + 1, {
+        { 2, 1, 10 }, { 3, 2, 4 }, { 1, 3, 7 }, { 2, 4, 1 }, { 1, 9, 5 }
+    });
+    graph.updateCrossings(provinces);
+
+    ASSERT_EQ(graph.getVertexCount(), 5);
+    ASSERT_EQ(graph.getEdgeCount(), 8);
+
+    auto edges = graph.getEdges(1);
+    ASSERT_EQ(edges.size(), 2);
+    ASSERT_EQ(edges.begin()[0].neighbour, 2);
+    ASSERT_EQ(edges.begin()[0].length, 10);
+    ASSERT_EQ(edges.begin()[0].crossing, HMDT::ProvinceCrossing::LAND);
+    ASSERT_EQ(edges.begin()[1].neighbour, 3);
+    ASSERT_EQ(edges.begin()[1].crossing, HMDT::ProvinceCrossing::COAST);
+
+    ASSERT_TRUE(graph.areAdjacent(3, 2));
+    ASSERT_FALSE(graph.areAdjacent(3, 4));
+    ASSERT_EQ(graph.findEdge(4, 2)->crossing, HMDT::ProvinceCrossing::LAKESHORE);
+    ASSERT_EQ(graph.findEdge(3, 1)->length, 7);
+
+    ASSERT_TRUE(graph.getEdges(HMDT::INVALID_PROVINCE_INDEX).empty());
+    ASSERT_TRUE(graph.getEdges(9).empty());
+
+    // Crossings follow the provinces when their types change
+    provinces.setType(2, HMDT::ProvinceType::SEA);
+    graph.updateCrossings(provinces);
+    ASSERT_EQ(graph.findEdge(1, 2)->crossing, HMDT::ProvinceCrossing::COAST);
+    ASSERT_EQ(graph.findEdge(3, 2)->crossing, HMDT::ProvinceCrossing::SEA);
+    ASSERT_EQ(graph.findEdge(2, 4)->crossing, HMDT::ProvinceCrossing::SEA_LAKE);
+}
+
+TEST(UtilTests, ProvinceSpansCoverEveryLabelledPixel) {
+    constexpr uint32_t WIDTH = 6;
+    constexpr uint32_t HEIGHT = 3;
+
+    // Label 9 is outside of the provinces, and so gets no spans
+    const uint32_t labels[WIDTH * HEIGHT] = {
+        1, 1, 2, 2, 1, 1,
+        3, 3, 3, 3, 3, 3,
+        1, 9, 9, 2, 2, 0,
+    };
+
+    HMDT::ProvinceSpans spans;
+    spans.build(labels, WIDTH, HEIGHT, 4, 7);
+
+    ASSERT_EQ(spans.getLabelGeneration(), 7);
+    ASSERT_EQ(spans.getProvinceCount(), 4);
+    ASSERT_EQ(spans.getSpanCount(), 7);
+
+    auto first = spans.getSpans(1);
+    ASSERT_EQ(first.size(), 3);
+    ASSERT_EQ(first.begin()[0].y, 0);
+    ASSERT_EQ(first.begin()[0].x, 0);
+    ASSERT_EQ(first.begin()[0].length, 2);
+    ASSERT_EQ(first.begin()[1].x, 4);
+    ASSERT_EQ(first.begin()[2].y, 2);
+    ASSERT_EQ(first.begin()[2].length, 1);
+
+    ASSERT_EQ(spans.getSpans(3).size(), 1);
+    ASSERT_EQ(spans.getSpans(3).begin()->length, WIDTH);
+
+    // Every labelled pixel is covered exactly once
+    uint32_t covered[WIDTH * HEIGHT] = { 0 };
+    for(HMDT::ProvinceIndex index = 0; index < spans.getProvinceCount(); ++index) {
+        for(auto&& span : spans.getSpans(index)) {
+            for(uint32_t x = span.x; x < span.x + span.length; ++x) {
+                ASSERT_EQ(labels[span.y * WIDTH + x], index);
+                ++covered[span.y * WIDTH + x];
+            }
+        }
+    }
+    for(uint32_t i = 0; i < WIDTH * HEIGHT; ++i) {
+        ASSERT_EQ(covered[i], labels[i] < 4 ? 1 : 0);
+    }
+
+    ASSERT_TRUE(spans.getSpans(4).empty());
+    ASSERT_TRUE(spans.getSpans(9).empty());
+
+    // Cleared spans never match any label matrix
+    spans.clear();
+    ASSERT_EQ(spans.getProvinceCount(), 0);
+    ASSERT_EQ(spans.getLabelGeneration(), static_cast<uint64_t>(-1));
+}
+
+TEST(UtilTests, ValidationReportCountsUnfixedIssues) {
+    using Severity = HMDT::ValidationReport::Severity;
+
+    HMDT::ValidationReport report;
+    ASSERT_TRUE(report.empty());
+    ASSERT_FALSE(report.hasErrors());
+
+    HMDT::ValidationReport other;
+    for(uint32_t i = 0; i < 5; ++i) {
+        other.addIssue(Severity::WARNING, "Warnings",
+                       HMDT::STATUS_PROVINCE_MERGE_MISMATCH, "Warning #", i);
+    }
+
+    auto& error = report.addIssue(Severity::ERROR, "Errors",
+                                  HMDT::STATUS_PROVINCE_NOT_IN_STATE,
+                                  "State ", 3, " is missing a province");
+    error.state = 3;
+
+    report.merge(std::move(other));
+    ASSERT_TRUE(other.empty());
+
+    ASSERT_EQ(report.getIssues().size(), 6);
+    ASSERT_EQ(report.getIssues().front().message, "State 3 is missing a province");
+    ASSERT_EQ(report.getIssues().front().state, 3);
+    ASSERT_EQ(report.getIssues().back().message, "Warning #4");
+    ASSERT_EQ(report.count(Severity::ERROR), 1);
+    ASSERT_EQ(report.count(Severity::WARNING), 5);
+    ASSERT_TRUE(report.hasErrors());
+
+    // Fixed issues stay in the report, but no longer count against it
+    report.getIssues().front().fixed = true;
+    ASSERT_FALSE(report.hasErrors());
+    ASSERT_EQ(report.count(Severity::ERROR), 0);
+    ASSERT_EQ(report.countFixed(), 1);
+
+    auto str = report.toString(2);
+    ASSERT_NE(str.find("0 errors, 5 warnings, 1 fixed"), std::string::npos);
+    ASSERT_NE(str.find("Errors: 1 issues"), std::string::npos);
+    ASSERT_NE(str.find("(fixed)"), std::string::npos);
+    ASSERT_NE(str.find("Warning #1"), std::string::npos);
+    ASSERT_EQ(str.find("Warning #2"), std::string::npos);
+    ASSERT_NE(str.find("... and 3 more"), std::string::npos);
+}
+
+TEST(UtilTests, FileWriterPoolSkipsUnchangedFiles) {
+    auto write_base_path = HMDT::UnitTests::getTestProgramPath() / "tmp" / "file_writer_pool";
+
+    std::filesystem::remove_all(write_base_path);
+    ASSERT_TRUE(std::filesystem::create_directories(write_base_path));
+
+    auto writeAll = [&](HMDT::FileWriterPool& writer, uint32_t changed) {
+        for(uint32_t i = 0; i < 20; ++i) {
+            writer.write(write_base_path / (std::to_string(i) + ".txt"),
+                         "file " + std::to_string(i) +
+                             (i == changed ? " changed" : ""));
+        }
+    };
+
+    {
+        // Only let a couple of files wait at once, so that writing blocks
+        HMDT::FileWriterPool writer(2, 2);
+
+        writeAll(writer, 20);
+        ASSERT_SUCCEEDED(writer.wait());
+        ASSERT_EQ(writer.getWrittenCount(), 20);
+        ASSERT_EQ(writer.getSkippedCount(), 0);
+
+        writeAll(writer, 7);
+        ASSERT_SUCCEEDED(writer.wait());
+        ASSERT_EQ(writer.getWrittenCount(), 21);
+        ASSERT_EQ(writer.getSkippedCount(), 19);
+    }
+
+    std::ifstream in(write_base_path / "7.txt");
+    std::string contents;
+    std::getline(in, contents);
+    ASSERT_EQ(contents, "file 7 changed");
+
+    // Errors are reported once every queued file has been handled
+    HMDT::FileWriterPool writer;
+    writer.write(write_base_path / "missing" / "0.txt", "");
+    ASSERT_FALSE(IS_SUCCESS(writer.wait()));
+    ASSERT_SUCCEEDED(writer.wait());
+}
+
+TEST(UtilTests, UUIDFromCharsMatchesParse) {
+    for(size_t i = 0; i < 32; ++i) {
+        HMDT::UUID uuid(HMDT::UUID::CreationParams::RANDOM);
+        auto str = std::to_string(uuid);
+
+        auto decoded = HMDT::UUID::fromChars(str);
+        ASSERT_SUCCEEDED(decoded);
+        ASSERT_EQ(*decoded, uuid);
+        ASSERT_EQ(*decoded, *HMDT::UUID::parse(str));
+    }
+
+    // Upper-case digits are accepted, and the string need not be terminated
+    std::string padded = "01234567-89AB-CDEF-0123-456789abcdef;trailing";
+    std::string_view view(padded.data(), HMDT::UUID::STRING_REPR_LENGTH);
+
+    auto decoded = HMDT::UUID::fromChars(view);
+    ASSERT_SUCCEEDED(decoded);
+    ASSERT_EQ(std::to_string(*decoded), "01234567-89ab-cdef-0123-456789abcdef");
+
+    ASSERT_FALSE(IS_SUCCESS(HMDT::UUID::fromChars("")));
+    ASSERT_FALSE(IS_SUCCESS(HMDT::UUID::fromChars(padded)));
+    ASSERT_FALSE(IS_SUCCESS(HMDT::UUID::fromChars("01234567-89ab-cdef-0123-456789abcdeg")));
+    ASSERT_FALSE(IS_SUCCESS(HMDT::UUID::fromChars("01234567+89ab-cdef-0123-456789abcdef")));
+}
+
+namespace {
+    /**
+     * @brief Builds an 8-bit greyscale heightmap with some rolling hills on it.
+     */
+    HMDT::BitMap2 makeHeightMap(uint32_t width, uint32_t height) {
+        HMDT::BitMap2 heightmap;
+        heightmap.info_header.v1.width = width;
+        heightmap.info_header.v1.height = height;
+        heightmap.info_header.v1.bitsPerPixel = 8;
+        heightmap.info_header.v1.colorsUsed = 256;
+
+        heightmap.color_table.reset(new HMDT::RGBQuad[256]);
+        for(uint32_t i = 0; i < 256; ++i) {
+            heightmap.color_table[i].red = i;
+            heightmap.color_table[i].green = i;
+            heightmap.color_table[i].blue = i;
+            heightmap.color_table[i].reserved = 0;
+        }
+
+        heightmap.data.reset(new unsigned char[width * height]);
+        for(uint32_t y = 0; y < height; ++y) {
+            for(uint32_t x = 0; x < width; ++x) {
+                heightmap.data[y * width + x] = static_cast<unsigned char>(
+                    127.5 + 60 * std::sin(x * 0.05) * std::cos(y * 0.03) +
+                    60 * std::sin((x + y) * 0.37));
+            }
+        }
+
+        return heightmap;
+    }
+}
+
+TEST(UtilTests, WorldNormalMapMatchesSobelFilter) {
+    // A plain sobel filter, with every edge clamped to the nearest pixel
+    auto sobel = [](const HMDT::BitMap2& heightmap, uint32_t x, uint32_t y,
+                    uint32_t c) -> uint8_t
+    {
+        int32_t width = heightmap.info_header.v1.width;
+        int32_t height = heightmap.info_header.v1.height;
+
+        auto at = [&](int32_t dx, int32_t dy) {
+            auto px = std::clamp<int32_t>(x + dx, 0, width - 1);
+            auto py = std::clamp<int32_t>(y + dy, 0, height - 1);
+            return heightmap.data[py * width + px] / 255.0;
+        };
+
+        double dX = (at(1, -1) + 2.0 * at(1, 0) + at(1, 1)) -
+                    (at(-1, -1) + 2.0 * at(-1, 0) + at(-1, 1));
+        double dY = (at(-1, 1) + 2.0 * at(0, 1) + at(1, 1)) -
+                    (at(-1, -1) + 2.0 * at(0, -1) + at(1, -1));
+        double dZ = 0.5;
+        double l = std::sqrt(dX * dX + dY * dY + dZ * dZ);
+
+        double n[3] = { dX / l, dY / l, dZ / l };
+        return static_cast<uint8_t>((n[c] + 1.0) * (255.0 / 2.0));
+    };
+
+    {
+        // Odd dimensions, so that the rows do not line up with anything
+        auto heightmap = makeHeightMap(131, 67);
+
+        std::vector<unsigned char> normals(131 * 67 * 3);
+        ASSERT_SUCCEEDED(HMDT::generateWorldNormalMap(heightmap, normals.data()));
+
+        for(uint32_t y = 0; y < 67; ++y) {
+            for(uint32_t x = 0; x < 131; ++x) {
+                for(uint32_t c = 0; c < 3; ++c) {
+                    auto expected = sobel(heightmap, x, y, c);
+                    auto actual = normals[(y * 131 + x) * 3 + c];
+
+                    ASSERT_LE(std::abs(expected - actual), 1)
+                        << "at " << x << ',' << y << " channel " << c;
+                }
+            }
+        }
+    }
+
+    {
+        // Every normal of a flat heightmap points straight up
+        auto heightmap = makeHeightMap(5, 3);
+        std::fill(heightmap.data.get(), heightmap.data.get() + 5 * 3, 42);
+
+        unsigned char normals[5 * 3 * 3];
+        ASSERT_SUCCEEDED(HMDT::generateWorldNormalMap(heightmap, normals));
+
+        for(uint32_t i = 0; i < 5 * 3; ++i) {
+            ASSERT_EQ(normals[i * 3], 127);
+            ASSERT_EQ(normals[i * 3 + 1], 127);
+            ASSERT_EQ(normals[i * 3 + 2], 255);
+        }
+    }
+
+    // Heightmaps must be 8-bit
+    auto heightmap = makeHeightMap(4, 4);
+    heightmap.info_header.v1.bitsPerPixel = 24;
+
+    unsigned char normals[4 * 4 * 3];
+    ASSERT_STATUS(HMDT::generateWorldNormalMap(heightmap, normals),
+                  HMDT::STATUS_INVALID_BIT_DEPTH);
+}
+
+/**
+ * Only times the filter on a map the size of the base game's, so it is not run
+ * by default. Use --gtest_also_run_disabled_tests to run it.
+ */
+TEST(UtilTests, DISABLED_WorldNormalMapBenchmark) {
+    // Benchmark against a map the size of the base game's
+    auto heightmap = makeHeightMap(5632, 2048);
+
+    std::vector<unsigned char> normals(5632 * 2048 * 3);
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_SUCCEEDED(HMDT::generateWorldNormalMap(heightmap, normals.data()));
+    auto end = std::chrono::steady_clock::now();
+
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    TEST_COUT << "Generated a 5632x2048 world normal map in "
+              << elapsed_ms << "ms" << std::endl;
+    RecordProperty("generate_world_normal_map_5632x2048_ms",
+                   std::to_string(elapsed_ms));
+}
+
+TEST(UtilTests, HeightMapPyramidAveragesEveryLevel) {
+    // Odd sizes on purpose, so that the last row and column get exercised
+    constexpr uint32_t width = 157;
+    constexpr uint32_t height = 83;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    // A palette that is not greyscale, and that does not cover every index
+    HMDT::BitMap2 bitmap;
+    bitmap.info_header.v1.bitsPerPixel = 8;
+    bitmap.info_header.v1.colorsUsed = 200;
+    bitmap.color_table.reset(new HMDT::RGBQuad[200]);
+    for(uint32_t i = 0; i < 200; ++i) {
+        bitmap.color_table[i].red = i;
+        bitmap.color_table[i].green = 255 - i;
+        bitmap.color_table[i].blue = i / 2;
+        bitmap.color_table[i].reserved = 0;
+    }
+
+    auto palette = HMDT::HeightMapPyramid::makePalette(bitmap);
+    for(uint32_t i = 0; i < 256; ++i) {
+        auto expected = (i < 200) ? (i + (255 - i) + i / 2 + 1) / 3 : 0;
+        ASSERT_EQ(palette[i], expected) << "palette index " << i;
+    }
+
+    std::vector<uint8_t> heightmap(width * height);
+    std::generate(heightmap.begin(), heightmap.end(), [&]() { return dist(rng); });
+
+    // Checks every level against a plain box filter of the level above it,
+    //  where only the full resolution heightmap goes through the palette
+    auto checkPyramid = [&](const HMDT::HeightMapPyramid& pyramid) {
+        ASSERT_EQ(pyramid.getWidth(), width);
+        ASSERT_EQ(pyramid.getHeight(), height);
+
+        std::vector<uint8_t> src(heightmap.size());
+        std::transform(heightmap.begin(), heightmap.end(), src.begin(),
+                       [&palette](uint8_t index) { return palette[index]; });
+        uint32_t src_width = width;
+        uint32_t src_height = height;
+
+        for(size_t i = 0; i < pyramid.getLevelCount(); ++i) {
+            auto level = pyramid.getLevel(i);
+            ASSERT_SUCCEEDED(level);
+
+            const auto& [w, h, data] = level->get();
+            ASSERT_EQ(w, (src_width + 1) / 2);
+            ASSERT_EQ(h, (src_height + 1) / 2);
+
+            for(uint32_t y = 0; y < h; ++y) {
+                for(uint32_t x = 0; x < w; ++x) {
+                    auto x1 = std::min(x * 2 + 1, src_width - 1);
+                    auto y1 = std::min(y * 2 + 1, src_height - 1);
+
+                    auto sum = src[y * 2 * src_width + x * 2] +
+                               src[y * 2 * src_width + x1] +
+                               src[y1 * src_width + x * 2] +
+                               src[y1 * src_width + x1];
+
+                    ASSERT_EQ(data[y * w + x], (sum + 2) / 4) << "level " << i
+                        << " at " << x << ',' << y;
+                }
+            }
+
+            src = data;
+            src_width = w;
+            src_height = h;
+        }
+
+        // The last level is always a single pixel
+        ASSERT_EQ(src_width, 1U);
+        ASSERT_EQ(src_height, 1U);
+    };
+
+    HMDT::HeightMapPyramid pyramid;
+    pyramid.build(heightmap.data(), width, height, palette);
+    checkPyramid(pyramid);
+    ASSERT_EQ(pyramid.getPalette(), palette);
+
+    // Both 157 and 83 take 8 halvings to reach 1
+    ASSERT_EQ(pyramid.getLevelCount(), 8U);
+    ASSERT_STATUS(pyramid.getLevel(8), HMDT::STATUS_OUT_OF_RANGE);
+
+    // Updating an edited area gives the same result as rebuilding everything
+    for(auto&& area : { HMDT::Rectangle{ 13, 7, 21, 9 },
+                        HMDT::Rectangle{ width - 5, height - 3, 5, 3 },
+                        HMDT::Rectangle{ 0, 0, 1, 1 } })
+    {
+        for(uint32_t y = area.y; y < area.y + area.h; ++y) {
+            for(uint32_t x = area.x; x < area.x + area.w; ++x) {
+                heightmap[y * width + x] = dist(rng);
+            }
+        }
+
+        pyramid.update(heightmap.data(), area);
+        checkPyramid(pyramid);
+    }
+
+    // The smallest level that can still cover the requested size is chosen
+    auto level = pyramid.findLevel(30, 10);
+    ASSERT_SUCCEEDED(level);
+    ASSERT_EQ(level->get().width, 40U);
+    ASSERT_EQ(level->get().height, 21U);
+
+    ASSERT_STATUS(pyramid.findLevel(width, 1), HMDT::STATUS_VALUE_NOT_FOUND);
+
+    ASSERT_GT(HMDT::estimateMemoryUsage(pyramid), width * height / 3);
+}
+
+TEST(UtilTests, RiversValidatorFindsBrokenRivers) {
+    constexpr uint32_t width = 32;
+    constexpr uint32_t height = 16;
+
+    std::vector<uint8_t> rivers(width * height, 0xFF);
+    auto set = [&](uint32_t x, uint32_t y, uint8_t value) {
+        rivers[y * width + x] = value;
+    };
+
+    // A valid river, with a tributary flowing in and a branch flowing out
+    set(2, 2, HMDT::RIVER_SOURCE_INDEX);
+    for(uint32_t x = 3; x <= 12; ++x) set(x, 2, 5);
+    set(6, 3, HMDT::RIVER_FLOW_IN_INDEX);
+    set(6, 4, 5);
+    set(6, 5, 5);
+    set(6, 6, HMDT::RIVER_SOURCE_INDEX);
+    set(9, 1, HMDT::RIVER_FLOW_OUT_INDEX);
+    set(9, 0, 5);
+
+    ASSERT_TRUE(HMDT::validateRivers(rivers.data(), width, height).empty());
+
+    // A river without any source
+    for(uint32_t x = 2; x <= 6; ++x) set(x, 10, 5);
+
+    // Two rivers which only touch diagonally
+    set(20, 1, HMDT::RIVER_SOURCE_INDEX);
+    set(21, 1, 5);
+    set(22, 2, HMDT::RIVER_SOURCE_INDEX);
+
+    // A river which splits without a flow-out marker
+    set(20, 6, HMDT::RIVER_SOURCE_INDEX);
+    for(uint32_t x = 21; x <= 23; ++x) set(x, 6, 5);
+    set(22, 7, 5);
+    set(22, 8, 5);
+
+    // A river which loops back on itself
+    for(uint32_t y = 10; y <= 12; ++y) {
+        for(uint32_t x = 26; x <= 28; ++x) {
+            if(x != 27 || y != 11) set(x, y, 5);
+        }
+    }
+
+    auto report = HMDT::validateRivers(rivers.data(), width, height);
+
+    using Found = std::tuple<int, uint32_t, uint32_t>;
+    std::vector<Found> found;
+    for(auto&& issue : report.getIssues()) {
+        ASSERT_EQ(issue.severity, HMDT::ValidationReport::Severity::WARNING);
+        ASSERT_EQ(issue.validator, "Rivers");
+        ASSERT_TRUE(issue.position.has_value()) << issue.message;
+
+        found.emplace_back(issue.code.value(), issue.position->x,
+                           issue.position->y);
+    }
+    std::sort(found.begin(), found.end());
+
+    std::vector<Found> expected{
+        { HMDT::STATUS_RIVER_NO_SOURCE.value(), 2, 10 },
+        { HMDT::STATUS_RIVER_DANGLING_END.value(), 2, 10 },
+        { HMDT::STATUS_RIVER_DIAGONAL_CONNECTION.value(), 21, 1 },
+        { HMDT::STATUS_RIVER_INVALID_BRANCH.value(), 22, 6 },
+        { HMDT::STATUS_RIVER_DANGLING_END.value(), 23, 6 },
+        { HMDT::STATUS_RIVER_LOOP.value(), 26, 10 },
+        { HMDT::STATUS_RIVER_NO_SOURCE.value(), 26, 10 },
+    };
+    std::sort(expected.begin(), expected.end());
+
+    ASSERT_EQ(found, expected) << report.toString(expected.size() + 1);
+
+    // Markers which don't sit between two rivers are reported as well
+    set(2, 12, HMDT::RIVER_FLOW_IN_INDEX);
+    report = HMDT::validateRivers(rivers.data(), width, height);
+
+    ASSERT_TRUE(std::any_of(report.getIssues().begin(), report.getIssues().end(),
+                            [](auto&& issue) {
+                                return issue.code == HMDT::STATUS_RIVER_MISPLACED_MARKER &&
+                                       issue.position->x == 2 &&
+                                       issue.position->y == 12;
+                            }));
+}